@@ -0,0 +1,155 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkAddonTestingMacros.h"
+#include "vtkOpenGLShaderComputation.h"
+#include "vtkOpenGLTextureImage.h"
+#include "vtkRawRGBVolumeCodec.h"
+#include "vtkRunLengthLabelMapVolumeCodec.h"
+#include "vtkStreamingVolumeFrame.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstring>
+#include <vector>
+
+//----------------------------------------------------------------------------
+int DecodeKeyFrameTest(vtkOpenGLShaderComputation* shaderComputation);
+int DecodePredictedFrameTest(vtkOpenGLShaderComputation* shaderComputation);
+
+//----------------------------------------------------------------------------
+int vtkOpenGLTextureImageTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  TESTING_OUTPUT_INIT();
+
+  // the shader computation renders into an offscreen window
+  vtkNew<vtkOpenGLShaderComputation> shaderComputation;
+  CHECK_BOOL(shaderComputation->GetInitialized(), true);
+
+  CHECK_EXIT_SUCCESS(DecodeKeyFrameTest(shaderComputation));
+  CHECK_EXIT_SUCCESS(DecodePredictedFrameTest(shaderComputation));
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Read the texture into an image of the same geometry as the reference image
+// (rows of the test images are multiples of 4 bytes, the default pack alignment)
+// and compare the voxels.
+int CheckTextureContents(vtkOpenGLTextureImage* textureImage, vtkImageData* referenceImage)
+{
+  vtkNew<vtkImageData> readBackImage;
+  readBackImage->SetDimensions(referenceImage->GetDimensions());
+  readBackImage->AllocateScalars(referenceImage->GetScalarType(), referenceImage->GetNumberOfScalarComponents());
+  textureImage->SetImageData(readBackImage);
+  textureImage->ReadBack();
+  textureImage->SetImageData(nullptr);
+
+  vtkIdType numberOfBytes = referenceImage->GetNumberOfPoints() * referenceImage->GetNumberOfScalarComponents()
+    * referenceImage->GetScalarSize();
+  CHECK_INT(memcmp(readBackImage->GetScalarPointer(), referenceImage->GetScalarPointer(), numberOfBytes), 0);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int DecodeKeyFrameTest(vtkOpenGLShaderComputation* shaderComputation)
+{
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(16, 12, 5);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  unsigned char* imagePointer = static_cast<unsigned char*>(image->GetScalarPointer());
+  vtkIdType numberOfValues = image->GetNumberOfPoints() * 3;
+  for (vtkIdType i = 0; i < numberOfValues; ++i)
+    {
+    imagePointer[i] = static_cast<unsigned char>((i * 37) % 256);
+    }
+
+  vtkNew<vtkRawRGBVolumeCodec> codec;
+  vtkNew<vtkStreamingVolumeFrame> frame;
+  CHECK_BOOL(codec->EncodeImageData(image, frame), true);
+
+  // the key frame is decoded into the mapped pixel unpack buffer
+  vtkNew<vtkOpenGLTextureImage> textureImage;
+  textureImage->SetShaderComputation(shaderComputation);
+  CHECK_BOOL(textureImage->DecodeFrame(codec, frame), true);
+  CHECK_BOOL(textureImage->GetTextureName() != 0, true);
+  CHECK_EXIT_SUCCESS(CheckTextureContents(textureImage, image));
+
+  // the existing texture and buffer are reused for the next frame
+  vtkTypeUInt32 textureName = textureImage->GetTextureName();
+  for (vtkIdType i = 0; i < numberOfValues; ++i)
+    {
+    imagePointer[i] = static_cast<unsigned char>(255 - imagePointer[i]);
+    }
+  image->Modified();
+  CHECK_BOOL(codec->EncodeImageData(image, frame), true);
+  CHECK_BOOL(textureImage->DecodeFrame(codec, frame), true);
+  CHECK_INT(textureImage->GetTextureName(), textureName);
+  CHECK_EXIT_SUCCESS(CheckTextureContents(textureImage, image));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int DecodePredictedFrameTest(vtkOpenGLShaderComputation* shaderComputation)
+{
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> encoder;
+  CHECK_BOOL(encoder->SetParameter("KeyFrameDistance", "3"), true);
+
+  const int numberOfFrames = 3;
+  std::vector<vtkSmartPointer<vtkImageData> > images;
+  std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > frames;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(20, 16, 8);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    unsigned char* imagePointer = static_cast<unsigned char*>(image->GetScalarPointer());
+    for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+      {
+      // a label that grows in each frame
+      imagePointer[i] = (i % 20 < 5 + 3 * frameIndex) ? 7 : 0;
+      }
+    images.push_back(image);
+
+    vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    CHECK_BOOL(encoder->EncodeImageData(image, frame), true);
+    frames.push_back(frame);
+    }
+  CHECK_NOT_NULL(frames[numberOfFrames - 1]->GetPreviousFrame());
+
+  // predicted frames are decoded on the CPU, as they update the previous frame
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> decoder;
+  vtkNew<vtkOpenGLTextureImage> textureImage;
+  textureImage->SetShaderComputation(shaderComputation);
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    CHECK_BOOL(textureImage->DecodeFrame(decoder, frames[frameIndex]), true);
+    CHECK_EXIT_SUCCESS(CheckTextureContents(textureImage, images[frameIndex]));
+    }
+
+  // the decoder is used for another image meanwhile, the texture image must not
+  // update its reference image with the next predicted frame
+  vtkNew<vtkImageData> otherImage;
+  CHECK_BOOL(decoder->DecodeFrame(frames[1], otherImage), true);
+  CHECK_BOOL(textureImage->DecodeFrame(decoder, frames[2]), true);
+  CHECK_EXIT_SUCCESS(CheckTextureContents(textureImage, images[2]));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,545 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkAddonTestingMacros.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+#include "vtkOrientedTransformFile.h"
+#include "vtkOrientedTransformJacobianDeterminant.h"
+#include "vtkOrientedTransformInverseStatistics.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+int EvaluateOnGridTest(int coefficientScalarType, bool alignedLattice, bool bulkTransform);
+int InverseTransformPointsTest(bool bulkTransform);
+int BroydenInverseTest(bool bulkTransform);
+int HierarchicalInverseTest(int inverseSolver);
+int ThreadSafeEvaluationTest();
+int JacobianDeterminantTest(bool alignedLattice);
+int ConvertToGridTransformTest();
+int TransformFileTest(const char* temporaryDirectory);
+
+//----------------------------------------------------------------------------
+int vtkOrientedBSplineTransformTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char* temporaryDirectory = argv[1];
+
+  TESTING_OUTPUT_INIT();
+  CHECK_EXIT_SUCCESS(EvaluateOnGridTest(VTK_DOUBLE, true, false));
+  CHECK_EXIT_SUCCESS(EvaluateOnGridTest(VTK_FLOAT, true, true));
+  CHECK_EXIT_SUCCESS(EvaluateOnGridTest(VTK_DOUBLE, false, true));
+  CHECK_EXIT_SUCCESS(InverseTransformPointsTest(false));
+  CHECK_EXIT_SUCCESS(InverseTransformPointsTest(true));
+  CHECK_EXIT_SUCCESS(BroydenInverseTest(false));
+  CHECK_EXIT_SUCCESS(BroydenInverseTest(true));
+  CHECK_EXIT_SUCCESS(HierarchicalInverseTest(vtkOrientedBSplineTransform::NewtonSolver));
+  CHECK_EXIT_SUCCESS(HierarchicalInverseTest(vtkOrientedBSplineTransform::BroydenSolver));
+  CHECK_EXIT_SUCCESS(ThreadSafeEvaluationTest());
+  CHECK_EXIT_SUCCESS(JacobianDeterminantTest(true));
+  CHECK_EXIT_SUCCESS(JacobianDeterminantTest(false));
+  CHECK_EXIT_SUCCESS(ConvertToGridTransformTest());
+  CHECK_EXIT_SUCCESS(TransformFileTest(temporaryDirectory));
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void SetRotationZ(vtkMatrix4x4* matrix, double angleDegrees)
+{
+  double angle = vtkMath::RadiansFromDegrees(angleDegrees);
+  matrix->Identity();
+  matrix->SetElement(0, 0, cos(angle));
+  matrix->SetElement(0, 1, -sin(angle));
+  matrix->SetElement(1, 0, sin(angle));
+  matrix->SetElement(1, 1, cos(angle));
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkOrientedBSplineTransform> CreateOrientedBSplineTransform(int coefficientScalarType, bool bulkTransform)
+{
+  vtkNew<vtkImageData> coefficients;
+  coefficients->SetExtent(0, 8, 0, 9, 0, 6);
+  coefficients->SetSpacing(4.0, 3.0, 5.0);
+  coefficients->SetOrigin(-10.0, -8.0, -5.0);
+  coefficients->AllocateScalars(coefficientScalarType, 3);
+  for (int k = 0; k <= 6; ++k)
+    {
+    for (int j = 0; j <= 9; ++j)
+      {
+      for (int i = 0; i <= 8; ++i)
+        {
+        coefficients->SetScalarComponentFromDouble(i, j, k, 0, 2.0 * sin(0.5 * i + 0.3 * k));
+        coefficients->SetScalarComponentFromDouble(i, j, k, 1, 1.5 * cos(0.4 * j));
+        coefficients->SetScalarComponentFromDouble(i, j, k, 2, 0.2 * (i - j + k));
+        }
+      }
+    }
+
+  vtkNew<vtkMatrix4x4> gridDirection;
+  SetRotationZ(gridDirection, 30.0);
+
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = vtkSmartPointer<vtkOrientedBSplineTransform>::New();
+  transform->SetCoefficientData(coefficients);
+  transform->SetGridDirectionMatrix(gridDirection);
+  transform->SetDisplacementScale(0.8);
+  if (bulkTransform)
+    {
+    vtkNew<vtkMatrix4x4> bulkMatrix;
+    SetRotationZ(bulkMatrix, 5.0);
+    bulkMatrix->SetElement(0, 3, 2.0);
+    bulkMatrix->SetElement(2, 3, -1.0);
+    transform->SetBulkTransformMatrix(bulkMatrix);
+    }
+  return transform;
+}
+
+//----------------------------------------------------------------------------
+int EvaluateOnGridTest(int coefficientScalarType, bool alignedLattice, bool bulkTransform)
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(coefficientScalarType, bulkTransform);
+
+  // The aligned lattice uses the grid axes in a different order and
+  // extends beyond the grid to test the border handling.
+  vtkNew<vtkMatrix4x4> latticeDirection;
+  if (alignedLattice)
+    {
+    vtkNew<vtkMatrix4x4> gridDirection;
+    SetRotationZ(gridDirection, 30.0);
+    for (int row = 0; row < 3; ++row)
+      {
+      latticeDirection->SetElement(row, 0, gridDirection->GetElement(row, 1));
+      latticeDirection->SetElement(row, 1, -gridDirection->GetElement(row, 0));
+      latticeDirection->SetElement(row, 2, gridDirection->GetElement(row, 2));
+      }
+    }
+  else
+    {
+    SetRotationZ(latticeDirection, -10.0);
+    }
+  double origin[3] = { -15.0, 20.0, -12.0 };
+  double spacing[3] = { 1.3, 1.7, 2.1 };
+  int dimensions[3] = { 30, 35, 20 };
+
+  vtkNew<vtkImageData> displacementField;
+  CHECK_BOOL(transform->EvaluateOnGrid(origin, spacing, latticeDirection, dimensions, displacementField), true);
+  CHECK_INT(displacementField->GetNumberOfScalarComponents(), 3);
+  CHECK_INT(displacementField->GetScalarType(), VTK_DOUBLE);
+
+  // Compare to single point evaluation
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        double point[3] = { origin[0], origin[1], origin[2] };
+        int latticeIndex[3] = { i, j, k };
+        for (int row = 0; row < 3; ++row)
+          {
+          for (int col = 0; col < 3; ++col)
+            {
+            point[row] += latticeDirection->GetElement(row, col) * spacing[col] * latticeIndex[col];
+            }
+          }
+        double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+        transform->TransformPoint(point, transformedPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(displacementField->GetScalarComponentAsDouble(i, j, k, c),
+            transformedPoint[c] - point[c], 1e-6);
+          }
+        }
+      }
+    }
+
+  // Invalid input
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  int invalidDimensions[3] = { 0, 1, 1 };
+  CHECK_BOOL(transform->EvaluateOnGrid(origin, spacing, latticeDirection, invalidDimensions, displacementField), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int InverseTransformPointsTest(bool bulkTransform)
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(VTK_DOUBLE, bulkTransform);
+
+  // Scanline-ordered points
+  std::vector<double> inPoints;
+  for (int k = 0; k < 10; ++k)
+    {
+    for (int j = 0; j < 20; ++j)
+      {
+      for (int i = 0; i < 25; ++i)
+        {
+        inPoints.push_back(-12.0 + 1.1 * i);
+        inPoints.push_back(-6.0 + 1.3 * j);
+        inPoints.push_back(-2.0 + 2.2 * k);
+        }
+      }
+    }
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(inPoints.size() / 3);
+  std::vector<double> outPoints(inPoints.size());
+  double meanIterations = transform->InverseTransformPoints(&inPoints[0], &outPoints[0], numberOfPoints);
+  CHECK_BOOL(meanIterations >= 1.0, true);
+
+  // Compare to single point inverse
+  vtkAbstractTransform* inverseTransform = transform->GetInverse();
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    inverseTransform->TransformPoint(&inPoints[3 * pointId], expectedPoint);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(outPoints[3 * pointId + c], expectedPoint[c], 1e-2);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int BroydenInverseTest(bool bulkTransform)
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(VTK_DOUBLE, bulkTransform);
+  transform->SetInverseTolerance(1e-6);
+  vtkSmartPointer<vtkOrientedBSplineTransform> broydenTransform = vtkSmartPointer<vtkOrientedBSplineTransform>::New();
+  broydenTransform->DeepCopy(transform);
+  CHECK_INT(broydenTransform->GetInverseSolver(), vtkOrientedBSplineTransform::NewtonSolver);
+  broydenTransform->SetInverseSolverToBroyden();
+  CHECK_INT(broydenTransform->GetInverseSolver(), vtkOrientedBSplineTransform::BroydenSolver);
+
+  std::vector<double> inPoints;
+  for (int k = 0; k < 6; ++k)
+    {
+    for (int j = 0; j < 15; ++j)
+      {
+      for (int i = 0; i < 20; ++i)
+        {
+        inPoints.push_back(-12.0 + 1.3 * i);
+        inPoints.push_back(-6.0 + 1.7 * j);
+        inPoints.push_back(-2.0 + 3.1 * k);
+        }
+      }
+    }
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(inPoints.size() / 3);
+  std::vector<double> newtonPoints(inPoints.size());
+  std::vector<double> broydenPoints(inPoints.size());
+  transform->InverseTransformPoints(&inPoints[0], &newtonPoints[0], numberOfPoints);
+  double meanIterations = broydenTransform->InverseTransformPoints(&inPoints[0], &broydenPoints[0], numberOfPoints);
+  CHECK_BOOL(meanIterations >= 1.0, true);
+  CHECK_INT(broydenTransform->GetInverseStatistics()->GetNumberOfFailures(), 0);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(broydenPoints[3 * pointId + c], newtonPoints[3 * pointId + c], 1e-4);
+      }
+    // the solution is mapped back to the input point
+    double forwardPoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(&broydenPoints[3 * pointId], forwardPoint);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(forwardPoint[c], inPoints[3 * pointId + c], 1e-4);
+      }
+    }
+
+  // Single point inverse returns the same point and derivative as Newton's method
+  vtkAbstractTransform* newtonInverse = transform->GetInverse();
+  vtkAbstractTransform* broydenInverse = broydenTransform->GetInverse();
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; pointId += 37)
+    {
+    double newtonPoint[3], broydenPoint[3];
+    double newtonDerivative[3][3], broydenDerivative[3][3];
+    newtonInverse->InternalTransformDerivative(&inPoints[3 * pointId], newtonPoint, newtonDerivative);
+    broydenInverse->InternalTransformDerivative(&inPoints[3 * pointId], broydenPoint, broydenDerivative);
+    for (int row = 0; row < 3; ++row)
+      {
+      CHECK_DOUBLE_TOLERANCE(broydenPoint[row], newtonPoint[row], 1e-4);
+      for (int col = 0; col < 3; ++col)
+        {
+        CHECK_DOUBLE_TOLERANCE(broydenDerivative[row][col], newtonDerivative[row][col], 1e-3);
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int HierarchicalInverseTest(int inverseSolver)
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(VTK_DOUBLE, true);
+  transform->SetInverseTolerance(1e-6);
+  transform->SetInverseSolver(inverseSolver);
+  vtkSmartPointer<vtkOrientedBSplineTransform> hierarchicalTransform = vtkSmartPointer<vtkOrientedBSplineTransform>::New();
+  hierarchicalTransform->DeepCopy(transform);
+  hierarchicalTransform->HierarchicalInverseOn();
+  hierarchicalTransform->Update();
+
+  // The coarse grid covers the 9x10x7 coefficient grid with every 2nd node
+  vtkOrientedGridTransform* coarseTransform = hierarchicalTransform->GetCoarseInverseTransform();
+  CHECK_NOT_NULL(coarseTransform);
+  int coarseExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  coarseTransform->GetDisplacementGrid()->GetExtent(coarseExtent);
+  CHECK_INT(coarseExtent[1], 4);
+  CHECK_INT(coarseExtent[3], 5);
+  CHECK_INT(coarseExtent[5], 3);
+
+  // Same inverse as without the coarse transform
+  vtkAbstractTransform* inverseTransform = transform->GetInverse();
+  vtkOrientedBSplineTransform* hierarchicalInverseTransform =
+    vtkOrientedBSplineTransform::SafeDownCast(hierarchicalTransform->GetInverse());
+  CHECK_NOT_NULL(hierarchicalInverseTransform);
+  for (int k = 0; k < 5; ++k)
+    {
+    for (int j = 0; j < 8; ++j)
+      {
+      for (int i = 0; i < 9; ++i)
+        {
+        double point[3] = { -9.0 + 2.9 * i, -6.0 + 2.3 * j, -3.0 + 4.1 * k };
+        double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+        inverseTransform->TransformPoint(point, expectedPoint);
+        double inversePoint[3] = { 0.0, 0.0, 0.0 };
+        hierarchicalInverseTransform->TransformPoint(point, inversePoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(inversePoint[c], expectedPoint[c], 1e-4);
+          }
+        }
+      }
+    }
+  CHECK_INT(hierarchicalInverseTransform->GetInverseStatistics()->GetNumberOfCalls(), 360);
+  CHECK_INT(hierarchicalInverseTransform->GetInverseStatistics()->GetNumberOfFailures(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int ThreadSafeEvaluationTest()
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(VTK_DOUBLE, true);
+  transform->ThreadSafeEvaluationOn();
+  vtkOrientedBSplineTransform* inverseTransform = vtkOrientedBSplineTransform::SafeDownCast(transform->GetInverse());
+  CHECK_NOT_NULL(inverseTransform);
+  CHECK_BOOL(inverseTransform->GetThreadSafeEvaluation(), true);
+
+  // The inverse is evaluated in parallel
+  double origin[3] = { -8.0, -4.0, 0.0 };
+  double spacing[3] = { 2.1, 1.9, 2.3 };
+  int dimensions[3] = { 12, 10, 8 };
+  vtkNew<vtkImageData> displacementField;
+  CHECK_BOOL(inverseTransform->EvaluateOnGrid(origin, spacing, nullptr, dimensions, displacementField), true);
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  CHECK_INT(inverseTransform->GetInverseStatistics()->GetNumberOfCalls(), numberOfPoints);
+
+  // Compare to serial evaluation
+  inverseTransform->ThreadSafeEvaluationOff();
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        double point[3] = { origin[0] + spacing[0] * i, origin[1] + spacing[1] * j, origin[2] + spacing[2] * k };
+        double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+        inverseTransform->TransformPoint(point, transformedPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(displacementField->GetScalarComponentAsDouble(i, j, k, c),
+            transformedPoint[c] - point[c], 1e-9);
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int JacobianDeterminantTest(bool alignedLattice)
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(VTK_DOUBLE, true);
+
+  vtkNew<vtkMatrix4x4> latticeDirection;
+  SetRotationZ(latticeDirection, alignedLattice ? 30.0 : -10.0);
+
+  vtkNew<vtkOrientedTransformJacobianDeterminant> jacobianFilter;
+  jacobianFilter->SetInput(transform);
+  jacobianFilter->SetGridOrigin(-15.0, -10.0, -12.0);
+  jacobianFilter->SetGridSpacing(1.3, 1.7, 2.1);
+  jacobianFilter->SetGridExtent(0, 29, 0, 24, 0, 19);
+  jacobianFilter->SetGridDirectionMatrix(latticeDirection);
+  jacobianFilter->ComputeStatisticsOn();
+  jacobianFilter->Update();
+  vtkImageData* jacobianDeterminant = jacobianFilter->GetOutput();
+  CHECK_INT(jacobianDeterminant->GetNumberOfScalarComponents(), 1);
+  CHECK_INT(jacobianDeterminant->GetScalarType(), VTK_DOUBLE);
+
+  // Compare to single point derivative
+  double minimumDeterminant = VTK_DOUBLE_MAX;
+  double maximumDeterminant = VTK_DOUBLE_MIN;
+  vtkIdType numberOfFoldedPoints = 0;
+  double* origin = jacobianFilter->GetGridOrigin();
+  double* spacing = jacobianFilter->GetGridSpacing();
+  for (int k = 0; k <= 19; ++k)
+    {
+    for (int j = 0; j <= 24; ++j)
+      {
+      for (int i = 0; i <= 29; ++i)
+        {
+        double point[3] = { origin[0], origin[1], origin[2] };
+        int latticeIndex[3] = { i, j, k };
+        for (int row = 0; row < 3; ++row)
+          {
+          for (int col = 0; col < 3; ++col)
+            {
+            point[row] += latticeDirection->GetElement(row, col) * spacing[col] * latticeIndex[col];
+            }
+          }
+        double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+        double derivative[3][3];
+        transform->TransformDerivative(point, transformedPoint, derivative);
+        double expectedDeterminant = vtkMath::Determinant3x3(derivative);
+        CHECK_DOUBLE_TOLERANCE(jacobianDeterminant->GetScalarComponentAsDouble(i, j, k, 0), expectedDeterminant, 1e-6);
+        minimumDeterminant = std::min(minimumDeterminant, expectedDeterminant);
+        maximumDeterminant = std::max(maximumDeterminant, expectedDeterminant);
+        if (expectedDeterminant <= 0.0)
+          {
+          numberOfFoldedPoints++;
+          }
+        }
+      }
+    }
+  CHECK_DOUBLE_TOLERANCE(jacobianFilter->GetMinimumDeterminant(), minimumDeterminant, 1e-6);
+  CHECK_DOUBLE_TOLERANCE(jacobianFilter->GetMaximumDeterminant(), maximumDeterminant, 1e-6);
+  CHECK_INT(jacobianFilter->GetNumberOfFoldedPoints(), numberOfFoldedPoints);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int ConvertToGridTransformTest()
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(VTK_DOUBLE, true);
+
+  vtkNew<vtkOrientedGridTransform> coarseGridTransform;
+  double coarseSpacing[3] = { 4.0, 4.0, 4.0 };
+  double coarseError = -1.0;
+  CHECK_BOOL(transform->ConvertToGridTransform(coarseGridTransform, coarseSpacing, &coarseError), true);
+
+  vtkNew<vtkOrientedGridTransform> gridTransform;
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  double error = -1.0;
+  CHECK_BOOL(transform->ConvertToGridTransform(gridTransform, spacing, &error), true);
+  CHECK_BOOL(error > 0.0, true);
+  CHECK_BOOL(error < coarseError, true);
+
+  // The grid covers the coefficient grid: 8*4, 9*3, 6*5 mm
+  vtkImageData* displacementGrid = gridTransform->GetDisplacementGrid();
+  int* dimensions = displacementGrid->GetDimensions();
+  CHECK_INT(dimensions[0], 33);
+  CHECK_INT(dimensions[1], 28);
+  CHECK_INT(dimensions[2], 31);
+
+  // Grid points are exact, including the bulk transform
+  vtkMatrix4x4* gridDirection = gridTransform->GetGridDirectionMatrix();
+  double* origin = displacementGrid->GetOrigin();
+  for (int k = 0; k < dimensions[2]; k += 3)
+    {
+    for (int j = 0; j < dimensions[1]; j += 3)
+      {
+      for (int i = 0; i < dimensions[0]; i += 3)
+        {
+        double point[3] = { origin[0], origin[1], origin[2] };
+        int gridIndex[3] = { i, j, k };
+        for (int row = 0; row < 3; ++row)
+          {
+          for (int col = 0; col < 3; ++col)
+            {
+            point[row] += gridDirection->GetElement(row, col) * spacing[col] * gridIndex[col];
+            }
+          }
+        double splinePoint[3] = { 0.0, 0.0, 0.0 };
+        transform->TransformPoint(point, splinePoint);
+        double gridPoint[3] = { 0.0, 0.0, 0.0 };
+        gridTransform->TransformPoint(point, gridPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(gridPoint[c], splinePoint[c], 1e-6);
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TransformFileTest(const char* temporaryDirectory)
+{
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = CreateOrientedBSplineTransform(VTK_DOUBLE, true);
+
+  std::string filePath = std::string(temporaryDirectory) + "/vtkOrientedBSplineTransformTest1_Transform.xfm";
+  const char* fileName = filePath.c_str();
+  CHECK_BOOL(vtkOrientedTransformFile::WriteFile(fileName, transform), true);
+
+  vtkNew<vtkOrientedBSplineTransform> readTransform;
+  CHECK_BOOL(vtkOrientedTransformFile::ReadFile(fileName, readTransform), true);
+  CHECK_DOUBLE(readTransform->GetDisplacementScale(), 0.8);
+  CHECK_NOT_NULL(readTransform->GetBulkTransformMatrix());
+  CHECK_DOUBLE(readTransform->GetBulkTransformMatrix()->GetElement(0, 3), 2.0);
+
+  for (int k = 0; k < 5; ++k)
+    {
+    for (int j = 0; j < 6; ++j)
+      {
+      for (int i = 0; i < 7; ++i)
+        {
+        double point[3] = { -6.0 + 3.1 * i, -4.0 + 2.7 * j, -1.0 + 4.3 * k };
+        double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+        transform->TransformPoint(point, expectedPoint);
+        double outputPoint[3] = { 0.0, 0.0, 0.0 };
+        readTransform->TransformPoint(point, outputPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(outputPoint[c], expectedPoint[c], 1e-12);
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,1355 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkAddonTestingMacros.h"
+#include "vtkMappedDisplacementGrid.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+#include "vtkOrientedTimeVaryingGridTransform.h"
+#include "vtkOrientedTransformFile.h"
+#include "vtkOrientedTransformInverseStatistics.h"
+#include "vtkOrientedTransformResample.h"
+#include "vtkOrientedTransformToGrid.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+int TransformPointsTest(int gridScalarType, int pointDataType, int interpolationMode);
+int TransformToGridTest(int outputScalarType);
+int InverseGridTest(bool newtonRefinement);
+int InverseTransformPointsTest();
+int HierarchicalInverseTest();
+int AxisAlignedKernelTest(int gridScalarType, int interpolationMode);
+int CollapseTransformsTest();
+int MappedDisplacementGridTest(int gridScalarType, int interpolationMode, const char* temporaryDirectory);
+int CompactDisplacementGridTest(int storageType, int interpolationMode, int expectedScalarType);
+int CompareTransformPoints(vtkAbstractTransform* transform, vtkAbstractTransform* expectedTransform, double tolerance);
+int NoGridDirectionTest(int storageType);
+int BSplineInterpolationTest();
+int ResampleTest(int interpolationMode);
+int TransformFileTest(int gridScalarType, const char* temporaryDirectory);
+int CompactTransformFileTest(int storageType, const char* temporaryDirectory);
+int TimeVaryingGridTest(int interpolationMode);
+
+//----------------------------------------------------------------------------
+int vtkOrientedGridTransformTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char* temporaryDirectory = argv[1];
+
+  TESTING_OUTPUT_INIT();
+  CHECK_EXIT_SUCCESS(TransformPointsTest(VTK_DOUBLE, VTK_DOUBLE, VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(TransformPointsTest(VTK_FLOAT, VTK_DOUBLE, VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(TransformPointsTest(VTK_DOUBLE, VTK_FLOAT, VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(TransformPointsTest(VTK_SHORT, VTK_DOUBLE, VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(TransformPointsTest(VTK_DOUBLE, VTK_DOUBLE, VTK_CUBIC_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(TransformToGridTest(VTK_DOUBLE));
+  CHECK_EXIT_SUCCESS(TransformToGridTest(VTK_FLOAT));
+  CHECK_EXIT_SUCCESS(InverseGridTest(true));
+  CHECK_EXIT_SUCCESS(InverseGridTest(false));
+  CHECK_EXIT_SUCCESS(InverseTransformPointsTest());
+  CHECK_EXIT_SUCCESS(HierarchicalInverseTest());
+  CHECK_EXIT_SUCCESS(AxisAlignedKernelTest(VTK_FLOAT, VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(AxisAlignedKernelTest(VTK_SHORT, VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(AxisAlignedKernelTest(VTK_DOUBLE, VTK_NEAREST_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(CollapseTransformsTest());
+  CHECK_EXIT_SUCCESS(MappedDisplacementGridTest(VTK_DOUBLE, VTK_LINEAR_INTERPOLATION, temporaryDirectory));
+  CHECK_EXIT_SUCCESS(MappedDisplacementGridTest(VTK_FLOAT, VTK_LINEAR_INTERPOLATION, temporaryDirectory));
+  CHECK_EXIT_SUCCESS(MappedDisplacementGridTest(VTK_DOUBLE, VTK_NEAREST_INTERPOLATION, temporaryDirectory));
+  CHECK_EXIT_SUCCESS(CompactDisplacementGridTest(vtkOrientedGridTransform::FloatStorage, VTK_LINEAR_INTERPOLATION, VTK_FLOAT));
+  CHECK_EXIT_SUCCESS(CompactDisplacementGridTest(vtkOrientedGridTransform::HalfFloatStorage, VTK_LINEAR_INTERPOLATION, VTK_UNSIGNED_SHORT));
+  CHECK_EXIT_SUCCESS(CompactDisplacementGridTest(vtkOrientedGridTransform::HalfFloatStorage, VTK_NEAREST_INTERPOLATION, VTK_UNSIGNED_SHORT));
+  CHECK_EXIT_SUCCESS(CompactDisplacementGridTest(vtkOrientedGridTransform::ShortStorage, VTK_LINEAR_INTERPOLATION, VTK_SHORT));
+  CHECK_EXIT_SUCCESS(NoGridDirectionTest(vtkOrientedGridTransform::ShortStorage));
+  CHECK_EXIT_SUCCESS(NoGridDirectionTest(vtkOrientedGridTransform::HalfFloatStorage));
+  CHECK_EXIT_SUCCESS(BSplineInterpolationTest());
+  CHECK_EXIT_SUCCESS(ResampleTest(VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(ResampleTest(VTK_NEAREST_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(TransformFileTest(VTK_FLOAT, temporaryDirectory));
+  CHECK_EXIT_SUCCESS(TransformFileTest(VTK_SHORT, temporaryDirectory));
+  CHECK_EXIT_SUCCESS(CompactTransformFileTest(vtkOrientedGridTransform::ShortStorage, temporaryDirectory));
+  CHECK_EXIT_SUCCESS(CompactTransformFileTest(vtkOrientedGridTransform::HalfFloatStorage, temporaryDirectory));
+  CHECK_EXIT_SUCCESS(TimeVaryingGridTest(VTK_LINEAR_INTERPOLATION));
+  CHECK_EXIT_SUCCESS(TimeVaryingGridTest(VTK_CUBIC_INTERPOLATION));
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkOrientedGridTransform> CreateOrientedGridTransform(int gridScalarType)
+{
+  vtkNew<vtkImageData> grid;
+  grid->SetExtent(0, 9, 0, 11, 0, 7);
+  grid->SetSpacing(2.0, 1.5, 3.0);
+  grid->SetOrigin(-5.0, 3.0, 10.0);
+  grid->AllocateScalars(gridScalarType, 3);
+  for (int k = 0; k <= 7; ++k)
+    {
+    for (int j = 0; j <= 11; ++j)
+      {
+      for (int i = 0; i <= 9; ++i)
+        {
+        // smooth displacement field that is exactly representable in short grids
+        grid->SetScalarComponentFromDouble(i, j, k, 0, floor(8.0 * sin(0.3 * i + 0.2 * k)));
+        grid->SetScalarComponentFromDouble(i, j, k, 1, floor(6.0 * cos(0.4 * j)));
+        grid->SetScalarComponentFromDouble(i, j, k, 2, i - j + k);
+        }
+      }
+    }
+
+  // rotation around the Z axis
+  vtkNew<vtkMatrix4x4> gridDirection;
+  double angle = vtkMath::RadiansFromDegrees(30.0);
+  gridDirection->SetElement(0, 0, cos(angle));
+  gridDirection->SetElement(0, 1, -sin(angle));
+  gridDirection->SetElement(1, 0, sin(angle));
+  gridDirection->SetElement(1, 1, cos(angle));
+
+  vtkSmartPointer<vtkOrientedGridTransform> transform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+  transform->SetDisplacementGridData(grid);
+  transform->SetGridDirectionMatrix(gridDirection);
+  transform->SetDisplacementScale(0.5);
+  transform->SetDisplacementShift(0.1);
+  return transform;
+}
+
+//----------------------------------------------------------------------------
+void GridIndexToOutputPoint(const double gridIndex[3], double point[3])
+{
+  // geometry of the grid created in CreateOrientedGridTransform
+  double angle = vtkMath::RadiansFromDegrees(30.0);
+  double x = 2.0 * gridIndex[0];
+  double y = 1.5 * gridIndex[1];
+  point[0] = -5.0 + cos(angle) * x - sin(angle) * y;
+  point[1] = 3.0 + sin(angle) * x + cos(angle) * y;
+  point[2] = 10.0 + 3.0 * gridIndex[2];
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPoints> CreateTestPoints(int pointDataType)
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataType(pointDataType);
+  // a lattice that extends beyond the grid to test clamping at the border
+  for (int k = 0; k < 12; ++k)
+    {
+    for (int j = 0; j < 25; ++j)
+      {
+      for (int i = 0; i < 30; ++i)
+        {
+        double point[3] = { -20.0 + 1.3 * i, -5.0 + 1.1 * j, 2.0 + 2.9 * k };
+        points->InsertNextPoint(point);
+        }
+      }
+    }
+  return points;
+}
+
+//----------------------------------------------------------------------------
+int TransformPointsTest(int gridScalarType, int pointDataType, int interpolationMode)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(gridScalarType);
+  transform->SetInterpolationMode(interpolationMode);
+  vtkSmartPointer<vtkPoints> inputPoints = CreateTestPoints(pointDataType);
+
+  // Output is appended to existing points
+  vtkNew<vtkPoints> outputPoints;
+  outputPoints->SetDataType(pointDataType);
+  double firstPoint[3] = { 1.0, 2.0, 3.0 };
+  outputPoints->InsertNextPoint(firstPoint);
+  transform->TransformPoints(inputPoints, outputPoints);
+  CHECK_INT(outputPoints->GetNumberOfPoints(), inputPoints->GetNumberOfPoints() + 1);
+
+  double outputPoint[3] = { 0.0, 0.0, 0.0 };
+  outputPoints->GetPoint(0, outputPoint);
+  CHECK_DOUBLE(outputPoint[0], firstPoint[0]);
+
+  // Compare to single point evaluation
+  double tolerance = (pointDataType == VTK_FLOAT ? 1e-4 : 1e-9);
+  for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); ++pointId)
+    {
+    double inputPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(pointId, inputPoint);
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(inputPoint, expectedPoint);
+    outputPoints->GetPoint(pointId + 1, outputPoint);
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(outputPoint[i], expectedPoint[i], tolerance);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TransformToGridTest(int outputScalarType)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(VTK_FLOAT);
+
+  vtkNew<vtkMatrix4x4> outputDirection;
+  double angle = vtkMath::RadiansFromDegrees(-15.0);
+  outputDirection->SetElement(1, 1, cos(angle));
+  outputDirection->SetElement(1, 2, -sin(angle));
+  outputDirection->SetElement(2, 1, sin(angle));
+  outputDirection->SetElement(2, 2, cos(angle));
+
+  vtkNew<vtkOrientedTransformToGrid> transformToGrid;
+  transformToGrid->SetInput(transform);
+  transformToGrid->SetGridExtent(-2, 20, 0, 15, 1, 9);
+  transformToGrid->SetGridOrigin(-12.0, 0.0, 5.0);
+  transformToGrid->SetGridSpacing(1.2, 1.4, 2.5);
+  transformToGrid->SetGridDirectionMatrix(outputDirection);
+  transformToGrid->SetGridScalarType(outputScalarType);
+  transformToGrid->Update();
+
+  vtkImageData* displacementField = transformToGrid->GetOutput();
+  CHECK_INT(displacementField->GetScalarType(), outputScalarType);
+  CHECK_INT(displacementField->GetNumberOfScalarComponents(), 3);
+
+  double tolerance = (outputScalarType == VTK_FLOAT ? 1e-4 : 1e-9);
+  int* extent = displacementField->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        double gridIndex[3] = { i * 1.2, j * 1.4, k * 2.5 };
+        double point[3] = { -12.0, 0.0, 5.0 };
+        for (int row = 0; row < 3; ++row)
+          {
+          for (int col = 0; col < 3; ++col)
+            {
+            point[row] += outputDirection->GetElement(row, col) * gridIndex[col];
+            }
+          }
+        double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+        transform->TransformPoint(point, transformedPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(displacementField->GetScalarComponentAsDouble(i, j, k, c),
+            transformedPoint[c] - point[c], tolerance);
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int InverseGridTest(bool newtonRefinement)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(VTK_DOUBLE);
+  transform->SetDisplacementScale(0.1);
+
+  vtkSmartPointer<vtkOrientedGridTransform> inverseTransform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+  inverseTransform->DeepCopy(transform);
+  inverseTransform->UseInverseGridOn();
+  inverseTransform->SetInverseGridNewtonRefinement(newtonRefinement);
+  inverseTransform->Inverse();
+  inverseTransform->Update();
+  CHECK_NOT_NULL(inverseTransform->GetInverseGrid());
+
+  // Points inside the displacement grid
+  double tolerance = (newtonRefinement ? 1e-2 : 1e-1);
+  for (int k = 0; k < 5; ++k)
+    {
+    for (int j = 0; j < 6; ++j)
+      {
+      for (int i = 0; i < 7; ++i)
+        {
+        double gridIndex[3] = { 1.0 + 1.13 * i, 1.0 + 1.37 * j, 1.0 + 1.21 * k };
+        double point[3] = { 0.0, 0.0, 0.0 };
+        GridIndexToOutputPoint(gridIndex, point);
+        double inversePoint[3] = { 0.0, 0.0, 0.0 };
+        inverseTransform->TransformPoint(point, inversePoint);
+        double roundTripPoint[3] = { 0.0, 0.0, 0.0 };
+        transform->TransformPoint(inversePoint, roundTripPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(roundTripPoint[c], point[c], tolerance);
+          }
+        }
+      }
+    }
+
+  // Inverse grid is released when it is not used
+  inverseTransform->UseInverseGridOff();
+  inverseTransform->Update();
+  CHECK_NULL(inverseTransform->GetInverseGrid());
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int InverseTransformPointsTest()
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(VTK_DOUBLE);
+  transform->SetDisplacementScale(0.2);
+  vtkSmartPointer<vtkPoints> points = CreateTestPoints(VTK_DOUBLE);
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+
+  std::vector<double> inPoints(3 * numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    points->GetPoint(pointId, &inPoints[3 * pointId]);
+    }
+  std::vector<double> outPoints(3 * numberOfPoints);
+  int numberOfStatisticsEvents = 0;
+  vtkNew<vtkCallbackCommand> statisticsCallback;
+  statisticsCallback->SetClientData(&numberOfStatisticsEvents);
+  statisticsCallback->SetCallback([](vtkObject*, unsigned long, void* clientData, void*)
+    {
+    (*static_cast<int*>(clientData))++;
+    });
+  transform->AddObserver(vtkOrientedGridTransform::InverseStatisticsEvent, statisticsCallback);
+  transform->SetInverseStatisticsEventInterval(numberOfPoints / 2);
+  double meanIterations = transform->InverseTransformPoints(&inPoints[0], &outPoints[0], numberOfPoints);
+  CHECK_BOOL(meanIterations >= 1.0, true);
+
+  // Convergence statistics
+  vtkOrientedTransformInverseStatistics* statistics = transform->GetInverseStatistics();
+  CHECK_INT(statistics->GetNumberOfCalls(), numberOfPoints);
+  CHECK_INT(statistics->GetNumberOfFailures(), 0);
+  CHECK_DOUBLE_TOLERANCE(statistics->GetMeanNumberOfIterations(), meanIterations, 1e-9);
+  CHECK_BOOL(statistics->GetMaximumResidual() < 1e-2, true);
+  vtkIdType histogramTotal = 0;
+  for (int iterations = 0; iterations < vtkOrientedTransformInverseStatistics::NumberOfIterationHistogramBins; ++iterations)
+    {
+    histogramTotal += statistics->GetIterationHistogramCount(iterations);
+    }
+  CHECK_INT(histogramTotal, numberOfPoints);
+  CHECK_BOOL(numberOfStatisticsEvents > 0, true);
+  transform->ResetInverseStatistics();
+  CHECK_INT(statistics->GetNumberOfCalls(), 0);
+  CHECK_INT(statistics->GetNumberOfIterations(), 0);
+
+  // Compare to single point inverse
+  vtkAbstractTransform* inverseTransform = transform->GetInverse();
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    inverseTransform->TransformPoint(&inPoints[3 * pointId], expectedPoint);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(outPoints[3 * pointId + c], expectedPoint[c], 1e-2);
+      }
+    }
+  CHECK_INT(vtkOrientedGridTransform::SafeDownCast(inverseTransform)->GetInverseStatistics()->GetNumberOfCalls(),
+    numberOfPoints);
+
+  // In-place computation of the inverse of the inverse
+  std::vector<double> roundTripPoints(outPoints);
+  inverseTransform->Update();
+  CHECK_DOUBLE(vtkOrientedGridTransform::SafeDownCast(inverseTransform)->InverseTransformPoints(
+    &roundTripPoints[0], &roundTripPoints[0], numberOfPoints), 0.0);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(&outPoints[3 * pointId], expectedPoint);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(roundTripPoints[3 * pointId + c], expectedPoint[c], 1e-9);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int HierarchicalInverseTest()
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(VTK_DOUBLE);
+  transform->SetDisplacementScale(0.2);
+  transform->Update();
+  CHECK_NULL(transform->GetCoarseInverseTransform());
+
+  vtkSmartPointer<vtkOrientedGridTransform> hierarchicalTransform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+  hierarchicalTransform->DeepCopy(transform);
+  hierarchicalTransform->HierarchicalInverseOn();
+  hierarchicalTransform->Update();
+
+  // The coarse grid covers the 10x12x8 grid with every 4th sample
+  vtkOrientedGridTransform* coarseTransform = hierarchicalTransform->GetCoarseInverseTransform();
+  CHECK_NOT_NULL(coarseTransform);
+  int coarseExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  coarseTransform->GetDisplacementGrid()->GetExtent(coarseExtent);
+  CHECK_INT(coarseExtent[1], 3);
+  CHECK_INT(coarseExtent[3], 3);
+  CHECK_INT(coarseExtent[5], 2);
+  double coarseSpacing[3] = { 0.0, 0.0, 0.0 };
+  coarseTransform->GetDisplacementGrid()->GetSpacing(coarseSpacing);
+  CHECK_DOUBLE_TOLERANCE(coarseSpacing[0], 8.0, 1e-9);
+  CHECK_DOUBLE_TOLERANCE(coarseSpacing[1], 6.0, 1e-9);
+  CHECK_DOUBLE_TOLERANCE(coarseSpacing[2], 12.0, 1e-9);
+
+  // The coarse displacement is the mean displacement around the coarse grid point
+  double gridIndex[3] = { 4.0, 4.0, 4.0 };
+  double coarsePoint[3] = { 0.0, 0.0, 0.0 };
+  GridIndexToOutputPoint(gridIndex, coarsePoint);
+  double meanDisplacement[3] = { 0.0, 0.0, 0.0 };
+  for (int k = 2; k <= 6; ++k)
+    {
+    for (int j = 2; j <= 6; ++j)
+      {
+      for (int i = 2; i <= 6; ++i)
+        {
+        double boxIndex[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+        double boxPoint[3] = { 0.0, 0.0, 0.0 };
+        GridIndexToOutputPoint(boxIndex, boxPoint);
+        double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+        transform->TransformPoint(boxPoint, transformedPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          meanDisplacement[c] += (transformedPoint[c] - boxPoint[c]) / 125.0;
+          }
+        }
+      }
+    }
+  double transformedCoarsePoint[3] = { 0.0, 0.0, 0.0 };
+  coarseTransform->TransformPoint(coarsePoint, transformedCoarsePoint);
+  for (int c = 0; c < 3; ++c)
+    {
+    CHECK_DOUBLE_TOLERANCE(transformedCoarsePoint[c] - coarsePoint[c], meanDisplacement[c], 1e-6);
+    }
+
+  // Same inverse as without the coarse transform
+  vtkSmartPointer<vtkPoints> points = CreateTestPoints(VTK_DOUBLE);
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  std::vector<double> inPoints(3 * numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    points->GetPoint(pointId, &inPoints[3 * pointId]);
+    }
+  std::vector<double> outPoints(3 * numberOfPoints);
+  std::vector<double> hierarchicalOutPoints(3 * numberOfPoints);
+  transform->InverseTransformPoints(&inPoints[0], &outPoints[0], numberOfPoints);
+  hierarchicalTransform->InverseTransformPoints(&inPoints[0], &hierarchicalOutPoints[0], numberOfPoints);
+  CHECK_INT(hierarchicalTransform->GetInverseStatistics()->GetNumberOfFailures(), 0);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(hierarchicalOutPoints[3 * pointId + c], outPoints[3 * pointId + c], 1e-2);
+      }
+    }
+
+  // Inverted transform
+  vtkOrientedGridTransform* inverseTransform = vtkOrientedGridTransform::SafeDownCast(hierarchicalTransform->GetInverse());
+  CHECK_NOT_NULL(inverseTransform);
+  CHECK_BOOL(inverseTransform->GetHierarchicalInverse(), true);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; pointId += 13)
+    {
+    double inversePoint[3] = { 0.0, 0.0, 0.0 };
+    inverseTransform->TransformPoint(&inPoints[3 * pointId], inversePoint);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(inversePoint[c], outPoints[3 * pointId + c], 1e-2);
+      }
+    }
+  CHECK_INT(inverseTransform->GetInverseStatistics()->GetNumberOfFailures(), 0);
+
+  hierarchicalTransform->HierarchicalInverseOff();
+  hierarchicalTransform->Update();
+  CHECK_NULL(hierarchicalTransform->GetCoarseInverseTransform());
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int AxisAlignedKernelTest(int gridScalarType, int interpolationMode)
+{
+  // With identity grid direction the oriented transform must give the
+  // same results as vtkGridTransform
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(gridScalarType);
+  vtkNew<vtkMatrix4x4> identity;
+  transform->SetGridDirectionMatrix(identity);
+  transform->SetInterpolationMode(interpolationMode);
+
+  vtkNew<vtkGridTransform> referenceTransform;
+  referenceTransform->SetDisplacementGridData(transform->GetDisplacementGrid());
+  referenceTransform->SetDisplacementScale(transform->GetDisplacementScale());
+  referenceTransform->SetDisplacementShift(transform->GetDisplacementShift());
+  referenceTransform->SetInterpolationMode(interpolationMode);
+
+  transform->Update();
+  referenceTransform->Update();
+  vtkSmartPointer<vtkPoints> points = CreateTestPoints(VTK_DOUBLE);
+  for (vtkIdType pointId = 0; pointId < points->GetNumberOfPoints(); ++pointId)
+    {
+    double point[3] = { 0.0, 0.0, 0.0 };
+    points->GetPoint(pointId, point);
+    double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    double derivative[3][3];
+    double expectedDerivative[3][3];
+    transform->InternalTransformDerivative(point, transformedPoint, derivative);
+    referenceTransform->InternalTransformDerivative(point, expectedPoint, expectedDerivative);
+    for (int row = 0; row < 3; ++row)
+      {
+      CHECK_DOUBLE_TOLERANCE(transformedPoint[row], expectedPoint[row], 1e-9);
+      for (int col = 0; col < 3; ++col)
+        {
+        CHECK_DOUBLE_TOLERANCE(derivative[row][col], expectedDerivative[row][col], 1e-9);
+        }
+      }
+    transform->InternalTransformPoint(point, transformedPoint);
+    for (int row = 0; row < 3; ++row)
+      {
+      CHECK_DOUBLE_TOLERANCE(transformedPoint[row], expectedPoint[row], 1e-9);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int CollapseTransformsTest()
+{
+  vtkSmartPointer<vtkOrientedGridTransform> gridTransform = CreateOrientedGridTransform(VTK_DOUBLE);
+
+  // Similarity pre-transform and general affine post-transform
+  vtkNew<vtkTransform> preTransform;
+  preTransform->Translate(3.0, -2.0, 1.0);
+  preTransform->RotateX(20.0);
+  preTransform->Scale(1.2, 1.2, 1.2);
+  vtkNew<vtkMatrix4x4> postMatrix;
+  postMatrix->SetElement(0, 1, 0.3);
+  postMatrix->SetElement(1, 1, 0.8);
+  postMatrix->SetElement(2, 0, -0.2);
+  postMatrix->SetElement(1, 3, 4.0);
+  vtkNew<vtkTransform> postTransform;
+  postTransform->SetMatrix(postMatrix);
+
+  vtkNew<vtkGeneralTransform> chain;
+  chain->PostMultiply();
+  chain->Concatenate(preTransform);
+  chain->Concatenate(gridTransform);
+  chain->Concatenate(postTransform);
+
+  vtkNew<vtkOrientedGridTransform> collapsedTransform;
+  CHECK_BOOL(collapsedTransform->CollapseTransforms(chain), true);
+
+  // Compare to the chain within the grid
+  vtkAbstractTransform* preInverse = preTransform->GetInverse();
+  for (int k = 0; k < 7; ++k)
+    {
+    for (int j = 0; j < 11; ++j)
+      {
+      for (int i = 0; i < 9; ++i)
+        {
+        double gridIndex[3] = { i + 0.3, j + 0.6, k + 0.5 };
+        double gridPoint[3] = { 0.0, 0.0, 0.0 };
+        GridIndexToOutputPoint(gridIndex, gridPoint);
+        double point[3] = { 0.0, 0.0, 0.0 };
+        preInverse->TransformPoint(gridPoint, point);
+        double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+        chain->TransformPoint(point, expectedPoint);
+        double collapsedPoint[3] = { 0.0, 0.0, 0.0 };
+        collapsedTransform->TransformPoint(point, collapsedPoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(collapsedPoint[c], expectedPoint[c], 1e-6);
+          }
+        }
+      }
+    }
+
+  // Outside the grid, the displacement of the chain at the grid border is extended
+  for (int j = 0; j < 11; ++j)
+    {
+    double gridIndex[3] = { 13.0, j + 0.6, 2.5 };
+    double borderGridIndex[3] = { 9.0, j + 0.6, 2.5 };
+    double gridPoint[3] = { 0.0, 0.0, 0.0 };
+    GridIndexToOutputPoint(gridIndex, gridPoint);
+    double point[3] = { 0.0, 0.0, 0.0 };
+    preInverse->TransformPoint(gridPoint, point);
+    GridIndexToOutputPoint(borderGridIndex, gridPoint);
+    double borderPoint[3] = { 0.0, 0.0, 0.0 };
+    preInverse->TransformPoint(gridPoint, borderPoint);
+    double expectedBorderPoint[3] = { 0.0, 0.0, 0.0 };
+    chain->TransformPoint(borderPoint, expectedBorderPoint);
+    double collapsedPoint[3] = { 0.0, 0.0, 0.0 };
+    collapsedTransform->TransformPoint(point, collapsedPoint);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(collapsedPoint[c] - point[c], expectedBorderPoint[c] - borderPoint[c], 1e-6);
+      }
+    }
+
+  // Chains of translations and a grid transform are identical everywhere,
+  // including outside the grid and with B-spline interpolation
+  for (int bsplineInterpolation = 0; bsplineInterpolation < 2; ++bsplineInterpolation)
+    {
+    gridTransform->SetBSplineInterpolation(bsplineInterpolation != 0);
+    vtkNew<vtkTransform> preTranslation;
+    preTranslation->Translate(3.0, -2.0, 1.0);
+    vtkNew<vtkTransform> postTranslation;
+    postTranslation->Translate(-1.0, 0.5, 2.0);
+    vtkNew<vtkGeneralTransform> translationChain;
+    translationChain->PostMultiply();
+    translationChain->Concatenate(preTranslation);
+    translationChain->Concatenate(gridTransform);
+    translationChain->Concatenate(postTranslation);
+    vtkNew<vtkOrientedGridTransform> collapsedTranslationTransform;
+    CHECK_BOOL(collapsedTranslationTransform->CollapseTransforms(translationChain), true);
+    CHECK_EXIT_SUCCESS(CompareTransformPoints(collapsedTranslationTransform, translationChain, 1e-6));
+    }
+  gridTransform->SetBSplineInterpolation(false);
+
+  // Chains with more than one grid transform cannot be collapsed
+  chain->Concatenate(gridTransform);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(collapsedTransform->CollapseTransforms(chain), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int MappedDisplacementGridTest(int gridScalarType, int interpolationMode, const char* temporaryDirectory)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(gridScalarType);
+  transform->SetInterpolationMode(interpolationMode);
+
+  // Small bricks, so that interpolation crosses many brick boundaries
+  std::string filePath = std::string(temporaryDirectory) + "/vtkOrientedGridTransformTest1_MappedGrid.grid";
+  const char* fileName = filePath.c_str();
+  CHECK_BOOL(vtkMappedDisplacementGrid::WriteFile(fileName, transform->GetDisplacementGrid(),
+    transform->GetGridDirectionMatrix(), 4), true);
+
+  vtkNew<vtkMappedDisplacementGrid> mappedGrid;
+  CHECK_BOOL(mappedGrid->Open(fileName), true);
+  CHECK_INT(mappedGrid->GetScalarType(), gridScalarType);
+  CHECK_INT(mappedGrid->GetBrickSize(), 4);
+  vtkNew<vtkMatrix4x4> gridDirection;
+  mappedGrid->GetDirectionMatrix(gridDirection);
+  CHECK_DOUBLE_TOLERANCE(gridDirection->GetElement(1, 0), transform->GetGridDirectionMatrix()->GetElement(1, 0), 1e-12);
+
+  // The mapped grid transform has no displacement grid image
+  vtkNew<vtkOrientedGridTransform> mappedTransform;
+  mappedTransform->SetMappedDisplacementGrid(mappedGrid);
+  mappedTransform->SetGridDirectionMatrix(gridDirection);
+  mappedTransform->SetInterpolationMode(interpolationMode);
+  mappedTransform->SetDisplacementScale(0.5);
+  mappedTransform->SetDisplacementShift(0.1);
+
+  vtkSmartPointer<vtkPoints> inputPoints = CreateTestPoints(VTK_DOUBLE);
+  vtkNew<vtkPoints> expectedPoints;
+  transform->TransformPoints(inputPoints, expectedPoints);
+  vtkNew<vtkPoints> outputPoints;
+  mappedTransform->TransformPoints(inputPoints, outputPoints);
+  CHECK_INT(outputPoints->GetNumberOfPoints(), inputPoints->GetNumberOfPoints());
+  for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); ++pointId)
+    {
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    expectedPoints->GetPoint(pointId, expectedPoint);
+    double outputPoint[3] = { 0.0, 0.0, 0.0 };
+    outputPoints->GetPoint(pointId, outputPoint);
+    double inputPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(pointId, inputPoint);
+    double singlePoint[3] = { 0.0, 0.0, 0.0 };
+    mappedTransform->TransformPoint(inputPoint, singlePoint);
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(outputPoint[i], expectedPoint[i], 1e-9);
+      CHECK_DOUBLE_TOLERANCE(singlePoint[i], expectedPoint[i], 1e-9);
+      }
+    }
+
+  // A cache of less than one brick keeps at most one brick resident
+  mappedGrid->SetCacheSize(0);
+  mappedGrid->TrimCache();
+  CHECK_BOOL(mappedGrid->GetNumberOfCachedBricks() <= 1, true);
+  double point[3] = { 0.0, 5.0, 15.0 };
+  double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+  mappedTransform->TransformPoint(point, transformedPoint);
+  double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+  transform->TransformPoint(point, expectedPoint);
+  CHECK_DOUBLE_TOLERANCE(transformedPoint[0], expectedPoint[0], 1e-9);
+
+  // Without an open grid the transform is identity
+  mappedGrid->Close();
+  mappedTransform->TransformPoint(point, transformedPoint);
+  CHECK_DOUBLE_TOLERANCE(transformedPoint[0], point[0], 1e-12);
+
+  std::remove(fileName);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int CompactDisplacementGridTest(int storageType, int interpolationMode, int expectedScalarType)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> referenceTransform = CreateOrientedGridTransform(VTK_DOUBLE);
+  referenceTransform->SetInterpolationMode(interpolationMode);
+
+  // Add a fractional part to the displacements, so that they are not exactly representable
+  vtkImageData* referenceGrid = referenceTransform->GetDisplacementGrid();
+  for (vtkIdType valueId = 0; valueId < 3 * referenceGrid->GetNumberOfPoints(); ++valueId)
+    {
+    static_cast<double*>(referenceGrid->GetScalarPointer())[valueId] += 0.01 * sin(0.7 * valueId);
+    }
+  referenceGrid->Modified();
+
+  vtkNew<vtkOrientedGridTransform> transform;
+  transform->SetGridDirectionMatrix(referenceTransform->GetGridDirectionMatrix());
+  transform->SetInterpolationMode(interpolationMode);
+  transform->SetDisplacementScale(0.5);
+  transform->SetDisplacementShift(0.1);
+  double maximumError = -1.0;
+  CHECK_BOOL(transform->SetCompactDisplacementGrid(referenceGrid, storageType, &maximumError), true);
+  CHECK_INT(transform->GetDisplacementGrid()->GetScalarType(), expectedScalarType);
+  CHECK_BOOL(transform->GetHalfFloatGrid(), storageType == vtkOrientedGridTransform::HalfFloatStorage);
+  CHECK_BOOL(maximumError >= 0.0 && maximumError < 2e-2, true);
+
+  // Interpolation does not increase the error of the samples
+  double transformError = transform->ComputeMaximumDisplacementError(referenceTransform);
+  CHECK_BOOL(transformError >= 0.0, true);
+  CHECK_BOOL(transformError <= 0.5 * maximumError + 1e-9, true);
+
+  // Batch and single point evaluation are consistent
+  vtkSmartPointer<vtkPoints> inputPoints = CreateTestPoints(VTK_DOUBLE);
+  vtkNew<vtkPoints> outputPoints;
+  transform->TransformPoints(inputPoints, outputPoints);
+  for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); ++pointId)
+    {
+    double inputPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(pointId, inputPoint);
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    referenceTransform->TransformPoint(inputPoint, expectedPoint);
+    double singlePoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(inputPoint, singlePoint);
+    double outputPoint[3] = { 0.0, 0.0, 0.0 };
+    outputPoints->GetPoint(pointId, outputPoint);
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(outputPoint[i], singlePoint[i], 1e-9);
+      CHECK_DOUBLE_TOLERANCE(singlePoint[i], expectedPoint[i], 0.5 * maximumError + 1e-9);
+      }
+    }
+
+  // The inverse uses the same storage
+  double point[3] = { 2.0, 8.0, 20.0 };
+  double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+  transform->TransformPoint(point, transformedPoint);
+  double inversePoint[3] = { 0.0, 0.0, 0.0 };
+  transform->GetInverse()->TransformPoint(transformedPoint, inversePoint);
+  if (interpolationMode == VTK_LINEAR_INTERPOLATION)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(inversePoint[i], point[i], 1e-2);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int NoGridDirectionTest(int storageType)
+{
+  // Axis-aligned reference grid
+  vtkSmartPointer<vtkOrientedGridTransform> referenceTransform = CreateOrientedGridTransform(VTK_DOUBLE);
+  vtkNew<vtkMatrix4x4> identity;
+  referenceTransform->SetGridDirectionMatrix(identity);
+
+  // Without grid direction, the component scale and shift and the half-float
+  // values are decoded the same way as with an identity grid direction
+  vtkNew<vtkOrientedGridTransform> transform;
+  transform->SetDisplacementScale(0.5);
+  transform->SetDisplacementShift(0.1);
+  double maximumError = -1.0;
+  CHECK_BOOL(transform->SetCompactDisplacementGrid(referenceTransform->GetDisplacementGrid(), storageType, &maximumError), true);
+  CHECK_NULL(transform->GetGridDirectionMatrix());
+  transform->Update();
+
+  // Single point and line evaluation are consistent
+  double start[3] = { -4.0, 3.5, 11.0 };
+  double step[3] = { 0.7, 0.3, 0.4 };
+  const int numberOfPoints = 20;
+  double displacements[3 * numberOfPoints];
+  CHECK_BOOL(transform->EvaluateDisplacementsAlongLine(start, step, numberOfPoints, displacements), true);
+  for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+    double point[3] = { start[0] + pointIndex * step[0], start[1] + pointIndex * step[1], start[2] + pointIndex * step[2] };
+    double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(point, transformedPoint);
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    referenceTransform->TransformPoint(point, expectedPoint);
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(transformedPoint[i], point[i] + displacements[3 * pointIndex + i], 1e-9);
+      CHECK_DOUBLE_TOLERANCE(transformedPoint[i], expectedPoint[i], 0.5 * maximumError + 1e-9);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void SmoothDisplacement(const double point[3], double displacement[3])
+{
+  displacement[0] = 3.0 * sin(0.05 * point[0] + 0.03 * point[2]);
+  displacement[1] = 2.0 * cos(0.04 * point[1]) * sin(0.02 * point[0]);
+  displacement[2] = 1.5 * sin(0.03 * (point[0] - point[1] + point[2]));
+}
+
+//----------------------------------------------------------------------------
+int BSplineInterpolationTest()
+{
+  // Coarse (4mm) oblique grid of a smooth displacement field
+  vtkNew<vtkMatrix4x4> gridDirection;
+  double angle = vtkMath::RadiansFromDegrees(20.0);
+  gridDirection->SetElement(0, 0, cos(angle));
+  gridDirection->SetElement(0, 2, sin(angle));
+  gridDirection->SetElement(2, 0, -sin(angle));
+  gridDirection->SetElement(2, 2, cos(angle));
+  double gridOrigin[3] = { -10.0, 5.0, 0.0 };
+  double gridSpacing = 4.0;
+  vtkNew<vtkImageData> grid;
+  grid->SetExtent(0, 15, 0, 12, 0, 10);
+  grid->SetSpacing(gridSpacing, gridSpacing, gridSpacing);
+  grid->SetOrigin(gridOrigin);
+  grid->AllocateScalars(VTK_DOUBLE, 3);
+  for (int k = 0; k <= 10; ++k)
+    {
+    for (int j = 0; j <= 12; ++j)
+      {
+      for (int i = 0; i <= 15; ++i)
+        {
+        double point[3] = { 0.0, 0.0, 0.0 };
+        for (int row = 0; row < 3; ++row)
+          {
+          point[row] = gridOrigin[row] + gridSpacing * (gridDirection->GetElement(row, 0) * i
+            + gridDirection->GetElement(row, 1) * j + gridDirection->GetElement(row, 2) * k);
+          }
+        double displacement[3] = { 0.0, 0.0, 0.0 };
+        SmoothDisplacement(point, displacement);
+        for (int c = 0; c < 3; ++c)
+          {
+          grid->SetScalarComponentFromDouble(i, j, k, c, displacement[c]);
+          }
+        }
+      }
+    }
+
+  vtkNew<vtkOrientedGridTransform> linearTransform;
+  linearTransform->SetDisplacementGridData(grid);
+  linearTransform->SetGridDirectionMatrix(gridDirection);
+  linearTransform->SetInterpolationModeToLinear();
+  vtkNew<vtkOrientedGridTransform> transform;
+  transform->SetDisplacementGridData(grid);
+  transform->SetGridDirectionMatrix(gridDirection);
+  transform->BSplineInterpolationOn();
+
+  // Compare to the analytic field within the grid
+  double linearError = 0.0;
+  double bsplineError = 0.0;
+  vtkNew<vtkPoints> inputPoints;
+  for (int k = 0; k < 10; ++k)
+    {
+    for (int j = 0; j < 12; ++j)
+      {
+      for (int i = 0; i < 15; ++i)
+        {
+        double gridIndex[3] = { i + 0.37, j + 0.61, k + 0.5 };
+        double point[3] = { 0.0, 0.0, 0.0 };
+        for (int row = 0; row < 3; ++row)
+          {
+          point[row] = gridOrigin[row] + gridSpacing * (gridDirection->GetElement(row, 0) * gridIndex[0]
+            + gridDirection->GetElement(row, 1) * gridIndex[1] + gridDirection->GetElement(row, 2) * gridIndex[2]);
+          }
+        inputPoints->InsertNextPoint(point);
+        double expectedDisplacement[3] = { 0.0, 0.0, 0.0 };
+        SmoothDisplacement(point, expectedDisplacement);
+        double linearPoint[3] = { 0.0, 0.0, 0.0 };
+        linearTransform->TransformPoint(point, linearPoint);
+        double bsplinePoint[3] = { 0.0, 0.0, 0.0 };
+        transform->TransformPoint(point, bsplinePoint);
+        for (int c = 0; c < 3; ++c)
+          {
+          linearError = std::max(linearError, fabs(linearPoint[c] - point[c] - expectedDisplacement[c]));
+          bsplineError = std::max(bsplineError, fabs(bsplinePoint[c] - point[c] - expectedDisplacement[c]));
+          }
+        }
+      }
+    }
+  CHECK_BOOL(bsplineError < 0.25 * linearError, true);
+
+  // The B-spline interpolates the grid samples
+  double gridPoint[3] = { gridOrigin[0], gridOrigin[1], gridOrigin[2] };
+  for (int row = 0; row < 3; ++row)
+    {
+    gridPoint[row] += gridSpacing * (5 * gridDirection->GetElement(row, 0) + 7 * gridDirection->GetElement(row, 1)
+      + 3 * gridDirection->GetElement(row, 2));
+    }
+  double transformedGridPoint[3] = { 0.0, 0.0, 0.0 };
+  transform->TransformPoint(gridPoint, transformedGridPoint);
+  for (int c = 0; c < 3; ++c)
+    {
+    CHECK_DOUBLE_TOLERANCE(transformedGridPoint[c] - gridPoint[c], grid->GetScalarComponentAsDouble(5, 7, 3, c), 1e-9);
+    }
+
+  // Batch and single point evaluation are consistent
+  vtkNew<vtkPoints> outputPoints;
+  transform->TransformPoints(inputPoints, outputPoints);
+  for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); pointId += 7)
+    {
+    double inputPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(pointId, inputPoint);
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(inputPoint, expectedPoint);
+    double outputPoint[3] = { 0.0, 0.0, 0.0 };
+    outputPoints->GetPoint(pointId, outputPoint);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(outputPoint[c], expectedPoint[c], 1e-9);
+      }
+    }
+
+  // Analytic derivative, compared to central differences
+  double point[3] = { 8.3, 21.7, 14.2 };
+  double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+  double derivative[3][3];
+  transform->TransformDerivative(point, transformedPoint, derivative);
+  const double delta = 1e-4;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    double pointPlus[3] = { point[0], point[1], point[2] };
+    double pointMinus[3] = { point[0], point[1], point[2] };
+    pointPlus[axis] += delta;
+    pointMinus[axis] -= delta;
+    double transformedPlus[3] = { 0.0, 0.0, 0.0 };
+    double transformedMinus[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(pointPlus, transformedPlus);
+    transform->TransformPoint(pointMinus, transformedMinus);
+    for (int c = 0; c < 3; ++c)
+      {
+      CHECK_DOUBLE_TOLERANCE(derivative[c][axis], (transformedPlus[c] - transformedMinus[c]) / (2.0 * delta), 1e-6);
+      }
+    }
+
+  // The inverse derivative is the inverse of the forward derivative
+  transform->SetInverseTolerance(1e-6);
+  double inversePoint[3] = { 0.0, 0.0, 0.0 };
+  double inverseDerivative[3][3];
+  transform->GetInverse()->TransformDerivative(transformedPoint, inversePoint, inverseDerivative);
+  double product[3][3];
+  vtkMath::Multiply3x3(derivative, inverseDerivative, product);
+  for (int row = 0; row < 3; ++row)
+    {
+    CHECK_DOUBLE_TOLERANCE(inversePoint[row], point[row], 1e-4);
+    for (int col = 0; col < 3; ++col)
+      {
+      CHECK_DOUBLE_TOLERANCE(product[row][col], (row == col ? 1.0 : 0.0), 1e-4);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int ResampleTest(int interpolationMode)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(VTK_FLOAT);
+
+  vtkNew<vtkImageData> image;
+  image->SetExtent(0, 24, 0, 19, 0, 14);
+  image->SetSpacing(1.5, 1.5, 2.0);
+  image->SetOrigin(-15.0, -5.0, 5.0);
+  image->AllocateScalars(VTK_DOUBLE, 2);
+  for (int k = 0; k <= 14; ++k)
+    {
+    for (int j = 0; j <= 19; ++j)
+      {
+      for (int i = 0; i <= 24; ++i)
+        {
+        image->SetScalarComponentFromDouble(i, j, k, 0, 2.0 * i + 3.0 * j - k);
+        image->SetScalarComponentFromDouble(i, j, k, 1, 10.0 * sin(0.2 * i) * cos(0.3 * k));
+        }
+      }
+    }
+
+  vtkNew<vtkMatrix4x4> outputDirection;
+  double angle = vtkMath::RadiansFromDegrees(20.0);
+  outputDirection->SetElement(0, 0, cos(angle));
+  outputDirection->SetElement(0, 2, sin(angle));
+  outputDirection->SetElement(2, 0, -sin(angle));
+  outputDirection->SetElement(2, 2, cos(angle));
+
+  // Row evaluation of the grid transform
+  vtkNew<vtkOrientedTransformResample> resample;
+  resample->SetInputData(image);
+  resample->SetTransform(transform);
+  resample->SetOutputExtent(-3, 30, 0, 18, 2, 12);
+  resample->SetOutputOrigin(-10.0, -2.0, 4.0);
+  resample->SetOutputSpacing(0.9, 1.3, 1.7);
+  resample->SetOutputDirectionMatrix(outputDirection);
+  resample->SetInterpolationMode(interpolationMode);
+  resample->SetBackgroundValue(-100.0);
+  resample->Update();
+  vtkImageData* output = resample->GetOutput();
+  CHECK_INT(output->GetScalarType(), VTK_DOUBLE);
+  CHECK_INT(output->GetNumberOfScalarComponents(), 2);
+
+  // Point by point evaluation of the same transform
+  vtkNew<vtkGeneralTransform> generalTransform;
+  generalTransform->Concatenate(transform);
+  vtkNew<vtkOrientedTransformResample> referenceResample;
+  referenceResample->SetInputData(image);
+  referenceResample->SetTransform(generalTransform);
+  referenceResample->SetOutputExtent(-3, 30, 0, 18, 2, 12);
+  referenceResample->SetOutputOrigin(-10.0, -2.0, 4.0);
+  referenceResample->SetOutputSpacing(0.9, 1.3, 1.7);
+  referenceResample->SetOutputDirectionMatrix(outputDirection);
+  referenceResample->SetInterpolationMode(interpolationMode);
+  referenceResample->SetBackgroundValue(-100.0);
+  referenceResample->Update();
+  vtkImageData* referenceOutput = referenceResample->GetOutput();
+
+  int* extent = output->GetExtent();
+  int numberOfBackgroundVoxels = 0;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        for (int c = 0; c < 2; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(output->GetScalarComponentAsDouble(i, j, k, c),
+            referenceOutput->GetScalarComponentAsDouble(i, j, k, c), 1e-6);
+          }
+        if (output->GetScalarComponentAsDouble(i, j, k, 0) == -100.0)
+          {
+          numberOfBackgroundVoxels++;
+          }
+        }
+      }
+    }
+  // The output extends beyond the input image
+  CHECK_BOOL(numberOfBackgroundVoxels > 0, true);
+
+  // Parallel evaluation of the inverse in thread-safe mode
+  vtkNew<vtkOrientedGridTransform> inverseTransform;
+  inverseTransform->DeepCopy(transform);
+  inverseTransform->Inverse();
+  inverseTransform->SetThreadSafeEvaluation(true);
+  resample->SetTransform(inverseTransform);
+  resample->Update();
+  vtkNew<vtkGeneralTransform> generalInverseTransform;
+  generalInverseTransform->Concatenate(transform->GetInverse());
+  referenceResample->SetTransform(generalInverseTransform);
+  referenceResample->Update();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        for (int c = 0; c < 2; ++c)
+          {
+          CHECK_DOUBLE_TOLERANCE(resample->GetOutput()->GetScalarComponentAsDouble(i, j, k, c),
+            referenceResample->GetOutput()->GetScalarComponentAsDouble(i, j, k, c), 1e-6);
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TransformFileTest(int gridScalarType, const char* temporaryDirectory)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(gridScalarType);
+  transform->SetInterpolationMode(VTK_NEAREST_INTERPOLATION);
+
+  std::string filePath = std::string(temporaryDirectory) + "/vtkOrientedGridTransformTest1_Transform.xfm";
+  const char* fileName = filePath.c_str();
+  CHECK_BOOL(vtkOrientedTransformFile::WriteFile(fileName, transform), true);
+
+  vtkNew<vtkOrientedGridTransform> readTransform;
+  CHECK_BOOL(vtkOrientedTransformFile::ReadFile(fileName, readTransform), true);
+  CHECK_INT(readTransform->GetInterpolationMode(), VTK_NEAREST_INTERPOLATION);
+  CHECK_DOUBLE(readTransform->GetDisplacementScale(), 0.5);
+  CHECK_DOUBLE(readTransform->GetDisplacementShift(), 0.1);
+  CHECK_INT(readTransform->GetDisplacementGrid()->GetScalarType(), gridScalarType);
+
+  vtkSmartPointer<vtkPoints> inputPoints = CreateTestPoints(VTK_DOUBLE);
+  for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); ++pointId)
+    {
+    double inputPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(pointId, inputPoint);
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(inputPoint, expectedPoint);
+    double outputPoint[3] = { 0.0, 0.0, 0.0 };
+    readTransform->TransformPoint(inputPoint, outputPoint);
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(outputPoint[i], expectedPoint[i], 1e-12);
+      }
+    }
+
+  // The transform type must match
+  vtkNew<vtkOrientedBSplineTransform> bsplineTransform;
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  CHECK_BOOL(vtkOrientedTransformFile::ReadFile(fileName, bsplineTransform), false);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int CompactTransformFileTest(int storageType, const char* temporaryDirectory)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> referenceTransform = CreateOrientedGridTransform(VTK_DOUBLE);
+
+  // The component scale and shift of the quantized grid are not the defaults
+  vtkNew<vtkOrientedGridTransform> transform;
+  transform->SetGridDirectionMatrix(referenceTransform->GetGridDirectionMatrix());
+  transform->SetDisplacementScale(0.5);
+  transform->SetDisplacementShift(0.1);
+  CHECK_BOOL(transform->SetCompactDisplacementGrid(referenceTransform->GetDisplacementGrid(), storageType), true);
+  double componentScale[3] = { 0.0, 0.0, 0.0 };
+  transform->GetDisplacementComponentScale(componentScale);
+  if (storageType == vtkOrientedGridTransform::ShortStorage)
+    {
+    CHECK_BOOL(componentScale[0] != 1.0, true);
+    }
+
+  std::string filePath = std::string(temporaryDirectory) + "/vtkOrientedGridTransformTest1_CompactTransform.xfm";
+  const char* fileName = filePath.c_str();
+  CHECK_BOOL(vtkOrientedTransformFile::WriteFile(fileName, transform), true);
+
+  // Properties of the target transform that are stored in the file are replaced
+  vtkNew<vtkOrientedGridTransform> readTransform;
+  readTransform->SetBSplineInterpolation(true);
+  readTransform->SetHalfFloatGrid(storageType != vtkOrientedGridTransform::HalfFloatStorage);
+  readTransform->SetDisplacementComponentScale(2.0, 3.0, 4.0);
+  readTransform->SetDisplacementComponentShift(-1.0, 1.0, 2.0);
+  CHECK_BOOL(vtkOrientedTransformFile::ReadFile(fileName, readTransform), true);
+  CHECK_BOOL(readTransform->GetBSplineInterpolation(), false);
+  CHECK_BOOL(readTransform->GetHalfFloatGrid(), transform->GetHalfFloatGrid());
+  double readComponentScale[3] = { 0.0, 0.0, 0.0 };
+  readTransform->GetDisplacementComponentScale(readComponentScale);
+  double componentShift[3] = { 0.0, 0.0, 0.0 };
+  transform->GetDisplacementComponentShift(componentShift);
+  double readComponentShift[3] = { 0.0, 0.0, 0.0 };
+  readTransform->GetDisplacementComponentShift(readComponentShift);
+  for (int i = 0; i < 3; ++i)
+    {
+    CHECK_DOUBLE(readComponentScale[i], componentScale[i]);
+    CHECK_DOUBLE(readComponentShift[i], componentShift[i]);
+    }
+
+  vtkSmartPointer<vtkPoints> inputPoints = CreateTestPoints(VTK_DOUBLE);
+  for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); ++pointId)
+    {
+    double inputPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(pointId, inputPoint);
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(inputPoint, expectedPoint);
+    double outputPoint[3] = { 0.0, 0.0, 0.0 };
+    readTransform->TransformPoint(inputPoint, outputPoint);
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(outputPoint[i], expectedPoint[i], 1e-12);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> BlendPhaseGrids(vtkImageData* grid0, vtkImageData* grid1,
+  double weight0, double weight1, double shift1)
+{
+  // weight0 * grid0 + weight1 * (grid1 + shift1 * component)
+  vtkSmartPointer<vtkImageData> blendedGrid = vtkSmartPointer<vtkImageData>::New();
+  blendedGrid->DeepCopy(grid0);
+  int* extent = blendedGrid->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        for (int c = 0; c < 3; ++c)
+          {
+          double value = weight0 * grid0->GetScalarComponentAsDouble(i, j, k, c)
+            + weight1 * (grid1->GetScalarComponentAsDouble(i, j, k, c) + shift1 * c);
+          blendedGrid->SetScalarComponentFromDouble(i, j, k, c, value);
+          }
+        }
+      }
+    }
+  return blendedGrid;
+}
+
+//----------------------------------------------------------------------------
+int CompareTransformPoints(vtkAbstractTransform* transform, vtkAbstractTransform* expectedTransform, double tolerance)
+{
+  vtkSmartPointer<vtkPoints> inputPoints = CreateTestPoints(VTK_DOUBLE);
+  vtkNew<vtkPoints> outputPoints;
+  transform->TransformPoints(inputPoints, outputPoints);
+  CHECK_INT(outputPoints->GetNumberOfPoints(), inputPoints->GetNumberOfPoints());
+  for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); ++pointId)
+    {
+    double inputPoint[3] = { 0.0, 0.0, 0.0 };
+    inputPoints->GetPoint(pointId, inputPoint);
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    expectedTransform->TransformPoint(inputPoint, expectedPoint);
+    double outputPoint[3] = { 0.0, 0.0, 0.0 };
+    outputPoints->GetPoint(pointId, outputPoint);
+    double singlePoint[3] = { 0.0, 0.0, 0.0 };
+    transform->TransformPoint(inputPoint, singlePoint);
+    for (int i = 0; i < 3; ++i)
+      {
+      CHECK_DOUBLE_TOLERANCE(outputPoint[i], expectedPoint[i], tolerance);
+      CHECK_DOUBLE_TOLERANCE(singlePoint[i], expectedPoint[i], tolerance);
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TimeVaryingGridTest(int interpolationMode)
+{
+  vtkSmartPointer<vtkOrientedGridTransform> transform = CreateOrientedGridTransform(VTK_DOUBLE);
+  vtkImageData* grid = transform->GetDisplacementGrid();
+
+  // Three phases: the grid, the grid scaled by 2, and the grid shifted
+  vtkSmartPointer<vtkImageData> phaseGrids[3] =
+    {
+    BlendPhaseGrids(grid, grid, 1.0, 0.0, 0.0),
+    BlendPhaseGrids(grid, grid, 1.0, 1.0, 0.0),
+    BlendPhaseGrids(grid, grid, 0.0, 1.0, 1.5)
+    };
+
+  vtkNew<vtkOrientedTimeVaryingGridTransform> timeVaryingTransform;
+  for (int phase = 0; phase < 3; ++phase)
+    {
+    timeVaryingTransform->AddPhaseGrid(phaseGrids[phase]);
+    }
+  CHECK_INT(timeVaryingTransform->GetNumberOfPhases(), 3);
+  CHECK_POINTER(timeVaryingTransform->GetDisplacementGrid(), phaseGrids[0].GetPointer());
+  timeVaryingTransform->SetGridDirectionMatrix(transform->GetGridDirectionMatrix());
+  timeVaryingTransform->SetInterpolationMode(interpolationMode);
+  timeVaryingTransform->SetDisplacementScale(0.5);
+  timeVaryingTransform->SetDisplacementShift(0.1);
+
+  vtkNew<vtkOrientedGridTransform> expectedTransform;
+  expectedTransform->SetGridDirectionMatrix(transform->GetGridDirectionMatrix());
+  expectedTransform->SetInterpolationMode(interpolationMode);
+  expectedTransform->SetDisplacementScale(0.5);
+  expectedTransform->SetDisplacementShift(0.1);
+
+  // Time, phases and weight of the expected displacement; periodic times
+  // after the last phase blend the last and the first phase
+  struct
+    {
+    double Time;
+    int Phase0;
+    int Phase1;
+    double Weight1;
+    } timePoints[] =
+    {
+      { 0.0, 0, 0, 0.0 },
+      { 1.0, 1, 1, 0.0 },
+      { 0.25, 0, 1, 0.25 },
+      { 1.5, 1, 2, 0.5 },
+      { 2.75, 2, 0, 0.75 },
+      { -0.5, 2, 0, 0.5 },
+      { 4.0, 1, 1, 0.0 }
+    };
+  for (size_t timeIndex = 0; timeIndex < sizeof(timePoints) / sizeof(timePoints[0]); ++timeIndex)
+    {
+    timeVaryingTransform->SetTime(timePoints[timeIndex].Time);
+    expectedTransform->SetDisplacementGridData(BlendPhaseGrids(phaseGrids[timePoints[timeIndex].Phase0],
+      phaseGrids[timePoints[timeIndex].Phase1], 1.0 - timePoints[timeIndex].Weight1,
+      timePoints[timeIndex].Weight1, 0.0));
+    CHECK_EXIT_SUCCESS(CompareTransformPoints(timeVaryingTransform, expectedTransform, 1e-9));
+    }
+
+  // Non-periodic times are clamped to the phase range
+  timeVaryingTransform->PeriodicOff();
+  timeVaryingTransform->SetTime(2.75);
+  expectedTransform->SetDisplacementGridData(phaseGrids[2]);
+  CHECK_EXIT_SUCCESS(CompareTransformPoints(timeVaryingTransform, expectedTransform, 1e-9));
+
+  // Nearest phase
+  timeVaryingTransform->SetTimeInterpolationModeToNearestNeighbor();
+  timeVaryingTransform->SetTime(0.6);
+  expectedTransform->SetDisplacementGridData(phaseGrids[1]);
+  CHECK_EXIT_SUCCESS(CompareTransformPoints(timeVaryingTransform, expectedTransform, 1e-9));
+
+  // The inverse follows the time of the forward transform
+  timeVaryingTransform->SetTimeInterpolationModeToLinear();
+  timeVaryingTransform->SetTime(1.5);
+  expectedTransform->SetDisplacementGridData(BlendPhaseGrids(phaseGrids[1], phaseGrids[2], 0.5, 0.5, 0.0));
+  double point[3] = { 2.0, 8.0, 17.0 };
+  double inversePoint[3] = { 0.0, 0.0, 0.0 };
+  timeVaryingTransform->GetInverse()->TransformPoint(point, inversePoint);
+  double expectedInversePoint[3] = { 0.0, 0.0, 0.0 };
+  expectedTransform->GetInverse()->TransformPoint(point, expectedInversePoint);
+  for (int i = 0; i < 3; ++i)
+    {
+    CHECK_DOUBLE_TOLERANCE(inversePoint[i], expectedInversePoint[i], 1e-3);
+    }
+
+  // The inverse grid is not used by the forward transform, changing the time
+  // only changes the blending weight
+  timeVaryingTransform->UseInverseGridOn();
+  timeVaryingTransform->SetTime(0.25);
+  expectedTransform->SetDisplacementGridData(BlendPhaseGrids(phaseGrids[0], phaseGrids[1], 0.75, 0.25, 0.0));
+  CHECK_EXIT_SUCCESS(CompareTransformPoints(timeVaryingTransform, expectedTransform, 1e-9));
+  CHECK_NULL(timeVaryingTransform->GetInverseGrid());
+  timeVaryingTransform->UseInverseGridOff();
+
+  // A phase grid with a different extent is not used
+  vtkNew<vtkImageData> invalidGrid;
+  invalidGrid->SetExtent(0, 3, 0, 3, 0, 3);
+  invalidGrid->AllocateScalars(VTK_DOUBLE, 3);
+  timeVaryingTransform->AddPhaseGrid(invalidGrid);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  timeVaryingTransform->Update();
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
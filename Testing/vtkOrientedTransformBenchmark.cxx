@@ -0,0 +1,556 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Benchmark of the forward, derivative and inverse evaluation of
+// vtkOrientedGridTransform and vtkOrientedBSplineTransform.
+//
+// Usage:
+//   vtkAddonBenchmarks [--quick] [--output <file>] [--grid-sizes <n1,n2,...>]
+//     [--threads <n1,n2,...>] [--lattice-size <n>] [--repeats <n>]
+//
+// Each measurement is written as one JSON object per line (to the standard
+// output or to the output file), for example:
+//   {"transform": "grid", "operation": "inverse", "gridSize": 64, "scalarType": "float",
+//    "direction": "oblique", "bulk": false, "threads": 8, "points": 1000000,
+//    "seconds": 0.21, "pointsPerSecond": 4.7e+06, "meanIterations": 3.1}
+// seconds is the shortest time of the repeated runs. meanIterations is null
+// for operations that are not iterative.
+// threads is the number of threads requested by vtkSMPTools::Initialize,
+// the sequential SMP backend always uses a single thread.
+
+// vtkAddon includes
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Physical size of the displacement grids and of the evaluation lattice (mm)
+static const double BenchmarkGridSize = 200.0;
+static const double BenchmarkLatticeSize = 180.0;
+
+//----------------------------------------------------------------------------
+struct BenchmarkCase
+{
+  std::string Transform;
+  std::string Operation;
+  int GridSize;
+  int ScalarType;
+  bool Oblique;
+  bool Bulk;
+  int Threads;
+};
+
+//----------------------------------------------------------------------------
+void WriteResult(std::ostream& os, const BenchmarkCase& benchmarkCase, vtkIdType numberOfPoints,
+  double seconds, double meanIterations)
+{
+  os << "{\"transform\": \"" << benchmarkCase.Transform << "\""
+     << ", \"operation\": \"" << benchmarkCase.Operation << "\""
+     << ", \"gridSize\": " << benchmarkCase.GridSize
+     << ", \"scalarType\": \"" << vtkImageScalarTypeNameMacro(benchmarkCase.ScalarType) << "\""
+     << ", \"direction\": \"" << (benchmarkCase.Oblique ? "oblique" : "axis-aligned") << "\""
+     << ", \"bulk\": " << (benchmarkCase.Bulk ? "true" : "false")
+     << ", \"threads\": " << benchmarkCase.Threads
+     << ", \"points\": " << numberOfPoints
+     << ", \"seconds\": " << seconds
+     << ", \"pointsPerSecond\": " << (seconds > 0.0 ? numberOfPoints / seconds : 0.0)
+     << ", \"meanIterations\": ";
+  if (meanIterations >= 0.0)
+    {
+    os << meanIterations;
+    }
+  else
+    {
+    os << "null";
+    }
+  os << "}" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+// Shortest time of repeated runs of a function, in seconds
+template <class F>
+double MeasureSeconds(int repeats, F function)
+{
+  double bestSeconds = VTK_DOUBLE_MAX;
+  for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    bestSeconds = std::min(bestSeconds, elapsed.count());
+    }
+  return bestSeconds;
+}
+
+//----------------------------------------------------------------------------
+// Smooth displacement field with a magnitude of a few mm
+void BenchmarkDisplacement(const double point[3], double displacement[3])
+{
+  displacement[0] = 6.0 * sin(0.03 * point[0] + 0.02 * point[2]);
+  displacement[1] = 4.0 * cos(0.025 * point[1]) * sin(0.015 * point[0]);
+  displacement[2] = 5.0 * sin(0.02 * (point[0] - point[1] + point[2]));
+}
+
+//----------------------------------------------------------------------------
+void SetBenchmarkDirection(vtkMatrix4x4* direction, bool oblique)
+{
+  direction->Identity();
+  if (!oblique)
+    {
+    return;
+    }
+  // rotation by 30 degrees around the Z axis and by 10 degrees around the X axis
+  vtkNew<vtkMatrix4x4> rotationZ;
+  double angleZ = vtkMath::RadiansFromDegrees(30.0);
+  rotationZ->SetElement(0, 0, cos(angleZ));
+  rotationZ->SetElement(0, 1, -sin(angleZ));
+  rotationZ->SetElement(1, 0, sin(angleZ));
+  rotationZ->SetElement(1, 1, cos(angleZ));
+  vtkNew<vtkMatrix4x4> rotationX;
+  double angleX = vtkMath::RadiansFromDegrees(10.0);
+  rotationX->SetElement(1, 1, cos(angleX));
+  rotationX->SetElement(1, 2, -sin(angleX));
+  rotationX->SetElement(2, 1, sin(angleX));
+  rotationX->SetElement(2, 2, cos(angleX));
+  vtkMatrix4x4::Multiply4x4(rotationZ, rotationX, direction);
+}
+
+//----------------------------------------------------------------------------
+// Grid of gridSize^3 samples of BenchmarkDisplacement, centered at the
+// origin. Values are divided by valueScale before they are stored.
+template <class T>
+void FillBenchmarkGrid(vtkImageData* grid, vtkMatrix4x4* direction, double valueScale)
+{
+  int* dimensions = grid->GetDimensions();
+  double* origin = grid->GetOrigin();
+  double* spacing = grid->GetSpacing();
+  T* gridPtr = static_cast<T*>(grid->GetScalarPointer());
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        double index[3] = { i * spacing[0], j * spacing[1], k * spacing[2] };
+        double point[3] = { 0.0, 0.0, 0.0 };
+        for (int row = 0; row < 3; ++row)
+          {
+          point[row] = origin[row] + direction->GetElement(row, 0) * index[0]
+            + direction->GetElement(row, 1) * index[1] + direction->GetElement(row, 2) * index[2];
+          }
+        double displacement[3] = { 0.0, 0.0, 0.0 };
+        BenchmarkDisplacement(point, displacement);
+        for (int c = 0; c < 3; ++c)
+          {
+          *(gridPtr++) = static_cast<T>(displacement[c] / valueScale);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateBenchmarkGrid(int gridSize, int scalarType, vtkMatrix4x4* direction,
+  double valueScale)
+{
+  vtkSmartPointer<vtkImageData> grid = vtkSmartPointer<vtkImageData>::New();
+  grid->SetDimensions(gridSize, gridSize, gridSize);
+  double spacing = BenchmarkGridSize / (gridSize - 1);
+  grid->SetSpacing(spacing, spacing, spacing);
+  // the grid center is at the origin
+  double center[3] = { 0.5 * BenchmarkGridSize, 0.5 * BenchmarkGridSize, 0.5 * BenchmarkGridSize };
+  double rotatedCenter[3] = { 0.0, 0.0, 0.0 };
+  for (int row = 0; row < 3; ++row)
+    {
+    rotatedCenter[row] = direction->GetElement(row, 0) * center[0] + direction->GetElement(row, 1) * center[1]
+      + direction->GetElement(row, 2) * center[2];
+    }
+  grid->SetOrigin(-rotatedCenter[0], -rotatedCenter[1], -rotatedCenter[2]);
+  grid->AllocateScalars(scalarType, 3);
+  switch (scalarType)
+    {
+    case VTK_FLOAT: FillBenchmarkGrid<float>(grid, direction, valueScale); break;
+    case VTK_DOUBLE: FillBenchmarkGrid<double>(grid, direction, valueScale); break;
+    case VTK_SHORT: FillBenchmarkGrid<short>(grid, direction, valueScale); break;
+    default: return nullptr;
+    }
+  return grid;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkOrientedGridTransform> CreateBenchmarkGridTransform(int gridSize, int scalarType, bool oblique)
+{
+  vtkNew<vtkMatrix4x4> direction;
+  SetBenchmarkDirection(direction, oblique);
+  // short grids store the displacement in 0.01mm units
+  double valueScale = (scalarType == VTK_SHORT ? 0.01 : 1.0);
+  vtkSmartPointer<vtkImageData> grid = CreateBenchmarkGrid(gridSize, scalarType, direction, valueScale);
+  vtkSmartPointer<vtkOrientedGridTransform> transform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+  transform->SetDisplacementGridData(grid);
+  transform->SetGridDirectionMatrix(direction);
+  transform->SetDisplacementScale(valueScale);
+  transform->SetInterpolationModeToLinear();
+  return transform;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkOrientedBSplineTransform> CreateBenchmarkBSplineTransform(int gridSize, int scalarType,
+  bool oblique, bool bulk)
+{
+  vtkNew<vtkMatrix4x4> direction;
+  SetBenchmarkDirection(direction, oblique);
+  vtkSmartPointer<vtkImageData> coefficients = CreateBenchmarkGrid(gridSize, scalarType, direction, 1.0);
+  vtkSmartPointer<vtkOrientedBSplineTransform> transform = vtkSmartPointer<vtkOrientedBSplineTransform>::New();
+  transform->SetCoefficientData(coefficients);
+  transform->SetGridDirectionMatrix(direction);
+  if (bulk)
+    {
+    // rotation by 5 degrees around the Z axis and a translation
+    vtkNew<vtkMatrix4x4> bulkMatrix;
+    double angle = vtkMath::RadiansFromDegrees(5.0);
+    bulkMatrix->SetElement(0, 0, cos(angle));
+    bulkMatrix->SetElement(0, 1, -sin(angle));
+    bulkMatrix->SetElement(1, 0, sin(angle));
+    bulkMatrix->SetElement(1, 1, cos(angle));
+    bulkMatrix->SetElement(0, 3, 3.0);
+    bulkMatrix->SetElement(2, 3, -2.0);
+    transform->SetBulkTransformMatrix(bulkMatrix);
+    }
+  return transform;
+}
+
+//----------------------------------------------------------------------------
+// Scanline-ordered points of the evaluation lattice
+void CreateBenchmarkPoints(int latticeSize, std::vector<double>& points)
+{
+  double spacing = BenchmarkLatticeSize / (latticeSize - 1);
+  points.resize(3 * static_cast<size_t>(latticeSize) * latticeSize * latticeSize);
+  double* pointPtr = &points[0];
+  for (int k = 0; k < latticeSize; ++k)
+    {
+    for (int j = 0; j < latticeSize; ++j)
+      {
+      for (int i = 0; i < latticeSize; ++i)
+        {
+        *(pointPtr++) = -0.5 * BenchmarkLatticeSize + i * spacing;
+        *(pointPtr++) = -0.5 * BenchmarkLatticeSize + j * spacing;
+        *(pointPtr++) = -0.5 * BenchmarkLatticeSize + k * spacing;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+struct BenchmarkSettings
+{
+  std::vector<int> GridSizes;
+  std::vector<int> ThreadCounts;
+  int LatticeSize;
+  int Repeats;
+};
+
+//----------------------------------------------------------------------------
+void RunGridTransformBenchmarks(const BenchmarkSettings& settings, const std::vector<double>& points,
+  std::ostream& os)
+{
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(points.size() / 3);
+  vtkNew<vtkPoints> inputPoints;
+  inputPoints->SetDataTypeToDouble();
+  inputPoints->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    inputPoints->SetPoint(pointId, &points[3 * pointId]);
+    }
+  std::vector<double> outPoints(points.size());
+
+  double latticeOrigin[3] = { -0.5 * BenchmarkLatticeSize, -0.5 * BenchmarkLatticeSize, -0.5 * BenchmarkLatticeSize };
+  double latticeSpacing = BenchmarkLatticeSize / (settings.LatticeSize - 1);
+  double latticeSpacings[3] = { latticeSpacing, latticeSpacing, latticeSpacing };
+  int latticeDimensions[3] = { settings.LatticeSize, settings.LatticeSize, settings.LatticeSize };
+
+  const int scalarTypes[3] = { VTK_FLOAT, VTK_DOUBLE, VTK_SHORT };
+  for (int gridSize : settings.GridSizes)
+    {
+    for (int scalarType : scalarTypes)
+      {
+      for (int oblique = 0; oblique <= 1; ++oblique)
+        {
+        vtkSmartPointer<vtkOrientedGridTransform> transform =
+          CreateBenchmarkGridTransform(gridSize, scalarType, oblique != 0);
+        vtkSmartPointer<vtkOrientedGridTransform> hierarchicalTransform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+        hierarchicalTransform->DeepCopy(transform);
+        hierarchicalTransform->HierarchicalInverseOn();
+        transform->Update();
+        hierarchicalTransform->Update();
+        for (int threads : settings.ThreadCounts)
+          {
+          vtkSMPTools::Initialize(threads);
+          BenchmarkCase benchmarkCase = { "grid", "", gridSize, scalarType, oblique != 0, false, threads };
+
+          benchmarkCase.Operation = "forward";
+          double seconds = MeasureSeconds(settings.Repeats, [&]()
+            {
+            vtkNew<vtkPoints> outputPoints;
+            outputPoints->SetDataTypeToDouble();
+            transform->TransformPoints(inputPoints, outputPoints);
+            });
+          WriteResult(os, benchmarkCase, numberOfPoints, seconds, -1.0);
+
+          benchmarkCase.Operation = "forward-grid";
+          seconds = MeasureSeconds(settings.Repeats, [&]()
+            {
+            vtkNew<vtkImageData> displacementField;
+            transform->EvaluateOnGrid(latticeOrigin, latticeSpacings, nullptr, latticeDimensions, displacementField);
+            });
+          WriteResult(os, benchmarkCase, numberOfPoints, seconds, -1.0);
+
+          benchmarkCase.Operation = "derivative-grid";
+          seconds = MeasureSeconds(settings.Repeats, [&]()
+            {
+            vtkNew<vtkImageData> jacobianDeterminant;
+            transform->EvaluateJacobianDeterminantOnGrid(latticeOrigin, latticeSpacings, nullptr,
+              latticeDimensions, jacobianDeterminant);
+            });
+          WriteResult(os, benchmarkCase, numberOfPoints, seconds, -1.0);
+
+          benchmarkCase.Operation = "inverse";
+          double meanIterations = 0.0;
+          seconds = MeasureSeconds(settings.Repeats, [&]()
+            {
+            meanIterations = transform->InverseTransformPoints(&points[0], &outPoints[0], numberOfPoints);
+            });
+          WriteResult(os, benchmarkCase, numberOfPoints, seconds, meanIterations);
+
+          benchmarkCase.Operation = "inverse-hierarchical";
+          seconds = MeasureSeconds(settings.Repeats, [&]()
+            {
+            meanIterations = hierarchicalTransform->InverseTransformPoints(&points[0], &outPoints[0], numberOfPoints);
+            });
+          WriteResult(os, benchmarkCase, numberOfPoints, seconds, meanIterations);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void RunBSplineTransformBenchmarks(const BenchmarkSettings& settings, const std::vector<double>& points,
+  std::ostream& os)
+{
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(points.size() / 3);
+  std::vector<double> outPoints(points.size());
+
+  double latticeOrigin[3] = { -0.5 * BenchmarkLatticeSize, -0.5 * BenchmarkLatticeSize, -0.5 * BenchmarkLatticeSize };
+  double latticeSpacing = BenchmarkLatticeSize / (settings.LatticeSize - 1);
+  double latticeSpacings[3] = { latticeSpacing, latticeSpacing, latticeSpacing };
+  int latticeDimensions[3] = { settings.LatticeSize, settings.LatticeSize, settings.LatticeSize };
+
+  const int scalarTypes[2] = { VTK_FLOAT, VTK_DOUBLE };
+  for (int gridSize : settings.GridSizes)
+    {
+    for (int scalarType : scalarTypes)
+      {
+      for (int oblique = 0; oblique <= 1; ++oblique)
+        {
+        for (int bulk = 0; bulk <= 1; ++bulk)
+          {
+          vtkSmartPointer<vtkOrientedBSplineTransform> transform =
+            CreateBenchmarkBSplineTransform(gridSize, scalarType, oblique != 0, bulk != 0);
+          vtkSmartPointer<vtkOrientedBSplineTransform> broydenTransform = vtkSmartPointer<vtkOrientedBSplineTransform>::New();
+          broydenTransform->DeepCopy(transform);
+          broydenTransform->SetInverseSolverToBroyden();
+          vtkSmartPointer<vtkOrientedBSplineTransform> hierarchicalTransform = vtkSmartPointer<vtkOrientedBSplineTransform>::New();
+          hierarchicalTransform->DeepCopy(transform);
+          hierarchicalTransform->HierarchicalInverseOn();
+          transform->Update();
+          broydenTransform->Update();
+          hierarchicalTransform->Update();
+          for (int threads : settings.ThreadCounts)
+            {
+            vtkSMPTools::Initialize(threads);
+            BenchmarkCase benchmarkCase = { "bspline", "", gridSize, scalarType, oblique != 0, bulk != 0, threads };
+
+            benchmarkCase.Operation = "forward-grid";
+            double seconds = MeasureSeconds(settings.Repeats, [&]()
+              {
+              vtkNew<vtkImageData> displacementField;
+              transform->EvaluateOnGrid(latticeOrigin, latticeSpacings, nullptr, latticeDimensions, displacementField);
+              });
+            WriteResult(os, benchmarkCase, numberOfPoints, seconds, -1.0);
+
+            benchmarkCase.Operation = "derivative-grid";
+            seconds = MeasureSeconds(settings.Repeats, [&]()
+              {
+              vtkNew<vtkImageData> jacobianDeterminant;
+              transform->EvaluateJacobianDeterminantOnGrid(latticeOrigin, latticeSpacings, nullptr,
+                latticeDimensions, jacobianDeterminant);
+              });
+            WriteResult(os, benchmarkCase, numberOfPoints, seconds, -1.0);
+
+            benchmarkCase.Operation = "inverse-newton";
+            double meanIterations = 0.0;
+            seconds = MeasureSeconds(settings.Repeats, [&]()
+              {
+              meanIterations = transform->InverseTransformPoints(&points[0], &outPoints[0], numberOfPoints);
+              });
+            WriteResult(os, benchmarkCase, numberOfPoints, seconds, meanIterations);
+
+            benchmarkCase.Operation = "inverse-broyden";
+            seconds = MeasureSeconds(settings.Repeats, [&]()
+              {
+              meanIterations = broydenTransform->InverseTransformPoints(&points[0], &outPoints[0], numberOfPoints);
+              });
+            WriteResult(os, benchmarkCase, numberOfPoints, seconds, meanIterations);
+
+            benchmarkCase.Operation = "inverse-hierarchical";
+            seconds = MeasureSeconds(settings.Repeats, [&]()
+              {
+              meanIterations = hierarchicalTransform->InverseTransformPoints(&points[0], &outPoints[0], numberOfPoints);
+              });
+            WriteResult(os, benchmarkCase, numberOfPoints, seconds, meanIterations);
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool ParseIntegerList(const char* text, std::vector<int>& values)
+{
+  values.clear();
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    {
+    int value = atoi(item.c_str());
+    if (value <= 0)
+      {
+      return false;
+      }
+    values.push_back(value);
+    }
+  return !values.empty();
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  BenchmarkSettings settings;
+  settings.GridSizes = { 16, 64, 128 };
+  settings.ThreadCounts = { 1, vtkSMPTools::GetEstimatedNumberOfThreads() };
+  settings.LatticeSize = 100;
+  settings.Repeats = 3;
+  const char* outputFileName = nullptr;
+
+  for (int argIndex = 1; argIndex < argc; ++argIndex)
+    {
+    bool hasValue = (argIndex + 1 < argc);
+    if (strcmp(argv[argIndex], "--quick") == 0)
+      {
+      settings.GridSizes = { 16 };
+      settings.LatticeSize = 30;
+      settings.Repeats = 1;
+      }
+    else if (strcmp(argv[argIndex], "--output") == 0 && hasValue)
+      {
+      outputFileName = argv[++argIndex];
+      }
+    else if (strcmp(argv[argIndex], "--grid-sizes") == 0 && hasValue)
+      {
+      if (!ParseIntegerList(argv[++argIndex], settings.GridSizes)
+        || *std::min_element(settings.GridSizes.begin(), settings.GridSizes.end()) < 4)
+        {
+        std::cerr << "Invalid grid sizes: " << argv[argIndex] << " (minimum is 4)" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    else if (strcmp(argv[argIndex], "--threads") == 0 && hasValue)
+      {
+      if (!ParseIntegerList(argv[++argIndex], settings.ThreadCounts))
+        {
+        std::cerr << "Invalid thread counts: " << argv[argIndex] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    else if (strcmp(argv[argIndex], "--lattice-size") == 0 && hasValue)
+      {
+      settings.LatticeSize = atoi(argv[++argIndex]);
+      if (settings.LatticeSize < 2)
+        {
+        std::cerr << "Invalid lattice size: " << argv[argIndex] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    else if (strcmp(argv[argIndex], "--repeats") == 0 && hasValue)
+      {
+      settings.Repeats = atoi(argv[++argIndex]);
+      if (settings.Repeats < 1)
+        {
+        std::cerr << "Invalid number of repeats: " << argv[argIndex] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    else
+      {
+      std::cerr << "Usage: " << argv[0] << " [--quick] [--output <file>] [--grid-sizes <n1,n2,...>]"
+        " [--threads <n1,n2,...>] [--lattice-size <n>] [--repeats <n>]" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  // the same thread count may be listed twice on single core machines
+  std::sort(settings.ThreadCounts.begin(), settings.ThreadCounts.end());
+  settings.ThreadCounts.erase(std::unique(settings.ThreadCounts.begin(), settings.ThreadCounts.end()),
+    settings.ThreadCounts.end());
+
+  std::ofstream outputFile;
+  if (outputFileName)
+    {
+    outputFile.open(outputFileName);
+    if (!outputFile.is_open())
+      {
+      std::cerr << "Failed to open output file: " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::ostream& os = (outputFileName ? outputFile : std::cout);
+
+  std::vector<double> points;
+  CreateBenchmarkPoints(settings.LatticeSize, points);
+
+  RunGridTransformBenchmarks(settings, points, os);
+  RunBSplineTransformBenchmarks(settings, points, os);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,255 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkAddonTestingMacros.h"
+#include "vtkRawRGBVolumeCodec.h"
+#include "vtkStreamingVolumeFrame.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstring>
+#include <vector>
+
+//----------------------------------------------------------------------------
+int RawEncodeDecodeTest();
+int ProgressiveEncodeDecodeTest();
+int ReorderBufferTest();
+
+//----------------------------------------------------------------------------
+int vtkRawRGBVolumeCodecTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  TESTING_OUTPUT_INIT();
+  CHECK_EXIT_SUCCESS(RawEncodeDecodeTest());
+  CHECK_EXIT_SUCCESS(ProgressiveEncodeDecodeTest());
+  CHECK_EXIT_SUCCESS(ReorderBufferTest());
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateColorImage()
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(21, 14, 9);
+  image->SetSpacing(0.5, 1.0, 2.0);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  unsigned char* imagePointer = static_cast<unsigned char*>(image->GetScalarPointer());
+  for (int k = 0; k < 9; ++k)
+    {
+    for (int j = 0; j < 14; ++j)
+      {
+      for (int i = 0; i < 21; ++i)
+        {
+        for (int c = 0; c < 3; ++c)
+          {
+          *(imagePointer++) = static_cast<unsigned char>((7 * i + 13 * j + 29 * k + 3 * c) % 256);
+          }
+        }
+      }
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+// Copy the information of a frame that is transmitted to a receiver
+vtkSmartPointer<vtkStreamingVolumeFrame> CreateTransmittedFrame(vtkStreamingVolumeFrame* frame, vtkIdType numberOfBytes)
+{
+  vtkSmartPointer<vtkUnsignedCharArray> frameData = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  frameData->SetNumberOfValues(numberOfBytes);
+  memcpy(frameData->GetPointer(0), frame->GetFrameData()->GetPointer(0), numberOfBytes);
+
+  vtkSmartPointer<vtkStreamingVolumeFrame> transmittedFrame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+  transmittedFrame->SetFrameData(frameData);
+  transmittedFrame->SetDimensions(frame->GetDimensions());
+  transmittedFrame->SetNumberOfComponents(frame->GetNumberOfComponents());
+  transmittedFrame->SetVTKScalarType(frame->GetVTKScalarType());
+  transmittedFrame->SetFrameType(frame->GetFrameType());
+  transmittedFrame->SetCodecFourCC(frame->GetCodecFourCC());
+  return transmittedFrame;
+}
+
+//----------------------------------------------------------------------------
+// Compare a decoded image to the input image sampled with the specified stride
+int CheckDecodedImage(vtkImageData* decodedImage, vtkImageData* image, int stride)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(dimensions);
+  int decodedDimensions[3] = { 0, 0, 0 };
+  decodedImage->GetDimensions(decodedDimensions);
+  for (int i = 0; i < 3; ++i)
+    {
+    CHECK_INT(decodedDimensions[i], (dimensions[i] - 1) / stride + 1);
+    CHECK_DOUBLE(decodedImage->GetSpacing()[i], image->GetSpacing()[i] * stride);
+    }
+  for (int k = 0; k < decodedDimensions[2]; ++k)
+    {
+    for (int j = 0; j < decodedDimensions[1]; ++j)
+      {
+      for (int i = 0; i < decodedDimensions[0]; ++i)
+        {
+        const unsigned char* decodedVoxel = static_cast<unsigned char*>(decodedImage->GetScalarPointer(i, j, k));
+        const unsigned char* voxel = static_cast<unsigned char*>(image->GetScalarPointer(stride * i, stride * j, stride * k));
+        CHECK_INT(memcmp(decodedVoxel, voxel, 3), 0);
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int RawEncodeDecodeTest()
+{
+  vtkSmartPointer<vtkImageData> image = CreateColorImage();
+  vtkNew<vtkRawRGBVolumeCodec> codec;
+  vtkNew<vtkStreamingVolumeFrame> frame;
+  CHECK_BOOL(codec->EncodeImageData(image, frame), true);
+  CHECK_INT(frame->GetFrameData()->GetNumberOfValues(), image->GetNumberOfPoints() * 3);
+  CHECK_INT(frame->GetNumberOfResolutionLevels(), 1);
+
+  vtkSmartPointer<vtkStreamingVolumeFrame> transmittedFrame =
+    CreateTransmittedFrame(frame, frame->GetFrameData()->GetNumberOfValues());
+  vtkNew<vtkImageData> decodedImage;
+  decodedImage->SetSpacing(image->GetSpacing());
+  CHECK_BOOL(codec->DecodeFrame(transmittedFrame, decodedImage), true);
+  CHECK_EXIT_SUCCESS(CheckDecodedImage(decodedImage, image, 1));
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int ProgressiveEncodeDecodeTest()
+{
+  vtkSmartPointer<vtkImageData> image = CreateColorImage();
+  vtkNew<vtkRawRGBVolumeCodec> encoder;
+  CHECK_BOOL(encoder->SetParameter("ResolutionLevels", "3"), true);
+  vtkNew<vtkStreamingVolumeFrame> frame;
+  CHECK_BOOL(encoder->EncodeImageData(image, frame), true);
+  CHECK_INT(frame->GetNumberOfResolutionLevels(), 3);
+  std::vector<vtkIdType> levelOffsets = frame->GetResolutionLevelOffsets();
+
+  // The level table is read from the frame data, the frame is not modified
+  vtkSmartPointer<vtkStreamingVolumeFrame> transmittedFrame =
+    CreateTransmittedFrame(frame, frame->GetFrameData()->GetNumberOfValues());
+  CHECK_INT(transmittedFrame->GetNumberOfResolutionLevels(), 1);
+  vtkNew<vtkRawRGBVolumeCodec> decoder;
+  decoder->SetMaximumDecodedResolutionLevel(0);
+  vtkNew<vtkImageData> decodedImage;
+  decodedImage->SetSpacing(image->GetSpacing());
+  CHECK_BOOL(decoder->DecodeFrame(transmittedFrame, decodedImage), true);
+  CHECK_INT(transmittedFrame->GetNumberOfResolutionLevels(), 1);
+  CHECK_EXIT_SUCCESS(CheckDecodedImage(decodedImage, image, 4));
+
+  // A frame that only contains the first two levels is refined into the same image
+  vtkSmartPointer<vtkStreamingVolumeFrame> partialFrame = CreateTransmittedFrame(frame, levelOffsets[2]);
+  decoder->SetMaximumDecodedResolutionLevel(1);
+  CHECK_BOOL(decoder->DecodeFrame(partialFrame, decodedImage), true);
+  CHECK_EXIT_SUCCESS(CheckDecodedImage(decodedImage, image, 2));
+
+  // The full resolution image restores the original dimensions and spacing
+  decoder->SetMaximumDecodedResolutionLevel(-1);
+  CHECK_BOOL(decoder->DecodeFrame(transmittedFrame, decodedImage), true);
+  CHECK_EXIT_SUCCESS(CheckDecodedImage(decodedImage, image, 1));
+
+  // The partial frame does not contain the full resolution level
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(decoder->DecodeFrame(partialFrame, decodedImage), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Returns the first component of the first voxel of the image
+int GetFirstVoxelValue(vtkImageData* image)
+{
+  return static_cast<unsigned char*>(image->GetScalarPointer())[0];
+}
+
+//----------------------------------------------------------------------------
+int ReorderBufferTest()
+{
+  // Frames in decode order, the images are filled with 10 times the presentation timestamp
+  const int numberOfFrames = 6;
+  const double presentationTimestamps[numberOfFrames] = { 0.0, 3.0, 1.0, 2.0, 5.0, 4.0 };
+  vtkNew<vtkRawRGBVolumeCodec> encoder;
+  std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > frames;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(8, 6, 4);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    memset(image->GetScalarPointer(), static_cast<int>(10 * presentationTimestamps[frameIndex]),
+      image->GetNumberOfPoints() * 3);
+    vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    CHECK_BOOL(encoder->EncodeImageData(image, frame), true);
+    frame->SetPresentationTimestamp(presentationTimestamps[frameIndex]);
+    frames.push_back(frame);
+    }
+
+  vtkNew<vtkRawRGBVolumeCodec> decoder;
+  decoder->SetReorderBufferSize(2);
+  vtkNew<vtkImageData> outputImage;
+  outputImage->SetSpacing(0.5, 0.5, 2.0);
+
+  // The first images are held back, then one image is output for each frame in presentation order
+  std::vector<double> outputTimestamps;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    bool outputAvailable = true;
+    CHECK_BOOL(decoder->DecodeFrameReordered(frames[frameIndex], outputImage, outputAvailable), true);
+    CHECK_BOOL(outputAvailable, frameIndex >= 2);
+    if (outputAvailable)
+      {
+      outputTimestamps.push_back(decoder->GetLastOutputPresentationTimestamp());
+      CHECK_INT(GetFirstVoxelValue(outputImage), static_cast<int>(10 * decoder->GetLastOutputPresentationTimestamp()));
+      }
+    }
+  CHECK_INT(outputImage->GetDimensions()[0], 8);
+  CHECK_DOUBLE(outputImage->GetSpacing()[2], 2.0);
+
+  // Flushing outputs the remaining images
+  while (decoder->FlushReorderBuffer(outputImage))
+    {
+    outputTimestamps.push_back(decoder->GetLastOutputPresentationTimestamp());
+    CHECK_INT(GetFirstVoxelValue(outputImage), static_cast<int>(10 * decoder->GetLastOutputPresentationTimestamp()));
+    }
+  CHECK_INT(static_cast<int>(outputTimestamps.size()), numberOfFrames);
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    CHECK_DOUBLE(outputTimestamps[frameIndex], frameIndex);
+    }
+
+  // Clearing discards the pending images, for example after seeking
+  bool outputAvailable = true;
+  CHECK_BOOL(decoder->DecodeFrameReordered(frames[1], outputImage, outputAvailable), true);
+  CHECK_BOOL(outputAvailable, false);
+  CHECK_BOOL(decoder->DecodeFrameReordered(frames[2], outputImage, outputAvailable), true);
+  CHECK_BOOL(outputAvailable, false);
+  decoder->ClearReorderBuffer();
+  CHECK_BOOL(decoder->FlushReorderBuffer(outputImage), false);
+  CHECK_DOUBLE(decoder->GetLastOutputPresentationTimestamp(), 5.0);
+
+  // Decoding restarts with an empty buffer
+  CHECK_BOOL(decoder->DecodeFrameReordered(frames[3], outputImage, outputAvailable), true);
+  CHECK_BOOL(outputAvailable, false);
+  CHECK_BOOL(decoder->FlushReorderBuffer(outputImage), true);
+  CHECK_DOUBLE(decoder->GetLastOutputPresentationTimestamp(), 2.0);
+  CHECK_INT(GetFirstVoxelValue(outputImage), 20);
+
+  return EXIT_SUCCESS;
+}
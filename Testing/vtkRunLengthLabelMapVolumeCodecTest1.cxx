@@ -0,0 +1,289 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkAddonTestingMacros.h"
+#include "vtkRunLengthLabelMapVolumeCodec.h"
+#include "vtkStreamingVolumeCodecFactory.h"
+#include "vtkStreamingVolumeFrame.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+//----------------------------------------------------------------------------
+int EncodeDecodeTest(int scalarType);
+int EncodeExtentTest();
+int KeyFrameDistanceChangeTest();
+int ReorderBufferTest();
+int FactoryTest();
+
+//----------------------------------------------------------------------------
+int vtkRunLengthLabelMapVolumeCodecTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  TESTING_OUTPUT_INIT();
+  CHECK_EXIT_SUCCESS(EncodeDecodeTest(VTK_UNSIGNED_CHAR));
+  CHECK_EXIT_SUCCESS(EncodeDecodeTest(VTK_SHORT));
+  CHECK_EXIT_SUCCESS(EncodeExtentTest());
+  CHECK_EXIT_SUCCESS(KeyFrameDistanceChangeTest());
+  CHECK_EXIT_SUCCESS(ReorderBufferTest());
+  CHECK_EXIT_SUCCESS(FactoryTest());
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void FillLabelMap(vtkImageData* image, int frameIndex)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(dimensions);
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        // a sphere that moves along the X axis in each frame, on a background of 0
+        double x = i - 10 - frameIndex;
+        double y = j - 10;
+        double z = k - 5;
+        int label = (x * x + y * y + z * z < 25) ? 3 : 0;
+        if (i == dimensions[0] - 1)
+          {
+          label = 300 % 256;
+          }
+        image->SetScalarComponentFromDouble(i, j, k, 0, label);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int EncodeDecodeTest(int scalarType)
+{
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> encoder;
+  CHECK_BOOL(encoder->SetParameter("KeyFrameDistance", "3"), true);
+
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> decoder;
+
+  const int numberOfFrames = 5;
+  std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > frames;
+  std::vector<vtkSmartPointer<vtkImageData> > images;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(40, 20, 10);
+    image->AllocateScalars(scalarType, 1);
+    FillLabelMap(image, frameIndex);
+    images.push_back(image);
+
+    vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    CHECK_BOOL(encoder->EncodeImageData(image, frame), true);
+    frames.push_back(frame);
+
+    // Every third frame is a keyframe, the others are predicted from the previous frame
+    CHECK_BOOL(frame->IsKeyFrame(), frameIndex % 3 == 0);
+    CHECK_BOOL(frame->GetFrameData()->GetNumberOfValues() < image->GetNumberOfPoints(), true);
+    }
+
+  // Decoding a predicted frame must decode all preceding frames up to the keyframe
+  vtkNew<vtkImageData> decodedImage;
+  CHECK_BOOL(decoder->DecodeFrame(frames[numberOfFrames - 1], decodedImage), true);
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    CHECK_BOOL(decoder->DecodeFrame(frames[frameIndex], decodedImage), true);
+    CHECK_INT(decodedImage->GetScalarType(), scalarType);
+    vtkIdType numberOfBytes = images[frameIndex]->GetNumberOfPoints() * images[frameIndex]->GetScalarSize();
+    CHECK_INT(memcmp(decodedImage->GetScalarPointer(), images[frameIndex]->GetScalarPointer(), numberOfBytes), 0);
+    }
+
+  // A predicted frame that is decoded into another image is decoded starting from its keyframe
+  vtkNew<vtkImageData> otherImage;
+  CHECK_BOOL(decoder->DecodeFrame(frames[numberOfFrames - 1], otherImage), true);
+  vtkIdType numberOfBytes = images[numberOfFrames - 1]->GetNumberOfPoints() * images[numberOfFrames - 1]->GetScalarSize();
+  CHECK_INT(memcmp(otherImage->GetScalarPointer(), images[numberOfFrames - 1]->GetScalarPointer(), numberOfBytes), 0);
+
+  // Frames without data cannot be decoded
+  vtkNew<vtkStreamingVolumeFrame> emptyFrame;
+  emptyFrame->SetFrameType(vtkStreamingVolumeFrame::IFrame);
+  emptyFrame->SetDimensions(40, 20, 10);
+  emptyFrame->SetNumberOfComponents(1);
+  emptyFrame->SetVTKScalarType(scalarType);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(decoder->DecodeFrame(emptyFrame, decodedImage), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int EncodeExtentTest()
+{
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(40, 20, 10);
+  image->AllocateScalars(VTK_SHORT, 1);
+  FillLabelMap(image, 0);
+
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> codec;
+  int extent[6] = { 5, 24, 3, 12, 2, 7 };
+  vtkNew<vtkStreamingVolumeFrame> frame;
+  CHECK_BOOL(codec->EncodeImageData(image, extent, frame), true);
+  CHECK_INT(frame->GetDimensions()[0], 20);
+  CHECK_INT(frame->GetDimensions()[1], 10);
+  CHECK_INT(frame->GetDimensions()[2], 6);
+
+  vtkNew<vtkImageData> decodedImage;
+  CHECK_BOOL(codec->DecodeFrame(frame, decodedImage), true);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        CHECK_DOUBLE(decodedImage->GetScalarComponentAsDouble(i - extent[0], j - extent[2], k - extent[4], 0),
+                     image->GetScalarComponentAsDouble(i, j, k, 0));
+        }
+      }
+    }
+
+  // Regions outside of the image cannot be encoded
+  int invalidExtent[6] = { 5, 40, 3, 12, 2, 7 };
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(codec->EncodeImageData(image, invalidExtent, frame), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int KeyFrameDistanceChangeTest()
+{
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> encoder;
+  CHECK_BOOL(encoder->SetParameter("KeyFrameDistance", "3"), true);
+
+  // Key frame distance 3, 1, then 3 again: the first frame after each change
+  // starts a new group of frames
+  const char* keyFrameDistances[6] = { "3", "3", "1", "3", "3", "3" };
+  const bool expectedKeyFrames[6] = { true, false, true, true, false, false };
+  std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > frames;
+  std::vector<vtkSmartPointer<vtkImageData> > images;
+  for (int frameIndex = 0; frameIndex < 6; ++frameIndex)
+    {
+    CHECK_BOOL(encoder->SetParameter("KeyFrameDistance", keyFrameDistances[frameIndex]), true);
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(40, 20, 10);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    FillLabelMap(image, frameIndex);
+    images.push_back(image);
+
+    vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    CHECK_BOOL(encoder->EncodeImageData(image, frame), true);
+    CHECK_BOOL(frame->IsKeyFrame(), expectedKeyFrames[frameIndex]);
+    frames.push_back(frame);
+    }
+
+  // Each frame is decoded from its own group of frames
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> decoder;
+  vtkNew<vtkImageData> decodedImage;
+  for (int frameIndex = 5; frameIndex >= 0; --frameIndex)
+    {
+    CHECK_BOOL(decoder->DecodeFrame(frames[frameIndex], decodedImage), true);
+    vtkIdType numberOfBytes = images[frameIndex]->GetNumberOfPoints() * images[frameIndex]->GetScalarSize();
+    CHECK_INT(memcmp(decodedImage->GetScalarPointer(), images[frameIndex]->GetScalarPointer(), numberOfBytes), 0);
+    }
+
+  // A reused output frame cannot reference itself
+  vtkNew<vtkStreamingVolumeFrame> reusedFrame;
+  for (int frameIndex = 0; frameIndex < 2; ++frameIndex)
+    {
+    CHECK_BOOL(encoder->EncodeImageData(images[frameIndex], reusedFrame), true);
+    CHECK_BOOL(reusedFrame->IsKeyFrame(), true);
+    CHECK_NULL(reusedFrame->GetPreviousFrame());
+    CHECK_BOOL(decoder->DecodeFrame(reusedFrame, decodedImage), true);
+    vtkIdType numberOfBytes = images[frameIndex]->GetNumberOfPoints() * images[frameIndex]->GetScalarSize();
+    CHECK_INT(memcmp(decodedImage->GetScalarPointer(), images[frameIndex]->GetScalarPointer(), numberOfBytes), 0);
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int ReorderBufferTest()
+{
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> encoder;
+  CHECK_BOOL(encoder->SetParameter("KeyFrameDistance", "3"), true);
+
+  // Predicted frames are passed in decode order, with presentation timestamps out of order
+  const int numberOfFrames = 6;
+  const double presentationTimestamps[numberOfFrames] = { 0.0, 2.0, 1.0, 3.0, 5.0, 4.0 };
+  std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > frames;
+  std::vector<vtkSmartPointer<vtkImageData> > images;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(40, 20, 10);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    FillLabelMap(image, frameIndex);
+    images.push_back(image);
+
+    vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    CHECK_BOOL(encoder->EncodeImageData(image, frame), true);
+    frame->SetPresentationTimestamp(presentationTimestamps[frameIndex]);
+    frames.push_back(frame);
+    }
+  CHECK_NOT_NULL(frames[2]->GetPreviousFrame());
+
+  // The output images are swapped with the buffered images, predicted frames
+  // must still be decoded from the previous frame in decode order
+  const int expectedFrameIndices[numberOfFrames] = { 0, 2, 1, 3, 5, 4 };
+  vtkNew<vtkRunLengthLabelMapVolumeCodec> decoder;
+  decoder->SetReorderBufferSize(1);
+  vtkNew<vtkImageData> decodedImage;
+  int numberOfOutputFrames = 0;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    bool outputAvailable = false;
+    CHECK_BOOL(decoder->DecodeFrameReordered(frames[frameIndex], decodedImage, outputAvailable), true);
+    CHECK_BOOL(outputAvailable, frameIndex > 0);
+    if (outputAvailable)
+      {
+      vtkImageData* expectedImage = images[expectedFrameIndices[numberOfOutputFrames++]];
+      vtkIdType numberOfBytes = expectedImage->GetNumberOfPoints() * expectedImage->GetScalarSize();
+      CHECK_INT(memcmp(decodedImage->GetScalarPointer(), expectedImage->GetScalarPointer(), numberOfBytes), 0);
+      }
+
+    // decoding a frame outside of the reorder buffer does not affect the buffered frames
+    vtkNew<vtkImageData> otherImage;
+    CHECK_BOOL(decoder->DecodeFrame(frames[0], otherImage), true);
+    }
+  CHECK_BOOL(decoder->FlushReorderBuffer(decodedImage), true);
+  vtkImageData* expectedImage = images[expectedFrameIndices[numberOfOutputFrames++]];
+  vtkIdType numberOfBytes = expectedImage->GetNumberOfPoints() * expectedImage->GetScalarSize();
+  CHECK_INT(memcmp(decodedImage->GetScalarPointer(), expectedImage->GetScalarPointer(), numberOfBytes), 0);
+  CHECK_BOOL(decoder->FlushReorderBuffer(decodedImage), false);
+  CHECK_INT(numberOfOutputFrames, numberOfFrames);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int FactoryTest()
+{
+  vtkSmartPointer<vtkStreamingVolumeCodec> codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+    vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC("RLLM"));
+  CHECK_NOT_NULL(codec);
+  CHECK_NOT_NULL(vtkRunLengthLabelMapVolumeCodec::SafeDownCast(codec));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,827 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkMappedDisplacementGrid.h"
+
+#include "vtkAlgorithm.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkObjectFactory.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+vtkStandardNewMacro(vtkMappedDisplacementGrid);
+
+// Signature and version of the grid file format
+static const char vtkMappedDisplacementGridSignature[16] = "vtkMappedGrid";
+static const vtkTypeInt32 vtkMappedDisplacementGridVersion = 1;
+
+// Size of the file header and alignment of the bricks in the file
+static const vtkIdType vtkMappedDisplacementGridAlignment = 4096;
+
+//----------------------------------------------------------------------------
+// Header at the beginning of the grid file.
+struct vtkMappedDisplacementGridHeader
+{
+  char Signature[16];
+  vtkTypeInt32 Version;
+  vtkTypeInt32 ScalarType;
+  vtkTypeInt32 BrickSize;
+  vtkTypeInt32 Extent[6];
+  vtkTypeInt32 Reserved;
+  double Origin[3];
+  double Spacing[3];
+  double Direction[9];
+};
+
+//----------------------------------------------------------------------------
+// Number of bricks along each axis of a grid extent.
+static void vtkMappedDisplacementGridNumberOfBricks(const int extent[6], int brickSize, int numberOfBricks[3])
+{
+  for (int i = 0; i < 3; i++)
+    {
+    int numberOfCells = extent[2*i+1] - extent[2*i];
+    numberOfBricks[i] = std::max((numberOfCells + brickSize - 1) / brickSize, 1);
+    }
+}
+
+#ifndef _WIN32
+//----------------------------------------------------------------------------
+// Size of the memory pages, which may be larger than the alignment of the
+// bricks in the file. Only whole pages can be released.
+static size_t vtkMappedDisplacementGridPageSize()
+{
+  static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return pageSize;
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Size of a brick in the file, padded to the alignment.
+static vtkIdType vtkMappedDisplacementGridBrickStride(int brickSize, int scalarType)
+{
+  vtkIdType samples = static_cast<vtkIdType>(brickSize + 1) * (brickSize + 1) * (brickSize + 1);
+  vtkIdType size = 3 * samples * (scalarType == VTK_FLOAT ? sizeof(float) : sizeof(double));
+  return (size + vtkMappedDisplacementGridAlignment - 1)
+    / vtkMappedDisplacementGridAlignment * vtkMappedDisplacementGridAlignment;
+}
+
+//----------------------------------------------------------------------------
+// Write one layer of bricks (all bricks with the same brick index along
+// the third axis). data contains the samples in dataExtent.
+template <class T>
+static void vtkMappedDisplacementGridWriteBrickLayer(std::ofstream& file, const T* data, const int dataExtent[6],
+  const int extent[6], int brickSize, const int numberOfBricks[3], int brickIndex2, vtkIdType brickStride)
+{
+  int brickSamples = brickSize + 1;
+  std::vector<T> brick(3 * brickSamples * brickSamples * brickSamples);
+  std::vector<char> padding(brickStride - brick.size() * sizeof(T), 0);
+  vtkIdType dataIncrement1 = 3 * static_cast<vtkIdType>(dataExtent[1] - dataExtent[0] + 1);
+  vtkIdType dataIncrement2 = dataIncrement1 * (dataExtent[3] - dataExtent[2] + 1);
+  for (int brickIndex1 = 0; brickIndex1 < numberOfBricks[1]; brickIndex1++)
+    {
+    for (int brickIndex0 = 0; brickIndex0 < numberOfBricks[0]; brickIndex0++)
+      {
+      // Samples that are outside the grid are set to zero
+      std::fill(brick.begin(), brick.end(), static_cast<T>(0));
+      T* brickPtr = &brick[0];
+      for (int k = 0; k < brickSamples; k++)
+        {
+        int gridK = extent[4] + brickIndex2 * brickSize + k;
+        for (int j = 0; j < brickSamples; j++)
+          {
+          int gridJ = extent[2] + brickIndex1 * brickSize + j;
+          for (int i = 0; i < brickSamples; i++, brickPtr += 3)
+            {
+            int gridI = extent[0] + brickIndex0 * brickSize + i;
+            if (gridI > dataExtent[1] || gridJ > dataExtent[3] || gridK > dataExtent[5])
+              {
+              continue;
+              }
+            const T* dataPtr = data + (gridK - dataExtent[4]) * dataIncrement2
+              + (gridJ - dataExtent[2]) * dataIncrement1 + 3 * (gridI - dataExtent[0]);
+            brickPtr[0] = dataPtr[0];
+            brickPtr[1] = dataPtr[1];
+            brickPtr[2] = dataPtr[2];
+            }
+          }
+        }
+      file.write(reinterpret_cast<const char*>(&brick[0]), brick.size() * sizeof(T));
+      if (!padding.empty())
+        {
+        file.write(&padding[0], padding.size());
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Write the file header, padded to the alignment.
+static void vtkMappedDisplacementGridWriteHeader(std::ofstream& file, vtkImageData* grid, const int extent[6],
+  vtkMatrix4x4* gridDirection, int brickSize)
+{
+  vtkMappedDisplacementGridHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.Signature, vtkMappedDisplacementGridSignature, sizeof(header.Signature));
+  header.Version = vtkMappedDisplacementGridVersion;
+  header.ScalarType = grid->GetScalarType();
+  header.BrickSize = brickSize;
+  for (int i = 0; i < 6; i++)
+    {
+    header.Extent[i] = extent[i];
+    }
+  for (int i = 0; i < 3; i++)
+    {
+    header.Origin[i] = grid->GetOrigin()[i];
+    header.Spacing[i] = grid->GetSpacing()[i];
+    for (int j = 0; j < 3; j++)
+      {
+      header.Direction[3*i+j] = (gridDirection ? gridDirection->GetElement(i, j) : (i == j ? 1.0 : 0.0));
+      }
+    }
+  std::vector<char> buffer(vtkMappedDisplacementGridAlignment, 0);
+  memcpy(&buffer[0], &header, sizeof(header));
+  file.write(&buffer[0], buffer.size());
+}
+
+//----------------------------------------------------------------------------
+// Write the layer of bricks contained in grid.
+static void vtkMappedDisplacementGridWriteBrickLayer(std::ofstream& file, vtkImageData* grid, const int extent[6],
+  int brickSize, const int numberOfBricks[3], int brickIndex2)
+{
+  vtkIdType brickStride = vtkMappedDisplacementGridBrickStride(brickSize, grid->GetScalarType());
+  if (grid->GetScalarType() == VTK_FLOAT)
+    {
+    vtkMappedDisplacementGridWriteBrickLayer(file, static_cast<const float*>(grid->GetScalarPointer()),
+      grid->GetExtent(), extent, brickSize, numberOfBricks, brickIndex2, brickStride);
+    }
+  else
+    {
+    vtkMappedDisplacementGridWriteBrickLayer(file, static_cast<const double*>(grid->GetScalarPointer()),
+      grid->GetExtent(), extent, brickSize, numberOfBricks, brickIndex2, brickStride);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Check that the image can be stored in a grid file.
+static bool vtkMappedDisplacementGridIsValidGrid(vtkImageData* grid)
+{
+  return grid && grid->GetScalarPointer() && grid->GetNumberOfScalarComponents() == 3
+    && (grid->GetScalarType() == VTK_FLOAT || grid->GetScalarType() == VTK_DOUBLE);
+}
+
+//----------------------------------------------------------------------------
+vtkMappedDisplacementGrid::vtkMappedDisplacementGrid()
+{
+  this->FileName = nullptr;
+
+  for (int i = 0; i < 3; i++)
+    {
+    this->Extent[2*i] = 0;
+    this->Extent[2*i+1] = -1;
+    this->Origin[i] = 0.0;
+    this->Spacing[i] = 1.0;
+    this->NumberOfBricks[i] = 0;
+    this->BrickIncrements[i] = 0;
+    }
+  for (int i = 0; i < 9; i++)
+    {
+    this->Direction[i] = (i % 4 == 0 ? 1.0 : 0.0);
+    }
+  this->ScalarType = VTK_DOUBLE;
+  this->BrickSize = 0;
+  this->BrickStride = 0;
+
+  this->MappedData = nullptr;
+  this->MappedSize = 0;
+#ifdef _WIN32
+  this->FileHandle = nullptr;
+  this->MappingHandle = nullptr;
+#endif
+
+  this->CacheSize = 1024;
+  this->CacheEpoch = 1;
+  this->NumberOfCachedBricks = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkMappedDisplacementGrid::~vtkMappedDisplacementGrid()
+{
+  this->Close();
+  this->SetFileName(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "FileName: " << (this->FileName ? this->FileName : "(none)") << "\n";
+  os << indent << "Extent: (" << this->Extent[0] << ", "
+     << this->Extent[1] << ", " << this->Extent[2] << ", "
+     << this->Extent[3] << ", " << this->Extent[4] << ", "
+     << this->Extent[5] << ")\n";
+  os << indent << "Origin: (" << this->Origin[0] << ", "
+     << this->Origin[1] << ", " << this->Origin[2] << ")\n";
+  os << indent << "Spacing: (" << this->Spacing[0] << ", "
+     << this->Spacing[1] << ", " << this->Spacing[2] << ")\n";
+  os << indent << "ScalarType: " << vtkImageScalarTypeNameMacro(this->ScalarType) << "\n";
+  os << indent << "BrickSize: " << this->BrickSize << "\n";
+  os << indent << "CacheSize: " << this->CacheSize << " MB\n";
+  os << indent << "NumberOfCachedBricks: " << this->NumberOfCachedBricks << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkMappedDisplacementGrid::WriteFile(const char* fileName, vtkImageData* grid,
+  vtkMatrix4x4* gridDirection, int brickSize)
+{
+  if (!fileName || !vtkMappedDisplacementGridIsValidGrid(grid) || brickSize < 1)
+    {
+    vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: invalid file name, grid or brick size");
+    return false;
+    }
+  std::ofstream file(fileName, std::ios::out | std::ios::binary);
+  if (!file)
+    {
+    vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: cannot open " << fileName);
+    return false;
+    }
+
+  int* extent = grid->GetExtent();
+  int numberOfBricks[3];
+  vtkMappedDisplacementGridNumberOfBricks(extent, brickSize, numberOfBricks);
+  vtkMappedDisplacementGridWriteHeader(file, grid, extent, gridDirection, brickSize);
+  for (int brickIndex2 = 0; brickIndex2 < numberOfBricks[2]; brickIndex2++)
+    {
+    vtkMappedDisplacementGridWriteBrickLayer(file, grid, extent, brickSize, numberOfBricks, brickIndex2);
+    }
+  if (!file)
+    {
+    vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: failed to write " << fileName);
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMappedDisplacementGrid::WriteFile(const char* fileName, vtkAlgorithm* source,
+  vtkMatrix4x4* gridDirection, int brickSize)
+{
+  if (!fileName || !source || brickSize < 1)
+    {
+    vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: invalid file name, source or brick size");
+    return false;
+    }
+  source->UpdateInformation();
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  source->GetOutputInformation(0)->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
+  if (extent[1] < extent[0] || extent[3] < extent[2] || extent[5] < extent[4])
+    {
+    vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: empty source extent");
+    return false;
+    }
+  std::ofstream file(fileName, std::ios::out | std::ios::binary);
+  if (!file)
+    {
+    vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: cannot open " << fileName);
+    return false;
+    }
+
+  int numberOfBricks[3];
+  vtkMappedDisplacementGridNumberOfBricks(extent, brickSize, numberOfBricks);
+  int scalarType = VTK_VOID;
+  for (int brickIndex2 = 0; brickIndex2 < numberOfBricks[2]; brickIndex2++)
+    {
+    // Request the samples of one layer of bricks
+    int slabExtent[6] = { extent[0], extent[1], extent[2], extent[3],
+      extent[4] + brickIndex2 * brickSize, std::min(extent[4] + (brickIndex2 + 1) * brickSize, extent[5]) };
+    source->UpdateExtent(slabExtent);
+    vtkImageData* slab = vtkImageData::SafeDownCast(source->GetOutputDataObject(0));
+    if (!vtkMappedDisplacementGridIsValidGrid(slab)
+      || (scalarType != VTK_VOID && slab->GetScalarType() != scalarType))
+      {
+      vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: source output must be a 3-component"
+        " float or double image");
+      return false;
+      }
+    int* slabDataExtent = slab->GetExtent();
+    for (int i = 0; i < 6; i += 2)
+      {
+      if (slabDataExtent[i] > slabExtent[i] || slabDataExtent[i+1] < slabExtent[i+1])
+        {
+        vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: source did not provide the requested extent");
+        return false;
+        }
+      }
+    if (scalarType == VTK_VOID)
+      {
+      scalarType = slab->GetScalarType();
+      vtkMappedDisplacementGridWriteHeader(file, slab, extent, gridDirection, brickSize);
+      }
+    vtkMappedDisplacementGridWriteBrickLayer(file, slab, extent, brickSize, numberOfBricks, brickIndex2);
+    }
+  if (!file)
+    {
+    vtkGenericWarningMacro("vtkMappedDisplacementGrid::WriteFile: failed to write " << fileName);
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMappedDisplacementGrid::Open(const char* fileName)
+{
+  this->Close();
+  if (!fileName)
+    {
+    vtkErrorMacro("Open: invalid file name");
+    return false;
+    }
+
+#ifdef _WIN32
+  HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+    vtkErrorMacro("Open: cannot open " << fileName);
+    return false;
+    }
+  LARGE_INTEGER fileSize;
+  HANDLE mappingHandle = nullptr;
+  void* mappedData = nullptr;
+  if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+    {
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+  if (mappingHandle)
+    {
+    mappedData = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    }
+  if (!mappedData)
+    {
+    if (mappingHandle)
+      {
+      CloseHandle(mappingHandle);
+      }
+    CloseHandle(fileHandle);
+    vtkErrorMacro("Open: cannot map " << fileName);
+    return false;
+    }
+  this->FileHandle = fileHandle;
+  this->MappingHandle = mappingHandle;
+  this->MappedData = static_cast<char*>(mappedData);
+  this->MappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+  int fileDescriptor = open(fileName, O_RDONLY);
+  if (fileDescriptor < 0)
+    {
+    vtkErrorMacro("Open: cannot open " << fileName);
+    return false;
+    }
+  struct stat fileStatus;
+  void* mappedData = MAP_FAILED;
+  if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0)
+    {
+    mappedData = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    }
+  // The mapping remains valid after the file is closed
+  close(fileDescriptor);
+  if (mappedData == MAP_FAILED)
+    {
+    vtkErrorMacro("Open: cannot map " << fileName);
+    return false;
+    }
+  this->MappedData = static_cast<char*>(mappedData);
+  this->MappedSize = static_cast<size_t>(fileStatus.st_size);
+#endif
+
+  // Read and validate the header
+  vtkMappedDisplacementGridHeader header;
+  bool valid = (this->MappedSize >= static_cast<size_t>(vtkMappedDisplacementGridAlignment));
+  if (valid)
+    {
+    memcpy(&header, this->MappedData, sizeof(header));
+    valid = (memcmp(header.Signature, vtkMappedDisplacementGridSignature, sizeof(header.Signature)) == 0
+      && header.Version == vtkMappedDisplacementGridVersion
+      && (header.ScalarType == VTK_FLOAT || header.ScalarType == VTK_DOUBLE)
+      && header.BrickSize > 0
+      && header.Extent[0] <= header.Extent[1] && header.Extent[2] <= header.Extent[3]
+      && header.Extent[4] <= header.Extent[5]);
+    }
+  if (valid)
+    {
+    vtkMappedDisplacementGridNumberOfBricks(header.Extent, header.BrickSize, this->NumberOfBricks);
+    this->BrickStride = vtkMappedDisplacementGridBrickStride(header.BrickSize, header.ScalarType);
+    vtkIdType numberOfBricks = static_cast<vtkIdType>(this->NumberOfBricks[0]) * this->NumberOfBricks[1]
+      * this->NumberOfBricks[2];
+    valid = (this->MappedSize >= static_cast<size_t>(vtkMappedDisplacementGridAlignment
+      + numberOfBricks * this->BrickStride));
+    }
+  if (!valid)
+    {
+    vtkErrorMacro("Open: " << fileName << " is not a valid grid file");
+    this->Close();
+    return false;
+    }
+
+  this->ScalarType = header.ScalarType;
+  this->BrickSize = header.BrickSize;
+  for (int i = 0; i < 6; i++)
+    {
+    this->Extent[i] = header.Extent[i];
+    }
+  for (int i = 0; i < 3; i++)
+    {
+    this->Origin[i] = header.Origin[i];
+    this->Spacing[i] = header.Spacing[i];
+    }
+  for (int i = 0; i < 9; i++)
+    {
+    this->Direction[i] = header.Direction[i];
+    }
+  int brickSamples = this->BrickSize + 1;
+  this->BrickIncrements[0] = 3;
+  this->BrickIncrements[1] = 3 * brickSamples;
+  this->BrickIncrements[2] = 3 * brickSamples * brickSamples;
+
+  vtkIdType numberOfBricks = static_cast<vtkIdType>(this->NumberOfBricks[0]) * this->NumberOfBricks[1]
+    * this->NumberOfBricks[2];
+  this->BrickEpochs.reset(new std::atomic<vtkTypeUInt64>[numberOfBricks]);
+  for (vtkIdType brickId = 0; brickId < numberOfBricks; brickId++)
+    {
+    this->BrickEpochs[brickId] = 0;
+    }
+  this->CacheEpoch = 1;
+  this->NumberOfCachedBricks = 0;
+
+  this->SetFileName(fileName);
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::Close()
+{
+  if (!this->MappedData)
+    {
+    return;
+    }
+#ifdef _WIN32
+  UnmapViewOfFile(this->MappedData);
+  CloseHandle(static_cast<HANDLE>(this->MappingHandle));
+  CloseHandle(static_cast<HANDLE>(this->FileHandle));
+  this->MappingHandle = nullptr;
+  this->FileHandle = nullptr;
+#else
+  munmap(this->MappedData, this->MappedSize);
+#endif
+  this->MappedData = nullptr;
+  this->MappedSize = 0;
+  this->BrickEpochs.reset();
+  this->NumberOfCachedBricks = 0;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMappedDisplacementGrid::IsOpen()
+{
+  return (this->MappedData != nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::GetDirectionMatrix(vtkMatrix4x4* direction)
+{
+  if (!direction)
+    {
+    return;
+    }
+  direction->Identity();
+  for (int i = 0; i < 3; i++)
+    {
+    for (int j = 0; j < 3; j++)
+      {
+      direction->SetElement(i, j, this->Direction[3*i+j]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkMappedDisplacementGrid::GetNumberOfCachedBricks()
+{
+  return this->NumberOfCachedBricks;
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::TouchBrick(vtkIdType brickId)
+{
+  // Relaxed atomics: the epochs are only used to select bricks for eviction.
+  // The brick is counted by the thread that changes its epoch from 0.
+  vtkTypeUInt64 epoch = this->CacheEpoch.load(std::memory_order_relaxed);
+  vtkTypeUInt64 brickEpoch = this->BrickEpochs[brickId].load(std::memory_order_relaxed);
+  while (brickEpoch != epoch)
+    {
+    if (this->BrickEpochs[brickId].compare_exchange_weak(brickEpoch, epoch, std::memory_order_relaxed))
+      {
+      if (brickEpoch == 0)
+        {
+        this->NumberOfCachedBricks++;
+        }
+      break;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::EvictBrick(vtkIdType brickId)
+{
+  char* brickBegin = this->MappedData + vtkMappedDisplacementGridAlignment + brickId * this->BrickStride;
+#ifdef _WIN32
+  // Unlocking pages that are not locked removes them from the working set
+  VirtualUnlock(brickBegin, this->BrickStride);
+#else
+  // Only whole pages of the brick can be released
+  size_t pageSize = vtkMappedDisplacementGridPageSize();
+  size_t begin = (reinterpret_cast<size_t>(brickBegin) + pageSize - 1) / pageSize * pageSize;
+  size_t end = (reinterpret_cast<size_t>(brickBegin) + this->BrickStride) / pageSize * pageSize;
+  if (end > begin)
+    {
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::PrefetchRegion(const int indexBounds[6])
+{
+  if (!this->MappedData)
+    {
+    return;
+    }
+  int brickBegin[3], brickEnd[3];
+  for (int i = 0; i < 3; i++)
+    {
+    int begin = std::max(indexBounds[2*i], this->Extent[2*i]) - this->Extent[2*i];
+    int end = std::min(indexBounds[2*i+1], this->Extent[2*i+1]) - this->Extent[2*i];
+    if (end < begin)
+      {
+      return;
+      }
+    brickBegin[i] = std::min(begin / this->BrickSize, this->NumberOfBricks[i] - 1);
+    brickEnd[i] = std::min(end / this->BrickSize, this->NumberOfBricks[i] - 1);
+    }
+
+  for (int k = brickBegin[2]; k <= brickEnd[2]; k++)
+    {
+    for (int j = brickBegin[1]; j <= brickEnd[1]; j++)
+      {
+      for (int i = brickBegin[0]; i <= brickEnd[0]; i++)
+        {
+        vtkIdType brickId = (static_cast<vtkIdType>(k) * this->NumberOfBricks[1] + j) * this->NumberOfBricks[0] + i;
+        if (this->BrickEpochs[brickId].load(std::memory_order_relaxed) == 0)
+          {
+#ifndef _WIN32
+          size_t pageSize = vtkMappedDisplacementGridPageSize();
+          size_t begin = reinterpret_cast<size_t>(this->MappedData + vtkMappedDisplacementGridAlignment
+            + brickId * this->BrickStride) / pageSize * pageSize;
+          size_t end = reinterpret_cast<size_t>(this->MappedData + vtkMappedDisplacementGridAlignment
+            + (brickId + 1) * this->BrickStride);
+          madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+          }
+        this->TouchBrick(brickId);
+        }
+      }
+    }
+
+  if (this->NumberOfCachedBricks * this->BrickStride > this->CacheSize * 1024 * 1024)
+    {
+    this->TrimCache();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::TrimCache()
+{
+  if (!this->MappedData)
+    {
+    return;
+    }
+  std::lock_guard<std::mutex> lock(this->CacheMutex);
+
+  // Resident bricks, sorted by the epoch of their last use
+  vtkIdType numberOfBricks = static_cast<vtkIdType>(this->NumberOfBricks[0]) * this->NumberOfBricks[1]
+    * this->NumberOfBricks[2];
+  std::vector<std::pair<vtkTypeUInt64, vtkIdType> > cachedBricks;
+  for (vtkIdType brickId = 0; brickId < numberOfBricks; brickId++)
+    {
+    vtkTypeUInt64 brickEpoch = this->BrickEpochs[brickId].load(std::memory_order_relaxed);
+    if (brickEpoch != 0)
+      {
+      cachedBricks.push_back(std::make_pair(brickEpoch, brickId));
+      }
+    }
+
+  vtkIdType maximumNumberOfBricks = std::max<vtkIdType>(this->CacheSize * 1024 * 1024 / this->BrickStride, 1);
+  vtkIdType numberOfEvictedBricks = static_cast<vtkIdType>(cachedBricks.size()) - maximumNumberOfBricks;
+  if (numberOfEvictedBricks > 0)
+    {
+    std::nth_element(cachedBricks.begin(), cachedBricks.begin() + numberOfEvictedBricks, cachedBricks.end());
+    for (vtkIdType i = 0; i < numberOfEvictedBricks; i++)
+      {
+      // Bricks that were used by another thread meanwhile are kept
+      vtkTypeUInt64 brickEpoch = cachedBricks[i].first;
+      if (this->BrickEpochs[cachedBricks[i].second].compare_exchange_strong(brickEpoch, 0, std::memory_order_relaxed))
+        {
+        this->EvictBrick(cachedBricks[i].second);
+        this->NumberOfCachedBricks--;
+        }
+      }
+    }
+
+  // Bricks used after this point are more recent than the remaining ones
+  this->CacheEpoch++;
+}
+
+//----------------------------------------------------------------------------
+const char* vtkMappedDisplacementGrid::GetBrick(const int sampleIndex[3], int localIndex[3])
+{
+  int brickIndex[3];
+  for (int i = 0; i < 3; i++)
+    {
+    brickIndex[i] = std::min(sampleIndex[i] / this->BrickSize, this->NumberOfBricks[i] - 1);
+    localIndex[i] = sampleIndex[i] - brickIndex[i] * this->BrickSize;
+    }
+  vtkIdType brickId = (static_cast<vtkIdType>(brickIndex[2]) * this->NumberOfBricks[1] + brickIndex[1])
+    * this->NumberOfBricks[0] + brickIndex[0];
+  this->TouchBrick(brickId);
+  return this->MappedData + vtkMappedDisplacementGridAlignment + brickId * this->BrickStride;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkMappedDisplacementGrid::InterpolateNearestTemplate(const double point[3], double displacement[3],
+  double derivatives[3][3])
+{
+  int sampleIndex[3];
+  for (int i = 0; i < 3; i++)
+    {
+    int gridId = vtkMath::Floor(point[i] + 0.5) - this->Extent[2*i];
+    sampleIndex[i] = std::min(std::max(gridId, 0), this->Extent[2*i+1] - this->Extent[2*i]);
+    }
+  int localIndex[3];
+  const T* v = reinterpret_cast<const T*>(this->GetBrick(sampleIndex, localIndex))
+    + localIndex[0] * this->BrickIncrements[0] + localIndex[1] * this->BrickIncrements[1]
+    + localIndex[2] * this->BrickIncrements[2];
+  displacement[0] = v[0];
+  displacement[1] = v[1];
+  displacement[2] = v[2];
+
+  if (derivatives)
+    {
+    for (int i = 0; i < 3; i++)
+      {
+      derivatives[i][0] = derivatives[i][1] = derivatives[i][2] = 0.0;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkMappedDisplacementGrid::InterpolateLinearTemplate(const double point[3], double displacement[3],
+  double derivatives[3][3])
+{
+  // Clamp to the grid boundary the same way as vtkGridTransform
+  double f[3];
+  int gridId0[3], gridId1[3];
+  for (int i = 0; i < 3; i++)
+    {
+    int floorIndex = vtkMath::Floor(point[i]);
+    f[i] = point[i] - floorIndex;
+    gridId0[i] = floorIndex - this->Extent[2*i];
+    gridId1[i] = gridId0[i] + 1;
+    int ext = this->Extent[2*i+1] - this->Extent[2*i];
+    if (gridId0[i] < 0)
+      {
+      gridId0[i] = 0;
+      gridId1[i] = 0;
+      f[i] = 0;
+      }
+    else if (gridId1[i] > ext)
+      {
+      gridId0[i] = ext;
+      gridId1[i] = ext;
+      f[i] = 0;
+      }
+    }
+
+  // Both corners of the cell are in the brick of the first corner
+  int localIndex[3];
+  const T* brickPtr = reinterpret_cast<const T*>(this->GetBrick(gridId0, localIndex));
+  vtkIdType offset0[3], offset1[3];
+  for (int i = 0; i < 3; i++)
+    {
+    offset0[i] = localIndex[i] * this->BrickIncrements[i];
+    offset1[i] = (localIndex[i] + gridId1[i] - gridId0[i]) * this->BrickIncrements[i];
+    }
+
+  double rx = 1 - f[0];
+  double ry = 1 - f[1];
+  double rz = 1 - f[2];
+
+  double ryrz = ry*rz;
+  double ryfz = ry*f[2];
+  double fyrz = f[1]*rz;
+  double fyfz = f[1]*f[2];
+
+  const T *v000 = brickPtr + offset0[0] + offset0[1] + offset0[2];
+  const T *v001 = brickPtr + offset0[0] + offset0[1] + offset1[2];
+  const T *v010 = brickPtr + offset0[0] + offset1[1] + offset0[2];
+  const T *v011 = brickPtr + offset0[0] + offset1[1] + offset1[2];
+  const T *v100 = brickPtr + offset1[0] + offset0[1] + offset0[2];
+  const T *v101 = brickPtr + offset1[0] + offset0[1] + offset1[2];
+  const T *v110 = brickPtr + offset1[0] + offset1[1] + offset0[2];
+  const T *v111 = brickPtr + offset1[0] + offset1[1] + offset1[2];
+
+  for (int i = 0; i < 3; i++)
+    {
+    displacement[i] = (rx*(ryrz*v000[i] + ryfz*v001[i] + fyrz*v010[i] + fyfz*v011[i]) +
+                       f[0]*(ryrz*v100[i] + ryfz*v101[i] + fyrz*v110[i] + fyfz*v111[i]));
+    }
+
+  if (!derivatives)
+    {
+    return;
+    }
+
+  double rxrz = rx*rz;
+  double rxfz = rx*f[2];
+  double fxrz = f[0]*rz;
+  double fxfz = f[0]*f[2];
+  double rxry = rx*ry;
+  double rxfy = rx*f[1];
+  double fxry = f[0]*ry;
+  double fxfy = f[0]*f[1];
+
+  for (int i = 0; i < 3; i++)
+    {
+    derivatives[i][0] = (ryrz*(v100[i] - v000[i]) + ryfz*(v101[i] - v001[i]) +
+                         fyrz*(v110[i] - v010[i]) + fyfz*(v111[i] - v011[i]));
+    derivatives[i][1] = (rxrz*(v010[i] - v000[i]) + rxfz*(v011[i] - v001[i]) +
+                         fxrz*(v110[i] - v100[i]) + fxfz*(v111[i] - v101[i]));
+    derivatives[i][2] = (rxry*(v001[i] - v000[i]) + rxfy*(v011[i] - v010[i]) +
+                         fxry*(v101[i] - v100[i]) + fxfy*(v111[i] - v110[i]));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::InterpolateNearest(double point[3], double displacement[3],
+  double derivatives[3][3], void* gridPtr, int vtkNotUsed(gridType), int* vtkNotUsed(gridExt),
+  vtkIdType* vtkNotUsed(gridInc))
+{
+  vtkMappedDisplacementGrid* grid = static_cast<vtkMappedDisplacementGrid*>(gridPtr);
+  if (grid->ScalarType == VTK_FLOAT)
+    {
+    grid->InterpolateNearestTemplate<float>(point, displacement, derivatives);
+    }
+  else
+    {
+    grid->InterpolateNearestTemplate<double>(point, displacement, derivatives);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMappedDisplacementGrid::InterpolateLinear(double point[3], double displacement[3],
+  double derivatives[3][3], void* gridPtr, int vtkNotUsed(gridType), int* vtkNotUsed(gridExt),
+  vtkIdType* vtkNotUsed(gridInc))
+{
+  vtkMappedDisplacementGrid* grid = static_cast<vtkMappedDisplacementGrid*>(gridPtr);
+  if (grid->ScalarType == VTK_FLOAT)
+    {
+    grid->InterpolateLinearTemplate<float>(point, displacement, derivatives);
+    }
+  else
+    {
+    grid->InterpolateLinearTemplate<double>(point, displacement, derivatives);
+    }
+}
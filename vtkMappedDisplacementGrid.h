@@ -0,0 +1,201 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkMappedDisplacementGrid - memory-mapped, bricked displacement
+/// grid for out-of-core grid transforms.
+///
+/// Stores a 3-component float or double displacement grid in a file, split
+/// into cubic bricks. The file is memory-mapped when it is opened, so grids
+/// larger than the available memory can be used in a
+/// vtkOrientedGridTransform (see SetMappedDisplacementGrid).
+///
+/// Each brick of BrickSize cells stores BrickSize+1 samples along each axis
+/// (neighboring bricks share one layer of samples), therefore each
+/// interpolation reads a single brick. Bricks are aligned to memory pages.
+///
+/// Resident bricks are tracked in a cache of CacheSize megabytes. Batch
+/// evaluations prefetch the bricks of each block of points and evict the
+/// least recently used bricks from memory when the cache is full.
+/// Lookups do not lock, so the grid can be read from multiple threads.
+///
+/// The file is stored in the native byte order.
+///
+
+#ifndef __vtkMappedDisplacementGrid_h
+#define __vtkMappedDisplacementGrid_h
+
+#include "vtkAddon.h"
+
+#include "vtkObject.h"
+
+// STD includes
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+class vtkAlgorithm;
+class vtkImageData;
+class vtkMatrix4x4;
+
+class VTK_ADDON_EXPORT vtkMappedDisplacementGrid : public vtkObject
+{
+public:
+  static vtkMappedDisplacementGrid *New();
+  vtkTypeMacro(vtkMappedDisplacementGrid,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Write a displacement grid (3-component float or double image) to a
+  // bricked grid file. gridDirection is stored in the file (nullptr means
+  // identity). Returns false on error.
+  static bool WriteFile(const char* fileName, vtkImageData* grid, vtkMatrix4x4* gridDirection,
+    int brickSize = 32);
+
+  // Description:
+  // Write the output of an image algorithm (for example
+  // vtkOrientedTransformToGrid) to a bricked grid file. The output is
+  // requested in slabs of one brick layer, so the whole grid never has to
+  // be in memory. Returns false on error.
+  static bool WriteFile(const char* fileName, vtkAlgorithm* source, vtkMatrix4x4* gridDirection,
+    int brickSize = 32);
+
+  // Description:
+  // Memory-map a bricked grid file. Returns false if the file cannot be
+  // opened or it is not a valid grid file.
+  bool Open(const char* fileName);
+
+  // Description:
+  // Unmap the grid file.
+  void Close();
+
+  // Description:
+  // Returns true if a grid file is mapped.
+  bool IsOpen();
+
+  // Description:
+  // Get the name of the mapped file.
+  vtkGetStringMacro(FileName);
+
+  // Description:
+  // Get the geometry of the mapped grid.
+  vtkGetVector6Macro(Extent,int);
+  vtkGetVector3Macro(Origin,double);
+  vtkGetVector3Macro(Spacing,double);
+
+  // Description:
+  // Get the grid axis directions stored in the file.
+  void GetDirectionMatrix(vtkMatrix4x4* direction);
+
+  // Description:
+  // Get the scalar type (VTK_FLOAT or VTK_DOUBLE) and the brick size
+  // (number of cells along each axis) of the mapped grid.
+  vtkGetMacro(ScalarType,int);
+  vtkGetMacro(BrickSize,int);
+
+  // Description:
+  // Set/Get the maximum size of resident bricks in megabytes.
+  // Default is 1024.
+  vtkSetMacro(CacheSize,vtkIdType);
+  vtkGetMacro(CacheSize,vtkIdType);
+
+  // Description:
+  // Get the number of bricks that are currently tracked as resident.
+  vtkIdType GetNumberOfCachedBricks();
+
+  // Description:
+  // Ask the operating system to read the bricks that contain the
+  // specified grid index range (i0, i1, j0, j1, k0, k1) in advance.
+  // The cache is trimmed if it becomes full.
+  void PrefetchRegion(const int indexBounds[6]);
+
+  // Description:
+  // Evict the least recently used bricks from memory until the resident
+  // bricks fit in the cache. Single point evaluations do not trim the
+  // cache, batch evaluations of vtkOrientedGridTransform trim it when
+  // they are completed.
+  void TrimCache();
+
+#ifndef __VTK_WRAP__
+  // Description:
+  // Interpolation functions with the signature of the
+  // vtkGridTransform::InterpolationFunction. gridPtr must point to a
+  // vtkMappedDisplacementGrid, gridType, gridExt and gridInc are ignored.
+  // The border handling is the same as in vtkGridTransform.
+  static void InterpolateNearest(double point[3], double displacement[3], double derivatives[3][3],
+    void* gridPtr, int gridType, int gridExt[6], vtkIdType gridInc[3]);
+  static void InterpolateLinear(double point[3], double displacement[3], double derivatives[3][3],
+    void* gridPtr, int gridType, int gridExt[6], vtkIdType gridInc[3]);
+#endif
+
+protected:
+  vtkMappedDisplacementGrid();
+  ~vtkMappedDisplacementGrid() override;
+
+  vtkSetStringMacro(FileName);
+
+  // Description:
+  // Get the brick that contains a grid sample (relative to the extent
+  // start) and the sample index within the brick. The brick is marked as
+  // recently used.
+  const char* GetBrick(const int sampleIndex[3], int localIndex[3]);
+
+  template <class T>
+  void InterpolateNearestTemplate(const double point[3], double displacement[3], double derivatives[3][3]);
+  template <class T>
+  void InterpolateLinearTemplate(const double point[3], double displacement[3], double derivatives[3][3]);
+
+  // Description:
+  // Mark a brick as recently used.
+  void TouchBrick(vtkIdType brickId);
+
+  // Description:
+  // Release a range of the mapped memory.
+  void EvictBrick(vtkIdType brickId);
+
+  char* FileName;
+
+  int Extent[6];
+  double Origin[3];
+  double Spacing[3];
+  double Direction[9];
+  int ScalarType;
+  int BrickSize;
+
+  // Description:
+  // Number of bricks along each axis, size of a brick in the file and
+  // increments between samples within a brick (in scalar values).
+  int NumberOfBricks[3];
+  vtkIdType BrickStride;
+  vtkIdType BrickIncrements[3];
+
+  // Description:
+  // Mapped file.
+  char* MappedData;
+  size_t MappedSize;
+#ifdef _WIN32
+  void* FileHandle;
+  void* MappingHandle;
+#endif
+
+  // Description:
+  // Brick cache: the last cache epoch when each brick was used
+  // (0 if not resident). Epochs are 64-bit so that they do not wrap
+  // around, as a wrapped epoch would be taken as not resident.
+  vtkIdType CacheSize;
+  std::unique_ptr<std::atomic<vtkTypeUInt64>[]> BrickEpochs;
+  std::atomic<vtkTypeUInt64> CacheEpoch;
+  std::atomic<vtkIdType> NumberOfCachedBricks;
+  std::mutex CacheMutex;
+
+private:
+  vtkMappedDisplacementGrid(const vtkMappedDisplacementGrid&) = delete;
+  void operator=(const vtkMappedDisplacementGrid&) = delete;
+};
+
+#endif
@@ -26,6 +26,9 @@
 #include "vtkPolyDataMapper.h"
 #include "vtkProperty.h"
 
+#include "vtkStreamingVolumeCodec.h"
+#include "vtkStreamingVolumeFrame.h"
+
 #include "vtkOpenGL.h"
 #include <math.h>
 
@@ -41,13 +44,37 @@ vtkOpenGLTextureImage::vtkOpenGLTextureImage()
   this->Interpolate = 1;
   this->TextureMTime = 0;
   this->TextureWrap = vtkOpenGLTextureImage::ClampToEdge;
+  this->TextureDimensions[0] = 0;
+  this->TextureDimensions[1] = 0;
+  this->TextureDimensions[2] = 0;
+  this->TextureScalarType = VTK_VOID;
+  this->TextureComponentCount = 0;
+  this->PixelUnpackBufferName = 0;
+  this->DecodedImageData = vtkImageData::New();
 }
 
 //----------------------------------------------------------------------------
 vtkOpenGLTextureImage::~vtkOpenGLTextureImage()
 {
+  if (this->ShaderComputation && (this->TextureName != 0 || this->PixelUnpackBufferName != 0))
+    {
+    // the OpenGL objects were created in the context of the ShaderComputation
+    this->ShaderComputation->MakeCurrent();
+    if (this->PixelUnpackBufferName != 0)
+      {
+      glDeleteBuffers(1, &(this->PixelUnpackBufferName));
+      this->PixelUnpackBufferName = 0;
+      }
+    if (this->TextureName != 0)
+      {
+      glDeleteTextures(1, &(this->TextureName));
+      this->TextureName = 0;
+      }
+    }
   this->SetShaderComputation(nullptr);
   this->SetImageData(nullptr);
+  this->DecodedImageData->Delete();
+  this->DecodedImageData = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -83,38 +110,8 @@ GLenum vtkOpenGLTextureImage::vtkScalarTypeToGLType(int vtk_scalar_type)
 }
 
 //----------------------------------------------------------------------------
-// Reload the texture if needed
-//
-bool vtkOpenGLTextureImage::UpdateTexture()
+bool vtkOpenGLTextureImage::GetTextureFormat(int componentCount, GLenum& format, GLenum& internalFormat)
 {
-  if (!this->ShaderComputation || !this->ShaderComputation->GetInitialized())
-    {
-    vtkErrorMacro("No initialized ShaderComputation instance is set.");
-    return false;
-    }
-  this->ShaderComputation->MakeCurrent();
-
-  if (this->ImageData == nullptr)
-    {
-    return false;
-    }
-
-  if (this->ImageData->GetMTime() > this->TextureMTime)
-    {
-    if (this->TextureName != 0)
-      {
-      glDeleteTextures (1, &(this->TextureName) );
-      }
-    this->TextureMTime = 0;
-    }
-  else
-    {
-    return true;
-    }
-
-  int componentCount = this->ImageData->GetNumberOfScalarComponents();
-  GLenum format;
-  GLenum internalFormat;
   if ( componentCount == 1 )
     {
     format = GL_RED;
@@ -132,17 +129,38 @@ bool vtkOpenGLTextureImage::UpdateTexture()
     }
   else
     {
-    vtkErrorMacro("Must have 1, 3 or 4 component image data for texture");
     return false;
     }
+  return true;
+}
 
-  int dimensions[3];
-  this->ImageData->GetDimensions(dimensions);
-  vtkPointData *pointData = this->ImageData->GetPointData();
-  vtkDataArray *scalars = pointData->GetScalars();
-  void *pixels = scalars->GetVoidPointer(0);
+//----------------------------------------------------------------------------
+bool vtkOpenGLTextureImage::AllocateTexture(const int dimensions[3], int scalarType, int componentCount)
+{
+  if (this->TextureName != 0 &&
+      this->TextureDimensions[0] == dimensions[0] &&
+      this->TextureDimensions[1] == dimensions[1] &&
+      this->TextureDimensions[2] == dimensions[2] &&
+      this->TextureScalarType == scalarType &&
+      this->TextureComponentCount == componentCount)
+    {
+    // existing storage can be reused
+    return true;
+    }
 
-  vtkOpenGLCheckErrorMacro("before uploading");
+  GLenum format;
+  GLenum internalFormat;
+  if (!vtkOpenGLTextureImage::GetTextureFormat(componentCount, format, internalFormat))
+    {
+    vtkErrorMacro("Must have 1, 3 or 4 component image data for texture");
+    return false;
+    }
+
+  if (this->TextureName != 0)
+    {
+    glDeleteTextures (1, &(this->TextureName) );
+    this->TextureName = 0;
+    }
 
   glGenTextures(1, &(this->TextureName));
   glBindTexture(GL_TEXTURE_3D, this->TextureName);
@@ -179,12 +197,238 @@ bool vtkOpenGLTextureImage::UpdateTexture()
                /* depth */             dimensions[2],
                /* border */            0,
                /* format */            format,
+               /* type */              vtkScalarTypeToGLType(scalarType),
+               /* pixels */            nullptr
+  );
+
+  this->TextureDimensions[0] = dimensions[0];
+  this->TextureDimensions[1] = dimensions[1];
+  this->TextureDimensions[2] = dimensions[2];
+  this->TextureScalarType = scalarType;
+  this->TextureComponentCount = componentCount;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Reload the texture if needed
+//
+bool vtkOpenGLTextureImage::UpdateTexture()
+{
+  if (!this->ShaderComputation || !this->ShaderComputation->GetInitialized())
+    {
+    vtkErrorMacro("No initialized ShaderComputation instance is set.");
+    return false;
+    }
+  this->ShaderComputation->MakeCurrent();
+
+  if (this->ImageData == nullptr)
+    {
+    // the texture may have been filled by DecodeFrame
+    return this->TextureName != 0;
+    }
+
+  if (this->TextureName != 0 && this->ImageData->GetMTime() <= this->TextureMTime)
+    {
+    return true;
+    }
+
+  int componentCount = this->ImageData->GetNumberOfScalarComponents();
+  GLenum format;
+  GLenum internalFormat;
+  if (!vtkOpenGLTextureImage::GetTextureFormat(componentCount, format, internalFormat))
+    {
+    vtkErrorMacro("Must have 1, 3 or 4 component image data for texture");
+    return false;
+    }
+
+  int dimensions[3];
+  this->ImageData->GetDimensions(dimensions);
+  vtkPointData *pointData = this->ImageData->GetPointData();
+  vtkDataArray *scalars = pointData->GetScalars();
+  void *pixels = scalars->GetVoidPointer(0);
+
+  vtkOpenGLCheckErrorMacro("before uploading");
+
+  if (!this->AllocateTexture(dimensions, this->ImageData->GetScalarType(), componentCount))
+    {
+    return false;
+    }
+
+  glBindTexture(GL_TEXTURE_3D, this->TextureName);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(
+               /* target */            GL_TEXTURE_3D,
+               /* level */             0,
+               /* offset */            0, 0, 0,
+               /* width */             dimensions[0],
+               /* height */            dimensions[1],
+               /* depth */             dimensions[2],
+               /* format */            format,
                /* type */              vtkScalarTypeToGLType(this->ImageData->GetScalarType()),
                /* pixels */            pixels
   );
   vtkOpenGLCheckErrorMacro("after uploading");
 
-  this->TextureMTime = this->GetMTime();
+  this->TextureMTime = this->ImageData->GetMTime();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOpenGLTextureImage::DecodeFrame(vtkStreamingVolumeCodec* codec, vtkStreamingVolumeFrame* frame)
+{
+  if (!codec || !frame)
+    {
+    vtkErrorMacro("Invalid arguments!");
+    return false;
+    }
+
+  if (!this->ShaderComputation || !this->ShaderComputation->GetInitialized())
+    {
+    vtkErrorMacro("No initialized ShaderComputation instance is set.");
+    return false;
+    }
+  this->ShaderComputation->MakeCurrent();
+
+  int dimensions[3] = {0,0,0};
+  frame->GetDimensions(dimensions);
+  int scalarType = frame->GetVTKScalarType();
+  int componentCount = frame->GetNumberOfComponents();
+
+  GLenum format;
+  GLenum internalFormat;
+  if (!vtkOpenGLTextureImage::GetTextureFormat(componentCount, format, internalFormat))
+    {
+    vtkErrorMacro("Must have 1, 3 or 4 component frame for texture");
+    return false;
+    }
+  GLenum type = vtkScalarTypeToGLType(scalarType);
+  vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+  if (type == 0 || !scalars)
+    {
+    vtkErrorMacro("Unsupported frame scalar type: " << scalarType);
+    return false;
+    }
+
+  vtkIdType numberOfValues = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2] * componentCount;
+  GLsizeiptr numberOfBytes = static_cast<GLsizeiptr>(numberOfValues) * scalars->GetDataTypeSize();
+  if (numberOfBytes == 0)
+    {
+    vtkErrorMacro("Cannot decode frame, number of voxels is zero");
+    return false;
+    }
+
+  vtkOpenGLCheckErrorMacro("before decoding");
+
+  if (!this->AllocateTexture(dimensions, scalarType, componentCount))
+    {
+    return false;
+    }
+
+  // Frames that depend on previous frames are decoded by updating the output image,
+  // which cannot be read from the write-only mapped buffer, so they are decoded on the CPU.
+  void* mappedPixels = nullptr;
+  if (!frame->GetPreviousFrame())
+    {
+    if (this->PixelUnpackBufferName == 0)
+      {
+      glGenBuffers(1, &(this->PixelUnpackBufferName));
+      }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->PixelUnpackBufferName);
+    // Orphan the previous buffer contents so that mapping does not wait for the previous transfer
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, numberOfBytes, nullptr, GL_STREAM_DRAW);
+    mappedPixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, numberOfBytes,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mappedPixels)
+      {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      vtkErrorMacro("Could not map pixel unpack buffer.");
+      return false;
+      }
+
+    // Let the codec write directly into the mapped buffer.
+    scalars->SetNumberOfComponents(componentCount);
+    scalars->SetVoidArray(mappedPixels, numberOfValues, 1);
+    this->DecodedImageData->SetDimensions(dimensions);
+    this->DecodedImageData->GetPointData()->SetScalars(scalars);
+    }
+  else if (this->ReferenceCodec != codec || this->ReferenceFrame != codec->GetLastDecodedFrame()
+    || !this->DecodedImageData->GetPointData()->GetScalars()
+    || this->DecodedImageData->GetDimensions()[0] != dimensions[0]
+    || this->DecodedImageData->GetDimensions()[1] != dimensions[1]
+    || this->DecodedImageData->GetDimensions()[2] != dimensions[2])
+    {
+    // The reference image does not contain the last frame decoded by the codec,
+    // the frame is decoded starting from its keyframe
+    codec->ResetLastDecodedFrame();
+    this->DecodedImageData->SetDimensions(dimensions);
+    this->DecodedImageData->AllocateScalars(scalarType, componentCount);
+    }
+
+  bool success = codec->DecodeFrame(frame, this->DecodedImageData);
+  if (success && !mappedPixels)
+    {
+    this->ReferenceCodec = codec;
+    this->ReferenceFrame = frame;
+    }
+  else
+    {
+    this->ReferenceCodec = nullptr;
+    this->ReferenceFrame = nullptr;
+    }
+  // the codec may have resized the output, for example when decoding a reduced resolution level
+  bool decodedInPlace = (mappedPixels && this->DecodedImageData->GetScalarPointer() == mappedPixels);
+
+  glBindTexture(GL_TEXTURE_3D, this->TextureName);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (mappedPixels)
+    {
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+      {
+      vtkErrorMacro("Pixel unpack buffer contents were lost while decoding.");
+      success = false;
+      }
+    if (success && decodedInPlace)
+      {
+      // pixels are read from offset 0 of the bound pixel unpack buffer
+      glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0,
+        dimensions[0], dimensions[1], dimensions[2], format, type, nullptr);
+      }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+  if (success && !decodedInPlace)
+    {
+    int decodedDimensions[3] = {0,0,0};
+    this->DecodedImageData->GetDimensions(decodedDimensions);
+    success = this->AllocateTexture(decodedDimensions, scalarType, componentCount);
+    if (success)
+      {
+      glBindTexture(GL_TEXTURE_3D, this->TextureName);
+      glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0,
+        decodedDimensions[0], decodedDimensions[1], decodedDimensions[2], format, type,
+        this->DecodedImageData->GetScalarPointer());
+      }
+    }
+
+  if (mappedPixels)
+    {
+    // do not keep a reference to the unmapped buffer
+    this->DecodedImageData->GetPointData()->SetScalars(nullptr);
+    }
+
+  vtkOpenGLCheckErrorMacro("after decoding");
+
+  if (!success)
+    {
+    vtkErrorMacro("Could not decode frame into texture.");
+    return false;
+    }
+
+  // the texture is now newer than the image data
+  if (this->ImageData)
+    {
+    this->TextureMTime = this->ImageData->GetMTime();
+    }
   return true;
 }
 
@@ -256,8 +500,8 @@ void vtkOpenGLTextureImage::AttachAsDrawTarget(int attachmentIndex, int layer, i
 
   vtkOpenGLClearErrorMacro();
 
-  int dimensions[3] = {0,0,0};
-  this->ImageData->GetDimensions(dimensions);
+  // use the texture geometry, the texture may have been filled by DecodeFrame
+  int* dimensions = this->TextureDimensions;
 
   //
   // Set up a normalized rendering environment
@@ -367,4 +611,7 @@ void vtkOpenGLTextureImage::PrintSelf(ostream& os, vtkIndent indent)
     }
   os << indent << "TextureName: " << this->TextureName << "\n";
   os << indent << "TextureMTime: " << this->TextureMTime << "\n";
+  os << indent << "TextureDimensions: (" << this->TextureDimensions[0] << ", "
+     << this->TextureDimensions[1] << ", " << this->TextureDimensions[2] << ")\n";
+  os << indent << "PixelUnpackBufferName: " << this->PixelUnpackBufferName << "\n";
 }
@@ -30,9 +30,12 @@
 #include "vtkOpenGL.h"
 
 #include "vtkImageData.h"
+#include "vtkWeakPointer.h"
 
 #include "vtkAddon.h"
 
+class vtkStreamingVolumeCodec;
+class vtkStreamingVolumeFrame;
 
 /*
 #ifndef _WIN32
@@ -107,8 +110,29 @@ public:
 
   // Description:
   // Creates/transfers image data to texture if needed.
+  // The texture storage is only reallocated if the dimensions,
+  // scalar type or number of components of the image data change.
   bool UpdateTexture();
 
+  // Description:
+  // Decode a compressed frame directly into the texture.
+  // The codec writes the decoded voxels into a mapped pixel unpack
+  // buffer, which is then transferred with glTexSubImage3D into the
+  // existing texture storage, avoiding the intermediate vtkImageData
+  // and the reallocation of the texture for each frame.
+  // The mapped buffer is write-only: the codec must only write the
+  // output image, never read it. Frames that have a PreviousFrame are
+  // decoded by updating the previously decoded image, therefore they are
+  // decoded into a CPU reference image that is then uploaded to the
+  // texture. If the reference image does not contain the previous frame
+  // of the codec (for example because it was decoded into the mapped
+  // buffer), the frame is decoded starting from its keyframe.
+  // The codecs decode whole frames, therefore the frame is transferred
+  // with a single glTexSubImage3D call instead of slab by slab.
+  // The ImageData is not modified, and is not uploaded again until it
+  // is modified.
+  bool DecodeFrame(vtkStreamingVolumeCodec* codec, vtkStreamingVolumeFrame* frame);
+
   // Description:
   // Make the specified layer (slice) be the draw target.
   // This is used to direct the output of the shading into
@@ -151,6 +175,17 @@ protected:
   vtkOpenGLTextureImage();
   ~vtkOpenGLTextureImage() override;
 
+  // Description:
+  // Get the pixel format for the number of components.
+  // Returns false if the number of components is not supported.
+  static bool GetTextureFormat(int componentCount, GLenum& format, GLenum& internalFormat);
+
+  // Description:
+  // Generate the texture and allocate its storage, if the current
+  // texture does not already match the specified geometry.
+  // The contents of a newly allocated texture are undefined.
+  bool AllocateTexture(const int dimensions[3], int scalarType, int componentCount);
+
 private:
   vtkOpenGLTextureImage(const vtkOpenGLTextureImage&) = delete;
   void operator=(const vtkOpenGLTextureImage&) = delete;
@@ -162,6 +197,21 @@ private:
   unsigned long TextureMTime;
   int TextureWrap;
 
+  // Geometry of the currently allocated texture storage
+  int TextureDimensions[3];
+  int TextureScalarType;
+  int TextureComponentCount;
+
+  // Buffer used to transfer decoded frames, see DecodeFrame().
+  // Deleted with the texture when this object is destroyed.
+  vtkTypeUInt32 PixelUnpackBufferName;
+  vtkImageData *DecodedImageData;
+
+  // Codec and frame of the image that is kept in DecodedImageData,
+  // which predicted frames of the same codec are decoded from
+  vtkWeakPointer<vtkStreamingVolumeCodec> ReferenceCodec;
+  vtkWeakPointer<vtkStreamingVolumeFrame> ReferenceFrame;
+
 };
 
 #endif
@@ -12,15 +12,26 @@
 #include "vtkImageData.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkOrientedGridTransform.h"
+#include "vtkOrientedTransformInverseStatistics.h"
+#include "vtkOrientedTransformLattice.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 
+#include <algorithm>
 #include <math.h>
+#include <vector>
 
 vtkStandardNewMacro(vtkOrientedBSplineTransform);
 
 vtkCxxSetObjectMacro(vtkOrientedBSplineTransform,GridDirectionMatrix,vtkMatrix4x4);
 vtkCxxSetObjectMacro(vtkOrientedBSplineTransform,BulkTransformMatrix,vtkMatrix4x4);
 
+// Number of consecutive points that are inverted in sequence in InverseTransformPoints
+static const vtkIdType vtkOrientedBSplineTransformInverseBlockSize = 1024;
+
 //------------------------------------------------------------------------
 inline void vtkLinearTransformPoint(const double matrix[4][4],
                                     const double in[3], double out[3])
@@ -85,6 +96,19 @@ vtkOrientedBSplineTransform::vtkOrientedBSplineTransform()
   this->GridIndexToOutputTransformMatrixCached = vtkMatrix4x4::New();
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
   this->InverseBulkTransformMatrixCached = vtkMatrix4x4::New();
+
+  this->InverseStatistics = vtkOrientedTransformInverseStatistics::New();
+  this->InverseStatisticsEventInterval = 0;
+  this->InverseSolver = vtkOrientedBSplineTransform::NewtonSolver;
+
+  this->HierarchicalInverse = false;
+  this->HierarchicalInverseDownsamplingFactor = 2;
+  this->CoarseInverseTransform = nullptr;
+
+  this->LastWarningMTime = 0;
+  this->ThreadSafeEvaluation = false;
+  this->PendingConvergenceFailures = 0;
+  this->PendingInverseStatisticsEvent = false;
 }
 
 //----------------------------------------------------------------------------
@@ -107,6 +131,16 @@ vtkOrientedBSplineTransform::~vtkOrientedBSplineTransform()
     this->InverseBulkTransformMatrixCached->Delete();
     this->InverseBulkTransformMatrixCached=nullptr;
     }
+  if (this->InverseStatistics!=nullptr)
+    {
+    this->InverseStatistics->Delete();
+    this->InverseStatistics=nullptr;
+    }
+  if (this->CoarseInverseTransform!=nullptr)
+    {
+    this->CoarseInverseTransform->Delete();
+    this->CoarseInverseTransform=nullptr;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -124,6 +158,39 @@ void vtkOrientedBSplineTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GetBulkTransformMatrix()->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "ThreadSafeEvaluation: " << (this->ThreadSafeEvaluation ? "true" : "false") << "\n";
+  os << indent << "InverseSolver: " << (this->InverseSolver == vtkOrientedBSplineTransform::BroydenSolver ? "Broyden" : "Newton") << "\n";
+  os << indent << "HierarchicalInverse: " << (this->HierarchicalInverse ? "true" : "false") << "\n";
+  os << indent << "HierarchicalInverseDownsamplingFactor: " << this->HierarchicalInverseDownsamplingFactor << "\n";
+  os << indent << "InverseStatisticsEventInterval: " << this->InverseStatisticsEventInterval << "\n";
+  os << indent << "InverseStatistics:\n";
+  this->InverseStatistics->PrintSelf(os,indent.GetNextIndent());
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::ResetInverseStatistics()
+{
+  this->InverseStatistics->Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::InvokePendingEvents()
+{
+  vtkIdType numberOfFailures = this->PendingConvergenceFailures.exchange(0);
+  if (numberOfFailures > 0)
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence for " << numberOfFailures << " points."
+                      "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedBSplineTransform::ConvergenceFailureEvent);
+    }
+  if (this->PendingInverseStatisticsEvent.exchange(false))
+    {
+    this->InvokeEvent(vtkOrientedBSplineTransform::InverseStatisticsEvent);
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -236,10 +303,16 @@ void vtkOrientedBSplineTransform::ForwardTransformDerivative(const double inPoin
 // singular.
 // Note that this is similar to vtkWarpTransform::InverseTransformPoint()
 // but has been optimized specifically for uniform grid transforms.
-void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPointTemp[3],
-                                                     double outPoint[3],
-                                                     double derivative[3][3])
+bool vtkOrientedBSplineTransform::InverseTransformPointNewton(const double inPointTemp[3],
+                                                              const double* initialGuess,
+                                                              double outPoint[3],
+                                                              double derivative[3][3],
+                                                              int& numberOfIterations,
+                                                              double& errorSquared)
 {
+  numberOfIterations = 0;
+  errorSquared = 0.0;
+
   // inPointTemp and outPoint may be the same vector, so make a copy of the
   // input before modifying the output
   double inPoint[3] = {inPointTemp[0],inPointTemp[1],inPointTemp[2]};
@@ -260,7 +333,7 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
 
   if (!this->GridPointer || !this->CalculateSpline)
     {
-    return;
+    return true;
     }
 
   void *gridPtr = this->GridPointer;
@@ -276,28 +349,36 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   double functionDerivative = 0;
   double lastFunctionValue = VTK_DOUBLE_MAX;
 
-  double errorSquared = 0.0;
   double toleranceSquared = this->InverseTolerance * this->InverseTolerance;
 
   double f = 1.0;
   double a;
 
-  double inPoint_IJK[3];
-  // Convert the inPoint to i,j,k indices into the deformation grid
-  // plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, inPoint_IJK);
-
-  // first guess at inverse_IJK point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->CalculateSpline(inPoint_IJK, deltaP, nullptr,
-                        gridPtr, extent, increments, this->BorderMode);
+  if (initialGuess)
+    {
+    inverse[0] = initialGuess[0];
+    inverse[1] = initialGuess[1];
+    inverse[2] = initialGuess[2];
+    }
+  else
+    {
+    double inPoint_IJK[3];
+    // Convert the inPoint to i,j,k indices into the deformation grid
+    // plus fractions
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, inPoint_IJK);
+
+    // first guess at inverse_IJK point, just subtract displacement
+    // (the inverse point is given in i,j,k indices plus fractions)
+    this->CalculateSpline(inPoint_IJK, deltaP, nullptr,
+                          gridPtr, extent, increments, this->BorderMode);
 
-  double inverseBulkTransformedInPoint[3];
-  vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element,inPoint,inverseBulkTransformedInPoint);
+    double inverseBulkTransformedInPoint[3];
+    vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element,inPoint,inverseBulkTransformedInPoint);
 
-  inverse[0] = inverseBulkTransformedInPoint[0] - deltaP[0]*scale;
-  inverse[1] = inverseBulkTransformedInPoint[1] - deltaP[1]*scale;
-  inverse[2] = inverseBulkTransformedInPoint[2] - deltaP[2]*scale;
+    inverse[0] = inverseBulkTransformedInPoint[0] - deltaP[0]*scale;
+    inverse[1] = inverseBulkTransformedInPoint[1] - deltaP[1]*scale;
+    inverse[2] = inverseBulkTransformedInPoint[2] - deltaP[2]*scale;
+    }
   lastInverse[0] = inverse[0];
   lastInverse[1] = inverse[1];
   lastInverse[2] = inverse[2];
@@ -418,17 +499,14 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
     inverse[2] = lastInverse[2] - f*deltaI[2];
     }
 
-  if (iteration >= maxNumberOfIterations)
+  numberOfIterations = iteration;
+  bool converged = (iteration < maxNumberOfIterations);
+  if (!converged)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
-
-    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                    ") error = " << sqrt(errorSquared) << " after " <<
-                    iteration << " iterations.");
     }
 
   // Convert the inPoint to i,j,k indices into the deformation grid
@@ -436,6 +514,1212 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::ComputeInverseError(const double point[3], const double target[3],
+                                                      double errorVector[3], double derivative[3][3])
+{
+  double scale = this->DisplacementScale;
+
+  double point_IJK[3], deltaP[3], splineDerivative[3][3];
+  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, point, point_IJK);
+  this->CalculateSpline(point_IJK, deltaP, derivative ? splineDerivative : nullptr,
+                        this->GridPointer, this->GridExtent, this->GridIncrements, this->BorderMode);
+
+  double bulkTransformed[3];
+  if (this->BulkTransformMatrix)
+    {
+    if (derivative)
+      {
+      vtkLinearTransformDerivative(this->BulkTransformMatrix->Element, point, bulkTransformed, derivative);
+      }
+    else
+      {
+      vtkLinearTransformPoint(this->BulkTransformMatrix->Element, point, bulkTransformed);
+      }
+    }
+  else
+    {
+    bulkTransformed[0] = point[0];
+    bulkTransformed[1] = point[1];
+    bulkTransformed[2] = point[2];
+    if (derivative)
+      {
+      vtkMath::Identity3x3(derivative);
+      }
+    }
+
+  if (derivative)
+    {
+    vtkLinearTransformJacobian(splineDerivative, this->OutputToGridIndexTransformMatrixCached->Element, splineDerivative);
+    for (int i = 0; i < 3; i++)
+      {
+      derivative[i][0] += splineDerivative[i][0]*scale;
+      derivative[i][1] += splineDerivative[i][1]*scale;
+      derivative[i][2] += splineDerivative[i][2]*scale;
+      }
+    }
+
+  errorVector[0] = (bulkTransformed[0] + deltaP[0]*scale) - target[0];
+  errorVector[1] = (bulkTransformed[1] + deltaP[1]*scale) - target[1];
+  errorVector[2] = (bulkTransformed[2] + deltaP[2]*scale) - target[2];
+}
+
+//----------------------------------------------------------------------------
+// Broyden's method: the derivative is evaluated at the first guess, and
+// then it is updated using the spline values of the following iterations
+// (rank-1 secant update). If a step does not decrease the error, then the
+// derivative is evaluated again at the last point. If the error does not
+// decrease even with the exact derivative, then the step is shortened.
+bool vtkOrientedBSplineTransform::InverseTransformPointBroyden(const double inPointTemp[3],
+                                                               const double* initialGuess,
+                                                               double outPoint[3],
+                                                               double derivative[3][3],
+                                                               int& numberOfIterations,
+                                                               double& errorSquared)
+{
+  numberOfIterations = 0;
+  errorSquared = 0.0;
+
+  // inPointTemp and outPoint may be the same vector, so make a copy of the
+  // input before modifying the output
+  double inPoint[3] = {inPointTemp[0],inPointTemp[1],inPointTemp[2]};
+
+  if (!this->GridPointer || !this->CalculateSpline)
+    {
+    if (this->BulkTransformMatrix)
+      {
+      if (derivative)
+        {
+        vtkLinearTransformDerivative(this->InverseBulkTransformMatrixCached->Element,inPoint,outPoint,derivative);
+        }
+      else
+        {
+        vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element,inPoint,outPoint);
+        }
+      }
+    else
+      {
+      outPoint[0] = inPoint[0];
+      outPoint[1] = inPoint[1];
+      outPoint[2] = inPoint[2];
+      if (derivative)
+        {
+        vtkMath::Identity3x3(derivative);
+        }
+      }
+    return true;
+    }
+
+  double inverse[3];
+  if (initialGuess)
+    {
+    inverse[0] = initialGuess[0];
+    inverse[1] = initialGuess[1];
+    inverse[2] = initialGuess[2];
+    }
+  else
+    {
+    // first guess: inverse bulk transform minus the displacement at the input point
+    double inPoint_IJK[3], deltaP[3];
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, inPoint_IJK);
+    this->CalculateSpline(inPoint_IJK, deltaP, nullptr,
+                          this->GridPointer, this->GridExtent, this->GridIncrements, this->BorderMode);
+    double scale = this->DisplacementScale;
+    vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element, inPoint, inverse);
+    inverse[0] -= deltaP[0]*scale;
+    inverse[1] -= deltaP[1]*scale;
+    inverse[2] -= deltaP[2]*scale;
+    }
+
+  double toleranceSquared = this->InverseTolerance * this->InverseTolerance;
+  int maxNumberOfIterations = this->InverseIterations;
+
+  double jacobian[3][3];
+  double errorVector[3], deltaI[3];
+  this->ComputeInverseError(inverse, inPoint, errorVector, jacobian);
+  double functionValue = vtkMath::Dot(errorVector, errorVector);
+  bool jacobianUpToDate = true;
+  int numberOfEvaluations = 1;
+
+  double f = 1.0;
+  bool converged = false;
+  for (;;)
+    {
+    vtkMath::LinearSolve3x3(jacobian,errorVector,deltaI);
+
+    // get the error value in the output coord space
+    errorSquared = vtkMath::Dot(deltaI, deltaI);
+
+    // break if less than tolerance in both coordinate systems
+    if (errorSquared < toleranceSquared &&
+        functionValue < toleranceSquared)
+      {
+      converged = true;
+      break;
+      }
+    if (numberOfEvaluations >= maxNumberOfIterations)
+      {
+      break;
+      }
+
+    double trialInverse[3] = { inverse[0] - f*deltaI[0], inverse[1] - f*deltaI[1], inverse[2] - f*deltaI[2] };
+    double trialErrorVector[3];
+    this->ComputeInverseError(trialInverse, inPoint, trialErrorVector, nullptr);
+    numberOfEvaluations++;
+    double trialFunctionValue = vtkMath::Dot(trialErrorVector, trialErrorVector);
+
+    if (trialFunctionValue < functionValue)
+      {
+      // Broyden update: jacobian += (deltaError - jacobian * step) * step^T / (step^T * step)
+      double step[3] = { trialInverse[0] - inverse[0], trialInverse[1] - inverse[1], trialInverse[2] - inverse[2] };
+      double stepSquared = vtkMath::Dot(step, step);
+      if (stepSquared > 0.0)
+        {
+        double predicted[3];
+        vtkMath::Multiply3x3(jacobian, step, predicted);
+        for (int i = 0; i < 3; i++)
+          {
+          double residual = (trialErrorVector[i] - errorVector[i] - predicted[i]) / stepSquared;
+          jacobian[i][0] += residual*step[0];
+          jacobian[i][1] += residual*step[1];
+          jacobian[i][2] += residual*step[2];
+          }
+        jacobianUpToDate = false;
+        }
+      inverse[0] = trialInverse[0];
+      inverse[1] = trialInverse[1];
+      inverse[2] = trialInverse[2];
+      errorVector[0] = trialErrorVector[0];
+      errorVector[1] = trialErrorVector[1];
+      errorVector[2] = trialErrorVector[2];
+      functionValue = trialFunctionValue;
+      f = 1.0;
+      continue;
+      }
+
+    if (!jacobianUpToDate)
+      {
+      // convergence stalled: evaluate the derivative at the last good point
+      this->ComputeInverseError(inverse, inPoint, errorVector, jacobian);
+      numberOfEvaluations++;
+      jacobianUpToDate = true;
+      f = 1.0;
+      continue;
+      }
+
+    // the error is increasing even with the exact derivative,
+    // so take a partial step
+    f *= 0.5;
+    }
+
+  // same convention as in InverseTransformPointNewton: the first
+  // evaluation is not counted
+  numberOfIterations = numberOfEvaluations - 1;
+
+  if (derivative)
+    {
+    // return the exact derivative at the result (the approximation is
+    // only accurate along the directions of the steps)
+    if (jacobianUpToDate)
+      {
+      for (int i = 0; i < 3; i++)
+        {
+        derivative[i][0] = jacobian[i][0];
+        derivative[i][1] = jacobian[i][1];
+        derivative[i][2] = jacobian[i][2];
+        }
+      }
+    else
+      {
+      this->ComputeInverseError(inverse, inPoint, errorVector, derivative);
+      }
+    }
+
+  // if not converged then inverse is the last good result
+  outPoint[0] = inverse[0];
+  outPoint[1] = inverse[1];
+  outPoint[2] = inverse[2];
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::InverseTransformPointIterative(const double inPoint[3],
+                                                                 const double* initialGuess,
+                                                                 double outPoint[3],
+                                                                 double derivative[3][3],
+                                                                 int& numberOfIterations,
+                                                                 double& errorSquared)
+{
+  if (this->InverseSolver == vtkOrientedBSplineTransform::BroydenSolver)
+    {
+    return this->InverseTransformPointBroyden(inPoint, initialGuess, outPoint, derivative,
+      numberOfIterations, errorSquared);
+    }
+  // Newton's method needs the derivative in each iteration
+  double newtonDerivative[3][3];
+  return this->InverseTransformPointNewton(inPoint, initialGuess, outPoint,
+    derivative ? derivative : newtonDerivative, numberOfIterations, errorSquared);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::InverseTransformPointHierarchical(const double inPoint[3],
+                                                                    double outPoint[3],
+                                                                    double derivative[3][3],
+                                                                    int& numberOfIterations,
+                                                                    double& errorSquared)
+{
+  if (!this->CoarseInverseTransform)
+    {
+    return this->InverseTransformPointIterative(inPoint, nullptr, outPoint, derivative,
+      numberOfIterations, errorSquared);
+    }
+
+  // Solve on the coarse transform. If it does not converge then the last
+  // good result is still a better first guess than the default one.
+  double coarseInverse[3];
+  double coarseDerivative[3][3];
+  int coarseIterations = 0;
+  this->CoarseInverseTransform->InverseTransformPointNewton(inPoint, nullptr, coarseInverse, coarseDerivative,
+    coarseIterations, errorSquared);
+
+  // Refine on the b-spline transform
+  bool converged = this->InverseTransformPointIterative(inPoint, coarseInverse, outPoint, derivative,
+    numberOfIterations, errorSquared);
+  numberOfIterations += coarseIterations + 1;
+  if (!converged)
+    {
+    int fallbackIterations = 0;
+    converged = this->InverseTransformPointIterative(inPoint, nullptr, outPoint, derivative,
+      fallbackIterations, errorSquared);
+    numberOfIterations += fallbackIterations + 1;
+    }
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoint[3],
+                                                     double outPoint[3],
+                                                     double derivative[3][3])
+{
+  int numberOfIterations = 0;
+  double errorSquared = 0.0;
+  bool converged = this->InverseTransformPointHierarchical(inPoint, outPoint, derivative,
+    numberOfIterations, errorSquared);
+
+  bool intervalReached = this->InverseStatistics->AddCall(numberOfIterations + 1, converged,
+    sqrt(errorSquared), this->InverseStatisticsEventInterval);
+
+  if (this->ThreadSafeEvaluation)
+    {
+    // Reported later, from the calling thread (see InvokePendingEvents)
+    if (intervalReached)
+      {
+      this->PendingInverseStatisticsEvent = true;
+      }
+    if (!converged)
+      {
+      this->PendingConvergenceFailures++;
+      }
+    return;
+    }
+
+  if (intervalReached)
+    {
+    this->InvokeEvent(vtkOrientedBSplineTransform::InverseStatisticsEvent);
+    }
+
+  if (!converged)
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                      ") error = " << sqrt(errorSquared) << " after " <<
+                      numberOfIterations << " iterations."
+                      "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedBSplineTransform::ConvergenceFailureEvent);
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkOrientedBSplineTransform::InverseTransformPoints(const double* inPoints,
+                                                          double* outPoints,
+                                                          vtkIdType numberOfPoints)
+{
+  this->Update();
+  if (numberOfPoints <= 0)
+    {
+    return 0.0;
+    }
+
+  if (this->InverseFlag)
+    {
+    // The inverse of an inverted transform is the forward transform
+    vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end)
+      {
+      for (vtkIdType pointId = begin; pointId < end; pointId++)
+        {
+        this->ForwardTransformPoint(inPoints + 3*pointId, outPoints + 3*pointId);
+        }
+      });
+    return 0.0;
+    }
+
+  vtkSMPThreadLocal<vtkOrientedTransformInverseStatistics::Accumulator> statisticsLocal;
+  // Each block of points is solved in sequence, so that the solution of the
+  // previous point can be used as first guess
+  vtkSMPTools::For(0, numberOfPoints, vtkOrientedBSplineTransformInverseBlockSize,
+    [&](vtkIdType begin, vtkIdType end)
+    {
+    vtkOrientedTransformInverseStatistics::Accumulator& statistics = statisticsLocal.Local();
+    double previousInPoint[3] = { 0.0, 0.0, 0.0 };
+    double previousOutPoint[3] = { 0.0, 0.0, 0.0 };
+    bool previousConverged = false;
+    for (vtkIdType pointId = begin; pointId < end; pointId++)
+      {
+      double inPoint[3] = { inPoints[3*pointId], inPoints[3*pointId+1], inPoints[3*pointId+2] };
+      double* outPoint = outPoints + 3*pointId;
+      int numberOfIterations = 0;
+      int pointIterations = 0;
+      double errorSquared = 0.0;
+      bool converged = false;
+      if (previousConverged)
+        {
+        // shift the previous solution by the distance between the input points
+        double initialGuess[3] = { previousOutPoint[0] + inPoint[0] - previousInPoint[0],
+                                   previousOutPoint[1] + inPoint[1] - previousInPoint[1],
+                                   previousOutPoint[2] + inPoint[2] - previousInPoint[2] };
+        converged = this->InverseTransformPointIterative(inPoint, initialGuess, outPoint, nullptr,
+          numberOfIterations, errorSquared);
+        pointIterations += numberOfIterations + 1;
+        }
+      if (!converged)
+        {
+        converged = this->InverseTransformPointHierarchical(inPoint, outPoint, nullptr,
+          numberOfIterations, errorSquared);
+        pointIterations += numberOfIterations + 1;
+        }
+      statistics.AddCall(pointIterations, converged, sqrt(errorSquared));
+      previousConverged = converged;
+      previousInPoint[0] = inPoint[0];
+      previousInPoint[1] = inPoint[1];
+      previousInPoint[2] = inPoint[2];
+      previousOutPoint[0] = outPoint[0];
+      previousOutPoint[1] = outPoint[1];
+      previousOutPoint[2] = outPoint[2];
+      }
+    });
+
+  // Merge the statistics of all threads
+  vtkOrientedTransformInverseStatistics::Accumulator total;
+  bool invokeStatisticsEvent = false;
+  for (const vtkOrientedTransformInverseStatistics::Accumulator& statistics : statisticsLocal)
+    {
+    total.NumberOfIterations += statistics.NumberOfIterations;
+    total.NumberOfFailures += statistics.NumberOfFailures;
+    total.MaximumResidual = std::max(total.MaximumResidual, statistics.MaximumResidual);
+    if (this->InverseStatistics->AddCalls(statistics, this->InverseStatisticsEventInterval))
+      {
+      invokeStatisticsEvent = true;
+      }
+    }
+  if (invokeStatisticsEvent)
+    {
+    this->InvokeEvent(vtkOrientedBSplineTransform::InverseStatisticsEvent);
+    }
+
+  if (total.NumberOfFailures > 0)
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoints: no convergence for " << total.NumberOfFailures << " of "
+        << numberOfPoints << " points, max error = " << total.MaximumResidual << "."
+        "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedBSplineTransform::ConvergenceFailureEvent);
+    }
+
+  return static_cast<double>(total.NumberOfIterations) / numberOfPoints;
+}
+
+
+//------------------------------------------------------------------------
+// Cubic b-spline weights of the four nodes around a point
+// (floor(point)-1 ... floor(point)+2), f is the fractional part of the point.
+inline void vtkOrientedBSplineTransformWeights(double weights[4], double f)
+{
+  const double sixth = 1.0 / 6.0;
+  double f2 = f * f;
+  double f3 = f2 * f;
+  double r = 1.0 - f;
+  weights[0] = r * r * r * sixth;
+  weights[1] = (3.0 * f3 - 6.0 * f2 + 4.0) * sixth;
+  weights[2] = (-3.0 * f3 + 3.0 * f2 + 3.0 * f + 1.0) * sixth;
+  weights[3] = f3 * sixth;
+}
+
+//------------------------------------------------------------------------
+// Derivatives of the cubic b-spline weights with respect to the point.
+inline void vtkOrientedBSplineTransformDerivativeWeights(double weights[4], double f)
+{
+  double f2 = f * f;
+  double r = 1.0 - f;
+  weights[0] = -0.5 * r * r;
+  weights[1] = 1.5 * f2 - 2.0 * f;
+  weights[2] = -1.5 * f2 + f + 0.5;
+  weights[3] = 0.5 * f2;
+}
+
+//------------------------------------------------------------------------
+// Precomputed b-spline weights along one lattice axis, which is mapped
+// to a single grid axis.
+struct vtkOrientedBSplineTransformLatticeAxis
+{
+  // Grid axis that this lattice axis is mapped to
+  int GridAxis;
+  // First node of the support of each lattice sample
+  std::vector<int> FirstNode;
+  // 4 weights for each lattice sample
+  std::vector<double> Weights;
+  // 4 weight derivatives for each lattice sample
+  std::vector<double> DerivativeWeights;
+  // Range of lattice samples [InteriorBegin, InteriorEnd) whose support
+  // is fully inside the grid. Border modes do not affect these samples.
+  int InteriorBegin;
+  int InteriorEnd;
+
+  vtkOrientedBSplineTransformLatticeAxis()
+    : GridAxis(0)
+    , InteriorBegin(0)
+    , InteriorEnd(0)
+  {
+  }
+
+  void Initialize(int gridAxis, double latticeToGridIndexScale, double latticeToGridIndexOffset,
+    int numberOfSamples, const int gridExtent[6])
+  {
+    this->GridAxis = gridAxis;
+    this->FirstNode.resize(numberOfSamples);
+    this->Weights.resize(4 * numberOfSamples);
+    this->DerivativeWeights.resize(4 * numberOfSamples);
+    this->InteriorBegin = 0;
+    this->InteriorEnd = 0;
+    for (int n = 0; n < numberOfSamples; n++)
+      {
+      double p = latticeToGridIndexScale * n + latticeToGridIndexOffset;
+      int floorIndex = vtkMath::Floor(p);
+      this->FirstNode[n] = floorIndex - 1;
+      vtkOrientedBSplineTransformWeights(&this->Weights[4 * n], p - floorIndex);
+      vtkOrientedBSplineTransformDerivativeWeights(&this->DerivativeWeights[4 * n], p - floorIndex);
+      // the lattice is mapped linearly to the grid, so interior samples are contiguous
+      if (floorIndex - 1 >= gridExtent[2 * gridAxis] && floorIndex + 2 <= gridExtent[2 * gridAxis + 1])
+        {
+        if (this->InteriorBegin >= this->InteriorEnd)
+          {
+          this->InteriorBegin = n;
+          }
+        this->InteriorEnd = n + 1;
+        }
+      }
+  }
+};
+
+//------------------------------------------------------------------------
+// Initialize the lattice axes if each lattice axis is mapped to exactly
+// one grid axis. Returns false if the lattice is not separable.
+static bool vtkOrientedBSplineTransformInitializeLatticeAxes(const double latticeToIJK[4][4], const int dimensions[3],
+  const int gridExtent[6], vtkOrientedBSplineTransformLatticeAxis axes[3])
+{
+  bool gridAxisUsed[3] = { false, false, false };
+  for (int latticeAxis = 0; latticeAxis < 3; latticeAxis++)
+    {
+    int gridAxis = -1;
+    double maxComponent = 0.0;
+    for (int row = 0; row < 3; row++)
+      {
+      if (fabs(latticeToIJK[row][latticeAxis]) > maxComponent)
+        {
+        maxComponent = fabs(latticeToIJK[row][latticeAxis]);
+        gridAxis = row;
+        }
+      }
+    if (gridAxis < 0 || gridAxisUsed[gridAxis])
+      {
+      return false;
+      }
+    for (int row = 0; row < 3; row++)
+      {
+      if (row != gridAxis && fabs(latticeToIJK[row][latticeAxis]) > 1e-9 * maxComponent)
+        {
+        return false;
+        }
+      }
+    gridAxisUsed[gridAxis] = true;
+    axes[latticeAxis].Initialize(gridAxis, latticeToIJK[gridAxis][latticeAxis], latticeToIJK[gridAxis][3],
+      dimensions[latticeAxis], gridExtent);
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------
+// Separable evaluation of the b-spline displacement on the interior
+// samples of a range of lattice slices. Coefficients are first reduced
+// along the slice axis, then along the row axis, then along the column axis.
+template <class T>
+void vtkOrientedBSplineTransformEvaluateSeparable(const T* gridPtr, const int gridExt[6], const vtkIdType gridInc[3],
+  const vtkOrientedBSplineTransformLatticeAxis axes[3], const int dimensions[3], double scale,
+  double* field, vtkIdType sliceBegin, vtkIdType sliceEnd)
+{
+  const vtkOrientedBSplineTransformLatticeAxis& axis0 = axes[0];
+  const vtkOrientedBSplineTransformLatticeAxis& axis1 = axes[1];
+  const vtkOrientedBSplineTransformLatticeAxis& axis2 = axes[2];
+  if (axis0.InteriorBegin >= axis0.InteriorEnd || axis1.InteriorBegin >= axis1.InteriorEnd)
+    {
+    return;
+    }
+
+  // Range of grid nodes needed along the column and row axes
+  int nodeBegin0 = std::min(axis0.FirstNode[axis0.InteriorBegin], axis0.FirstNode[axis0.InteriorEnd - 1]);
+  int nodeEnd0 = std::max(axis0.FirstNode[axis0.InteriorBegin], axis0.FirstNode[axis0.InteriorEnd - 1]) + 4;
+  int nodeBegin1 = std::min(axis1.FirstNode[axis1.InteriorBegin], axis1.FirstNode[axis1.InteriorEnd - 1]);
+  int nodeEnd1 = std::max(axis1.FirstNode[axis1.InteriorBegin], axis1.FirstNode[axis1.InteriorEnd - 1]) + 4;
+  int numberOfNodes0 = nodeEnd0 - nodeBegin0;
+  int numberOfNodes1 = nodeEnd1 - nodeBegin1;
+
+  vtkIdType inc0 = gridInc[axis0.GridAxis];
+  vtkIdType inc1 = gridInc[axis1.GridAxis];
+  vtkIdType inc2 = gridInc[axis2.GridAxis];
+  vtkIdType offset0 = (nodeBegin0 - gridExt[2 * axis0.GridAxis]) * inc0;
+  vtkIdType offset1 = (nodeBegin1 - gridExt[2 * axis1.GridAxis]) * inc1;
+
+  std::vector<double> sliceCoefficients(3 * numberOfNodes0 * numberOfNodes1);
+  std::vector<double> rowCoefficients(3 * numberOfNodes0);
+
+  for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+    {
+    if (k < axis2.InteriorBegin || k >= axis2.InteriorEnd)
+      {
+      continue;
+      }
+
+    // Reduce along the slice axis
+    const double* w2 = &axis2.Weights[4 * k];
+    const T* slicePtr = gridPtr + offset0 + offset1 + (axis2.FirstNode[k] - gridExt[2 * axis2.GridAxis]) * inc2;
+    double* sliceCoefficient = &sliceCoefficients[0];
+    for (int n1 = 0; n1 < numberOfNodes1; n1++)
+      {
+      for (int n0 = 0; n0 < numberOfNodes0; n0++)
+        {
+        const T* nodePtr = slicePtr + n0 * inc0 + n1 * inc1;
+        for (int c = 0; c < 3; c++)
+          {
+          sliceCoefficient[c] = w2[0] * nodePtr[c] + w2[1] * nodePtr[inc2 + c]
+            + w2[2] * nodePtr[2 * inc2 + c] + w2[3] * nodePtr[3 * inc2 + c];
+          }
+        sliceCoefficient += 3;
+        }
+      }
+
+    for (int j = axis1.InteriorBegin; j < axis1.InteriorEnd; j++)
+      {
+      // Reduce along the row axis
+      const double* w1 = &axis1.Weights[4 * j];
+      const double* rowPtr = &sliceCoefficients[3 * numberOfNodes0 * (axis1.FirstNode[j] - nodeBegin1)];
+      vtkIdType rowInc = 3 * numberOfNodes0;
+      for (int n0 = 0; n0 < 3 * numberOfNodes0; n0++)
+        {
+        rowCoefficients[n0] = w1[0] * rowPtr[n0] + w1[1] * rowPtr[rowInc + n0]
+          + w1[2] * rowPtr[2 * rowInc + n0] + w1[3] * rowPtr[3 * rowInc + n0];
+        }
+
+      // Reduce along the column axis
+      double* fieldPtr = field + 3 * ((k * dimensions[1] + j) * static_cast<vtkIdType>(dimensions[0]) + axis0.InteriorBegin);
+      for (int i = axis0.InteriorBegin; i < axis0.InteriorEnd; i++)
+        {
+        const double* w0 = &axis0.Weights[4 * i];
+        const double* columnPtr = &rowCoefficients[3 * (axis0.FirstNode[i] - nodeBegin0)];
+        for (int c = 0; c < 3; c++)
+          {
+          fieldPtr[c] = scale * (w0[0] * columnPtr[c] + w0[1] * columnPtr[3 + c]
+            + w0[2] * columnPtr[6 + c] + w0[3] * columnPtr[9 + c]);
+          }
+        fieldPtr += 3;
+        }
+      }
+    }
+}
+
+//------------------------------------------------------------------------
+// Jacobian determinant of the transform from the derivative of the spline
+// with respect to the grid index.
+// splineToOutput is the scaled output to grid index matrix and
+// linearDerivative is the derivative of the bulk transform.
+inline double vtkOrientedBSplineTransformJacobianDeterminant(const double splineDerivative[3][3],
+  const double splineToOutput[3][3], const double linearDerivative[3][3])
+{
+  double jacobian[3][3];
+  for (int i = 0; i < 3; i++)
+    {
+    for (int k = 0; k < 3; k++)
+      {
+      jacobian[i][k] = linearDerivative[i][k] + splineDerivative[i][0] * splineToOutput[0][k]
+        + splineDerivative[i][1] * splineToOutput[1][k] + splineDerivative[i][2] * splineToOutput[2][k];
+      }
+    }
+  return vtkMath::Determinant3x3(jacobian);
+}
+
+//------------------------------------------------------------------------
+// Separable evaluation of the Jacobian determinant on the interior
+// samples of a range of lattice slices. The same reduction order is used
+// as in vtkOrientedBSplineTransformEvaluateSeparable, with the weight
+// derivatives along one axis for each of the three partial derivatives.
+template <class T>
+void vtkOrientedBSplineTransformEvaluateSeparableDeterminant(const T* gridPtr, const int gridExt[6],
+  const vtkIdType gridInc[3], const vtkOrientedBSplineTransformLatticeAxis axes[3], const int dimensions[3],
+  const double splineToOutput[3][3], const double linearDerivative[3][3],
+  double* determinant, vtkIdType sliceBegin, vtkIdType sliceEnd)
+{
+  const vtkOrientedBSplineTransformLatticeAxis& axis0 = axes[0];
+  const vtkOrientedBSplineTransformLatticeAxis& axis1 = axes[1];
+  const vtkOrientedBSplineTransformLatticeAxis& axis2 = axes[2];
+  if (axis0.InteriorBegin >= axis0.InteriorEnd || axis1.InteriorBegin >= axis1.InteriorEnd)
+    {
+    return;
+    }
+
+  // Range of grid nodes needed along the column and row axes
+  int nodeBegin0 = std::min(axis0.FirstNode[axis0.InteriorBegin], axis0.FirstNode[axis0.InteriorEnd - 1]);
+  int nodeEnd0 = std::max(axis0.FirstNode[axis0.InteriorBegin], axis0.FirstNode[axis0.InteriorEnd - 1]) + 4;
+  int nodeBegin1 = std::min(axis1.FirstNode[axis1.InteriorBegin], axis1.FirstNode[axis1.InteriorEnd - 1]);
+  int nodeEnd1 = std::max(axis1.FirstNode[axis1.InteriorBegin], axis1.FirstNode[axis1.InteriorEnd - 1]) + 4;
+  int numberOfNodes0 = nodeEnd0 - nodeBegin0;
+  int numberOfNodes1 = nodeEnd1 - nodeBegin1;
+
+  vtkIdType inc0 = gridInc[axis0.GridAxis];
+  vtkIdType inc1 = gridInc[axis1.GridAxis];
+  vtkIdType inc2 = gridInc[axis2.GridAxis];
+  vtkIdType offset0 = (nodeBegin0 - gridExt[2 * axis0.GridAxis]) * inc0;
+  vtkIdType offset1 = (nodeBegin1 - gridExt[2 * axis1.GridAxis]) * inc1;
+
+  // Coefficients reduced with the weights (S) and the weight derivatives (S2)
+  // along the slice axis
+  std::vector<double> sliceCoefficients(3 * numberOfNodes0 * numberOfNodes1);
+  std::vector<double> sliceDerivativeCoefficients(3 * numberOfNodes0 * numberOfNodes1);
+  // Row reductions: S with weights, S with weight derivatives, S2 with weights
+  std::vector<double> rowCoefficients(3 * numberOfNodes0);
+  std::vector<double> rowDerivative1Coefficients(3 * numberOfNodes0);
+  std::vector<double> rowDerivative2Coefficients(3 * numberOfNodes0);
+
+  for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+    {
+    if (k < axis2.InteriorBegin || k >= axis2.InteriorEnd)
+      {
+      continue;
+      }
+
+    // Reduce along the slice axis
+    const double* w2 = &axis2.Weights[4 * k];
+    const double* dw2 = &axis2.DerivativeWeights[4 * k];
+    const T* slicePtr = gridPtr + offset0 + offset1 + (axis2.FirstNode[k] - gridExt[2 * axis2.GridAxis]) * inc2;
+    double* sliceCoefficient = &sliceCoefficients[0];
+    double* sliceDerivativeCoefficient = &sliceDerivativeCoefficients[0];
+    for (int n1 = 0; n1 < numberOfNodes1; n1++)
+      {
+      for (int n0 = 0; n0 < numberOfNodes0; n0++)
+        {
+        const T* nodePtr = slicePtr + n0 * inc0 + n1 * inc1;
+        for (int c = 0; c < 3; c++)
+          {
+          double v0 = nodePtr[c];
+          double v1 = nodePtr[inc2 + c];
+          double v2 = nodePtr[2 * inc2 + c];
+          double v3 = nodePtr[3 * inc2 + c];
+          sliceCoefficient[c] = w2[0] * v0 + w2[1] * v1 + w2[2] * v2 + w2[3] * v3;
+          sliceDerivativeCoefficient[c] = dw2[0] * v0 + dw2[1] * v1 + dw2[2] * v2 + dw2[3] * v3;
+          }
+        sliceCoefficient += 3;
+        sliceDerivativeCoefficient += 3;
+        }
+      }
+
+    for (int j = axis1.InteriorBegin; j < axis1.InteriorEnd; j++)
+      {
+      // Reduce along the row axis
+      const double* w1 = &axis1.Weights[4 * j];
+      const double* dw1 = &axis1.DerivativeWeights[4 * j];
+      vtkIdType rowOffset = 3 * numberOfNodes0 * (axis1.FirstNode[j] - nodeBegin1);
+      const double* rowPtr = &sliceCoefficients[rowOffset];
+      const double* rowDerivativePtr = &sliceDerivativeCoefficients[rowOffset];
+      vtkIdType rowInc = 3 * numberOfNodes0;
+      for (int n0 = 0; n0 < 3 * numberOfNodes0; n0++)
+        {
+        double v0 = rowPtr[n0];
+        double v1 = rowPtr[rowInc + n0];
+        double v2 = rowPtr[2 * rowInc + n0];
+        double v3 = rowPtr[3 * rowInc + n0];
+        rowCoefficients[n0] = w1[0] * v0 + w1[1] * v1 + w1[2] * v2 + w1[3] * v3;
+        rowDerivative1Coefficients[n0] = dw1[0] * v0 + dw1[1] * v1 + dw1[2] * v2 + dw1[3] * v3;
+        rowDerivative2Coefficients[n0] = w1[0] * rowDerivativePtr[n0] + w1[1] * rowDerivativePtr[rowInc + n0]
+          + w1[2] * rowDerivativePtr[2 * rowInc + n0] + w1[3] * rowDerivativePtr[3 * rowInc + n0];
+        }
+
+      // Reduce along the column axis
+      double* determinantPtr = determinant + (k * dimensions[1] + j) * static_cast<vtkIdType>(dimensions[0]) + axis0.InteriorBegin;
+      for (int i = axis0.InteriorBegin; i < axis0.InteriorEnd; i++)
+        {
+        const double* w0 = &axis0.Weights[4 * i];
+        const double* dw0 = &axis0.DerivativeWeights[4 * i];
+        int columnOffset = 3 * (axis0.FirstNode[i] - nodeBegin0);
+        const double* columnPtr = &rowCoefficients[columnOffset];
+        const double* column1Ptr = &rowDerivative1Coefficients[columnOffset];
+        const double* column2Ptr = &rowDerivative2Coefficients[columnOffset];
+        double splineDerivative[3][3];
+        for (int c = 0; c < 3; c++)
+          {
+          splineDerivative[c][axis0.GridAxis] = dw0[0] * columnPtr[c] + dw0[1] * columnPtr[3 + c]
+            + dw0[2] * columnPtr[6 + c] + dw0[3] * columnPtr[9 + c];
+          splineDerivative[c][axis1.GridAxis] = w0[0] * column1Ptr[c] + w0[1] * column1Ptr[3 + c]
+            + w0[2] * column1Ptr[6 + c] + w0[3] * column1Ptr[9 + c];
+          splineDerivative[c][axis2.GridAxis] = w0[0] * column2Ptr[c] + w0[1] * column2Ptr[3 + c]
+            + w0[2] * column2Ptr[6 + c] + w0[3] * column2Ptr[9 + c];
+          }
+        *determinantPtr = vtkOrientedBSplineTransformJacobianDeterminant(splineDerivative, splineToOutput, linearDerivative);
+        determinantPtr++;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::EvaluateOnGrid(const double origin[3], const double spacing[3],
+  vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* displacementField)
+{
+  if (!displacementField)
+    {
+    vtkErrorMacro("EvaluateOnGrid: invalid displacement field");
+    return false;
+    }
+  if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+    {
+    vtkErrorMacro("EvaluateOnGrid: invalid dimensions " << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2]);
+    return false;
+    }
+
+  this->Update();
+
+  displacementField->SetOrigin(origin[0], origin[1], origin[2]);
+  displacementField->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  displacementField->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+  displacementField->AllocateScalars(VTK_DOUBLE, 3);
+  double* field = static_cast<double*>(displacementField->GetScalarPointer());
+
+  // Lattice index to output transform
+  vtkNew<vtkMatrix4x4> latticeToOutput;
+  vtkOrientedTransformLattice::GetLatticeToOutputMatrix(origin, spacing, direction, latticeToOutput);
+
+  // The bulk transform adds a displacement that is linear in the lattice index:
+  // (BulkTransformMatrix - I) * latticeToOutput
+  vtkNew<vtkMatrix4x4> latticeToBulkDisplacement;
+  bool hasBulkTransform = (this->BulkTransformMatrix != nullptr);
+  if (hasBulkTransform)
+    {
+    vtkNew<vtkMatrix4x4> bulkDisplacement;
+    bulkDisplacement->DeepCopy(this->BulkTransformMatrix);
+    for (int i = 0; i < 3; i++)
+      {
+      bulkDisplacement->SetElement(i, i, bulkDisplacement->GetElement(i, i) - 1.0);
+      }
+    vtkMatrix4x4::Multiply4x4(bulkDisplacement, latticeToOutput, latticeToBulkDisplacement);
+    }
+  const double (*bulk)[4] = latticeToBulkDisplacement->Element;
+
+  vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+
+  if (this->InverseFlag)
+    {
+    auto evaluateSlices = [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+      {
+      double* fieldPtr = field + 3*sliceBegin*sliceSize;
+      for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+        {
+        for (int j = 0; j < dimensions[1]; j++)
+          {
+          for (int i = 0; i < dimensions[0]; i++)
+            {
+            double latticePoint[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+            double point[3], transformedPoint[3];
+            vtkLinearTransformPoint(latticeToOutput->Element, latticePoint, point);
+            this->InternalTransformPoint(point, transformedPoint);
+            fieldPtr[0] = transformedPoint[0] - point[0];
+            fieldPtr[1] = transformedPoint[1] - point[1];
+            fieldPtr[2] = transformedPoint[2] - point[2];
+            fieldPtr += 3;
+            }
+          }
+        }
+      };
+    vtkOrientedTransformLattice::EvaluateSlices(this, dimensions[2], evaluateSlices);
+    return true;
+    }
+
+  if (!this->GridPointer || !this->CalculateSpline)
+    {
+    // Only bulk transform
+    if (!hasBulkTransform)
+      {
+      std::fill(field, field + 3 * sliceSize * dimensions[2], 0.0);
+      return true;
+      }
+    vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+      {
+      for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+        {
+        double* fieldPtr = field + 3 * k * sliceSize;
+        for (int j = 0; j < dimensions[1]; j++)
+          {
+          for (int i = 0; i < dimensions[0]; i++)
+            {
+            double latticePoint[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+            vtkLinearTransformPoint(bulk, latticePoint, fieldPtr);
+            fieldPtr += 3;
+            }
+          }
+        }
+      });
+    return true;
+    }
+
+  // Lattice index to grid index transform
+  vtkNew<vtkMatrix4x4> latticeToGridIndex;
+  vtkMatrix4x4::Multiply4x4(this->OutputToGridIndexTransformMatrixCached, latticeToOutput, latticeToGridIndex);
+  const double (*latticeToIJK)[4] = latticeToGridIndex->Element;
+
+  // Check if each lattice axis is mapped to exactly one grid axis
+  vtkOrientedBSplineTransformLatticeAxis axes[3];
+  bool separable = vtkOrientedBSplineTransformInitializeLatticeAxes(latticeToIJK, dimensions, this->GridExtent, axes);
+
+  int gridType = this->GetCoefficientData()->GetScalarType();
+  double scale = this->DisplacementScale;
+
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    if (separable)
+      {
+      if (gridType == VTK_FLOAT)
+        {
+        vtkOrientedBSplineTransformEvaluateSeparable(static_cast<const float*>(this->GridPointer), this->GridExtent,
+          this->GridIncrements, axes, dimensions, scale, field, sliceBegin, sliceEnd);
+        }
+      else
+        {
+        vtkOrientedBSplineTransformEvaluateSeparable(static_cast<const double*>(this->GridPointer), this->GridExtent,
+          this->GridIncrements, axes, dimensions, scale, field, sliceBegin, sliceEnd);
+        }
+      }
+
+    // Evaluate samples that the separable evaluation did not compute
+    // and add the bulk transform
+    double displacement[3];
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      bool interiorSlice = separable && k >= axes[2].InteriorBegin && k < axes[2].InteriorEnd;
+      double* fieldPtr = field + 3 * k * sliceSize;
+      for (int j = 0; j < dimensions[1]; j++)
+        {
+        bool interiorRow = interiorSlice && j >= axes[1].InteriorBegin && j < axes[1].InteriorEnd;
+        for (int i = 0; i < dimensions[0]; i++)
+          {
+          double latticePoint[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+          if (!interiorRow || i < axes[0].InteriorBegin || i >= axes[0].InteriorEnd)
+            {
+            double point[3];
+            vtkLinearTransformPoint(latticeToIJK, latticePoint, point);
+            this->CalculateSpline(point, displacement, nullptr,
+              this->GridPointer, this->GridExtent, this->GridIncrements, this->BorderMode);
+            fieldPtr[0] = displacement[0] * scale;
+            fieldPtr[1] = displacement[1] * scale;
+            fieldPtr[2] = displacement[2] * scale;
+            }
+          if (hasBulkTransform)
+            {
+            double bulkDisplacement[3];
+            vtkLinearTransformPoint(bulk, latticePoint, bulkDisplacement);
+            fieldPtr[0] += bulkDisplacement[0];
+            fieldPtr[1] += bulkDisplacement[1];
+            fieldPtr[2] += bulkDisplacement[2];
+            }
+          fieldPtr += 3;
+          }
+        }
+      }
+    });
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::EvaluateJacobianDeterminantOnGrid(const double origin[3], const double spacing[3],
+  vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* jacobianDeterminant)
+{
+  if (!jacobianDeterminant)
+    {
+    vtkErrorMacro("EvaluateJacobianDeterminantOnGrid: invalid output image");
+    return false;
+    }
+  if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+    {
+    vtkErrorMacro("EvaluateJacobianDeterminantOnGrid: invalid dimensions " << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2]);
+    return false;
+    }
+
+  this->Update();
+
+  jacobianDeterminant->SetOrigin(origin[0], origin[1], origin[2]);
+  jacobianDeterminant->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  jacobianDeterminant->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+  jacobianDeterminant->AllocateScalars(VTK_DOUBLE, 1);
+  double* determinant = static_cast<double*>(jacobianDeterminant->GetScalarPointer());
+
+  // Lattice index to output transform
+  vtkNew<vtkMatrix4x4> latticeToOutput;
+  vtkOrientedTransformLattice::GetLatticeToOutputMatrix(origin, spacing, direction, latticeToOutput);
+  vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+
+  if (this->InverseFlag)
+    {
+    auto evaluateSlices = [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+      {
+      double* determinantPtr = determinant + sliceBegin*sliceSize;
+      for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+        {
+        for (int j = 0; j < dimensions[1]; j++)
+          {
+          for (int i = 0; i < dimensions[0]; i++)
+            {
+            double latticePoint[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+            double point[3], transformedPoint[3], derivative[3][3];
+            vtkLinearTransformPoint(latticeToOutput->Element, latticePoint, point);
+            this->InternalTransformDerivative(point, transformedPoint, derivative);
+            *(determinantPtr++) = vtkMath::Determinant3x3(derivative);
+            }
+          }
+        }
+      };
+    vtkOrientedTransformLattice::EvaluateSlices(this, dimensions[2], evaluateSlices);
+    return true;
+    }
+
+  // Derivative of the bulk transform
+  double linearDerivative[3][3];
+  vtkMath::Identity3x3(linearDerivative);
+  if (this->BulkTransformMatrix)
+    {
+    for (int i = 0; i < 3; i++)
+      {
+      for (int k = 0; k < 3; k++)
+        {
+        linearDerivative[i][k] = this->BulkTransformMatrix->GetElement(i, k);
+        }
+      }
+    }
+
+  if (!this->GridPointer || !this->CalculateSpline)
+    {
+    // Only bulk transform
+    std::fill(determinant, determinant + sliceSize * dimensions[2], vtkMath::Determinant3x3(linearDerivative));
+    return true;
+    }
+
+  // Derivative with respect to the grid index to derivative with respect
+  // to the output coordinates
+  double splineToOutput[3][3];
+  for (int i = 0; i < 3; i++)
+    {
+    for (int k = 0; k < 3; k++)
+      {
+      splineToOutput[i][k] = this->DisplacementScale * this->OutputToGridIndexTransformMatrixCached->GetElement(i, k);
+      }
+    }
+
+  // Lattice index to grid index transform
+  vtkNew<vtkMatrix4x4> latticeToGridIndex;
+  vtkMatrix4x4::Multiply4x4(this->OutputToGridIndexTransformMatrixCached, latticeToOutput, latticeToGridIndex);
+  const double (*latticeToIJK)[4] = latticeToGridIndex->Element;
+
+  vtkOrientedBSplineTransformLatticeAxis axes[3];
+  bool separable = vtkOrientedBSplineTransformInitializeLatticeAxes(latticeToIJK, dimensions, this->GridExtent, axes);
+
+  int gridType = this->GetCoefficientData()->GetScalarType();
+
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    if (separable)
+      {
+      if (gridType == VTK_FLOAT)
+        {
+        vtkOrientedBSplineTransformEvaluateSeparableDeterminant(static_cast<const float*>(this->GridPointer),
+          this->GridExtent, this->GridIncrements, axes, dimensions, splineToOutput, linearDerivative,
+          determinant, sliceBegin, sliceEnd);
+        }
+      else
+        {
+        vtkOrientedBSplineTransformEvaluateSeparableDeterminant(static_cast<const double*>(this->GridPointer),
+          this->GridExtent, this->GridIncrements, axes, dimensions, splineToOutput, linearDerivative,
+          determinant, sliceBegin, sliceEnd);
+        }
+      }
+
+    // Evaluate samples that the separable evaluation did not compute
+    double displacement[3];
+    double splineDerivative[3][3];
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      bool interiorSlice = separable && k >= axes[2].InteriorBegin && k < axes[2].InteriorEnd;
+      double* determinantPtr = determinant + k * sliceSize;
+      for (int j = 0; j < dimensions[1]; j++)
+        {
+        bool interiorRow = interiorSlice && j >= axes[1].InteriorBegin && j < axes[1].InteriorEnd;
+        for (int i = 0; i < dimensions[0]; i++)
+          {
+          if (!interiorRow || i < axes[0].InteriorBegin || i >= axes[0].InteriorEnd)
+            {
+            double latticePoint[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+            double point[3];
+            vtkLinearTransformPoint(latticeToIJK, latticePoint, point);
+            this->CalculateSpline(point, displacement, splineDerivative,
+              this->GridPointer, this->GridExtent, this->GridIncrements, this->BorderMode);
+            *determinantPtr = vtkOrientedBSplineTransformJacobianDeterminant(splineDerivative, splineToOutput,
+              linearDerivative);
+            }
+          determinantPtr++;
+          }
+        }
+      }
+    });
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::ConvertToGridTransform(vtkOrientedGridTransform* gridTransform,
+  const double origin[3], const double spacing[3], vtkMatrix4x4* direction, const int dimensions[3],
+  double* maximumError)
+{
+  if (!gridTransform)
+    {
+    vtkErrorMacro("ConvertToGridTransform: invalid grid transform");
+    return false;
+    }
+  if (gridTransform->GetInverseFlag())
+    {
+    vtkErrorMacro("ConvertToGridTransform: grid transform must not be inverted");
+    return false;
+    }
+
+  vtkNew<vtkImageData> displacementGrid;
+  if (!this->EvaluateOnGrid(origin, spacing, direction, dimensions, displacementGrid))
+    {
+    return false;
+    }
+
+  // The grid transform keeps a reference to the direction matrix,
+  // therefore a copy is stored.
+  vtkNew<vtkMatrix4x4> gridDirection;
+  if (direction)
+    {
+    gridDirection->DeepCopy(direction);
+    }
+  gridTransform->SetDisplacementGridData(displacementGrid);
+  gridTransform->SetGridDirectionMatrix(gridDirection);
+  gridTransform->SetDisplacementScale(1.0);
+  gridTransform->SetDisplacementShift(0.0);
+  gridTransform->SetDisplacementComponentScale(1.0, 1.0, 1.0);
+  gridTransform->SetDisplacementComponentShift(0.0, 0.0, 0.0);
+  gridTransform->SetHalfFloatGrid(false);
+  gridTransform->SetBSplineInterpolation(false);
+  gridTransform->SetInterpolationModeToLinear();
+  gridTransform->Update();
+
+  if (!maximumError)
+    {
+    return true;
+    }
+
+  // Trilinear interpolation error is largest between grid points,
+  // therefore the error is evaluated at the center of each grid cell.
+  vtkNew<vtkMatrix4x4> latticeToOutput;
+  vtkOrientedTransformLattice::GetLatticeToOutputMatrix(origin, spacing, gridDirection, latticeToOutput);
+  const double (*latticeToOutputMatrix)[4] = latticeToOutput->Element;
+  int numberOfCells[3];
+  double cellOffset[3];
+  for (int i = 0; i < 3; i++)
+    {
+    numberOfCells[i] = std::max(dimensions[i] - 1, 1);
+    cellOffset[i] = (dimensions[i] > 1 ? 0.5 : 0.0);
+    }
+
+  vtkSMPThreadLocal<double> maximumErrorLocal(0.0);
+  auto evaluateSlices = [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    double& localMaximumError = maximumErrorLocal.Local();
+    double point[3], splinePoint[3], gridPoint[3];
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      for (int j = 0; j < numberOfCells[1]; j++)
+        {
+        for (int i = 0; i < numberOfCells[0]; i++)
+          {
+          double latticePoint[3] = { i + cellOffset[0], j + cellOffset[1], k + cellOffset[2] };
+          vtkLinearTransformPoint(latticeToOutputMatrix, latticePoint, point);
+          this->InternalTransformPoint(point, splinePoint);
+          gridTransform->InternalTransformPoint(point, gridPoint);
+          localMaximumError = std::max(localMaximumError, sqrt(vtkMath::Distance2BetweenPoints(splinePoint, gridPoint)));
+          }
+        }
+      }
+    };
+  vtkOrientedTransformLattice::EvaluateSlices(this, numberOfCells[2], evaluateSlices);
+
+  *maximumError = 0.0;
+  for (double localMaximumError : maximumErrorLocal)
+    {
+    *maximumError = std::max(*maximumError, localMaximumError);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::ConvertToGridTransform(vtkOrientedGridTransform* gridTransform,
+  const double spacing[3], double* maximumError)
+{
+  this->Update();
+  vtkImageData* coefficients = this->GetCoefficientData();
+  if (!coefficients || spacing[0] <= 0.0 || spacing[1] <= 0.0 || spacing[2] <= 0.0)
+    {
+    vtkErrorMacro("ConvertToGridTransform: invalid coefficient data or spacing");
+    return false;
+    }
+
+  // Cover the coefficient grid with grid axes in the same directions
+  int dimensions[3];
+  double origin[3];
+  for (int i = 0; i < 3; i++)
+    {
+    double length = (this->GridExtent[2 * i + 1] - this->GridExtent[2 * i]) * this->GridSpacing[i];
+    dimensions[i] = static_cast<int>(floor(length / spacing[i] + 1e-6)) + 1;
+    }
+  double firstGridIndex[3] = { static_cast<double>(this->GridExtent[0]), static_cast<double>(this->GridExtent[2]),
+    static_cast<double>(this->GridExtent[4]) };
+  vtkLinearTransformPoint(this->GridIndexToOutputTransformMatrixCached->Element, firstGridIndex, origin);
+
+  return this->ConvertToGridTransform(gridTransform, origin, spacing, this->GridDirectionMatrix, dimensions, maximumError);
 }
 
 //----------------------------------------------------------------------------
@@ -444,8 +1728,13 @@ void vtkOrientedBSplineTransform::InternalDeepCopy(vtkAbstractTransform *transfo
   vtkOrientedBSplineTransform *orientedBSplineTransform = (vtkOrientedBSplineTransform *)transform;
   this->SetGridDirectionMatrix(orientedBSplineTransform->GetGridDirectionMatrix());
   this->SetBulkTransformMatrix(orientedBSplineTransform ->GetBulkTransformMatrix());
+  this->SetThreadSafeEvaluation(orientedBSplineTransform->GetThreadSafeEvaluation());
+  this->SetInverseStatisticsEventInterval(orientedBSplineTransform->GetInverseStatisticsEventInterval());
+  this->SetInverseSolver(orientedBSplineTransform->GetInverseSolver());
+  this->SetHierarchicalInverse(orientedBSplineTransform->GetHierarchicalInverse());
+  this->SetHierarchicalInverseDownsamplingFactor(orientedBSplineTransform->GetHierarchicalInverseDownsamplingFactor());
 
-  // Cached matrices will be recomputed automatically in InternalUpdate()
+  // Cached matrices and the coarse transform will be recomputed automatically in InternalUpdate()
   // therefore we do not need to copy them.
 
   this->Superclass::InternalDeepCopy(transform);
@@ -485,6 +1774,42 @@ void vtkOrientedBSplineTransform::InternalUpdate()
     {
     vtkMatrix4x4::Invert(this->BulkTransformMatrix, this->InverseBulkTransformMatrixCached);
     }
+
+  this->UpdateCoarseInverseTransform();
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::UpdateCoarseInverseTransform()
+{
+  if (!this->HierarchicalInverse || !this->GridPointer || !this->CalculateSpline)
+    {
+    if (this->CoarseInverseTransform)
+      {
+      this->CoarseInverseTransform->Delete();
+      this->CoarseInverseTransform = nullptr;
+      }
+    return;
+    }
+
+  if (!this->CoarseInverseTransform)
+    {
+    this->CoarseInverseTransform = vtkOrientedGridTransform::New();
+    }
+  // The forward transform is sampled at the coefficient grid nodes, even if this transform is inverted
+  if (!this->CoarseInverseTransform->SetDownsampledDisplacementGrid(
+    [this](const double* point, double* transformedPoint) { this->ForwardTransformPoint(point, transformedPoint); },
+    this->GridIndexToOutputTransformMatrixCached, this->GridExtent, this->HierarchicalInverseDownsamplingFactor))
+    {
+    this->CoarseInverseTransform->Delete();
+    this->CoarseInverseTransform = nullptr;
+    return;
+    }
+
+  // The coarse solution is only a first guess, a tenth of a grid cell is accurate enough
+  double minimumSpacing = std::min(std::min(fabs(this->GridSpacing[0]), fabs(this->GridSpacing[1])), fabs(this->GridSpacing[2]));
+  this->CoarseInverseTransform->SetInverseTolerance(std::max(this->InverseTolerance, 0.1 * minimumSpacing));
+  this->CoarseInverseTransform->SetInverseIterations(this->InverseIterations);
+  this->CoarseInverseTransform->Update();
 }
 
 //----------------------------------------------------------------------------
@@ -30,6 +30,14 @@
 #include "vtkAddon.h"
 
 #include "vtkBSplineTransform.h"
+#include "vtkCommand.h"
+
+// STD includes
+#include <atomic>
+
+class vtkImageData;
+class vtkOrientedGridTransform;
+class vtkOrientedTransformInverseStatistics;
 
 class VTK_ADDON_EXPORT vtkOrientedBSplineTransform : public vtkBSplineTransform
 {
@@ -56,6 +64,157 @@ public:
   virtual void SetBulkTransformMatrix(vtkMatrix4x4*);
   vtkGetObjectMacro(BulkTransformMatrix,vtkMatrix4x4);
 
+  // Description:
+  // Evaluate the transform on a regular lattice and store the result as
+  // a displacement field (3-component double image, output point minus
+  // input point) in displacementField.
+  // The lattice is defined by its origin, spacing, axis directions (the
+  // 4th column and 4th row are ignored, nullptr means identity) and
+  // dimensions. The direction is not stored in the image.
+  // When the lattice axes are aligned with the b-spline grid axes (in any
+  // order) then the 1D basis weights are computed once per axis and the
+  // spline is evaluated separably. Other lattices are evaluated point by
+  // point. Slices are processed in parallel.
+  // Returns false on invalid input.
+  bool EvaluateOnGrid(const double origin[3], const double spacing[3],
+    vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* displacementField);
+
+  // Description:
+  // Evaluate the determinant of the Jacobian of the transform on a regular
+  // lattice (defined the same way as in EvaluateOnGrid) and store it in
+  // jacobianDeterminant (1-component double image).
+  // Aligned lattices use the separable evaluation with the derivatives of
+  // the 1D basis weights. Slices are processed in parallel.
+  // Returns false on invalid input.
+  bool EvaluateJacobianDeterminantOnGrid(const double origin[3], const double spacing[3],
+    vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* jacobianDeterminant);
+
+  // Description:
+  // Sample the transform, including the bulk transform, on a regular
+  // lattice (defined the same way as in EvaluateOnGrid) and set the result
+  // as the displacement grid of gridTransform (with linear interpolation).
+  // Within the lattice the grid transform approximates this transform with
+  // a trilinear lookup instead of a cubic b-spline evaluation. Outside the
+  // lattice the displacement is clamped, so the bulk transform is not
+  // extrapolated.
+  // If maximumError is not nullptr then it is set to the maximum distance
+  // between the two transforms at the center of the lattice cells.
+  // Sampling and error computation run in parallel.
+  // Returns false on invalid input.
+  bool ConvertToGridTransform(vtkOrientedGridTransform* gridTransform, const double origin[3],
+    const double spacing[3], vtkMatrix4x4* direction, const int dimensions[3], double* maximumError = nullptr);
+
+  // Description:
+  // Convert to a grid transform that covers the coefficient grid, with the
+  // same axis directions and the specified spacing.
+  bool ConvertToGridTransform(vtkOrientedGridTransform* gridTransform, const double spacing[3],
+    double* maximumError = nullptr);
+
+  // Description:
+  // Compute the inverse of the transform for a sequence of points, stored
+  // as x1, y1, z1, x2, y2, z2, ... (inPoints and outPoints may be the same).
+  // Consecutive points are expected to be close to each other (for example
+  // in scanline order): the iteration of each point starts from the
+  // solution of the previous point, shifted by the distance between the
+  // input points. Blocks of points are processed in parallel.
+  // Returns the mean number of iterations per point.
+  double InverseTransformPoints(const double* inPoints, double* outPoints, vtkIdType numberOfPoints);
+
+  // Description:
+  // Set/Get the method that is used for computing the inverse transform.
+  // NewtonSolver evaluates the spline derivative in each iteration.
+  // BroydenSolver evaluates the derivative at the first guess only and
+  // updates it with Broyden's rank-1 formula from the spline values of
+  // the following iterations. The derivative is evaluated again when the
+  // error stops decreasing. Evaluating the spline value is cheaper than
+  // evaluating its derivative, therefore BroydenSolver is usually faster
+  // for smooth transforms, while NewtonSolver needs fewer iterations.
+  // Default is NewtonSolver.
+  enum InverseSolverType
+    {
+    NewtonSolver = 0,
+    BroydenSolver = 1
+    };
+  vtkSetClampMacro(InverseSolver, int, NewtonSolver, BroydenSolver);
+  vtkGetMacro(InverseSolver, int);
+  void SetInverseSolverToNewton() { this->SetInverseSolver(NewtonSolver); };
+  void SetInverseSolverToBroyden() { this->SetInverseSolver(BroydenSolver); };
+
+  // Description:
+  // If enabled then the inverse is computed coarse-to-fine: a coarse grid
+  // transform, whose displacements are averaged over boxes of
+  // HierarchicalInverseDownsamplingFactor coefficient grid nodes along
+  // each axis, is built when the transform is updated. Inverse points that
+  // have no good first guess are solved on the coarse transform first,
+  // and the result is refined on the b-spline transform by the selected
+  // InverseSolver. Iterations on the coarse transform are included in the
+  // inverse statistics. Default is off.
+  vtkSetMacro(HierarchicalInverse, bool);
+  vtkGetMacro(HierarchicalInverse, bool);
+  vtkBooleanMacro(HierarchicalInverse, bool);
+
+  // Description:
+  // Downsampling factor of the coarse transform of the hierarchical
+  // inverse. The coefficient grid is usually coarse, so the default is 2.
+  vtkSetClampMacro(HierarchicalInverseDownsamplingFactor, int, 2, 64);
+  vtkGetMacro(HierarchicalInverseDownsamplingFactor, int);
+
+  // Description:
+  // Get the coarse transform of the hierarchical inverse.
+  // Returns nullptr if HierarchicalInverse is off.
+  vtkGetObjectMacro(CoarseInverseTransform, vtkOrientedGridTransform);
+
+  // Description:
+  // Get convergence statistics of the inverse computations (number of
+  // computations, iterations, failures, maximum residual).
+  // Each inverse point counts as one computation. Iterations
+  // count the number of evaluations of the forward transform.
+  // Statistics are not reset when the transform is modified.
+  vtkGetObjectMacro(InverseStatistics, vtkOrientedTransformInverseStatistics);
+
+  // Description:
+  // Set all inverse convergence statistics counters to zero.
+  void ResetInverseStatistics();
+
+  // Description:
+  // If larger than 0 then InverseStatisticsEvent is invoked each time
+  // the number of inverse computations reaches a multiple of this value.
+  // Default is 0 (no events).
+  vtkSetMacro(InverseStatisticsEventInterval, vtkIdType);
+  vtkGetMacro(InverseStatisticsEventInterval, vtkIdType);
+
+  // Description:
+  // Enable thread-safe evaluation. If enabled, then after Update() the
+  // transform can be evaluated concurrently from multiple threads (for
+  // example by calling InternalTransformPoint in vtkSMPTools loops):
+  // evaluation does not modify the transform, convergence failures are
+  // counted atomically, and no warnings are logged and no events are
+  // invoked during evaluation. Call InvokePendingEvents() from the calling
+  // thread when the batch completes to report them. EvaluateOnGrid then
+  // also evaluates inverted transforms in parallel, and reports pending
+  // events when it is done.
+  // Default is off.
+  vtkSetMacro(ThreadSafeEvaluation, bool);
+  vtkGetMacro(ThreadSafeEvaluation, bool);
+  vtkBooleanMacro(ThreadSafeEvaluation, bool);
+
+  // Description:
+  // Log a warning for convergence failures and invoke the events that
+  // were deferred in thread-safe evaluation mode.
+  // Must not be called while the transform is evaluated by other threads.
+  void InvokePendingEvents();
+
+  /// List of custom events fired by the class.
+  // ConvergenceFailureEvent is invoked when the inverse computation does
+  // not converge.
+  // InverseStatisticsEvent is invoked periodically, see
+  // InverseStatisticsEventInterval.
+  enum Events
+    {
+    ConvergenceFailureEvent = vtkCommand::UserEvent + 1,
+    InverseStatisticsEvent = vtkCommand::UserEvent + 2
+    };
+
 protected:
   vtkOrientedBSplineTransform();
   ~vtkOrientedBSplineTransform() override;
@@ -81,6 +240,51 @@ protected:
                                   double derivative[3][3]) override;
   using Superclass::InverseTransformDerivative; // Inherit the float version from parent
 
+  // Description:
+  // Compute the inverse transform using Newton's method.
+  // If initialGuess is nullptr then the first guess is computed from the
+  // inverse bulk transform and the displacement at the input point.
+  // This method does not log messages, therefore it can be called from
+  // multiple threads.
+  // Returns false if the iteration did not converge. The last good
+  // result is returned in outPoint in this case.
+  bool InverseTransformPointNewton(const double inPoint[3], const double* initialGuess,
+    double outPoint[3], double derivative[3][3], int& numberOfIterations, double& errorSquared);
+
+  // Description:
+  // Compute the inverse transform using Broyden's method. Arguments and
+  // return value are the same as in InverseTransformPointNewton, except
+  // that derivative may be nullptr if the derivative at the result is
+  // not needed. numberOfIterations counts the evaluations of the spline.
+  bool InverseTransformPointBroyden(const double inPoint[3], const double* initialGuess,
+    double outPoint[3], double derivative[3][3], int& numberOfIterations, double& errorSquared);
+
+  // Description:
+  // Compute the inverse transform using the selected InverseSolver.
+  // derivative may be nullptr if it is not needed.
+  bool InverseTransformPointIterative(const double inPoint[3], const double* initialGuess,
+    double outPoint[3], double derivative[3][3], int& numberOfIterations, double& errorSquared);
+
+  // Description:
+  // Compute the inverse transform without a first guess: on the coarse
+  // transform first (if HierarchicalInverse is enabled), then on the
+  // b-spline transform using the selected InverseSolver. If the
+  // refinement does not converge then the default first guess is tried
+  // as well. derivative may be nullptr if it is not needed.
+  bool InverseTransformPointHierarchical(const double inPoint[3], double outPoint[3],
+    double derivative[3][3], int& numberOfIterations, double& errorSquared);
+
+  // Description:
+  // Build the coarse transform of the hierarchical inverse.
+  void UpdateCoarseInverseTransform();
+
+  // Description:
+  // Compute the difference between the transformed point and the target
+  // point (errorVector = T(point) - target) and, if derivative is not
+  // nullptr, the derivative of the forward transform at point.
+  void ComputeInverseError(const double point[3], const double target[3],
+    double errorVector[3], double derivative[3][3]);
+
   // Description:
   // Grid axis direction vectors (i, j, k) in the output space
   vtkMatrix4x4* GridDirectionMatrix;
@@ -93,6 +297,29 @@ protected:
   vtkMatrix4x4* OutputToGridIndexTransformMatrixCached;
   vtkMatrix4x4* InverseBulkTransformMatrixCached;
 
+  // Description:
+  // Inverse convergence statistics.
+  vtkOrientedTransformInverseStatistics* InverseStatistics;
+  vtkIdType InverseStatisticsEventInterval;
+  int InverseSolver;
+
+  // Description:
+  // Coarse transform of the hierarchical inverse.
+  bool HierarchicalInverse;
+  int HierarchicalInverseDownsamplingFactor;
+  vtkOrientedGridTransform* CoarseInverseTransform;
+
+  // Description:
+  // Avoid generating hundreds of warning messages for convergence problems
+  // by keeping track of the MTime when the last warning was issued.
+  vtkMTimeType LastWarningMTime;
+
+  // Description:
+  // Thread-safe evaluation mode and the events deferred in this mode.
+  bool ThreadSafeEvaluation;
+  std::atomic<vtkIdType> PendingConvergenceFailures;
+  std::atomic<bool> PendingInverseStatisticsEvent;
+
 private:
   vtkOrientedBSplineTransform(const vtkOrientedBSplineTransform&) = delete;
   void operator=(const vtkOrientedBSplineTransform&) = delete;
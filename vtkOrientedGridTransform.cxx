@@ -9,14 +9,37 @@
 
 #include "vtkOrientedGridTransform.h"
 
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkGeneralTransform.h"
+#include "vtkImageData.h"
+#include "vtkLinearTransform.h"
+#include "vtkMappedDisplacementGrid.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkOrientedTransformInverseStatistics.h"
+#include "vtkOrientedTransformLattice.h"
+#include "vtkOrientedTransformToGrid.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
+
+#include <algorithm>
+#include <cstring>
 
 vtkStandardNewMacro(vtkOrientedGridTransform);
 
 vtkCxxSetObjectMacro(vtkOrientedGridTransform,GridDirectionMatrix,vtkMatrix4x4);
+vtkCxxSetObjectMacro(vtkOrientedGridTransform,MappedDisplacementGrid,vtkMappedDisplacementGrid);
+
+// Number of consecutive points that are inverted in sequence in InverseTransformPoints
+static const vtkIdType vtkOrientedGridTransformInverseBlockSize = 1024;
+
+// Number of consecutive points that are prefetched together from a mapped displacement grid
+static const vtkIdType vtkOrientedGridTransformPrefetchBlockSize = 1024;
 
 //----------------------------------------------------------------------------
 vtkOrientedGridTransform::vtkOrientedGridTransform()
@@ -26,12 +49,48 @@ vtkOrientedGridTransform::vtkOrientedGridTransform()
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
 
   this->LastWarningMTime = 0;
+
+  this->UseInverseGrid = false;
+  this->InverseGridNewtonRefinement = true;
+  this->InverseGrid = nullptr;
+
+  this->HierarchicalInverse = false;
+  this->HierarchicalInverseDownsamplingFactor = 4;
+  this->CoarseInverseTransform = nullptr;
+
+  this->InverseStatistics = vtkOrientedTransformInverseStatistics::New();
+  this->InverseStatisticsEventInterval = 0;
+
+  this->ForwardPointKernel = nullptr;
+  this->ForwardDerivativeKernel = nullptr;
+  this->GridAxisAligned = false;
+
+  this->ThreadSafeEvaluation = false;
+  this->PendingConvergenceFailures = 0;
+  this->PendingInverseStatisticsEvent = false;
+
+  this->HalfFloatGrid = false;
+  this->BSplineInterpolation = false;
+  this->UseBSplineInterpolation = false;
+  this->BSplineCoefficients = nullptr;
+  for (int i = 0; i < 3; i++)
+    {
+    this->DisplacementComponentScale[i] = 1.0;
+    this->DisplacementComponentShift[i] = 0.0;
+    this->DisplacementScaleCached[i] = 1.0;
+    this->DisplacementShiftCached[i] = 0.0;
+    }
+
+  this->MappedDisplacementGrid = nullptr;
+  this->UseMappedDisplacementGrid = false;
+  this->ImageInterpolationFunction = nullptr;
 }
 
 //----------------------------------------------------------------------------
 vtkOrientedGridTransform::~vtkOrientedGridTransform()
 {
   this->SetGridDirectionMatrix(nullptr);
+  this->SetMappedDisplacementGrid(nullptr);
   if (this->GridIndexToOutputTransformMatrixCached)
     {
     this->GridIndexToOutputTransformMatrixCached->Delete();
@@ -42,6 +101,26 @@ vtkOrientedGridTransform::~vtkOrientedGridTransform()
     this->OutputToGridIndexTransformMatrixCached->Delete();
     this->OutputToGridIndexTransformMatrixCached = nullptr;
     }
+  if (this->InverseGrid)
+    {
+    this->InverseGrid->Delete();
+    this->InverseGrid = nullptr;
+    }
+  if (this->CoarseInverseTransform)
+    {
+    this->CoarseInverseTransform->Delete();
+    this->CoarseInverseTransform = nullptr;
+    }
+  if (this->InverseStatistics)
+    {
+    this->InverseStatistics->Delete();
+    this->InverseStatistics = nullptr;
+    }
+  if (this->BSplineCoefficients)
+    {
+    this->BSplineCoefficients->Delete();
+    this->BSplineCoefficients = nullptr;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -54,6 +133,83 @@ void vtkOrientedGridTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GridDirectionMatrix->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "UseInverseGrid: " << (this->UseInverseGrid ? "true" : "false") << "\n";
+  os << indent << "InverseGridNewtonRefinement: " << (this->InverseGridNewtonRefinement ? "true" : "false") << "\n";
+  os << indent << "HierarchicalInverse: " << (this->HierarchicalInverse ? "true" : "false") << "\n";
+  os << indent << "HierarchicalInverseDownsamplingFactor: " << this->HierarchicalInverseDownsamplingFactor << "\n";
+  os << indent << "ThreadSafeEvaluation: " << (this->ThreadSafeEvaluation ? "true" : "false") << "\n";
+  os << indent << "BSplineInterpolation: " << (this->BSplineInterpolation ? "true" : "false") << "\n";
+  os << indent << "HalfFloatGrid: " << (this->HalfFloatGrid ? "true" : "false") << "\n";
+  os << indent << "DisplacementComponentScale: (" << this->DisplacementComponentScale[0] << ", "
+     << this->DisplacementComponentScale[1] << ", " << this->DisplacementComponentScale[2] << ")\n";
+  os << indent << "DisplacementComponentShift: (" << this->DisplacementComponentShift[0] << ", "
+     << this->DisplacementComponentShift[1] << ", " << this->DisplacementComponentShift[2] << ")\n";
+  os << indent << "MappedDisplacementGrid: " << this->MappedDisplacementGrid << "\n";
+  if (this->MappedDisplacementGrid)
+    {
+    this->MappedDisplacementGrid->PrintSelf(os,indent.GetNextIndent());
+    }
+  os << indent << "InverseStatisticsEventInterval: " << this->InverseStatisticsEventInterval << "\n";
+  os << indent << "InverseStatistics:\n";
+  this->InverseStatistics->PrintSelf(os,indent.GetNextIndent());
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkOrientedGridTransform::GetMTime()
+{
+  vtkMTimeType mtime = this->Superclass::GetMTime();
+  if (this->MappedDisplacementGrid)
+    {
+    vtkMTimeType mtime2 = this->MappedDisplacementGrid->GetMTime();
+    if (mtime2 > mtime)
+      {
+      mtime = mtime2;
+      }
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::ResetInverseStatistics()
+{
+  this->InverseStatistics->Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::InvokePendingEvents()
+{
+  vtkIdType numberOfFailures = this->PendingConvergenceFailures.exchange(0);
+  if (numberOfFailures > 0)
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence for " << numberOfFailures << " points."
+                      "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
+    }
+  if (this->PendingInverseStatisticsEvent.exchange(false))
+    {
+    this->InvokeEvent(vtkOrientedGridTransform::InverseStatisticsEvent);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::AddInverseStatistics(int numberOfIterations, bool converged, double residual)
+{
+  if (!this->InverseStatistics->AddCall(numberOfIterations, converged, residual, this->InverseStatisticsEventInterval))
+    {
+    return;
+    }
+  if (this->ThreadSafeEvaluation)
+    {
+    this->PendingInverseStatisticsEvent = true;
+    }
+  else
+    {
+    this->InvokeEvent(vtkOrientedGridTransform::InverseStatisticsEvent);
+    }
 }
 
 //------------------------------------------------------------------------
@@ -97,167 +253,1496 @@ inline void vtkLinearTransformJacobian(double aMat[3][3], double bMat[4][4], dou
     }
 }
 
-//----------------------------------------------------------------------------
-void vtkOrientedGridTransform::ForwardTransformPoint(const double inPoint[3],
-                                             double outPoint[3])
+//------------------------------------------------------------------------
+// Conversion of an IEEE 754 half-precision float to single precision.
+inline float vtkOrientedGridTransformHalfToFloat(vtkTypeUInt16 half)
 {
-  if (this->GridDirectionMatrix == nullptr || this->GridPointer == nullptr)
+  vtkTypeUInt32 sign = static_cast<vtkTypeUInt32>(half & 0x8000u) << 16;
+  vtkTypeUInt32 exponent = (half >> 10) & 0x1fu;
+  vtkTypeUInt32 mantissa = half & 0x3ffu;
+  vtkTypeUInt32 bits;
+  if (exponent == 0)
     {
-    this->Superclass::ForwardTransformPoint(inPoint,outPoint);
-    return;
+    // zero or subnormal: mantissa * 2^-24
+    float value = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+    return (sign ? -value : value);
     }
+  else if (exponent == 31)
+    {
+    // infinity or NaN
+    bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+  else
+    {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
 
-  void *gridPtr = this->GridPointer;
-  int gridType = this->GridScalarType;
-
-  int *extent = this->GridExtent;
-  vtkIdType *increments = this->GridIncrements;
-
-  double scale = this->DisplacementScale;
-  double shift = this->DisplacementShift;
-
-  double point[3];
-  double displacement[3];
+//------------------------------------------------------------------------
+// Conversion of a single precision float to IEEE 754 half-precision,
+// rounding to the nearest even value.
+inline vtkTypeUInt16 vtkOrientedGridTransformFloatToHalf(float value)
+{
+  vtkTypeUInt32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  vtkTypeUInt32 sign = (bits >> 16) & 0x8000u;
+  int exponent = static_cast<int>((bits >> 23) & 0xffu) - 127 + 15;
+  vtkTypeUInt32 mantissa = bits & 0x7fffffu;
+  if (((bits >> 23) & 0xffu) == 0xffu)
+    {
+    // infinity or NaN
+    return static_cast<vtkTypeUInt16>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+  if (exponent >= 31)
+    {
+    // overflow
+    return static_cast<vtkTypeUInt16>(sign | 0x7c00u);
+    }
+  if (exponent <= 0)
+    {
+    // subnormal or underflow
+    if (exponent < -10)
+      {
+      return static_cast<vtkTypeUInt16>(sign);
+      }
+    mantissa |= 0x800000u;
+    int shiftBits = 14 - exponent;
+    vtkTypeUInt32 half = mantissa >> shiftBits;
+    vtkTypeUInt32 remainder = mantissa & ((1u << shiftBits) - 1);
+    vtkTypeUInt32 halfway = 1u << (shiftBits - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1u)))
+      {
+      half++;
+      }
+    return static_cast<vtkTypeUInt16>(sign | half);
+    }
+  vtkTypeUInt32 half = sign | (static_cast<vtkTypeUInt32>(exponent) << 10) | (mantissa >> 13);
+  vtkTypeUInt32 remainder = mantissa & 0x1fffu;
+  // a carry into the exponent gives the correct result (up to infinity)
+  if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+    {
+    half++;
+    }
+  return static_cast<vtkTypeUInt16>(half);
+}
 
-  // Convert the inPoint to i,j,k indices into the deformation grid
-  // plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+//------------------------------------------------------------------------
+// Value of a half-float displacement grid. The interpolation kernels are
+// instantiated for this type, the values are converted when they are read.
+struct vtkOrientedGridTransformHalfFloat
+{
+  vtkTypeUInt16 Bits;
+  operator double() const
+  {
+    return vtkOrientedGridTransformHalfToFloat(this->Bits);
+  }
+};
 
-  this->InterpolationFunction(point,displacement,nullptr,
-                              gridPtr,gridType,extent,increments);
+// Grid type of half-float grids in the kernel selection (not a VTK scalar type)
+static const int vtkOrientedGridTransformHalfFloatType = -1;
 
-  outPoint[0] = inPoint[0] + (displacement[0]*scale + shift);
-  outPoint[1] = inPoint[1] + (displacement[1]*scale + shift);
-  outPoint[2] = inPoint[2] + (displacement[2]*scale + shift);
+//------------------------------------------------------------------------
+// Grid type used to select the interpolation kernels.
+inline int vtkOrientedGridTransformKernelType(int gridScalarType, bool halfFloatGrid)
+{
+  if (halfFloatGrid && gridScalarType == VTK_UNSIGNED_SHORT)
+    {
+    return vtkOrientedGridTransformHalfFloatType;
+    }
+  return gridScalarType;
 }
 
-//----------------------------------------------------------------------------
-void vtkOrientedGridTransform::ForwardTransformDerivative(const double inPoint[3],
-                                                  double outPoint[3],
-                                                  double derivative[3][3])
+//------------------------------------------------------------------------
+// Trilinear interpolation of the displacement at a grid index position.
+// Positions outside of the grid are clamped to the grid boundary, the
+// same way as in the linear interpolation of vtkGridTransform.
+// The derivative (with respect to the grid index) is only computed if
+// derivative is not nullptr.
+template <class T>
+inline void vtkOrientedGridTransformInterpolateLinear(const double point[3], double displacement[3],
+  double derivative[3][3], const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
 {
-  if (this->GridDirectionMatrix == nullptr || this->GridPointer == nullptr)
+  double f[3];
+  vtkIdType gridOffset0[3], gridOffset1[3];
+  for (int i = 0; i < 3; i++)
     {
-    this->Superclass::ForwardTransformDerivative(inPoint,outPoint,derivative);
-    return;
+    int floorIndex = vtkMath::Floor(point[i]);
+    f[i] = point[i] - floorIndex;
+    int gridId0 = floorIndex - gridExt[2*i];
+    int gridId1 = gridId0 + 1;
+    int ext = gridExt[2*i+1] - gridExt[2*i];
+    if (gridId0 < 0)
+      {
+      gridId0 = 0;
+      gridId1 = 0;
+      f[i] = 0;
+      }
+    else if (gridId1 > ext)
+      {
+      gridId0 = ext;
+      gridId1 = ext;
+      f[i] = 0;
+      }
+    gridOffset0[i] = gridId0*gridInc[i];
+    gridOffset1[i] = gridId1*gridInc[i];
     }
 
-  void *gridPtr = this->GridPointer;
-  int gridType = this->GridScalarType;
+  double rx = 1 - f[0];
+  double ry = 1 - f[1];
+  double rz = 1 - f[2];
 
-  int *extent = this->GridExtent;
-  vtkIdType *increments = this->GridIncrements;
+  double ryrz = ry*rz;
+  double ryfz = ry*f[2];
+  double fyrz = f[1]*rz;
+  double fyfz = f[1]*f[2];
 
-  double scale = this->DisplacementScale;
-  double shift = this->DisplacementShift;
+  const T *v000 = gridPtr + gridOffset0[0] + gridOffset0[1] + gridOffset0[2];
+  const T *v001 = gridPtr + gridOffset0[0] + gridOffset0[1] + gridOffset1[2];
+  const T *v010 = gridPtr + gridOffset0[0] + gridOffset1[1] + gridOffset0[2];
+  const T *v011 = gridPtr + gridOffset0[0] + gridOffset1[1] + gridOffset1[2];
+  const T *v100 = gridPtr + gridOffset1[0] + gridOffset0[1] + gridOffset0[2];
+  const T *v101 = gridPtr + gridOffset1[0] + gridOffset0[1] + gridOffset1[2];
+  const T *v110 = gridPtr + gridOffset1[0] + gridOffset1[1] + gridOffset0[2];
+  const T *v111 = gridPtr + gridOffset1[0] + gridOffset1[1] + gridOffset1[2];
 
-  double point[3];
-  double displacement[3];
+  for (int i = 0; i < 3; i++)
+    {
+    displacement[i] = (rx*(ryrz*v000[i] + ryfz*v001[i] + fyrz*v010[i] + fyfz*v011[i]) +
+                       f[0]*(ryrz*v100[i] + ryfz*v101[i] + fyrz*v110[i] + fyfz*v111[i]));
+    }
 
-  // convert the inPoint to i,j,k indices plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+  if (!derivative)
+    {
+    return;
+    }
 
-  this->InterpolationFunction(point,displacement,derivative,
-                              gridPtr,gridType,extent,increments);
+  double rxrz = rx*rz;
+  double rxfz = rx*f[2];
+  double fxrz = f[0]*rz;
+  double fxfz = f[0]*f[2];
+  double rxry = rx*ry;
+  double rxfy = rx*f[1];
+  double fxry = f[0]*ry;
+  double fxfy = f[0]*f[1];
 
-  vtkLinearTransformJacobian(derivative, this->OutputToGridIndexTransformMatrixCached->Element, derivative);
   for (int i = 0; i < 3; i++)
     {
-    derivative[i][0] = derivative[i][0]*scale;
-    derivative[i][1] = derivative[i][1]*scale;
-    derivative[i][2] = derivative[i][2]*scale;
-    derivative[i][i] += 1.0;
+    derivative[i][0] = (ryrz*(v100[i] - v000[i]) + ryfz*(v101[i] - v001[i]) +
+                        fyrz*(v110[i] - v010[i]) + fyfz*(v111[i] - v011[i]));
+    derivative[i][1] = (rxrz*(v010[i] - v000[i]) + rxfz*(v011[i] - v001[i]) +
+                        fxrz*(v110[i] - v100[i]) + fxfz*(v111[i] - v101[i]));
+    derivative[i][2] = (rxry*(v001[i] - v000[i]) + rxfy*(v011[i] - v010[i]) +
+                        fxry*(v101[i] - v100[i]) + fxfy*(v111[i] - v110[i]));
     }
-
-  outPoint[0] = inPoint[0] + (displacement[0]*scale + shift);
-  outPoint[1] = inPoint[1] + (displacement[1]*scale + shift);
-  outPoint[2] = inPoint[2] + (displacement[2]*scale + shift);
 }
 
-//----------------------------------------------------------------------------
-void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3],
-                                                  double outPoint[3],
-                                                  double derivative[3][3])
+//------------------------------------------------------------------------
+// Nearest neighbor interpolation of the displacement at a grid index
+// position, the same way as in vtkGridTransform (rounding to the closest
+// grid point and clamping to the grid boundary).
+template <class T>
+inline void vtkOrientedGridTransformInterpolateNearest(const double point[3], double displacement[3],
+  const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
 {
-  if (this->GridDirectionMatrix == nullptr || this->GridPointer == nullptr)
+  vtkIdType gridOffset = 0;
+  for (int i = 0; i < 3; i++)
     {
-    this->Superclass::InverseTransformDerivative(inPoint,outPoint,derivative);
-    return;
+    int gridId = vtkMath::Floor(point[i] + 0.5) - gridExt[2*i];
+    int ext = gridExt[2*i+1] - gridExt[2*i];
+    if (gridId < 0)
+      {
+      gridId = 0;
+      }
+    else if (gridId > ext)
+      {
+      gridId = ext;
+      }
+    gridOffset += gridId*gridInc[i];
     }
 
-  void *gridPtr = this->GridPointer;
-  int gridType = this->GridScalarType;
+  const T *v = gridPtr + gridOffset;
+  displacement[0] = v[0];
+  displacement[1] = v[1];
+  displacement[2] = v[2];
+}
 
-  int *extent = this->GridExtent;
-  vtkIdType *increments = this->GridIncrements;
+//------------------------------------------------------------------------
+// Interpolation mode of the kernels for prefiltered cubic B-spline
+// interpolation (not a vtkGridTransform interpolation mode)
+static const int vtkOrientedGridTransformBSplineInterpolation = 100;
 
-  double shift = this->DisplacementShift;
-  double scale = this->DisplacementScale;
+//------------------------------------------------------------------------
+// Cubic B-spline weights (and their derivatives) of the 4 coefficients
+// around a position, t is the fractional part of the position.
+inline void vtkOrientedGridTransformBSplineWeights(double t, double weights[4], double derivativeWeights[4])
+{
+  double r = 1.0 - t;
+  double t2 = t*t;
+  double t3 = t2*t;
+  weights[0] = r*r*r / 6.0;
+  weights[1] = (3.0*t3 - 6.0*t2 + 4.0) / 6.0;
+  weights[2] = (-3.0*t3 + 3.0*t2 + 3.0*t + 1.0) / 6.0;
+  weights[3] = t3 / 6.0;
+  if (derivativeWeights)
+    {
+    derivativeWeights[0] = -0.5*r*r;
+    derivativeWeights[1] = 1.5*t2 - 2.0*t;
+    derivativeWeights[2] = -1.5*t2 + t + 0.5;
+    derivativeWeights[3] = 0.5*t2;
+    }
+}
 
-  double point[3], inverse[3], lastInverse[3], inverse_IJK[3];
-  double deltaP[3], deltaI[3];
+//------------------------------------------------------------------------
+// Index of a coefficient beyond the grid boundary, mirrored at the first
+// and last sample (the boundary condition of the prefilter).
+inline int vtkOrientedGridTransformMirrorIndex(int index, int size)
+{
+  if (size == 1)
+    {
+    return 0;
+    }
+  int period = 2*size - 2;
+  index = (index < 0 ? -index : index) % period;
+  return (index < size ? index : period - index);
+}
 
-  double functionValue = 0;
-  double functionDerivative = 0;
-  double lastFunctionValue = VTK_DOUBLE_MAX;
+//------------------------------------------------------------------------
+// Cubic B-spline interpolation of the displacement at a grid index
+// position from prefiltered coefficients. Positions outside of the grid
+// are clamped to the grid boundary, the same way as in the other
+// interpolation modes. The kernel is separable: the coefficients are
+// combined along i, then j, then k, for the three components at once.
+// The derivative (with respect to the grid index) is only computed if
+// derivative is not nullptr.
+template <class T>
+inline void vtkOrientedGridTransformInterpolateBSpline(const double point[3], double displacement[3],
+  double derivative[3][3], const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
+{
+  double weights[3][4], derivativeWeights[3][4];
+  vtkIdType offsets[3][4];
+  for (int i = 0; i < 3; i++)
+    {
+    int size = gridExt[2*i+1] - gridExt[2*i] + 1;
+    double position = point[i] - gridExt[2*i];
+    bool clamped = false;
+    if (position < 0.0)
+      {
+      position = 0.0;
+      clamped = true;
+      }
+    else if (position > size - 1)
+      {
+      position = size - 1;
+      clamped = true;
+      }
+    int floorIndex = vtkMath::Floor(position);
+    vtkOrientedGridTransformBSplineWeights(position - floorIndex, weights[i], derivativeWeights[i]);
+    for (int n = 0; n < 4; n++)
+      {
+      offsets[i][n] = vtkOrientedGridTransformMirrorIndex(floorIndex - 1 + n, size) * gridInc[i];
+      if (clamped)
+        {
+        // the displacement is constant beyond the boundary
+        derivativeWeights[i][n] = 0.0;
+        }
+      }
+    }
 
-  double errorSquared = 0.0;
-  double toleranceSquared = this->InverseTolerance;
-  toleranceSquared *= toleranceSquared;
+  double value[3] = { 0.0, 0.0, 0.0 };
+  double valueDI[3] = { 0.0, 0.0, 0.0 };
+  double valueDJ[3] = { 0.0, 0.0, 0.0 };
+  double valueDK[3] = { 0.0, 0.0, 0.0 };
+  for (int k = 0; k < 4; k++)
+    {
+    double plane[3] = { 0.0, 0.0, 0.0 };
+    double planeDI[3] = { 0.0, 0.0, 0.0 };
+    double planeDJ[3] = { 0.0, 0.0, 0.0 };
+    for (int j = 0; j < 4; j++)
+      {
+      const T *row = gridPtr + offsets[2][k] + offsets[1][j];
+      double line[3] = { 0.0, 0.0, 0.0 };
+      double lineDI[3] = { 0.0, 0.0, 0.0 };
+      for (int i = 0; i < 4; i++)
+        {
+        const T *v = row + offsets[0][i];
+        for (int c = 0; c < 3; c++)
+          {
+          line[c] += weights[0][i] * v[c];
+          lineDI[c] += derivativeWeights[0][i] * v[c];
+          }
+        }
+      for (int c = 0; c < 3; c++)
+        {
+        plane[c] += weights[1][j] * line[c];
+        planeDI[c] += weights[1][j] * lineDI[c];
+        planeDJ[c] += derivativeWeights[1][j] * line[c];
+        }
+      }
+    for (int c = 0; c < 3; c++)
+      {
+      value[c] += weights[2][k] * plane[c];
+      valueDI[c] += weights[2][k] * planeDI[c];
+      valueDJ[c] += weights[2][k] * planeDJ[c];
+      valueDK[c] += derivativeWeights[2][k] * plane[c];
+      }
+    }
 
-  double f = 1.0;
-  double a;
+  displacement[0] = value[0];
+  displacement[1] = value[1];
+  displacement[2] = value[2];
+  if (derivative)
+    {
+    for (int c = 0; c < 3; c++)
+      {
+      derivative[c][0] = valueDI[c];
+      derivative[c][1] = valueDJ[c];
+      derivative[c][2] = valueDK[c];
+      }
+    }
+}
 
-  // convert the inPoint to i,j,k indices plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+//------------------------------------------------------------------------
+// Interpolation function of prefiltered B-spline coefficients with the
+// signature of the vtkGridTransform::InterpolationFunction.
+static void vtkOrientedGridTransformInterpolateBSplineFunction(double point[3], double displacement[3],
+  double derivatives[3][3], void *gridPtr, int vtkNotUsed(gridType), int gridExt[6], vtkIdType gridInc[3])
+{
+  vtkOrientedGridTransformInterpolateBSpline(point, displacement, derivatives,
+    static_cast<const double*>(gridPtr), gridExt, gridInc);
+}
 
-  // first guess at inverse point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->InterpolationFunction(point, deltaP, nullptr,
-                              gridPtr, gridType, extent, increments);
+//------------------------------------------------------------------------
+// Recursive cubic B-spline prefilter of a line of samples with mirror
+// boundary conditions, in place (Unser et al., IEEE TSP 1993).
+static void vtkOrientedGridTransformPrefilterLine(double *c, vtkIdType increment, int size)
+{
+  if (size < 2)
+    {
+    return;
+    }
+  const double z = sqrt(3.0) - 2.0;
+  const double gain = 6.0;
+  for (int n = 0; n < size; n++)
+    {
+    c[n*increment] *= gain;
+    }
 
-  inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
-  inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
-  inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
-  lastInverse[0] = inverse[0];
-  lastInverse[1] = inverse[1];
-  lastInverse[2] = inverse[2];
+  // initial causal coefficient
+  const int horizon = static_cast<int>(ceil(log(1e-12) / log(fabs(z))));
+  double sum = c[0];
+  if (horizon < size)
+    {
+    double zn = z;
+    for (int n = 1; n < horizon; n++)
+      {
+      sum += zn * c[n*increment];
+      zn *= z;
+      }
+    }
+  else
+    {
+    double zn = z;
+    double iz = 1.0 / z;
+    double z2n = pow(z, size - 1);
+    sum += z2n * c[(size - 1)*increment];
+    z2n *= z2n * iz;
+    for (int n = 1; n < size - 1; n++)
+      {
+      sum += (zn + z2n) * c[n*increment];
+      zn *= z;
+      z2n *= iz;
+      }
+    sum /= (1.0 - zn * zn);
+    }
+  c[0] = sum;
 
-  // do a maximum 500 iterations, usually less than 10 are required
-  int n = this->InverseIterations;
-  int i, j;
+  // causal recursion
+  for (int n = 1; n < size; n++)
+    {
+    c[n*increment] += z * c[(n - 1)*increment];
+    }
 
-  for (i = 0; i < n; i++)
+  // initial anti-causal coefficient and anti-causal recursion
+  c[(size - 1)*increment] = (z / (z*z - 1.0)) * (z * c[(size - 2)*increment] + c[(size - 1)*increment]);
+  for (int n = size - 2; n >= 0; n--)
     {
-    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inverse, inverse_IJK);
-    this->InterpolationFunction(inverse_IJK, deltaP, derivative,
-                                gridPtr, gridType, extent, increments);
+    c[n*increment] = z * (c[(n + 1)*increment] - c[n*increment]);
+    }
+}
+
+//------------------------------------------------------------------------
+// Displacement interpolation selected at compile time from the
+// interpolation mode, so that it can be inlined in the transform loops.
+template <class T, int Interpolation>
+struct vtkOrientedGridTransformInterpolator;
 
-    // convert displacement
-    deltaP[0] = (inverse[0] + deltaP[0]*scale + shift) - inPoint[0];
-    deltaP[1] = (inverse[1] + deltaP[1]*scale + shift) - inPoint[1];
-    deltaP[2] = (inverse[2] + deltaP[2]*scale + shift) - inPoint[2];
+template <class T>
+struct vtkOrientedGridTransformInterpolator<T, VTK_NEAREST_INTERPOLATION>
+{
+  static inline void Interpolate(const double point[3], double displacement[3],
+    const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
+  {
+    vtkOrientedGridTransformInterpolateNearest(point, displacement, gridPtr, gridExt, gridInc);
+  }
+};
+
+template <class T>
+struct vtkOrientedGridTransformInterpolator<T, VTK_LINEAR_INTERPOLATION>
+{
+  static inline void Interpolate(const double point[3], double displacement[3],
+    const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
+  {
+    vtkOrientedGridTransformInterpolateLinear(point, displacement, nullptr, gridPtr, gridExt, gridInc);
+  }
+  static inline void InterpolateDerivative(const double point[3], double displacement[3], double derivative[3][3],
+    const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
+  {
+    vtkOrientedGridTransformInterpolateLinear(point, displacement, derivative, gridPtr, gridExt, gridInc);
+  }
+};
+
+template <class T>
+struct vtkOrientedGridTransformInterpolator<T, vtkOrientedGridTransformBSplineInterpolation>
+{
+  static inline void Interpolate(const double point[3], double displacement[3],
+    const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
+  {
+    vtkOrientedGridTransformInterpolateBSpline(point, displacement, nullptr, gridPtr, gridExt, gridInc);
+  }
+  static inline void InterpolateDerivative(const double point[3], double displacement[3], double derivative[3][3],
+    const T *gridPtr, const int gridExt[6], const vtkIdType gridInc[3])
+  {
+    vtkOrientedGridTransformInterpolateBSpline(point, displacement, derivative, gridPtr, gridExt, gridInc);
+  }
+};
 
-    // convert derivative
-    vtkLinearTransformJacobian(derivative, this->OutputToGridIndexTransformMatrixCached->Element, derivative);
-    for (j = 0; j < 3; j++)
+//------------------------------------------------------------------------
+// Interpolation functions of half-float grids with the signature of the
+// vtkGridTransform::InterpolationFunction, used when there is no kernel
+// (derivative of nearest neighbor interpolation, inverse without kernels).
+static void vtkOrientedGridTransformInterpolateHalfFloatNearest(double point[3], double displacement[3],
+  double derivatives[3][3], void *gridPtr, int vtkNotUsed(gridType), int gridExt[6], vtkIdType gridInc[3])
+{
+  vtkOrientedGridTransformInterpolateNearest(point, displacement,
+    static_cast<const vtkOrientedGridTransformHalfFloat*>(gridPtr), gridExt, gridInc);
+  if (derivatives)
+    {
+    for (int i = 0; i < 3; i++)
       {
-      derivative[j][0] = derivative[j][0]*scale;
-      derivative[j][1] = derivative[j][1]*scale;
-      derivative[j][2] = derivative[j][2]*scale;
-      derivative[j][j] += 1.0;
+      derivatives[i][0] = derivatives[i][1] = derivatives[i][2] = 0.0;
       }
+    }
+}
 
-    // get the current function value
-    functionValue = (deltaP[0]*deltaP[0] +
-                     deltaP[1]*deltaP[1] +
-                     deltaP[2]*deltaP[2]);
+//------------------------------------------------------------------------
+static void vtkOrientedGridTransformInterpolateHalfFloatLinear(double point[3], double displacement[3],
+  double derivatives[3][3], void *gridPtr, int vtkNotUsed(gridType), int gridExt[6], vtkIdType gridInc[3])
+{
+  vtkOrientedGridTransformInterpolateLinear(point, displacement, derivatives,
+    static_cast<const vtkOrientedGridTransformHalfFloat*>(gridPtr), gridExt, gridInc);
+}
 
-    // if the function value is decreasing, do next Newton step
-    // (the f < 1.0 is there because I found that convergence
-    // is more stable if only a single reduction step is done)
-    if (i == 0 || functionValue < lastFunctionValue || f < 1.0)
-      {
+//------------------------------------------------------------------------
+// Conversion from output coordinates to grid index. If the grid axes are
+// aligned with the output axes then the matrix is diagonal and only the
+// diagonal and the translation are used.
+template <bool AxisAligned>
+inline void vtkOrientedGridTransformOutputToGridIndex(const double matrix[4][4],
+  const double in[3], double out[3])
+{
+  if (AxisAligned)
+    {
+    out[0] = matrix[0][0]*in[0] + matrix[0][3];
+    out[1] = matrix[1][1]*in[1] + matrix[1][3];
+    out[2] = matrix[2][2]*in[2] + matrix[2][3];
+    }
+  else
+    {
+    vtkLinearTransformPoint(matrix, in, out);
+    }
+}
+
+//------------------------------------------------------------------------
+// Conversion of the derivative with respect to the grid index to the
+// derivative with respect to the output coordinates.
+template <bool AxisAligned>
+inline void vtkOrientedGridTransformGridIndexJacobian(double derivative[3][3], const double matrix[4][4])
+{
+  if (AxisAligned)
+    {
+    for (int i = 0; i < 3; i++)
+      {
+      derivative[i][0] *= matrix[0][0];
+      derivative[i][1] *= matrix[1][1];
+      derivative[i][2] *= matrix[2][2];
+      }
+    }
+  else
+    {
+    double result[3][3];
+    for (int i = 0; i < 3; i++)
+      {
+      for (int k = 0; k < 3; k++)
+        {
+        result[i][k] = (derivative[i][0]*matrix[0][k] +
+                        derivative[i][1]*matrix[1][k] +
+                        derivative[i][2]*matrix[2][k]);
+        }
+      }
+    for (int i = 0; i < 3; i++)
+      {
+      derivative[i][0] = result[i][0];
+      derivative[i][1] = result[i][1];
+      derivative[i][2] = result[i][2];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T, int Interpolation, bool AxisAligned>
+void vtkOrientedGridTransform::ForwardTransformPointKernel(const double inPoint[3], double outPoint[3])
+{
+  double point[3];
+  double displacement[3];
+  vtkOrientedGridTransformOutputToGridIndex<AxisAligned>(this->OutputToGridIndexTransformMatrixCached->Element,
+    inPoint, point);
+  vtkOrientedGridTransformInterpolator<T, Interpolation>::Interpolate(point, displacement,
+    static_cast<const T*>(this->GridPointer), this->GridExtent, this->GridIncrements);
+
+  const double *scale = this->DisplacementScaleCached;
+  const double *shift = this->DisplacementShiftCached;
+  outPoint[0] = inPoint[0] + (displacement[0]*scale[0] + shift[0]);
+  outPoint[1] = inPoint[1] + (displacement[1]*scale[1] + shift[1]);
+  outPoint[2] = inPoint[2] + (displacement[2]*scale[2] + shift[2]);
+}
+
+//----------------------------------------------------------------------------
+template <class T, int Interpolation, bool AxisAligned>
+void vtkOrientedGridTransform::ForwardTransformDerivativeKernel(const double inPoint[3], double outPoint[3],
+  double derivative[3][3])
+{
+  const double (*m)[4] = this->OutputToGridIndexTransformMatrixCached->Element;
+  double point[3];
+  double displacement[3];
+  vtkOrientedGridTransformOutputToGridIndex<AxisAligned>(m, inPoint, point);
+  vtkOrientedGridTransformInterpolator<T, Interpolation>::InterpolateDerivative(point, displacement, derivative,
+    static_cast<const T*>(this->GridPointer), this->GridExtent, this->GridIncrements);
+
+  const double *scale = this->DisplacementScaleCached;
+  const double *shift = this->DisplacementShiftCached;
+  vtkOrientedGridTransformGridIndexJacobian<AxisAligned>(derivative, m);
+  for (int i = 0; i < 3; i++)
+    {
+    derivative[i][0] = derivative[i][0]*scale[i];
+    derivative[i][1] = derivative[i][1]*scale[i];
+    derivative[i][2] = derivative[i][2]*scale[i];
+    derivative[i][i] += 1.0;
+    }
+
+  outPoint[0] = inPoint[0] + (displacement[0]*scale[0] + shift[0]);
+  outPoint[1] = inPoint[1] + (displacement[1]*scale[1] + shift[1]);
+  outPoint[2] = inPoint[2] + (displacement[2]*scale[2] + shift[2]);
+}
+
+//----------------------------------------------------------------------------
+template <class T, bool AxisAligned>
+void vtkOrientedGridTransform::SelectKernels()
+{
+  if (this->UseBSplineInterpolation)
+    {
+    this->ForwardPointKernel =
+      &vtkOrientedGridTransform::ForwardTransformPointKernel<T, vtkOrientedGridTransformBSplineInterpolation, AxisAligned>;
+    this->ForwardDerivativeKernel =
+      &vtkOrientedGridTransform::ForwardTransformDerivativeKernel<T, vtkOrientedGridTransformBSplineInterpolation, AxisAligned>;
+    }
+  else if (this->InterpolationMode == VTK_NEAREST_INTERPOLATION)
+    {
+    // The derivative of nearest neighbor interpolation is computed by
+    // the generic interpolation function
+    this->ForwardPointKernel =
+      &vtkOrientedGridTransform::ForwardTransformPointKernel<T, VTK_NEAREST_INTERPOLATION, AxisAligned>;
+    }
+  else if (this->InterpolationMode == VTK_LINEAR_INTERPOLATION)
+    {
+    this->ForwardPointKernel =
+      &vtkOrientedGridTransform::ForwardTransformPointKernel<T, VTK_LINEAR_INTERPOLATION, AxisAligned>;
+    this->ForwardDerivativeKernel =
+      &vtkOrientedGridTransform::ForwardTransformDerivativeKernel<T, VTK_LINEAR_INTERPOLATION, AxisAligned>;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkOrientedGridTransform::SelectKernels(bool axisAligned)
+{
+  if (axisAligned)
+    {
+    this->SelectKernels<T, true>();
+    }
+  else
+    {
+    this->SelectKernels<T, false>();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::UpdateKernels()
+{
+  this->ForwardPointKernel = nullptr;
+  this->ForwardDerivativeKernel = nullptr;
+  this->GridAxisAligned = false;
+  if (this->GridPointer == nullptr)
+    {
+    return;
+    }
+
+  // If the grid axes are aligned with the output axes (identity direction,
+  // possibly flipped) then the output to grid index matrix is diagonal
+  const double (*m)[4] = this->OutputToGridIndexTransformMatrixCached->Element;
+  this->GridAxisAligned = (m[0][1] == 0.0 && m[0][2] == 0.0 &&
+                           m[1][0] == 0.0 && m[1][2] == 0.0 &&
+                           m[2][0] == 0.0 && m[2][1] == 0.0);
+
+  // Other scalar types and cubic interpolation use the generic
+  // interpolation function of vtkGridTransform
+  switch (vtkOrientedGridTransformKernelType(this->GridScalarType, this->HalfFloatGrid))
+    {
+    case VTK_FLOAT:
+      this->SelectKernels<float>(this->GridAxisAligned);
+      break;
+    case VTK_DOUBLE:
+      this->SelectKernels<double>(this->GridAxisAligned);
+      break;
+    case VTK_SHORT:
+      this->SelectKernels<short>(this->GridAxisAligned);
+      break;
+    case vtkOrientedGridTransformHalfFloatType:
+      this->SelectKernels<vtkOrientedGridTransformHalfFloat>(this->GridAxisAligned);
+      break;
+    default:
+      break;
+    }
+}
+
+//------------------------------------------------------------------------
+// Forward transformation of a range of points stored in contiguous
+// float or double arrays, using the inlined interpolation kernels.
+// This is a batched scalar kernel: each point is interpolated separately,
+// batching only removes the per-point dispatch of the generic path.
+template <class TIn, class TOut, class TGrid, int Interpolation, bool AxisAligned>
+class vtkOrientedGridTransformPointsFunctor
+{
+public:
+  const TIn *InPoints;
+  TOut *OutPoints;
+  const double (*OutputToGridIndex)[4];
+  const TGrid *GridPointer;
+  const int *GridExtent;
+  const vtkIdType *GridIncrements;
+  const double *Scale;
+  const double *Shift;
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    const int blockSize = 128;
+    double points[blockSize][3];
+    double pointsIJK[blockSize][3];
+    const double (*m)[4] = this->OutputToGridIndex;
+    for (vtkIdType blockBegin = begin; blockBegin < end; blockBegin += blockSize)
+      {
+      int numberOfPoints = static_cast<int>(std::min<vtkIdType>(blockSize, end - blockBegin));
+      const TIn *in = this->InPoints + 3*blockBegin;
+      TOut *out = this->OutPoints + 3*blockBegin;
+
+      // Convert the block to grid index space first
+      for (int p = 0; p < numberOfPoints; p++)
+        {
+        points[p][0] = in[3*p];
+        points[p][1] = in[3*p+1];
+        points[p][2] = in[3*p+2];
+        vtkOrientedGridTransformOutputToGridIndex<AxisAligned>(m, points[p], pointsIJK[p]);
+        }
+
+      double displacement[3];
+      for (int p = 0; p < numberOfPoints; p++)
+        {
+        vtkOrientedGridTransformInterpolator<TGrid, Interpolation>::Interpolate(pointsIJK[p], displacement,
+          this->GridPointer, this->GridExtent, this->GridIncrements);
+        out[3*p]   = static_cast<TOut>(points[p][0] + (displacement[0]*this->Scale[0] + this->Shift[0]));
+        out[3*p+1] = static_cast<TOut>(points[p][1] + (displacement[1]*this->Scale[1] + this->Shift[1]));
+        out[3*p+2] = static_cast<TOut>(points[p][2] + (displacement[2]*this->Scale[2] + this->Shift[2]));
+        }
+      }
+  }
+};
+
+//------------------------------------------------------------------------
+template <int Interpolation, bool AxisAligned, class TIn, class TOut, class TGrid>
+void vtkOrientedGridTransformPoints(const TIn *inPoints, TOut *outPoints, vtkIdType numberOfPoints,
+  const double outputToGridIndex[4][4], const TGrid *gridPtr, const int gridExt[6], const vtkIdType gridInc[3],
+  const double scale[3], const double shift[3])
+{
+  vtkOrientedGridTransformPointsFunctor<TIn, TOut, TGrid, Interpolation, AxisAligned> functor;
+  functor.InPoints = inPoints;
+  functor.OutPoints = outPoints;
+  functor.OutputToGridIndex = outputToGridIndex;
+  functor.GridPointer = gridPtr;
+  functor.GridExtent = gridExt;
+  functor.GridIncrements = gridInc;
+  functor.Scale = scale;
+  functor.Shift = shift;
+  vtkSMPTools::For(0, numberOfPoints, functor);
+}
+
+//------------------------------------------------------------------------
+template <class TIn, class TOut, class TGrid>
+bool vtkOrientedGridTransformPoints(const TIn *inPoints, TOut *outPoints, vtkIdType numberOfPoints,
+  const double outputToGridIndex[4][4], const TGrid *gridPtr, int interpolationMode, bool axisAligned,
+  const int gridExt[6], const vtkIdType gridInc[3], const double scale[3], const double shift[3])
+{
+  switch (interpolationMode)
+    {
+    case VTK_NEAREST_INTERPOLATION:
+      if (axisAligned)
+        {
+        vtkOrientedGridTransformPoints<VTK_NEAREST_INTERPOLATION, true>(inPoints, outPoints, numberOfPoints,
+          outputToGridIndex, gridPtr, gridExt, gridInc, scale, shift);
+        }
+      else
+        {
+        vtkOrientedGridTransformPoints<VTK_NEAREST_INTERPOLATION, false>(inPoints, outPoints, numberOfPoints,
+          outputToGridIndex, gridPtr, gridExt, gridInc, scale, shift);
+        }
+      return true;
+    case VTK_LINEAR_INTERPOLATION:
+      if (axisAligned)
+        {
+        vtkOrientedGridTransformPoints<VTK_LINEAR_INTERPOLATION, true>(inPoints, outPoints, numberOfPoints,
+          outputToGridIndex, gridPtr, gridExt, gridInc, scale, shift);
+        }
+      else
+        {
+        vtkOrientedGridTransformPoints<VTK_LINEAR_INTERPOLATION, false>(inPoints, outPoints, numberOfPoints,
+          outputToGridIndex, gridPtr, gridExt, gridInc, scale, shift);
+        }
+      return true;
+    case vtkOrientedGridTransformBSplineInterpolation:
+      if (axisAligned)
+        {
+        vtkOrientedGridTransformPoints<vtkOrientedGridTransformBSplineInterpolation, true>(inPoints, outPoints,
+          numberOfPoints, outputToGridIndex, gridPtr, gridExt, gridInc, scale, shift);
+        }
+      else
+        {
+        vtkOrientedGridTransformPoints<vtkOrientedGridTransformBSplineInterpolation, false>(inPoints, outPoints,
+          numberOfPoints, outputToGridIndex, gridPtr, gridExt, gridInc, scale, shift);
+        }
+      return true;
+    default:
+      return false;
+    }
+}
+
+//------------------------------------------------------------------------
+template <class TIn, class TOut>
+bool vtkOrientedGridTransformPoints(const TIn *inPoints, TOut *outPoints, vtkIdType numberOfPoints,
+  const double outputToGridIndex[4][4], void *gridPtr, int gridType, int interpolationMode, bool axisAligned,
+  const int gridExt[6], const vtkIdType gridInc[3], const double scale[3], const double shift[3])
+{
+  switch (gridType)
+    {
+    case VTK_FLOAT:
+      return vtkOrientedGridTransformPoints(inPoints, outPoints, numberOfPoints, outputToGridIndex,
+        static_cast<const float*>(gridPtr), interpolationMode, axisAligned, gridExt, gridInc, scale, shift);
+    case VTK_DOUBLE:
+      return vtkOrientedGridTransformPoints(inPoints, outPoints, numberOfPoints, outputToGridIndex,
+        static_cast<const double*>(gridPtr), interpolationMode, axisAligned, gridExt, gridInc, scale, shift);
+    case VTK_SHORT:
+      return vtkOrientedGridTransformPoints(inPoints, outPoints, numberOfPoints, outputToGridIndex,
+        static_cast<const short*>(gridPtr), interpolationMode, axisAligned, gridExt, gridInc, scale, shift);
+    case vtkOrientedGridTransformHalfFloatType:
+      return vtkOrientedGridTransformPoints(inPoints, outPoints, numberOfPoints, outputToGridIndex,
+        static_cast<const vtkOrientedGridTransformHalfFloat*>(gridPtr), interpolationMode, axisAligned,
+        gridExt, gridInc, scale, shift);
+    default:
+      return false;
+    }
+}
+
+//------------------------------------------------------------------------
+template <class TIn>
+bool vtkOrientedGridTransformPoints(const TIn *inPoints, vtkDataArray *outPoints, vtkIdType outOffset, vtkIdType numberOfPoints,
+  const double outputToGridIndex[4][4], void *gridPtr, int gridType, int interpolationMode, bool axisAligned,
+  const int gridExt[6], const vtkIdType gridInc[3], const double scale[3], const double shift[3])
+{
+  vtkFloatArray *outFloatPoints = vtkFloatArray::SafeDownCast(outPoints);
+  if (outFloatPoints)
+    {
+    return vtkOrientedGridTransformPoints(inPoints, outFloatPoints->GetPointer(0) + 3*outOffset, numberOfPoints,
+      outputToGridIndex, gridPtr, gridType, interpolationMode, axisAligned, gridExt, gridInc, scale, shift);
+    }
+  vtkDoubleArray *outDoublePoints = vtkDoubleArray::SafeDownCast(outPoints);
+  if (outDoublePoints)
+    {
+    return vtkOrientedGridTransformPoints(inPoints, outDoublePoints->GetPointer(0) + 3*outOffset, numberOfPoints,
+      outputToGridIndex, gridPtr, gridType, interpolationMode, axisAligned, gridExt, gridInc, scale, shift);
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::TransformPoints(vtkPoints *inPts, vtkPoints *outPts)
+{
+  this->Update();
+
+  // The inverse is only evaluated in parallel in thread-safe evaluation mode
+  if (this->GridPointer == nullptr
+    || (this->InverseFlag && !this->ThreadSafeEvaluation))
+    {
+    this->Superclass::TransformPoints(inPts, outPts);
+    return;
+    }
+
+  vtkIdType numberOfPoints = inPts->GetNumberOfPoints();
+  if (numberOfPoints == 0)
+    {
+    return;
+    }
+  vtkIdType outOffset = outPts->GetNumberOfPoints();
+  outPts->SetNumberOfPoints(outOffset + numberOfPoints);
+
+  vtkDataArray *inData = inPts->GetData();
+  vtkDataArray *outData = outPts->GetData();
+
+  bool transformed = false;
+  if (!this->InverseFlag && inData != outData)
+    {
+    const double (*outputToGridIndex)[4] = this->OutputToGridIndexTransformMatrixCached->Element;
+    int gridType = vtkOrientedGridTransformKernelType(this->GridScalarType, this->HalfFloatGrid);
+    int interpolation = (this->UseBSplineInterpolation ? vtkOrientedGridTransformBSplineInterpolation
+      : this->InterpolationMode);
+    vtkFloatArray *inFloatPoints = vtkFloatArray::SafeDownCast(inData);
+    vtkDoubleArray *inDoublePoints = vtkDoubleArray::SafeDownCast(inData);
+    if (inFloatPoints)
+      {
+      transformed = vtkOrientedGridTransformPoints(inFloatPoints->GetPointer(0), outData, outOffset, numberOfPoints,
+        outputToGridIndex, this->GridPointer, gridType, interpolation, this->GridAxisAligned,
+        this->GridExtent, this->GridIncrements, this->DisplacementScaleCached, this->DisplacementShiftCached);
+      }
+    else if (inDoublePoints)
+      {
+      transformed = vtkOrientedGridTransformPoints(inDoublePoints->GetPointer(0), outData, outOffset, numberOfPoints,
+        outputToGridIndex, this->GridPointer, gridType, interpolation, this->GridAxisAligned,
+        this->GridExtent, this->GridIncrements, this->DisplacementScaleCached, this->DisplacementShiftCached);
+      }
+    }
+
+  if (!transformed)
+    {
+    // Inverse, other point and grid types, cubic interpolation and mapped
+    // grids: parallel evaluation of the generic transformation
+    vtkSMPTools::For(0, numberOfPoints, vtkOrientedGridTransformPrefetchBlockSize,
+      [&](vtkIdType begin, vtkIdType end)
+      {
+      double point[3];
+      if (this->UseMappedDisplacementGrid)
+        {
+        // Read the bricks of this block of points in advance
+        double bounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+        for (vtkIdType pointId = begin; pointId < end; pointId++)
+          {
+          inData->GetTuple(pointId, point);
+          for (int i = 0; i < 3; i++)
+            {
+            bounds[2*i] = std::min(bounds[2*i], point[i]);
+            bounds[2*i+1] = std::max(bounds[2*i+1], point[i]);
+            }
+          }
+        this->PrefetchMappedDisplacementGrid(bounds);
+        }
+      for (vtkIdType pointId = begin; pointId < end; pointId++)
+        {
+        inData->GetTuple(pointId, point);
+        this->InternalTransformPoint(point, point);
+        outData->SetTuple(outOffset + pointId, point);
+        }
+      });
+    }
+
+  if (this->InverseFlag)
+    {
+    this->InvokePendingEvents();
+    }
+  if (this->UseMappedDisplacementGrid)
+    {
+    this->MappedDisplacementGrid->TrimCache();
+    }
+
+  outPts->Modified();
+}
+
+//------------------------------------------------------------------------
+// Displacement at numberOfPoints positions along a line in grid index
+// space. The position is advanced by adding delta at each step.
+template <class TGrid, int Interpolation>
+struct vtkOrientedGridTransformLineEvaluator
+{
+  static void Evaluate(const double start[3], const double delta[3], int numberOfPoints,
+    const TGrid *gridPtr, const int gridExt[6], const vtkIdType gridInc[3],
+    const double scale[3], const double shift[3], double *displacements)
+  {
+    double point[3] = { start[0], start[1], start[2] };
+    double displacement[3];
+    for (int i = 0; i < numberOfPoints; i++)
+      {
+      vtkOrientedGridTransformInterpolator<TGrid, Interpolation>::Interpolate(point, displacement,
+        gridPtr, gridExt, gridInc);
+      displacements[0] = displacement[0]*scale[0] + shift[0];
+      displacements[1] = displacement[1]*scale[1] + shift[1];
+      displacements[2] = displacement[2]*scale[2] + shift[2];
+      displacements += 3;
+      point[0] += delta[0];
+      point[1] += delta[1];
+      point[2] += delta[2];
+      }
+  }
+};
+
+// Linear interpolation along a line: the displacements at the corners of
+// the current grid cell are reused until the line leaves the cell, only
+// the trilinear weights are computed for each point. The border handling
+// is the same as in vtkOrientedGridTransformInterpolateLinear.
+template <class TGrid>
+struct vtkOrientedGridTransformLineEvaluator<TGrid, VTK_LINEAR_INTERPOLATION>
+{
+  static void Evaluate(const double start[3], const double delta[3], int numberOfPoints,
+    const TGrid *gridPtr, const int gridExt[6], const vtkIdType gridInc[3],
+    const double scale[3], const double shift[3], double *displacements)
+  {
+    double point[3] = { start[0], start[1], start[2] };
+    int ext[3] = { gridExt[1] - gridExt[0], gridExt[3] - gridExt[2], gridExt[5] - gridExt[4] };
+    // Current cell (-1 or ext on the clamped sides of the grid) and the
+    // displacements at its corners, indexed as (x << 2) | (y << 1) | z
+    int cell[3] = { VTK_INT_MIN, VTK_INT_MIN, VTK_INT_MIN };
+    double corners[8][3];
+    for (int n = 0; n < numberOfPoints; n++)
+      {
+      double f[3];
+      int pointCell[3];
+      for (int i = 0; i < 3; i++)
+        {
+        int floorIndex = vtkMath::Floor(point[i]);
+        int gridId0 = floorIndex - gridExt[2*i];
+        if (gridId0 < 0)
+          {
+          pointCell[i] = -1;
+          f[i] = 0;
+          }
+        else if (gridId0 >= ext[i])
+          {
+          pointCell[i] = ext[i];
+          f[i] = 0;
+          }
+        else
+          {
+          pointCell[i] = gridId0;
+          f[i] = point[i] - floorIndex;
+          }
+        }
+
+      if (pointCell[0] != cell[0] || pointCell[1] != cell[1] || pointCell[2] != cell[2])
+        {
+        vtkIdType gridOffset0[3], gridOffset1[3];
+        for (int i = 0; i < 3; i++)
+          {
+          cell[i] = pointCell[i];
+          int gridId0 = std::max(0, std::min(cell[i], ext[i]));
+          int gridId1 = (cell[i] < 0 || cell[i] >= ext[i] ? gridId0 : gridId0 + 1);
+          gridOffset0[i] = gridId0*gridInc[i];
+          gridOffset1[i] = gridId1*gridInc[i];
+          }
+        for (int corner = 0; corner < 8; corner++)
+          {
+          const TGrid *v = gridPtr
+            + ((corner & 4) ? gridOffset1[0] : gridOffset0[0])
+            + ((corner & 2) ? gridOffset1[1] : gridOffset0[1])
+            + ((corner & 1) ? gridOffset1[2] : gridOffset0[2]);
+          corners[corner][0] = v[0];
+          corners[corner][1] = v[1];
+          corners[corner][2] = v[2];
+          }
+        }
+
+      double rx = 1 - f[0];
+      double ry = 1 - f[1];
+      double rz = 1 - f[2];
+
+      double ryrz = ry*rz;
+      double ryfz = ry*f[2];
+      double fyrz = f[1]*rz;
+      double fyfz = f[1]*f[2];
+
+      for (int i = 0; i < 3; i++)
+        {
+        double displacement = (rx*(ryrz*corners[0][i] + ryfz*corners[1][i] + fyrz*corners[2][i] + fyfz*corners[3][i]) +
+                               f[0]*(ryrz*corners[4][i] + ryfz*corners[5][i] + fyrz*corners[6][i] + fyfz*corners[7][i]));
+        displacements[i] = displacement*scale[i] + shift[i];
+        }
+      displacements += 3;
+      point[0] += delta[0];
+      point[1] += delta[1];
+      point[2] += delta[2];
+      }
+  }
+};
+
+//------------------------------------------------------------------------
+template <class TGrid>
+bool vtkOrientedGridTransformEvaluateLine(const double start[3], const double delta[3], int numberOfPoints,
+  const TGrid *gridPtr, int interpolationMode, const int gridExt[6], const vtkIdType gridInc[3],
+  const double scale[3], const double shift[3], double *displacements)
+{
+  switch (interpolationMode)
+    {
+    case VTK_NEAREST_INTERPOLATION:
+      vtkOrientedGridTransformLineEvaluator<TGrid, VTK_NEAREST_INTERPOLATION>::Evaluate(start, delta,
+        numberOfPoints, gridPtr, gridExt, gridInc, scale, shift, displacements);
+      return true;
+    case VTK_LINEAR_INTERPOLATION:
+      vtkOrientedGridTransformLineEvaluator<TGrid, VTK_LINEAR_INTERPOLATION>::Evaluate(start, delta,
+        numberOfPoints, gridPtr, gridExt, gridInc, scale, shift, displacements);
+      return true;
+    case vtkOrientedGridTransformBSplineInterpolation:
+      vtkOrientedGridTransformLineEvaluator<TGrid, vtkOrientedGridTransformBSplineInterpolation>::Evaluate(start,
+        delta, numberOfPoints, gridPtr, gridExt, gridInc, scale, shift, displacements);
+      return true;
+    default:
+      return false;
+    }
+}
+
+//------------------------------------------------------------------------
+bool vtkOrientedGridTransformEvaluateLine(const double start[3], const double delta[3], int numberOfPoints,
+  void *gridPtr, int gridType, int interpolationMode, const int gridExt[6], const vtkIdType gridInc[3],
+  const double scale[3], const double shift[3], double *displacements)
+{
+  switch (gridType)
+    {
+    case VTK_FLOAT:
+      return vtkOrientedGridTransformEvaluateLine(start, delta, numberOfPoints, static_cast<const float*>(gridPtr),
+        interpolationMode, gridExt, gridInc, scale, shift, displacements);
+    case VTK_DOUBLE:
+      return vtkOrientedGridTransformEvaluateLine(start, delta, numberOfPoints, static_cast<const double*>(gridPtr),
+        interpolationMode, gridExt, gridInc, scale, shift, displacements);
+    case VTK_SHORT:
+      return vtkOrientedGridTransformEvaluateLine(start, delta, numberOfPoints, static_cast<const short*>(gridPtr),
+        interpolationMode, gridExt, gridInc, scale, shift, displacements);
+    case vtkOrientedGridTransformHalfFloatType:
+      return vtkOrientedGridTransformEvaluateLine(start, delta, numberOfPoints,
+        static_cast<const vtkOrientedGridTransformHalfFloat*>(gridPtr),
+        interpolationMode, gridExt, gridInc, scale, shift, displacements);
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::SupportsLineEvaluation()
+{
+  return !this->InverseFlag && this->GridPointer != nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::EvaluateDisplacementsAlongLine(const double start[3], const double step[3],
+  int numberOfPoints, double *displacements)
+{
+  if (!this->SupportsLineEvaluation() || numberOfPoints < 0)
+    {
+    return false;
+    }
+
+  // Line start and step in grid index space
+  const double (*m)[4] = this->OutputToGridIndexTransformMatrixCached->Element;
+  double gridStart[3], gridDelta[3];
+  vtkLinearTransformPoint(m, start, gridStart);
+  for (int i = 0; i < 3; i++)
+    {
+    gridDelta[i] = m[i][0]*step[0] + m[i][1]*step[1] + m[i][2]*step[2];
+    }
+
+  const double *scale = this->DisplacementScaleCached;
+  const double *shift = this->DisplacementShiftCached;
+  int gridType = vtkOrientedGridTransformKernelType(this->GridScalarType, this->HalfFloatGrid);
+  int interpolation = (this->UseBSplineInterpolation ? vtkOrientedGridTransformBSplineInterpolation
+    : this->InterpolationMode);
+  if (vtkOrientedGridTransformEvaluateLine(gridStart, gridDelta, numberOfPoints, this->GridPointer, gridType,
+    interpolation, this->GridExtent, this->GridIncrements, scale, shift, displacements))
+    {
+    return true;
+    }
+
+  // Other grid types, cubic interpolation and mapped grids
+  double point[3] = { gridStart[0], gridStart[1], gridStart[2] };
+  double displacement[3];
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    this->InterpolationFunction(point, displacement, nullptr,
+      this->GridPointer, this->GridScalarType, this->GridExtent, this->GridIncrements);
+    displacements[0] = displacement[0]*scale[0] + shift[0];
+    displacements[1] = displacement[1]*scale[1] + shift[1];
+    displacements[2] = displacement[2]*scale[2] + shift[2];
+    displacements += 3;
+    point[0] += gridDelta[0];
+    point[1] += gridDelta[1];
+    point[2] += gridDelta[2];
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::EvaluateOnGrid(const double origin[3], const double spacing[3],
+  vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* displacementField)
+{
+  if (!displacementField)
+    {
+    vtkErrorMacro("EvaluateOnGrid: invalid displacement field");
+    return false;
+    }
+  if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+    {
+    vtkErrorMacro("EvaluateOnGrid: invalid dimensions " << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2]);
+    return false;
+    }
+
+  this->Update();
+
+  displacementField->SetOrigin(origin[0], origin[1], origin[2]);
+  displacementField->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  displacementField->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+  displacementField->AllocateScalars(VTK_DOUBLE, 3);
+  double *field = static_cast<double*>(displacementField->GetScalarPointer());
+
+  // Lattice index to output transform
+  vtkNew<vtkMatrix4x4> latticeToOutput;
+  vtkOrientedTransformLattice::GetLatticeToOutputMatrix(origin, spacing, direction, latticeToOutput);
+  const double (*latticeToOutputMatrix)[4] = latticeToOutput->Element;
+  vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+
+  if (this->InverseFlag || this->GridPointer == nullptr)
+    {
+    auto evaluateSlices = [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+      {
+      double *fieldPtr = field + 3*sliceBegin*sliceSize;
+      for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+        {
+        for (int j = 0; j < dimensions[1]; j++)
+          {
+          for (int i = 0; i < dimensions[0]; i++)
+            {
+            double latticePoint[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+            double point[3], transformedPoint[3];
+            vtkLinearTransformPoint(latticeToOutputMatrix, latticePoint, point);
+            this->InternalTransformPoint(point, transformedPoint);
+            fieldPtr[0] = transformedPoint[0] - point[0];
+            fieldPtr[1] = transformedPoint[1] - point[1];
+            fieldPtr[2] = transformedPoint[2] - point[2];
+            fieldPtr += 3;
+            }
+          }
+        }
+      };
+    vtkOrientedTransformLattice::EvaluateSlices(this, dimensions[2], evaluateSlices);
+    return true;
+    }
+
+  // Each lattice row is evaluated as a line in the grid
+  double rowStep[3] = { latticeToOutputMatrix[0][0], latticeToOutputMatrix[1][0], latticeToOutputMatrix[2][0] };
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    double *fieldPtr = field + 3*sliceBegin*sliceSize;
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      for (int j = 0; j < dimensions[1]; j++)
+        {
+        double latticePoint[3] = { 0.0, static_cast<double>(j), static_cast<double>(k) };
+        double rowStart[3];
+        vtkLinearTransformPoint(latticeToOutputMatrix, latticePoint, rowStart);
+        this->EvaluateDisplacementsAlongLine(rowStart, rowStep, dimensions[0], fieldPtr);
+        fieldPtr += 3*dimensions[0];
+        }
+      }
+    });
+
+  if (this->UseMappedDisplacementGrid)
+    {
+    this->MappedDisplacementGrid->TrimCache();
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::EvaluateJacobianDeterminantOnGrid(const double origin[3], const double spacing[3],
+  vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* jacobianDeterminant)
+{
+  if (!jacobianDeterminant)
+    {
+    vtkErrorMacro("EvaluateJacobianDeterminantOnGrid: invalid output image");
+    return false;
+    }
+  if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+    {
+    vtkErrorMacro("EvaluateJacobianDeterminantOnGrid: invalid dimensions " << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2]);
+    return false;
+    }
+
+  this->Update();
+
+  jacobianDeterminant->SetOrigin(origin[0], origin[1], origin[2]);
+  jacobianDeterminant->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  jacobianDeterminant->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+  jacobianDeterminant->AllocateScalars(VTK_DOUBLE, 1);
+  double *determinant = static_cast<double*>(jacobianDeterminant->GetScalarPointer());
+
+  // Lattice index to output transform
+  vtkNew<vtkMatrix4x4> latticeToOutput;
+  vtkOrientedTransformLattice::GetLatticeToOutputMatrix(origin, spacing, direction, latticeToOutput);
+  const double (*latticeToOutputMatrix)[4] = latticeToOutput->Element;
+  vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+
+  // The forward derivative uses the interpolation kernels and only reads
+  // the grid, therefore it can always be evaluated in parallel.
+  bool inverse = (this->InverseFlag != 0);
+  auto evaluateSlices = [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    double *determinantPtr = determinant + sliceBegin*sliceSize;
+    double point[3], transformedPoint[3], derivative[3][3];
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      for (int j = 0; j < dimensions[1]; j++)
+        {
+        for (int i = 0; i < dimensions[0]; i++)
+          {
+          double latticePoint[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+          vtkLinearTransformPoint(latticeToOutputMatrix, latticePoint, point);
+          if (inverse)
+            {
+            this->InternalTransformDerivative(point, transformedPoint, derivative);
+            }
+          else
+            {
+            this->ForwardTransformDerivative(point, transformedPoint, derivative);
+            }
+          *(determinantPtr++) = vtkMath::Determinant3x3(derivative);
+          }
+        }
+      }
+    };
+
+  vtkOrientedTransformLattice::EvaluateSlices(this, dimensions[2], evaluateSlices);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::ForwardTransformPoint(const double inPoint[3],
+                                             double outPoint[3])
+{
+  if (this->GridPointer == nullptr)
+    {
+    this->Superclass::ForwardTransformPoint(inPoint,outPoint);
+    return;
+    }
+
+  if (this->ForwardPointKernel)
+    {
+    (this->*(this->ForwardPointKernel))(inPoint, outPoint);
+    return;
+    }
+
+  void *gridPtr = this->GridPointer;
+  int gridType = this->GridScalarType;
+
+  int *extent = this->GridExtent;
+  vtkIdType *increments = this->GridIncrements;
+
+  const double *scale = this->DisplacementScaleCached;
+  const double *shift = this->DisplacementShiftCached;
+
+  double point[3];
+  double displacement[3];
+
+  // Convert the inPoint to i,j,k indices into the deformation grid
+  // plus fractions
+  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+
+  this->InterpolationFunction(point,displacement,nullptr,
+                              gridPtr,gridType,extent,increments);
+
+  outPoint[0] = inPoint[0] + (displacement[0]*scale[0] + shift[0]);
+  outPoint[1] = inPoint[1] + (displacement[1]*scale[1] + shift[1]);
+  outPoint[2] = inPoint[2] + (displacement[2]*scale[2] + shift[2]);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::ForwardTransformDerivative(const double inPoint[3],
+                                                  double outPoint[3],
+                                                  double derivative[3][3])
+{
+  if (this->GridPointer == nullptr)
+    {
+    this->Superclass::ForwardTransformDerivative(inPoint,outPoint,derivative);
+    return;
+    }
+
+  if (this->ForwardDerivativeKernel)
+    {
+    (this->*(this->ForwardDerivativeKernel))(inPoint, outPoint, derivative);
+    return;
+    }
+
+  void *gridPtr = this->GridPointer;
+  int gridType = this->GridScalarType;
+
+  int *extent = this->GridExtent;
+  vtkIdType *increments = this->GridIncrements;
+
+  const double *scale = this->DisplacementScaleCached;
+  const double *shift = this->DisplacementShiftCached;
+
+  double point[3];
+  double displacement[3];
+
+  // convert the inPoint to i,j,k indices plus fractions
+  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+
+  this->InterpolationFunction(point,displacement,derivative,
+                              gridPtr,gridType,extent,increments);
+
+  vtkLinearTransformJacobian(derivative, this->OutputToGridIndexTransformMatrixCached->Element, derivative);
+  for (int i = 0; i < 3; i++)
+    {
+    derivative[i][0] = derivative[i][0]*scale[i];
+    derivative[i][1] = derivative[i][1]*scale[i];
+    derivative[i][2] = derivative[i][2]*scale[i];
+    derivative[i][i] += 1.0;
+    }
+
+  outPoint[0] = inPoint[0] + (displacement[0]*scale[0] + shift[0]);
+  outPoint[1] = inPoint[1] + (displacement[1]*scale[1] + shift[1]);
+  outPoint[2] = inPoint[2] + (displacement[2]*scale[2] + shift[2]);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::InverseTransformPointNewton(const double inPoint[3],
+                                                           const double* initialGuess,
+                                                           double outPoint[3],
+                                                           double derivative[3][3],
+                                                           int& numberOfIterations,
+                                                           double& errorSquared)
+{
+  void *gridPtr = this->GridPointer;
+  int gridType = this->GridScalarType;
+
+  int *extent = this->GridExtent;
+  vtkIdType *increments = this->GridIncrements;
+
+  const double *shift = this->DisplacementShiftCached;
+  const double *scale = this->DisplacementScaleCached;
+
+  double point[3], inverse[3], lastInverse[3], inverse_IJK[3];
+  double deltaP[3], deltaI[3];
+
+  double functionValue = 0;
+  double functionDerivative = 0;
+  double lastFunctionValue = VTK_DOUBLE_MAX;
+
+  errorSquared = 0.0;
+  double toleranceSquared = this->InverseTolerance;
+  toleranceSquared *= toleranceSquared;
+
+  double f = 1.0;
+  double a;
+
+  if (initialGuess)
+    {
+    inverse[0] = initialGuess[0];
+    inverse[1] = initialGuess[1];
+    inverse[2] = initialGuess[2];
+    }
+  else
+    {
+    // first guess at inverse point, just subtract displacement
+    if (this->ForwardPointKernel)
+      {
+      (this->*(this->ForwardPointKernel))(inPoint, point);
+      inverse[0] = 2.0*inPoint[0] - point[0];
+      inverse[1] = 2.0*inPoint[1] - point[1];
+      inverse[2] = 2.0*inPoint[2] - point[2];
+      }
+    else
+      {
+      // convert the inPoint to i,j,k indices plus fractions
+      vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+
+      this->InterpolationFunction(point, deltaP, nullptr,
+                                  gridPtr, gridType, extent, increments);
+
+      inverse[0] = inPoint[0] - (deltaP[0]*scale[0] + shift[0]);
+      inverse[1] = inPoint[1] - (deltaP[1]*scale[1] + shift[1]);
+      inverse[2] = inPoint[2] - (deltaP[2]*scale[2] + shift[2]);
+      }
+    }
+  lastInverse[0] = inverse[0];
+  lastInverse[1] = inverse[1];
+  lastInverse[2] = inverse[2];
+
+  // do a maximum 500 iterations, usually less than 10 are required
+  int n = this->InverseIterations;
+  int i, j;
+
+  for (i = 0; i < n; i++)
+    {
+    if (this->ForwardDerivativeKernel)
+      {
+      (this->*(this->ForwardDerivativeKernel))(inverse, deltaP, derivative);
+      deltaP[0] -= inPoint[0];
+      deltaP[1] -= inPoint[1];
+      deltaP[2] -= inPoint[2];
+      }
+    else
+      {
+      vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inverse, inverse_IJK);
+      this->InterpolationFunction(inverse_IJK, deltaP, derivative,
+                                  gridPtr, gridType, extent, increments);
+
+      // convert displacement
+      deltaP[0] = (inverse[0] + deltaP[0]*scale[0] + shift[0]) - inPoint[0];
+      deltaP[1] = (inverse[1] + deltaP[1]*scale[1] + shift[1]) - inPoint[1];
+      deltaP[2] = (inverse[2] + deltaP[2]*scale[2] + shift[2]) - inPoint[2];
+
+      // convert derivative
+      vtkLinearTransformJacobian(derivative, this->OutputToGridIndexTransformMatrixCached->Element, derivative);
+      for (j = 0; j < 3; j++)
+        {
+        derivative[j][0] = derivative[j][0]*scale[j];
+        derivative[j][1] = derivative[j][1]*scale[j];
+        derivative[j][2] = derivative[j][2]*scale[j];
+        derivative[j][j] += 1.0;
+        }
+      }
+
+    // get the current function value
+    functionValue = (deltaP[0]*deltaP[0] +
+                     deltaP[1]*deltaP[1] +
+                     deltaP[2]*deltaP[2]);
+
+    // if the function value is decreasing, do next Newton step
+    // (the f < 1.0 is there because I found that convergence
+    // is more stable if only a single reduction step is done)
+    if (i == 0 || functionValue < lastFunctionValue || f < 1.0)
+      {
       // here is the critical step in Newton's method
       vtkMath::LinearSolve3x3(derivative,deltaP,deltaI);
 
@@ -266,80 +1751,960 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
                       deltaI[1]*deltaI[1] +
                       deltaI[2]*deltaI[2]);
 
-      // break if less than tolerance in both coordinate systems
-      if (errorSquared < toleranceSquared &&
-          functionValue < toleranceSquared)
+      // break if less than tolerance in both coordinate systems
+      if (errorSquared < toleranceSquared &&
+          functionValue < toleranceSquared)
+        {
+        break;
+        }
+
+      // save the last inverse point
+      lastInverse[0] = inverse[0];
+      lastInverse[1] = inverse[1];
+      lastInverse[2] = inverse[2];
+
+      // save error at last inverse point
+      lastFunctionValue = functionValue;
+
+      // derivative of functionValue at last inverse point
+      functionDerivative = (deltaP[0]*derivative[0][0]*deltaI[0] +
+                            deltaP[1]*derivative[1][1]*deltaI[1] +
+                            deltaP[2]*derivative[2][2]*deltaI[2])*2;
+
+      // calculate new inverse point
+      inverse[0] -= deltaI[0];
+      inverse[1] -= deltaI[1];
+      inverse[2] -= deltaI[2];
+
+      // reset f to 1.0
+      f = 1.0;
+
+      continue;
+      }
+
+    // the error is increasing, so take a partial step
+    // (see Numerical Recipes 9.7 for rationale, this code
+    //  is a simplification of the algorithm provided there)
+
+    // quadratic approximation to find best fractional distance
+    a = -functionDerivative/(2*(functionValue -
+                                lastFunctionValue -
+                                functionDerivative));
+
+    // clamp to range [0.1,0.5]
+    f *= (a < 0.1 ? 0.1 : (a > 0.5 ? 0.5 : a));
+
+    // re-calculate inverse using fractional distance
+    inverse[0] = lastInverse[0] - f*deltaI[0];
+    inverse[1] = lastInverse[1] - f*deltaI[1];
+    inverse[2] = lastInverse[2] - f*deltaI[2];
+    }
+
+  numberOfIterations = i;
+  bool converged = (i < n);
+  if (!converged)
+    {
+    // didn't converge: back up to last good result
+    inverse[0] = lastInverse[0];
+    inverse[1] = lastInverse[1];
+    inverse[2] = lastInverse[2];
+    }
+
+  // convert point
+  outPoint[0] = inverse[0];
+  outPoint[1] = inverse[1];
+  outPoint[2] = inverse[2];
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::InverseTransformPoint(const double inPoint[3],
+                                                     double outPoint[3])
+{
+  if (this->InverseGrid && !this->InverseGridNewtonRefinement
+    && this->GridPointer != nullptr)
+    {
+    // The derivative is not needed, lookup is enough
+    double point[3];
+    double inverseDisplacement[3];
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+    vtkOrientedGridTransformInterpolateLinear(point, inverseDisplacement, nullptr,
+      static_cast<const double*>(this->InverseGrid->GetScalarPointer()), this->GridExtent, this->GridIncrements);
+    outPoint[0] = inPoint[0] + inverseDisplacement[0];
+    outPoint[1] = inPoint[1] + inverseDisplacement[1];
+    outPoint[2] = inPoint[2] + inverseDisplacement[2];
+    // The residual is not computed, to keep the lookup fast
+    this->AddInverseStatistics(0, true, 0.0);
+    return;
+    }
+
+  double derivative[3][3];
+  this->InverseTransformDerivative(inPoint, outPoint, derivative);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3],
+                                                  double outPoint[3],
+                                                  double derivative[3][3])
+{
+  if (this->GridPointer == nullptr)
+    {
+    this->Superclass::InverseTransformDerivative(inPoint,outPoint,derivative);
+    return;
+    }
+
+  if (this->InverseGrid)
+    {
+    // Lookup in the precomputed inverse grid
+    double point[3];
+    double inverse[3];
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+    vtkOrientedGridTransformInterpolateLinear(point, inverse, nullptr,
+      static_cast<const double*>(this->InverseGrid->GetScalarPointer()), this->GridExtent, this->GridIncrements);
+    inverse[0] += inPoint[0];
+    inverse[1] += inPoint[1];
+    inverse[2] += inPoint[2];
+
+    double forward[3];
+    this->ForwardTransformDerivative(inverse, forward, derivative);
+    double deltaP[3] = { forward[0] - inPoint[0], forward[1] - inPoint[1], forward[2] - inPoint[2] };
+    int numberOfIterations = 0;
+    if (this->InverseGridNewtonRefinement)
+      {
+      // One Newton step
+      numberOfIterations = 1;
+      double deltaI[3];
+      vtkMath::LinearSolve3x3(derivative, deltaP, deltaI);
+      inverse[0] -= deltaI[0];
+      inverse[1] -= deltaI[1];
+      inverse[2] -= deltaI[2];
+      }
+
+    outPoint[0] = inverse[0];
+    outPoint[1] = inverse[1];
+    outPoint[2] = inverse[2];
+    // The residual of the lookup is recorded (before refinement)
+    this->AddInverseStatistics(numberOfIterations, true, vtkMath::Norm(deltaP));
+    return;
+    }
+
+  int numberOfIterations = 0;
+  double errorSquared = 0.0;
+  bool converged = this->InverseTransformPointHierarchical(inPoint, outPoint, derivative,
+    numberOfIterations, errorSquared);
+
+  vtkDebugMacro("Inverse Iterations: " << (numberOfIterations+1));
+
+  this->AddInverseStatistics(numberOfIterations + 1, converged, sqrt(errorSquared));
+
+  if (!converged && this->ThreadSafeEvaluation)
+    {
+    // Reported later, from the calling thread (see InvokePendingEvents)
+    this->PendingConvergenceFailures++;
+    }
+  else if (!converged)
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                      ") error = " << sqrt(errorSquared) << " after " <<
+                      numberOfIterations << " iterations."
+                      "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkOrientedGridTransform::InverseTransformPoints(const double* inPoints,
+                                                       double* outPoints,
+                                                       vtkIdType numberOfPoints)
+{
+  this->Update();
+  if (numberOfPoints <= 0)
+    {
+    return 0.0;
+    }
+
+  if (this->InverseFlag || this->GridPointer == nullptr)
+    {
+    // The inverse of an inverted transform is the forward transform
+    // and without a grid the transform is identity
+    vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end)
+      {
+      for (vtkIdType pointId = begin; pointId < end; pointId++)
+        {
+        this->ForwardTransformPoint(inPoints + 3*pointId, outPoints + 3*pointId);
+        }
+      });
+    return 0.0;
+    }
+
+  vtkSMPThreadLocal<vtkOrientedTransformInverseStatistics::Accumulator> statisticsLocal;
+  // Each block of points is solved in sequence, so that the solution of the
+  // previous point can be used as first guess
+  vtkSMPTools::For(0, numberOfPoints, vtkOrientedGridTransformInverseBlockSize,
+    [&](vtkIdType begin, vtkIdType end)
+    {
+    vtkOrientedTransformInverseStatistics::Accumulator& statistics = statisticsLocal.Local();
+    if (this->UseMappedDisplacementGrid)
+      {
+      // Read the bricks of this block of points in advance. The inverse of
+      // a point is near the point if the displacements are small.
+      double bounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+      for (vtkIdType pointId = begin; pointId < end; pointId++)
+        {
+        for (int i = 0; i < 3; i++)
+          {
+          bounds[2*i] = std::min(bounds[2*i], inPoints[3*pointId+i]);
+          bounds[2*i+1] = std::max(bounds[2*i+1], inPoints[3*pointId+i]);
+          }
+        }
+      this->PrefetchMappedDisplacementGrid(bounds);
+      }
+    double derivative[3][3];
+    double previousInPoint[3] = { 0.0, 0.0, 0.0 };
+    double previousOutPoint[3] = { 0.0, 0.0, 0.0 };
+    bool previousConverged = false;
+    for (vtkIdType pointId = begin; pointId < end; pointId++)
+      {
+      double inPoint[3] = { inPoints[3*pointId], inPoints[3*pointId+1], inPoints[3*pointId+2] };
+      double* outPoint = outPoints + 3*pointId;
+      int numberOfIterations = 0;
+      int pointIterations = 0;
+      double errorSquared = 0.0;
+      bool converged = false;
+      if (previousConverged)
+        {
+        // shift the previous solution by the distance between the input points
+        double initialGuess[3] = { previousOutPoint[0] + inPoint[0] - previousInPoint[0],
+                                   previousOutPoint[1] + inPoint[1] - previousInPoint[1],
+                                   previousOutPoint[2] + inPoint[2] - previousInPoint[2] };
+        converged = this->InverseTransformPointNewton(inPoint, initialGuess, outPoint, derivative,
+          numberOfIterations, errorSquared);
+        pointIterations += numberOfIterations + 1;
+        }
+      if (!converged)
+        {
+        converged = this->InverseTransformPointHierarchical(inPoint, outPoint, derivative,
+          numberOfIterations, errorSquared);
+        pointIterations += numberOfIterations + 1;
+        }
+      statistics.AddCall(pointIterations, converged, sqrt(errorSquared));
+      previousConverged = converged;
+      previousInPoint[0] = inPoint[0];
+      previousInPoint[1] = inPoint[1];
+      previousInPoint[2] = inPoint[2];
+      previousOutPoint[0] = outPoint[0];
+      previousOutPoint[1] = outPoint[1];
+      previousOutPoint[2] = outPoint[2];
+      }
+    });
+
+  // Merge the statistics of all threads
+  vtkOrientedTransformInverseStatistics::Accumulator total;
+  bool invokeStatisticsEvent = false;
+  for (const vtkOrientedTransformInverseStatistics::Accumulator& statistics : statisticsLocal)
+    {
+    total.NumberOfIterations += statistics.NumberOfIterations;
+    total.NumberOfFailures += statistics.NumberOfFailures;
+    total.MaximumResidual = std::max(total.MaximumResidual, statistics.MaximumResidual);
+    if (this->InverseStatistics->AddCalls(statistics, this->InverseStatisticsEventInterval))
+      {
+      invokeStatisticsEvent = true;
+      }
+    }
+  if (invokeStatisticsEvent)
+    {
+    this->InvokeEvent(vtkOrientedGridTransform::InverseStatisticsEvent);
+    }
+
+  if (total.NumberOfFailures > 0)
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoints: no convergence for " << total.NumberOfFailures << " of "
+        << numberOfPoints << " points, max error = " << total.MaximumResidual << "."
+        "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
+    }
+
+  if (this->UseMappedDisplacementGrid)
+    {
+    this->MappedDisplacementGrid->TrimCache();
+    }
+  return static_cast<double>(total.NumberOfIterations) / numberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::InverseTransformPointHierarchical(const double inPoint[3],
+                                                                 double outPoint[3],
+                                                                 double derivative[3][3],
+                                                                 int& numberOfIterations,
+                                                                 double& errorSquared)
+{
+  if (!this->CoarseInverseTransform)
+    {
+    return this->InverseTransformPointNewton(inPoint, nullptr, outPoint, derivative,
+      numberOfIterations, errorSquared);
+    }
+
+  // Solve on the coarse transform. If it does not converge then the last
+  // good result is still a better first guess than the default one.
+  double coarseInverse[3];
+  int coarseIterations = 0;
+  this->CoarseInverseTransform->InverseTransformPointNewton(inPoint, nullptr, coarseInverse, derivative,
+    coarseIterations, errorSquared);
+
+  // Refine on the full resolution grid
+  bool converged = this->InverseTransformPointNewton(inPoint, coarseInverse, outPoint, derivative,
+    numberOfIterations, errorSquared);
+  numberOfIterations += coarseIterations + 1;
+  if (!converged)
+    {
+    int fallbackIterations = 0;
+    converged = this->InverseTransformPointNewton(inPoint, nullptr, outPoint, derivative,
+      fallbackIterations, errorSquared);
+    numberOfIterations += fallbackIterations + 1;
+    }
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::SetDownsampledDisplacementGrid(
+  const std::function<void(const double*, double*)>& forwardTransform,
+  vtkMatrix4x4* latticeToOutput, const int latticeExtent[6], int downsamplingFactor)
+{
+  if (!forwardTransform || !latticeToOutput || downsamplingFactor < 1
+    || latticeExtent[1] < latticeExtent[0] || latticeExtent[3] < latticeExtent[2] || latticeExtent[5] < latticeExtent[4])
+    {
+    vtkErrorMacro("SetDownsampledDisplacementGrid: invalid input");
+    return false;
+    }
+
+  // Coarse grid geometry. The last coarse sample may be beyond the lattice
+  // so that the whole lattice is covered.
+  int coarseDimensions[3];
+  double coarseSpacing[3];
+  vtkNew<vtkMatrix4x4> direction;
+  for (int axis = 0; axis < 3; axis++)
+    {
+    int size = latticeExtent[2*axis+1] - latticeExtent[2*axis];
+    coarseDimensions[axis] = (size + downsamplingFactor - 1) / downsamplingFactor + 1;
+    double column[3] = { latticeToOutput->GetElement(0, axis), latticeToOutput->GetElement(1, axis),
+      latticeToOutput->GetElement(2, axis) };
+    double spacing = vtkMath::Norm(column);
+    if (spacing == 0.0)
+      {
+      vtkErrorMacro("SetDownsampledDisplacementGrid: singular lattice to output matrix");
+      return false;
+      }
+    coarseSpacing[axis] = spacing * downsamplingFactor;
+    for (int row = 0; row < 3; row++)
+      {
+      direction->SetElement(row, axis, column[row] / spacing);
+      }
+    }
+  double latticeStart[3] = { static_cast<double>(latticeExtent[0]), static_cast<double>(latticeExtent[2]),
+    static_cast<double>(latticeExtent[4]) };
+  double coarseOrigin[3];
+  vtkLinearTransformPoint(latticeToOutput->Element, latticeStart, coarseOrigin);
+
+  vtkNew<vtkImageData> coarseGrid;
+  coarseGrid->SetExtent(0, coarseDimensions[0] - 1, 0, coarseDimensions[1] - 1, 0, coarseDimensions[2] - 1);
+  coarseGrid->SetOrigin(coarseOrigin);
+  coarseGrid->SetSpacing(coarseSpacing);
+  coarseGrid->AllocateScalars(VTK_DOUBLE, 3);
+  double* coarseGridPtr = static_cast<double*>(coarseGrid->GetScalarPointer());
+
+  const double (*latticeToOutputElements)[4] = latticeToOutput->Element;
+  int halfWidth = downsamplingFactor / 2;
+  vtkSMPTools::For(0, coarseDimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      double* coarsePoint = coarseGridPtr + 3*k*coarseDimensions[0]*coarseDimensions[1];
+      for (int j = 0; j < coarseDimensions[1]; j++)
+        {
+        for (int i = 0; i < coarseDimensions[0]; i++)
+          {
+          // Box of lattice samples around the coarse sample, clipped to the lattice
+          int coarseIndex[3] = { i, j, static_cast<int>(k) };
+          int boxBegin[3], boxEnd[3];
+          for (int axis = 0; axis < 3; axis++)
+            {
+            int center = latticeExtent[2*axis] + coarseIndex[axis] * downsamplingFactor;
+            boxBegin[axis] = std::min(std::max(center - halfWidth, latticeExtent[2*axis]), latticeExtent[2*axis+1]);
+            boxEnd[axis] = std::max(std::min(center + halfWidth, latticeExtent[2*axis+1]), boxBegin[axis]);
+            }
+          double sum[3] = { 0.0, 0.0, 0.0 };
+          int count = 0;
+          for (int kk = boxBegin[2]; kk <= boxEnd[2]; kk++)
+            {
+            for (int jj = boxBegin[1]; jj <= boxEnd[1]; jj++)
+              {
+              for (int ii = boxBegin[0]; ii <= boxEnd[0]; ii++)
+                {
+                double latticeIndex[3] = { static_cast<double>(ii), static_cast<double>(jj), static_cast<double>(kk) };
+                double point[3], transformedPoint[3];
+                vtkLinearTransformPoint(latticeToOutputElements, latticeIndex, point);
+                forwardTransform(point, transformedPoint);
+                sum[0] += transformedPoint[0] - point[0];
+                sum[1] += transformedPoint[1] - point[1];
+                sum[2] += transformedPoint[2] - point[2];
+                count++;
+                }
+              }
+            }
+          coarsePoint[0] = sum[0] / count;
+          coarsePoint[1] = sum[1] / count;
+          coarsePoint[2] = sum[2] / count;
+          coarsePoint += 3;
+          }
+        }
+      }
+    });
+
+  this->SetInterpolationModeToLinear();
+  this->SetBSplineInterpolation(false);
+  this->SetDisplacementScale(1.0);
+  this->SetDisplacementShift(0.0);
+  this->SetDisplacementComponentScale(1.0, 1.0, 1.0);
+  this->SetDisplacementComponentShift(0.0, 0.0, 0.0);
+  this->SetHalfFloatGrid(false);
+  this->SetMappedDisplacementGrid(nullptr);
+  this->SetGridDirectionMatrix(direction);
+  this->SetDisplacementGridData(coarseGrid);
+  if (this->InverseFlag)
+    {
+    this->Inverse();
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::UpdateCoarseInverseTransform()
+{
+  if (!this->HierarchicalInverse || this->GridPointer == nullptr)
+    {
+    if (this->CoarseInverseTransform)
+      {
+      this->CoarseInverseTransform->Delete();
+      this->CoarseInverseTransform = nullptr;
+      }
+    return;
+    }
+
+  if (!this->CoarseInverseTransform)
+    {
+    this->CoarseInverseTransform = vtkOrientedGridTransform::New();
+    }
+  // The forward transform is sampled, even if this transform is inverted
+  if (!this->CoarseInverseTransform->SetDownsampledDisplacementGrid(
+    [this](const double* point, double* transformedPoint) { this->ForwardTransformPoint(point, transformedPoint); },
+    this->GridIndexToOutputTransformMatrixCached, this->GridExtent, this->HierarchicalInverseDownsamplingFactor))
+    {
+    this->CoarseInverseTransform->Delete();
+    this->CoarseInverseTransform = nullptr;
+    return;
+    }
+  if (this->UseMappedDisplacementGrid)
+    {
+    this->MappedDisplacementGrid->TrimCache();
+    }
+
+  // The coarse solution is only a first guess, a tenth of a grid cell is accurate enough
+  double minimumSpacing = std::min(std::min(fabs(this->GridSpacing[0]), fabs(this->GridSpacing[1])), fabs(this->GridSpacing[2]));
+  this->CoarseInverseTransform->SetInverseTolerance(std::max(this->InverseTolerance, 0.1 * minimumSpacing));
+  this->CoarseInverseTransform->SetInverseIterations(this->InverseIterations);
+  this->CoarseInverseTransform->Update();
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::UpdateInverseGrid()
+{
+  vtkImageData* displacementGrid = this->GetDisplacementGrid();
+  if (!this->UseInverseGrid || !this->InverseFlag || this->UseMappedDisplacementGrid
+    || this->GridPointer == nullptr || !displacementGrid)
+    {
+    if (this->InverseGrid)
+      {
+      this->InverseGrid->Delete();
+      this->InverseGrid = nullptr;
+      }
+    return;
+    }
+
+  if (!this->InverseGrid)
+    {
+    this->InverseGrid = vtkImageData::New();
+    }
+  this->InverseGrid->SetExtent(this->GridExtent);
+  this->InverseGrid->SetOrigin(this->GridOrigin);
+  this->InverseGrid->SetSpacing(this->GridSpacing);
+  this->InverseGrid->AllocateScalars(VTK_DOUBLE, 3);
+  double* inverseGridPtr = static_cast<double*>(this->InverseGrid->GetScalarPointer());
+
+  const int* extent = this->GridExtent;
+  int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+  vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  const double (*gridIndexToOutput)[4] = this->GridIndexToOutputTransformMatrixCached->Element;
+
+  // Solve the inverse at each grid point. Neighboring points are solved in
+  // sequence, so the previous solution is a good first guess.
+  vtkSMPThreadLocal<vtkIdType> numberOfFailures(0);
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    vtkIdType& failures = numberOfFailures.Local();
+    double derivative[3][3];
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      double* inverseGridPoint = inverseGridPtr + 3*k*sliceSize;
+      for (int j = 0; j < dimensions[1]; j++)
         {
-        break;
+        bool previousConverged = false;
+        double previousInverse[3] = { 0.0, 0.0, 0.0 };
+        for (int i = 0; i < dimensions[0]; i++)
+          {
+          double gridIndex[3] = { static_cast<double>(extent[0] + i),
+                                  static_cast<double>(extent[2] + j),
+                                  static_cast<double>(extent[4] + k) };
+          double point[3];
+          vtkLinearTransformPoint(gridIndexToOutput, gridIndex, point);
+          double initialGuess[3];
+          if (previousConverged)
+            {
+            // shift the previous solution by the grid step
+            initialGuess[0] = previousInverse[0] + gridIndexToOutput[0][0];
+            initialGuess[1] = previousInverse[1] + gridIndexToOutput[1][0];
+            initialGuess[2] = previousInverse[2] + gridIndexToOutput[2][0];
+            }
+          double inverse[3];
+          int numberOfIterations = 0;
+          double errorSquared = 0.0;
+          if (previousConverged)
+            {
+            previousConverged = this->InverseTransformPointNewton(point, initialGuess,
+              inverse, derivative, numberOfIterations, errorSquared);
+            }
+          else
+            {
+            previousConverged = this->InverseTransformPointHierarchical(point,
+              inverse, derivative, numberOfIterations, errorSquared);
+            }
+          if (!previousConverged)
+            {
+            failures++;
+            }
+          previousInverse[0] = inverse[0];
+          previousInverse[1] = inverse[1];
+          previousInverse[2] = inverse[2];
+          inverseGridPoint[0] = inverse[0] - point[0];
+          inverseGridPoint[1] = inverse[1] - point[1];
+          inverseGridPoint[2] = inverse[2] - point[2];
+          inverseGridPoint += 3;
+          }
         }
+      }
+    });
 
-      // save the last inverse point
-      lastInverse[0] = inverse[0];
-      lastInverse[1] = inverse[1];
-      lastInverse[2] = inverse[2];
-
-      // save error at last inverse point
-      lastFunctionValue = functionValue;
+  vtkIdType totalNumberOfFailures = 0;
+  for (vtkIdType failures : numberOfFailures)
+    {
+    totalNumberOfFailures += failures;
+    }
+  if (totalNumberOfFailures > 0)
+    {
+    vtkWarningMacro("UpdateInverseGrid: no convergence at " << totalNumberOfFailures << " of "
+      << sliceSize * dimensions[2] << " grid points.");
+    }
+}
 
-      // derivative of functionValue at last inverse point
-      functionDerivative = (deltaP[0]*derivative[0][0]*deltaI[0] +
-                            deltaP[1]*derivative[1][1]*deltaI[1] +
-                            deltaP[2]*derivative[2][2]*deltaI[2])*2;
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::CollapseTransforms(vtkMatrix4x4* preMatrix,
+  vtkOrientedGridTransform* gridTransform, vtkMatrix4x4* postMatrix)
+{
+  if (!gridTransform)
+    {
+    vtkErrorMacro("CollapseTransforms: invalid grid transform");
+    return false;
+    }
+  gridTransform->Update();
+  if (gridTransform->InverseFlag)
+    {
+    vtkErrorMacro("CollapseTransforms: inverse grid transforms cannot be collapsed");
+    return false;
+    }
+  vtkImageData* displacementGrid = gridTransform->GetDisplacementGrid();
+  if (!displacementGrid || !gridTransform->GridPointer)
+    {
+    vtkErrorMacro("CollapseTransforms: grid transform has no displacement grid");
+    return false;
+    }
 
-      // calculate new inverse point
-      inverse[0] -= deltaI[0];
-      inverse[1] -= deltaI[1];
-      inverse[2] -= deltaI[2];
+  vtkNew<vtkMatrix4x4> pre;
+  if (preMatrix)
+    {
+    pre->DeepCopy(preMatrix);
+    }
+  vtkNew<vtkMatrix4x4> post;
+  if (postMatrix)
+    {
+    post->DeepCopy(postMatrix);
+    }
+  for (int col = 0; col < 4; col++)
+    {
+    if (pre->GetElement(3, col) != (col == 3 ? 1.0 : 0.0) || post->GetElement(3, col) != (col == 3 ? 1.0 : 0.0))
+      {
+      vtkErrorMacro("CollapseTransforms: only affine transforms can be collapsed");
+      return false;
+      }
+    }
+  if (pre->Determinant() == 0.0)
+    {
+    vtkErrorMacro("CollapseTransforms: pre-transform is not invertible");
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> preInverse;
+  vtkMatrix4x4::Invert(pre, preInverse);
+
+  // The collapsed grid is mapped by the pre-transform to the original grid:
+  // collapsed grid index to output = preInverse * grid index to output.
+  vtkNew<vtkMatrix4x4> gridIndexToOutput;
+  vtkMatrix4x4::Multiply4x4(preInverse, gridTransform->GridIndexToOutputTransformMatrixCached, gridIndexToOutput);
+
+  // Spacing is the length of the grid axes. If the pre-transform is not a
+  // similarity transform then the axes are not orthogonal anymore and the
+  // directions are orthogonalized, which requires resampling.
+  double axes[3][3];
+  double spacing[3];
+  for (int col = 0; col < 3; col++)
+    {
+    for (int row = 0; row < 3; row++)
+      {
+      axes[col][row] = gridIndexToOutput->GetElement(row, col);
+      }
+    spacing[col] = vtkMath::Normalize(axes[col]);
+    }
+  for (int col = 1; col < 3; col++)
+    {
+    for (int previousCol = 0; previousCol < col; previousCol++)
+      {
+      double projection = vtkMath::Dot(axes[col], axes[previousCol]);
+      for (int row = 0; row < 3; row++)
+        {
+        axes[col][row] -= projection * axes[previousCol][row];
+        }
+      }
+    vtkMath::Normalize(axes[col]);
+    }
+  vtkNew<vtkMatrix4x4> direction;
+  double origin[3];
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      direction->SetElement(row, col, axes[col][row]);
+      gridIndexToOutput->SetElement(row, col, axes[col][row] * spacing[col]);
+      }
+    origin[row] = gridIndexToOutput->GetElement(row, 3);
+    }
 
-      // reset f to 1.0
-      f = 1.0;
+  // Displacement of the collapsed transform at each grid point:
+  // post(grid(pre(point))) - point. The displacement grid geometry is
+  // preserved if the pre-transform is a similarity transform, therefore
+  // the grid points are mapped to the original grid points and the
+  // collapsed transform equals the chain within the grid.
+  int* extent = gridTransform->GridExtent;
+  int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+  int scalarType = (gridTransform->GridScalarType == VTK_FLOAT ? VTK_FLOAT : VTK_DOUBLE);
+  vtkNew<vtkImageData> collapsedGrid;
+  collapsedGrid->SetExtent(extent);
+  collapsedGrid->SetOrigin(origin);
+  collapsedGrid->SetSpacing(spacing);
+  collapsedGrid->AllocateScalars(scalarType, 3);
+  void* collapsedGridPtr = collapsedGrid->GetScalarPointer();
+  vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+
+  const double (*m)[4] = gridIndexToOutput->Element;
+  const double (*preElements)[4] = pre->Element;
+  const double (*postElements)[4] = post->Element;
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    double point[3], transformedPoint[3];
+    vtkIdType pointIndex = sliceBegin * sliceSize;
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      for (int j = 0; j < dimensions[1]; j++)
+        {
+        for (int i = 0; i < dimensions[0]; i++, pointIndex++)
+          {
+          double index[3] = { static_cast<double>(extent[0] + i), static_cast<double>(extent[2] + j),
+            static_cast<double>(extent[4] + k) };
+          vtkLinearTransformPoint(m, index, point);
+          vtkLinearTransformPoint(preElements, point, transformedPoint);
+          gridTransform->InternalTransformPoint(transformedPoint, transformedPoint);
+          vtkLinearTransformPoint(postElements, transformedPoint, transformedPoint);
+          for (int c = 0; c < 3; c++)
+            {
+            if (scalarType == VTK_FLOAT)
+              {
+              static_cast<float*>(collapsedGridPtr)[3 * pointIndex + c] = static_cast<float>(transformedPoint[c] - point[c]);
+              }
+            else
+              {
+              static_cast<double*>(collapsedGridPtr)[3 * pointIndex + c] = transformedPoint[c] - point[c];
+              }
+            }
+          }
+        }
+      }
+    });
+
+  // gridTransform may be this transform, therefore its properties are
+  // only modified after the displacements are computed.
+  this->SetInterpolationMode(gridTransform->GetInterpolationMode());
+  this->SetBSplineInterpolation(gridTransform->GetBSplineInterpolation());
+  this->SetDisplacementScale(1.0);
+  this->SetDisplacementShift(0.0);
+  this->SetDisplacementComponentScale(1.0, 1.0, 1.0);
+  this->SetDisplacementComponentShift(0.0, 0.0, 0.0);
+  this->SetHalfFloatGrid(false);
+  this->SetGridDirectionMatrix(direction);
+  this->SetDisplacementGridData(collapsedGrid);
+  if (this->InverseFlag)
+    {
+    this->Inverse();
+    }
+  return true;
+}
 
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::CollapseTransforms(vtkGeneralTransform* transform)
+{
+  if (!transform)
+    {
+    vtkErrorMacro("CollapseTransforms: invalid transform");
+    return false;
+    }
+  transform->Update();
+
+  // Accumulate the linear transforms before (pre) and after (post)
+  // the grid transform. Concatenated transforms are in the order
+  // they are applied to the points.
+  vtkNew<vtkMatrix4x4> preMatrix;
+  vtkNew<vtkMatrix4x4> postMatrix;
+  vtkOrientedGridTransform* gridTransform = nullptr;
+  for (int i = 0; i < transform->GetNumberOfConcatenatedTransforms(); i++)
+    {
+    vtkAbstractTransform* concatenatedTransform = transform->GetConcatenatedTransform(i);
+    vtkLinearTransform* linearTransform = vtkLinearTransform::SafeDownCast(concatenatedTransform);
+    if (linearTransform)
+      {
+      linearTransform->Update();
+      vtkMatrix4x4* matrix = (gridTransform ? postMatrix.GetPointer() : preMatrix.GetPointer());
+      vtkMatrix4x4::Multiply4x4(linearTransform->GetMatrix(), matrix, matrix);
       continue;
       }
+    vtkOrientedGridTransform* concatenatedGridTransform = vtkOrientedGridTransform::SafeDownCast(concatenatedTransform);
+    if (!concatenatedGridTransform || gridTransform)
+      {
+      vtkErrorMacro("CollapseTransforms: the transform must contain one vtkOrientedGridTransform and linear transforms only");
+      return false;
+      }
+    gridTransform = concatenatedGridTransform;
+    }
+  if (!gridTransform)
+    {
+    vtkErrorMacro("CollapseTransforms: the transform does not contain a vtkOrientedGridTransform");
+    return false;
+    }
+  return this->CollapseTransforms(preMatrix, gridTransform, postMatrix);
+}
 
-    // the error is increasing, so take a partial step
-    // (see Numerical Recipes 9.7 for rationale, this code
-    //  is a simplification of the algorithm provided there)
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::SetCompactDisplacementGrid(vtkImageData* grid, int storageType, double* maximumError)
+{
+  vtkDataArray* values = (grid ? grid->GetPointData()->GetScalars() : nullptr);
+  if (!values || values->GetNumberOfComponents() != 3)
+    {
+    vtkErrorMacro("SetCompactDisplacementGrid: invalid displacement grid, a 3-component image is required");
+    return false;
+    }
+  int scalarType = VTK_FLOAT;
+  switch (storageType)
+    {
+    case FloatStorage:
+      scalarType = VTK_FLOAT;
+      break;
+    case HalfFloatStorage:
+      scalarType = VTK_UNSIGNED_SHORT;
+      break;
+    case ShortStorage:
+      scalarType = VTK_SHORT;
+      break;
+    default:
+      vtkErrorMacro("SetCompactDisplacementGrid: invalid storage type " << storageType);
+      return false;
+    }
 
-    // quadratic approximation to find best fractional distance
-    a = -functionDerivative/(2*(functionValue -
-                                lastFunctionValue -
-                                functionDerivative));
+  // Quantized grids map the range of each component to [-VTK_SHORT_MAX, VTK_SHORT_MAX]
+  double componentScale[3] = { 1.0, 1.0, 1.0 };
+  double componentShift[3] = { 0.0, 0.0, 0.0 };
+  if (storageType == ShortStorage)
+    {
+    for (int c = 0; c < 3; c++)
+      {
+      double range[2] = { 0.0, 0.0 };
+      values->GetRange(range, c);
+      componentShift[c] = 0.5 * (range[0] + range[1]);
+      if (range[1] > range[0])
+        {
+        componentScale[c] = 0.5 * (range[1] - range[0]) / VTK_SHORT_MAX;
+        }
+      }
+    }
 
-    // clamp to range [0.1,0.5]
-    f *= (a < 0.1 ? 0.1 : (a > 0.5 ? 0.5 : a));
+  vtkNew<vtkImageData> compactGrid;
+  compactGrid->SetExtent(grid->GetExtent());
+  compactGrid->SetOrigin(grid->GetOrigin());
+  compactGrid->SetSpacing(grid->GetSpacing());
+  compactGrid->AllocateScalars(scalarType, 3);
+  void* compactGridPtr = compactGrid->GetScalarPointer();
 
-    // re-calculate inverse using fractional distance
-    inverse[0] = lastInverse[0] - f*deltaI[0];
-    inverse[1] = lastInverse[1] - f*deltaI[1];
-    inverse[2] = lastInverse[2] - f*deltaI[2];
+  vtkSMPThreadLocal<double> maximumErrorSquaredLocal(0.0);
+  vtkSMPTools::For(0, values->GetNumberOfTuples(), [&](vtkIdType begin, vtkIdType end)
+    {
+    double& maximumErrorSquared = maximumErrorSquaredLocal.Local();
+    double displacement[3];
+    for (vtkIdType pointId = begin; pointId < end; pointId++)
+      {
+      values->GetTuple(pointId, displacement);
+      double errorSquared = 0.0;
+      for (int c = 0; c < 3; c++)
+        {
+        vtkIdType valueId = 3*pointId + c;
+        double storedValue = 0.0;
+        if (storageType == FloatStorage)
+          {
+          float value = static_cast<float>(displacement[c]);
+          static_cast<float*>(compactGridPtr)[valueId] = value;
+          storedValue = value;
+          }
+        else if (storageType == HalfFloatStorage)
+          {
+          vtkTypeUInt16 value = vtkOrientedGridTransformFloatToHalf(static_cast<float>(displacement[c]));
+          static_cast<vtkTypeUInt16*>(compactGridPtr)[valueId] = value;
+          storedValue = vtkOrientedGridTransformHalfToFloat(value);
+          }
+        else
+          {
+          double value = floor((displacement[c] - componentShift[c]) / componentScale[c] + 0.5);
+          value = std::min(std::max(value, static_cast<double>(-VTK_SHORT_MAX)), static_cast<double>(VTK_SHORT_MAX));
+          static_cast<short*>(compactGridPtr)[valueId] = static_cast<short>(value);
+          storedValue = value * componentScale[c] + componentShift[c];
+          }
+        errorSquared += (storedValue - displacement[c]) * (storedValue - displacement[c]);
+        }
+      maximumErrorSquared = std::max(maximumErrorSquared, errorSquared);
+      }
+    });
+
+  if (maximumError)
+    {
+    double maximumErrorSquared = 0.0;
+    for (double errorSquared : maximumErrorSquaredLocal)
+      {
+      maximumErrorSquared = std::max(maximumErrorSquared, errorSquared);
+      }
+    *maximumError = sqrt(maximumErrorSquared);
+    }
+
+  // Compact storage is only used with a grid direction matrix
+  if (!this->GridDirectionMatrix)
+    {
+    vtkNew<vtkMatrix4x4> direction;
+    this->SetGridDirectionMatrix(direction);
     }
+  this->SetHalfFloatGrid(storageType == HalfFloatStorage);
+  this->SetDisplacementComponentScale(componentScale);
+  this->SetDisplacementComponentShift(componentShift);
+  this->SetDisplacementGridData(compactGrid);
+  return true;
+}
 
-  vtkDebugMacro("Inverse Iterations: " << (i+1));
+//----------------------------------------------------------------------------
+double vtkOrientedGridTransform::ComputeMaximumDisplacementError(vtkAbstractTransform* reference)
+{
+  if (!reference)
+    {
+    vtkErrorMacro("ComputeMaximumDisplacementError: invalid reference transform");
+    return -1.0;
+    }
+  this->Update();
+  if (this->GridPointer == nullptr)
+    {
+    vtkErrorMacro("ComputeMaximumDisplacementError: no displacement grid");
+    return -1.0;
+    }
 
-  if (i >= n)
+  // Sample at the grid points and at the cell centers
+  const int* extent = this->GridExtent;
+  double maximumErrorSquared = 0.0;
+  for (int sampling = 0; sampling < 2; sampling++)
     {
-    // didn't converge: back up to last good result
-    inverse[0] = lastInverse[0];
-    inverse[1] = lastInverse[1];
-    inverse[2] = lastInverse[2];
+    double offset = 0.5 * sampling;
+    int dimensions[3] = { extent[1] - extent[0] + 1 - sampling, extent[3] - extent[2] + 1 - sampling,
+      extent[5] - extent[4] + 1 - sampling };
+    if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+      {
+      continue;
+      }
+    double origin[3] = { extent[0] + offset, extent[2] + offset, extent[4] + offset };
+    vtkLinearTransformPoint(this->GridIndexToOutputTransformMatrixCached->Element, origin, origin);
+
+    vtkNew<vtkOrientedTransformToGrid> transformToGrid;
+    transformToGrid->SetGridExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+    transformToGrid->SetGridOrigin(origin);
+    transformToGrid->SetGridSpacing(this->GridSpacing);
+    transformToGrid->SetGridDirectionMatrix(this->GridDirectionMatrix);
+    vtkNew<vtkImageData> fields[2];
+    vtkAbstractTransform* transforms[2] = { this, reference };
+    for (int i = 0; i < 2; i++)
+      {
+      transformToGrid->SetInput(transforms[i]);
+      transformToGrid->Update();
+      fields[i]->ShallowCopy(transformToGrid->GetOutput());
+      }
+    transformToGrid->SetInput(nullptr);
 
-    if (this->MTime > this->LastWarningMTime)
+    const double* field = static_cast<double*>(fields[0]->GetScalarPointer());
+    const double* referenceField = static_cast<double*>(fields[1]->GetScalarPointer());
+    if (!field || !referenceField)
       {
-      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                      ") error = " << sqrt(errorSquared) << " after " <<
-                      i << " iterations."
-                      "  Further convergence warnings suppressed until transform is modified.");
-      this->LastWarningMTime = this->MTime;
+      vtkErrorMacro("ComputeMaximumDisplacementError: failed to evaluate the transforms");
+      return -1.0;
+      }
+    vtkSMPThreadLocal<double> maximumErrorSquaredLocal(0.0);
+    vtkSMPTools::For(0, fields[0]->GetNumberOfPoints(), [&](vtkIdType begin, vtkIdType end)
+      {
+      double& localMaximum = maximumErrorSquaredLocal.Local();
+      for (vtkIdType pointId = begin; pointId < end; pointId++)
+        {
+        localMaximum = std::max(localMaximum,
+          vtkMath::Distance2BetweenPoints(field + 3*pointId, referenceField + 3*pointId));
+        }
+      });
+    for (double errorSquared : maximumErrorSquaredLocal)
+      {
+      maximumErrorSquared = std::max(maximumErrorSquared, errorSquared);
       }
-    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
     }
-
-  // convert point
-  outPoint[0] = inverse[0];
-  outPoint[1] = inverse[1];
-  outPoint[2] = inverse[2];
+  return sqrt(maximumErrorSquared);
 }
 
 //----------------------------------------------------------------------------
@@ -348,9 +2713,20 @@ void vtkOrientedGridTransform::InternalDeepCopy(vtkAbstractTransform *transform)
   vtkOrientedGridTransform *gridTransform = (vtkOrientedGridTransform *)transform;
 
   this->SetGridDirectionMatrix(gridTransform->GetGridDirectionMatrix());
-
-  // Cached matrices will be recomputed automatically in InternalUpdate()
-  // therefore we do not need to copy them.
+  this->SetUseInverseGrid(gridTransform->GetUseInverseGrid());
+  this->SetInverseGridNewtonRefinement(gridTransform->GetInverseGridNewtonRefinement());
+  this->SetHierarchicalInverse(gridTransform->GetHierarchicalInverse());
+  this->SetHierarchicalInverseDownsamplingFactor(gridTransform->GetHierarchicalInverseDownsamplingFactor());
+  this->SetThreadSafeEvaluation(gridTransform->GetThreadSafeEvaluation());
+  this->SetInverseStatisticsEventInterval(gridTransform->GetInverseStatisticsEventInterval());
+  this->SetBSplineInterpolation(gridTransform->GetBSplineInterpolation());
+  this->SetHalfFloatGrid(gridTransform->GetHalfFloatGrid());
+  this->SetDisplacementComponentScale(gridTransform->GetDisplacementComponentScale());
+  this->SetDisplacementComponentShift(gridTransform->GetDisplacementComponentShift());
+  this->SetMappedDisplacementGrid(gridTransform->GetMappedDisplacementGrid());
+
+  // Cached matrices, the coarse transform and the inverse grid will be recomputed automatically
+  // in InternalUpdate() therefore we do not need to copy them.
 
   this->Superclass::InternalDeepCopy(transform);
 }
@@ -360,6 +2736,18 @@ void vtkOrientedGridTransform::InternalUpdate()
 {
   this->Superclass::InternalUpdate();
 
+  // Replace the displacement grid image by the mapped grid (the geometry
+  // must be set before the grid index matrices are computed)
+  this->UpdateGridStorage();
+
+  // Combine the per-component scale and shift with the displacement scale and shift
+  for (int i = 0; i < 3; i++)
+    {
+    this->DisplacementScaleCached[i] = this->DisplacementComponentScale[i] * this->DisplacementScale;
+    this->DisplacementShiftCached[i] = this->DisplacementComponentShift[i] * this->DisplacementScale
+      + this->DisplacementShift;
+    }
+
   // Pre-compute GridIndexToOutputTransformMatrixCached transform and store it in a member variable
   // to avoid recomputing it each time a point is transformed.
 
@@ -385,6 +2773,224 @@ void vtkOrientedGridTransform::InternalUpdate()
   // Compute Output to GridIndex transform
   vtkMatrix4x4::Invert(this->GridIndexToOutputTransformMatrixCached, this->OutputToGridIndexTransformMatrixCached);
 
+  // Select the interpolation kernels for the current grid
+  this->UpdateKernels();
+
+  // The coarse transform is used in the inverse grid computation as well
+  this->UpdateCoarseInverseTransform();
+
+  // The transform has been modified, so the inverse grid must be recomputed
+  this->UpdateInverseGrid();
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::UpdateGridStorage()
+{
+  // Restore the interpolation function of vtkGridTransform if it was
+  // replaced, otherwise save it, as SetInterpolationMode may have changed it
+  if (this->InterpolationFunction == &vtkMappedDisplacementGrid::InterpolateNearest
+    || this->InterpolationFunction == &vtkMappedDisplacementGrid::InterpolateLinear
+    || this->InterpolationFunction == &vtkOrientedGridTransformInterpolateHalfFloatNearest
+    || this->InterpolationFunction == &vtkOrientedGridTransformInterpolateHalfFloatLinear
+    || this->InterpolationFunction == &vtkOrientedGridTransformInterpolateBSplineFunction)
+    {
+    if (this->ImageInterpolationFunction)
+      {
+      this->InterpolationFunction = this->ImageInterpolationFunction;
+      }
+    }
+  else
+    {
+    this->ImageInterpolationFunction = this->InterpolationFunction;
+    }
+
+  this->UseMappedDisplacementGrid = (this->MappedDisplacementGrid && this->MappedDisplacementGrid->IsOpen());
+  bool useHalfFloatGrid = (!this->UseMappedDisplacementGrid && this->HalfFloatGrid && this->GridPointer
+    && this->GridDirectionMatrix);
+  if (useHalfFloatGrid && this->GridScalarType != VTK_UNSIGNED_SHORT)
+    {
+    vtkWarningMacro("UpdateGridStorage: half-float grids must be stored as unsigned short,"
+      " the grid values are used as " << vtkImageScalarTypeNameMacro(this->GridScalarType));
+    useHalfFloatGrid = false;
+    }
+
+  if (this->BSplineInterpolation && this->UseMappedDisplacementGrid)
+    {
+    vtkWarningMacro("UpdateGridStorage: B-spline interpolation is not supported with mapped displacement grids");
+    }
+  this->UseBSplineInterpolation = (this->BSplineInterpolation && !this->UseMappedDisplacementGrid
+    && this->GridPointer && this->GridDirectionMatrix);
+  if (this->UseBSplineInterpolation)
+    {
+    // The kernels interpolate the prefiltered coefficients instead of the grid
+    this->UpdateBSplineCoefficients(useHalfFloatGrid);
+    this->InterpolationFunction = &vtkOrientedGridTransformInterpolateBSplineFunction;
+    this->GridPointer = this->BSplineCoefficients->GetScalarPointer();
+    this->GridScalarType = VTK_DOUBLE;
+    this->GridIncrements[0] = 3;
+    this->GridIncrements[1] = 3 * static_cast<vtkIdType>(this->GridExtent[1] - this->GridExtent[0] + 1);
+    this->GridIncrements[2] = this->GridIncrements[1] * (this->GridExtent[3] - this->GridExtent[2] + 1);
+    return;
+    }
+  if (this->BSplineCoefficients)
+    {
+    this->BSplineCoefficients->Delete();
+    this->BSplineCoefficients = nullptr;
+    }
+
+  if (!this->UseMappedDisplacementGrid && !useHalfFloatGrid)
+    {
+    return;
+    }
+
+  if (this->InterpolationMode != VTK_NEAREST_INTERPOLATION && this->InterpolationMode != VTK_LINEAR_INTERPOLATION)
+    {
+    vtkWarningMacro("UpdateGridStorage: only nearest and linear interpolation are supported"
+      " with mapped and half-float displacement grids, linear interpolation is used");
+    }
+  bool nearest = (this->InterpolationMode == VTK_NEAREST_INTERPOLATION);
+
+  if (useHalfFloatGrid)
+    {
+    this->InterpolationFunction = (nearest ? &vtkOrientedGridTransformInterpolateHalfFloatNearest
+      : &vtkOrientedGridTransformInterpolateHalfFloatLinear);
+    return;
+    }
+
+  this->InterpolationFunction = (nearest ? &vtkMappedDisplacementGrid::InterpolateNearest
+    : &vtkMappedDisplacementGrid::InterpolateLinear);
+
+  // The interpolation functions read the samples from the mapped grid,
+  // the scalar type and the increments are not used
+  this->GridPointer = this->MappedDisplacementGrid;
+  this->GridScalarType = VTK_VOID;
+  this->MappedDisplacementGrid->GetExtent(this->GridExtent);
+  this->MappedDisplacementGrid->GetOrigin(this->GridOrigin);
+  this->MappedDisplacementGrid->GetSpacing(this->GridSpacing);
+  this->GridIncrements[0] = this->GridIncrements[1] = this->GridIncrements[2] = 0;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkOrientedGridTransformCopyGrid(const T *gridPtr, const int dimensions[3], const vtkIdType gridInc[3],
+  double *coefficients, vtkIdType sliceBegin, vtkIdType sliceEnd)
+{
+  double *coefficientPtr = coefficients + 3*sliceBegin*dimensions[0]*dimensions[1];
+  for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+    {
+    for (int j = 0; j < dimensions[1]; j++)
+      {
+      const T *v = gridPtr + k*gridInc[2] + j*gridInc[1];
+      for (int i = 0; i < dimensions[0]; i++, v += gridInc[0])
+        {
+        coefficientPtr[0] = v[0];
+        coefficientPtr[1] = v[1];
+        coefficientPtr[2] = v[2];
+        coefficientPtr += 3;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::UpdateBSplineCoefficients(bool halfFloatGrid)
+{
+  const int *extent = this->GridExtent;
+  int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+  if (!this->BSplineCoefficients)
+    {
+    this->BSplineCoefficients = vtkImageData::New();
+    }
+  this->BSplineCoefficients->SetExtent(this->GridExtent);
+  this->BSplineCoefficients->SetOrigin(this->GridOrigin);
+  this->BSplineCoefficients->SetSpacing(this->GridSpacing);
+  this->BSplineCoefficients->AllocateScalars(VTK_DOUBLE, 3);
+  double *coefficients = static_cast<double*>(this->BSplineCoefficients->GetScalarPointer());
+  vtkIdType rowSize = 3 * static_cast<vtkIdType>(dimensions[0]);
+  vtkIdType sliceSize = rowSize * dimensions[1];
+
+  void *gridPtr = this->GridPointer;
+  int gridType = this->GridScalarType;
+  const vtkIdType *gridInc = this->GridIncrements;
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    if (halfFloatGrid)
+      {
+      vtkOrientedGridTransformCopyGrid(static_cast<const vtkOrientedGridTransformHalfFloat*>(gridPtr),
+        dimensions, gridInc, coefficients, sliceBegin, sliceEnd);
+      return;
+      }
+    switch (gridType)
+      {
+      vtkTemplateMacro(vtkOrientedGridTransformCopyGrid(static_cast<const VTK_TT*>(gridPtr),
+        dimensions, gridInc, coefficients, sliceBegin, sliceEnd));
+      default:
+        break;
+      }
+    });
+
+  // Separable prefilter, the lines along each axis are filtered in parallel
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType sliceBegin, vtkIdType sliceEnd)
+    {
+    for (vtkIdType k = sliceBegin; k < sliceEnd; k++)
+      {
+      for (int j = 0; j < dimensions[1]; j++)
+        {
+        for (int c = 0; c < 3; c++)
+          {
+          vtkOrientedGridTransformPrefilterLine(coefficients + k*sliceSize + j*rowSize + c, 3, dimensions[0]);
+          }
+        }
+      for (int i = 0; i < dimensions[0]; i++)
+        {
+        for (int c = 0; c < 3; c++)
+          {
+          vtkOrientedGridTransformPrefilterLine(coefficients + k*sliceSize + 3*i + c, rowSize, dimensions[1]);
+          }
+        }
+      }
+    });
+  vtkSMPTools::For(0, dimensions[1], [&](vtkIdType rowBegin, vtkIdType rowEnd)
+    {
+    for (vtkIdType j = rowBegin; j < rowEnd; j++)
+      {
+      for (int i = 0; i < dimensions[0]; i++)
+        {
+        for (int c = 0; c < 3; c++)
+          {
+          vtkOrientedGridTransformPrefilterLine(coefficients + j*rowSize + 3*i + c, sliceSize, dimensions[2]);
+          }
+        }
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::PrefetchMappedDisplacementGrid(const double bounds[6])
+{
+  if (bounds[0] > bounds[1] || bounds[2] > bounds[3] || bounds[4] > bounds[5])
+    {
+    return;
+    }
+  double indexBounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+  for (int corner = 0; corner < 8; corner++)
+    {
+    double point[3] = { bounds[corner & 1], bounds[2 + ((corner >> 1) & 1)], bounds[4 + ((corner >> 2) & 1)] };
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, point, point);
+    for (int i = 0; i < 3; i++)
+      {
+      indexBounds[2*i] = std::min(indexBounds[2*i], point[i]);
+      indexBounds[2*i+1] = std::max(indexBounds[2*i+1], point[i]);
+      }
+    }
+  // One sample margin for the interpolation
+  int prefetchBounds[6];
+  for (int i = 0; i < 3; i++)
+    {
+    prefetchBounds[2*i] = static_cast<int>(std::max(floor(indexBounds[2*i]) - 1.0, static_cast<double>(VTK_INT_MIN)));
+    prefetchBounds[2*i+1] = static_cast<int>(std::min(ceil(indexBounds[2*i+1]) + 1.0, static_cast<double>(VTK_INT_MAX)));
+    }
+  this->MappedDisplacementGrid->PrefetchRegion(prefetchBounds);
 }
 
 //----------------------------------------------------------------------------
@@ -21,6 +21,15 @@
 #include "vtkCommand.h"
 #include "vtkGridTransform.h"
 
+// STD includes
+#include <atomic>
+#include <functional>
+
+class vtkGeneralTransform;
+class vtkImageData;
+class vtkMappedDisplacementGrid;
+class vtkOrientedTransformInverseStatistics;
+
 class VTK_ADDON_EXPORT vtkOrientedGridTransform : public vtkGridTransform
 {
 public:
@@ -32,20 +41,301 @@ public:
   // Set/Get the b-spline grid axis directions.
   // This transform class will never modify the data.
   // Must be an orthogonal, normalized matrix.
-  // The 4th column and 4th row are ignored.
+  // The 4th column and 4th row are ignored. nullptr means identity.
   virtual void SetGridDirectionMatrix(vtkMatrix4x4*);
   vtkGetObjectMacro(GridDirectionMatrix,vtkMatrix4x4);
 
+  // Description:
+  // Set/Get a memory-mapped, bricked displacement grid. If it is set and
+  // open then it is used instead of the displacement grid image, so
+  // displacement grids larger than the available memory can be used.
+  // The grid direction stored in the file is not applied automatically
+  // (see vtkMappedDisplacementGrid::GetDirectionMatrix).
+  // Nearest and linear interpolation are supported, cubic interpolation
+  // falls back to linear. The interpolation kernels and the inverse grid
+  // are not used with mapped grids. TransformPoints and
+  // InverseTransformPoints prefetch the bricks of each block of points.
+  virtual void SetMappedDisplacementGrid(vtkMappedDisplacementGrid*);
+  vtkGetObjectMacro(MappedDisplacementGrid,vtkMappedDisplacementGrid);
+
+  // Description:
+  // If enabled then the displacement grid is interpolated by cubic
+  // B-splines, instead of the method selected by InterpolationMode.
+  // The grid is prefiltered when the transform is updated, so that the
+  // B-spline interpolates the grid samples; a coarser grid then reaches
+  // the accuracy of linear interpolation on a finer grid. Derivatives are
+  // analytic, so the inverse and InverseTransformDerivative use them.
+  // The prefiltered coefficients are stored as double (3 values per grid
+  // point). Not supported with mapped displacement grids. Default is off.
+  vtkSetMacro(BSplineInterpolation,bool);
+  vtkGetMacro(BSplineInterpolation,bool);
+  vtkBooleanMacro(BSplineInterpolation,bool);
+
+  // Description:
+  // If enabled then an unsigned short displacement grid stores IEEE 754
+  // half-precision floats, which are converted in the interpolation.
+  // Nearest and linear interpolation are supported, cubic interpolation
+  // falls back to linear. Default is off.
+  vtkSetMacro(HalfFloatGrid,bool);
+  vtkGetMacro(HalfFloatGrid,bool);
+  vtkBooleanMacro(HalfFloatGrid,bool);
+
+  // Description:
+  // Set/Get the per-component scale and shift of the displacement grid
+  // values, applied before DisplacementScale and DisplacementShift:
+  // displacement = (value * componentScale + componentShift) * scale + shift
+  // This allows quantized (short) grids to use the full range of the
+  // scalar type for each component. Default is scale 1 and shift 0.
+  vtkSetVector3Macro(DisplacementComponentScale,double);
+  vtkGetVector3Macro(DisplacementComponentScale,double);
+  vtkSetVector3Macro(DisplacementComponentShift,double);
+  vtkGetVector3Macro(DisplacementComponentShift,double);
+
+  // Description:
+  // Storage types of SetCompactDisplacementGrid.
+  enum CompactStorageType
+    {
+    FloatStorage = 0,
+    HalfFloatStorage,
+    ShortStorage
+    };
+
+  // Description:
+  // Set a displacement grid (3-component image of any scalar type) in
+  // compact storage: 32-bit float, 16-bit half float or 16-bit integer
+  // quantized with a per-component scale and shift. HalfFloatGrid and
+  // the component scale and shift are set accordingly, DisplacementScale
+  // and DisplacementShift are not modified. If maximumError is not
+  // nullptr then it is set to the maximum distance between the original
+  // and the stored displacement vectors (before DisplacementScale is
+  // applied), which is also the maximum error of nearest and linear
+  // interpolation. Returns false on invalid input.
+  bool SetCompactDisplacementGrid(vtkImageData* grid, int storageType, double* maximumError = nullptr);
+
+  // Description:
+  // Compute the maximum distance between the points transformed by this
+  // transform and by a reference transform, sampled at the displacement
+  // grid points and at the cell centers of the displacement grid.
+  // It measures the error of compact storage or of any other
+  // approximation of the reference transform. Returns -1 on error.
+  double ComputeMaximumDisplacementError(vtkAbstractTransform* reference);
+
+  // Description:
+  // Get the modification time, including the mapped displacement grid.
+  vtkMTimeType GetMTime() override;
+
   // Description:
   // Make another transform of the same type.
   vtkAbstractTransform *MakeTransform() override;
 
+  // Description:
+  // Apply the transformation to a series of points, and append the
+  // results to outPts.
+  // Points are processed in blocks, in parallel using vtkSMPTools.
+  // Nearest, linear and B-spline interpolation of points stored in float
+  // or double point arrays uses inlined scalar kernels instead of the
+  // generic InterpolationFunction (points are not evaluated with vector
+  // instructions).
+  void TransformPoints(vtkPoints *inPts, vtkPoints *outPts) override;
+
+  // Description:
+  // Evaluate the transform on a regular lattice and store the result as
+  // a displacement field (3-component double image, output point minus
+  // input point) in displacementField.
+  // The lattice is defined by its origin, spacing, axis directions (the
+  // 4th column and 4th row are ignored, nullptr means identity) and
+  // dimensions. The direction is not stored in the image.
+  // Grid index coordinates are computed incrementally along each row and
+  // slices are processed in parallel.
+  // Returns false on invalid input.
+  bool EvaluateOnGrid(const double origin[3], const double spacing[3],
+    vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* displacementField);
+
+  // Description:
+  // Returns true if EvaluateDisplacementsAlongLine can evaluate the
+  // transform, i.e. the transform is not inverted and has a displacement
+  // grid. Update() must be called before.
+  bool SupportsLineEvaluation();
+
+  // Description:
+  // Evaluate the displacement of the forward transform at numberOfPoints
+  // equally spaced points (start + i*step) and store them in displacements
+  // (3 values per point). The grid index is computed incrementally and, with
+  // linear interpolation, the grid values of the current cell are reused
+  // until the line leaves the cell.
+  // Update() must be called before; the method does not modify the
+  // transform, therefore lines can be evaluated concurrently.
+  // Returns false if the transform is inverted or has no displacement grid.
+  // \sa SupportsLineEvaluation()
+  bool EvaluateDisplacementsAlongLine(const double start[3], const double step[3],
+    int numberOfPoints, double* displacements);
+
+  // Description:
+  // Evaluate the determinant of the Jacobian of the transform on a regular
+  // lattice (defined the same way as in EvaluateOnGrid) and store it in
+  // jacobianDeterminant (1-component double image).
+  // The forward transform is evaluated in parallel, using the analytic
+  // derivative of the selected interpolation kernel.
+  // Returns false on invalid input.
+  bool EvaluateJacobianDeterminantOnGrid(const double origin[3], const double spacing[3],
+    vtkMatrix4x4* direction, const int dimensions[3], vtkImageData* jacobianDeterminant);
+
+  // Description:
+  // Set this transform to be equivalent to the chain
+  // postMatrix * gridTransform * preMatrix, so that points are transformed
+  // by a single grid lookup. preMatrix and postMatrix must be affine,
+  // nullptr means identity. gridTransform must not be inverted, it may be
+  // this transform.
+  // The pre-transform is folded into the grid geometry (origin, spacing
+  // and GridDirectionMatrix) and the post-transform into the displacement
+  // vectors. If the pre-transform is a similarity transform then the
+  // result is identical to the chain within the grid, otherwise the grid
+  // axes are orthogonalized and the chain is resampled.
+  // Outside the grid the displacement at the grid border is extended, as
+  // for any grid transform, therefore the result is only identical to the
+  // chain outside the grid if the pre- and post-transforms are
+  // translations. With B-spline interpolation, the affine part of the
+  // collapsed displacements is not reproduced exactly near the grid
+  // border, unless the pre- and post-transforms are translations.
+  // The displacement scale and shift are folded into the grid as well.
+  // Returns false if the transforms cannot be collapsed.
+  bool CollapseTransforms(vtkMatrix4x4* preMatrix, vtkOrientedGridTransform* gridTransform,
+    vtkMatrix4x4* postMatrix);
+
+  // Description:
+  // Set this transform to be equivalent to a vtkGeneralTransform that
+  // concatenates linear transforms and a single vtkOrientedGridTransform.
+  // Returns false if the transform contains any other transforms.
+  bool CollapseTransforms(vtkGeneralTransform* transform);
+
+  // Description:
+  // Compute the inverse of the transform for a sequence of points, stored
+  // as x1, y1, z1, x2, y2, z2, ... (inPoints and outPoints may be the same).
+  // Consecutive points are expected to be close to each other (for example
+  // in scanline order): the Newton iteration of each point starts from the
+  // solution of the previous point, shifted by the distance between the
+  // input points. Blocks of points are processed in parallel.
+  // Returns the mean number of Newton iterations per point.
+  double InverseTransformPoints(const double* inPoints, double* outPoints, vtkIdType numberOfPoints);
+
+  // Description:
+  // If enabled then an inverse displacement grid is precomputed, in
+  // parallel, when an inverted transform is updated. The inverse grid has
+  // the same geometry as the displacement grid and it is recomputed
+  // whenever the transform is modified.
+  // Inverse points are then computed by a trilinear lookup in the inverse
+  // grid, optionally followed by a single Newton step (see
+  // InverseGridNewtonRefinement), instead of full Newton iterations.
+  // Default is off.
+  vtkSetMacro(UseInverseGrid, bool);
+  vtkGetMacro(UseInverseGrid, bool);
+  vtkBooleanMacro(UseInverseGrid, bool);
+
+  // Description:
+  // If enabled then the inverse grid lookup is refined by one Newton step.
+  // Default is on.
+  vtkSetMacro(InverseGridNewtonRefinement, bool);
+  vtkGetMacro(InverseGridNewtonRefinement, bool);
+  vtkBooleanMacro(InverseGridNewtonRefinement, bool);
+
+  // Description:
+  // Get the precomputed inverse displacement grid.
+  // Returns nullptr if UseInverseGrid is off or the transform is not inverted.
+  vtkGetObjectMacro(InverseGrid, vtkImageData);
+
+  // Description:
+  // If enabled then the inverse is computed coarse-to-fine: a coarse
+  // transform, whose displacements are averaged over boxes of
+  // HierarchicalInverseDownsamplingFactor grid samples along each axis, is
+  // built when the transform is updated. Inverse points that have no good
+  // first guess (for example the first point of each block in
+  // InverseTransformPoints) are solved on the coarse transform first, and
+  // the result is refined on the full resolution grid. The coarse
+  // transform is smoother, therefore large deformations need fewer
+  // iterations and fail less often. Iterations on the coarse transform are
+  // included in the inverse statistics. Default is off.
+  vtkSetMacro(HierarchicalInverse, bool);
+  vtkGetMacro(HierarchicalInverse, bool);
+  vtkBooleanMacro(HierarchicalInverse, bool);
+
+  // Description:
+  // Downsampling factor of the coarse transform of the hierarchical
+  // inverse. Default is 4.
+  vtkSetClampMacro(HierarchicalInverseDownsamplingFactor, int, 2, 64);
+  vtkGetMacro(HierarchicalInverseDownsamplingFactor, int);
+
+  // Description:
+  // Get the coarse transform of the hierarchical inverse.
+  // Returns nullptr if HierarchicalInverse is off.
+  vtkGetObjectMacro(CoarseInverseTransform, vtkOrientedGridTransform);
+
+#ifndef __VTK_WRAP__
+  // Description:
+  // Set this transform to a downsampled version of another transform.
+  // The other transform is sampled on a lattice, defined by the lattice
+  // index to output matrix (its columns must be orthogonal) and the
+  // lattice extent. The displacements are averaged over boxes of
+  // downsamplingFactor+1 samples along each axis, centered at every
+  // downsamplingFactor-th sample, and stored in a linearly interpolated
+  // double grid. forwardTransform must be thread-safe, as the lattice is
+  // sampled in parallel. Used for building the coarse transform of the
+  // hierarchical inverse. Returns false on invalid input.
+  bool SetDownsampledDisplacementGrid(const std::function<void(const double*, double*)>& forwardTransform,
+    vtkMatrix4x4* latticeToOutput, const int latticeExtent[6], int downsamplingFactor);
+#endif
+
+  // Description:
+  // Get convergence statistics of the inverse computations (number of
+  // computations, iterations, failures, maximum residual).
+  // Each inverse point counts as one computation. Newton iterations
+  // count the number of evaluations of the forward transform (the inverse
+  // grid lookup counts as 0, its refinement as 1 iteration).
+  // Statistics are not reset when the transform is modified.
+  vtkGetObjectMacro(InverseStatistics, vtkOrientedTransformInverseStatistics);
+
+  // Description:
+  // Set all inverse convergence statistics counters to zero.
+  void ResetInverseStatistics();
+
+  // Description:
+  // If larger than 0 then InverseStatisticsEvent is invoked each time
+  // the number of inverse computations reaches a multiple of this value.
+  // Default is 0 (no events).
+  vtkSetMacro(InverseStatisticsEventInterval, vtkIdType);
+  vtkGetMacro(InverseStatisticsEventInterval, vtkIdType);
+
+  // Description:
+  // Enable thread-safe evaluation. If enabled, then after Update() the
+  // transform can be evaluated concurrently from multiple threads (for
+  // example by calling InternalTransformPoint in vtkSMPTools loops):
+  // evaluation does not modify the transform, convergence failures are
+  // counted atomically, and no warnings are logged and no events are
+  // invoked during evaluation. Call InvokePendingEvents() from the calling
+  // thread when the batch completes to report them. TransformPoints and
+  // EvaluateOnGrid then also evaluate inverted transforms in parallel,
+  // and report pending events when they are done.
+  // Transforms without a grid direction matrix are evaluated by
+  // vtkGridTransform and are not covered.
+  // Default is off.
+  vtkSetMacro(ThreadSafeEvaluation, bool);
+  vtkGetMacro(ThreadSafeEvaluation, bool);
+  vtkBooleanMacro(ThreadSafeEvaluation, bool);
+
+  // Description:
+  // Log a warning for convergence failures and invoke the events that
+  // were deferred in thread-safe evaluation mode.
+  // Must not be called while the transform is evaluated by other threads.
+  void InvokePendingEvents();
+
   /// List of custom events fired by the class.
   // ConvergenceFailureEvent is invoked when the gradient cannot be
   // inverted, probably due to a singular transform or numeric instability.
+  // InverseStatisticsEvent is invoked periodically, see
+  // InverseStatisticsEventInterval.
   enum Events
     {
-    ConvergenceFailureEvent = vtkCommand::UserEvent + 1
+    ConvergenceFailureEvent = vtkCommand::UserEvent + 1,
+    InverseStatisticsEvent = vtkCommand::UserEvent + 2
     };
 
 protected:
@@ -65,6 +355,7 @@ protected:
   // the float versions)
   using vtkGridTransform::ForwardTransformPoint;
   using vtkGridTransform::ForwardTransformDerivative;
+  using vtkGridTransform::InverseTransformPoint;
   using vtkGridTransform::InverseTransformDerivative;
 
   // Description:
@@ -74,9 +365,84 @@ protected:
   void ForwardTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]) override;
 
+  void InverseTransformPoint(const double in[3], double out[3]) override;
+
   void InverseTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]) override;
 
+  // Description:
+  // Compute the inverse transform using Newton's method.
+  // If initialGuess is nullptr then the first guess is the input point
+  // minus the displacement at the input point.
+  // This method does not log messages or invoke events, therefore it can
+  // be called from multiple threads.
+  // Returns false if the iteration did not converge. The last good
+  // result is returned in outPoint in this case.
+  bool InverseTransformPointNewton(const double inPoint[3], const double* initialGuess,
+    double outPoint[3], double derivative[3][3], int& numberOfIterations, double& errorSquared);
+
+  // Description:
+  // Compute the inverse transform without a first guess: on the coarse
+  // transform first (if HierarchicalInverse is enabled), then on the full
+  // resolution grid. If the refinement does not converge then the default
+  // first guess is tried as well. numberOfIterations counts the iterations
+  // of all steps, with the same convention as InverseTransformPointNewton.
+  bool InverseTransformPointHierarchical(const double inPoint[3], double outPoint[3],
+    double derivative[3][3], int& numberOfIterations, double& errorSquared);
+
+  // Description:
+  // Build the coarse transform of the hierarchical inverse.
+  void UpdateCoarseInverseTransform();
+
+  // Description:
+  // Compute the inverse displacement grid (in parallel).
+  void UpdateInverseGrid();
+
+  // Description:
+  // Record an inverse computation in the statistics. The statistics event
+  // is invoked or, in thread-safe evaluation mode, deferred.
+  void AddInverseStatistics(int numberOfIterations, bool converged, double residual);
+
+  // Description:
+  // Forward transform kernels, specialized at compile time for the grid
+  // scalar type (float, double, short, half float), the interpolation mode
+  // (nearest, linear, B-spline) and the grid orientation (axis-aligned or
+  // oblique).
+  // UpdateKernels selects the kernels for the current grid once in
+  // InternalUpdate, so that no type or mode switch is needed per point.
+  // Kernel pointers are nullptr if there is no specialized kernel (cubic
+  // interpolation, other scalar types), then the generic interpolation
+  // function of vtkGridTransform is used.
+  typedef void (vtkOrientedGridTransform::*PointKernelType)(const double in[3], double out[3]);
+  typedef void (vtkOrientedGridTransform::*DerivativeKernelType)(const double in[3], double out[3],
+    double derivative[3][3]);
+  template <class T, int Interpolation, bool AxisAligned>
+  void ForwardTransformPointKernel(const double in[3], double out[3]);
+  template <class T, int Interpolation, bool AxisAligned>
+  void ForwardTransformDerivativeKernel(const double in[3], double out[3], double derivative[3][3]);
+  template <class T, bool AxisAligned>
+  void SelectKernels();
+  template <class T>
+  void SelectKernels(bool axisAligned);
+  void UpdateKernels();
+
+  // Description:
+  // Compute the prefiltered cubic B-spline coefficients of the displacement
+  // grid (in parallel).
+  void UpdateBSplineCoefficients(bool halfFloatGrid);
+
+  // Description:
+  // Replace the interpolation function of vtkGridTransform for mapped,
+  // half-float and B-spline interpolated grids, or restore it for other grids. Use the mapped
+  // displacement grid, if it is set and open, instead of the displacement
+  // grid image. Called in InternalUpdate.
+  virtual void UpdateGridStorage();
+
+  // Description:
+  // Prefetch the bricks of the mapped displacement grid that are needed
+  // to transform points within the specified bounds.
+  void PrefetchMappedDisplacementGrid(const double bounds[6]);
+
   // Description:
   // Grid axis direction vectors (i, j, k) in the output space
   vtkMatrix4x4* GridDirectionMatrix;
@@ -92,7 +458,63 @@ protected:
   // by keeping track of the MTime when the last warning was issued.
   vtkMTimeType LastWarningMTime;
 
+  // Description:
+  // Precomputed inverse displacement grid.
+  bool UseInverseGrid;
+  bool InverseGridNewtonRefinement;
+  vtkImageData* InverseGrid;
+
+  // Description:
+  // Coarse transform of the hierarchical inverse.
+  bool HierarchicalInverse;
+  int HierarchicalInverseDownsamplingFactor;
+  vtkOrientedGridTransform* CoarseInverseTransform;
+
+  // Description:
+  // Inverse convergence statistics.
+  vtkOrientedTransformInverseStatistics* InverseStatistics;
+  vtkIdType InverseStatisticsEventInterval;
+
+  // Description:
+  // Interpolation kernels selected in UpdateKernels.
+  PointKernelType ForwardPointKernel;
+  DerivativeKernelType ForwardDerivativeKernel;
+  bool GridAxisAligned;
+
+  // Description:
+  // Prefiltered cubic B-spline interpolation.
+  bool BSplineInterpolation;
+  bool UseBSplineInterpolation;
+  vtkImageData* BSplineCoefficients;
+
+  // Description:
+  // Compact storage of the displacement grid and the per-component
+  // scale and shift combined with DisplacementScale and DisplacementShift.
+  bool HalfFloatGrid;
+  double DisplacementComponentScale[3];
+  double DisplacementComponentShift[3];
+  double DisplacementScaleCached[3];
+  double DisplacementShiftCached[3];
+
+  // Description:
+  // Memory-mapped displacement grid. The interpolation function of the
+  // displacement grid image is restored when the mapped grid and the
+  // half-float grid are not used.
+  vtkMappedDisplacementGrid* MappedDisplacementGrid;
+  bool UseMappedDisplacementGrid;
+  void (*ImageInterpolationFunction)(double point[3], double displacement[3], double derivatives[3][3],
+    void *gridPtr, int gridType, int inExt[6], vtkIdType inInc[3]);
+
+  // Description:
+  // Thread-safe evaluation mode and the events deferred in this mode.
+  bool ThreadSafeEvaluation;
+  std::atomic<vtkIdType> PendingConvergenceFailures;
+  std::atomic<bool> PendingInverseStatisticsEvent;
+
 private:
+  // The b-spline transform uses a coarse grid transform in its hierarchical inverse
+  friend class vtkOrientedBSplineTransform;
+
   vtkOrientedGridTransform(const vtkOrientedGridTransform&) = delete;
   void operator=(const vtkOrientedGridTransform&) = delete;
 };
@@ -0,0 +1,478 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTimeVaryingGridTransform.h"
+
+#include "vtkImageData.h"
+#include "vtkMath.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+vtkStandardNewMacro(vtkOrientedTimeVaryingGridTransform);
+
+//----------------------------------------------------------------------------
+// Phase grids and the blending state at the current time. The transform
+// uses this structure as its grid pointer, the interpolation function reads
+// the phases and the weight from it.
+struct vtkOrientedTimeVaryingGridTransformPhases
+{
+  std::vector<vtkSmartPointer<vtkImageData> > Grids;
+  std::vector<void*> GridPointers;
+
+  // Phases are used only if all phase grids match the displacement grid
+  bool Active;
+
+  // Grid scalar type and the interpolation function of the displacement grid
+  int ScalarType;
+  int InterpolationMode;
+  void (*ImageInterpolationFunction)(double point[3], double displacement[3], double derivatives[3][3],
+    void *gridPtr, int gridType, int inExt[6], vtkIdType inInc[3]);
+
+  // displacement = (1 - Weight1) * phase0 + Weight1 * phase1
+  void* Phase0;
+  void* Phase1;
+  double Weight1;
+};
+
+//------------------------------------------------------------------------
+// Trilinear interpolation of the blended phases. The grid values of the
+// two phases are blended at the corners of the interpolated cell, which
+// is equivalent to blending the interpolated displacements. The border
+// handling is the same as in the linear interpolation of vtkGridTransform.
+template <class T>
+void vtkOrientedTimeVaryingGridTransformInterpolateLinear(const double point[3], double displacement[3],
+  double derivatives[3][3], const T *phase0, const T *phase1, double weight1,
+  const int gridExt[6], const vtkIdType gridInc[3])
+{
+  double f[3];
+  vtkIdType gridOffset0[3], gridOffset1[3];
+  for (int i = 0; i < 3; i++)
+    {
+    int floorIndex = vtkMath::Floor(point[i]);
+    f[i] = point[i] - floorIndex;
+    int gridId0 = floorIndex - gridExt[2*i];
+    int gridId1 = gridId0 + 1;
+    int ext = gridExt[2*i+1] - gridExt[2*i];
+    if (gridId0 < 0)
+      {
+      gridId0 = 0;
+      gridId1 = 0;
+      f[i] = 0;
+      }
+    else if (gridId1 > ext)
+      {
+      gridId0 = ext;
+      gridId1 = ext;
+      f[i] = 0;
+      }
+    gridOffset0[i] = gridId0*gridInc[i];
+    gridOffset1[i] = gridId1*gridInc[i];
+    }
+
+  // corner order: 000, 001, 010, 011, 100, 101, 110, 111 (x, y, z)
+  vtkIdType cornerOffsets[8] =
+    {
+    gridOffset0[0] + gridOffset0[1] + gridOffset0[2],
+    gridOffset0[0] + gridOffset0[1] + gridOffset1[2],
+    gridOffset0[0] + gridOffset1[1] + gridOffset0[2],
+    gridOffset0[0] + gridOffset1[1] + gridOffset1[2],
+    gridOffset1[0] + gridOffset0[1] + gridOffset0[2],
+    gridOffset1[0] + gridOffset0[1] + gridOffset1[2],
+    gridOffset1[0] + gridOffset1[1] + gridOffset0[2],
+    gridOffset1[0] + gridOffset1[1] + gridOffset1[2]
+    };
+  double v[8][3];
+  double weight0 = 1 - weight1;
+  for (int corner = 0; corner < 8; corner++)
+    {
+    const T *v0 = phase0 + cornerOffsets[corner];
+    if (weight1 == 0)
+      {
+      v[corner][0] = v0[0];
+      v[corner][1] = v0[1];
+      v[corner][2] = v0[2];
+      continue;
+      }
+    const T *v1 = phase1 + cornerOffsets[corner];
+    for (int i = 0; i < 3; i++)
+      {
+      v[corner][i] = weight0*v0[i] + weight1*v1[i];
+      }
+    }
+
+  double rx = 1 - f[0];
+  double ry = 1 - f[1];
+  double rz = 1 - f[2];
+
+  double ryrz = ry*rz;
+  double ryfz = ry*f[2];
+  double fyrz = f[1]*rz;
+  double fyfz = f[1]*f[2];
+
+  for (int i = 0; i < 3; i++)
+    {
+    displacement[i] = (rx*(ryrz*v[0][i] + ryfz*v[1][i] + fyrz*v[2][i] + fyfz*v[3][i]) +
+                       f[0]*(ryrz*v[4][i] + ryfz*v[5][i] + fyrz*v[6][i] + fyfz*v[7][i]));
+    }
+
+  if (!derivatives)
+    {
+    return;
+    }
+
+  double rxrz = rx*rz;
+  double rxfz = rx*f[2];
+  double fxrz = f[0]*rz;
+  double fxfz = f[0]*f[2];
+  double rxry = rx*ry;
+  double rxfy = rx*f[1];
+  double fxry = f[0]*ry;
+  double fxfy = f[0]*f[1];
+
+  for (int i = 0; i < 3; i++)
+    {
+    derivatives[i][0] = (ryrz*(v[4][i] - v[0][i]) + ryfz*(v[5][i] - v[1][i]) +
+                         fyrz*(v[6][i] - v[2][i]) + fyfz*(v[7][i] - v[3][i]));
+    derivatives[i][1] = (rxrz*(v[2][i] - v[0][i]) + rxfz*(v[3][i] - v[1][i]) +
+                         fxrz*(v[6][i] - v[4][i]) + fxfz*(v[7][i] - v[5][i]));
+    derivatives[i][2] = (rxry*(v[1][i] - v[0][i]) + rxfy*(v[3][i] - v[2][i]) +
+                         fxry*(v[5][i] - v[4][i]) + fxfy*(v[7][i] - v[6][i]));
+    }
+}
+
+//------------------------------------------------------------------------
+// Interpolation function with the signature of the
+// vtkGridTransform::InterpolationFunction. gridPtr points to the
+// vtkOrientedTimeVaryingGridTransformPhases of the transform, gridType is
+// ignored.
+static void vtkOrientedTimeVaryingGridTransformInterpolate(double point[3], double displacement[3],
+  double derivatives[3][3], void *gridPtr, int vtkNotUsed(gridType), int gridExt[6], vtkIdType gridInc[3])
+{
+  vtkOrientedTimeVaryingGridTransformPhases *phases =
+    static_cast<vtkOrientedTimeVaryingGridTransformPhases*>(gridPtr);
+
+  if (phases->InterpolationMode == VTK_LINEAR_INTERPOLATION)
+    {
+    switch (phases->ScalarType)
+      {
+      vtkTemplateMacro(vtkOrientedTimeVaryingGridTransformInterpolateLinear(point, displacement, derivatives,
+        static_cast<VTK_TT*>(phases->Phase0), static_cast<VTK_TT*>(phases->Phase1), phases->Weight1,
+        gridExt, gridInc));
+      default:
+        break;
+      }
+    return;
+    }
+
+  // Interpolate both phases with the interpolation function of the
+  // displacement grid and blend the results
+  phases->ImageInterpolationFunction(point, displacement, derivatives,
+    phases->Phase0, phases->ScalarType, gridExt, gridInc);
+  if (phases->Weight1 == 0)
+    {
+    return;
+    }
+  double displacement1[3];
+  double derivatives1[3][3];
+  phases->ImageInterpolationFunction(point, displacement1, derivatives ? derivatives1 : nullptr,
+    phases->Phase1, phases->ScalarType, gridExt, gridInc);
+  double weight0 = 1 - phases->Weight1;
+  for (int i = 0; i < 3; i++)
+    {
+    displacement[i] = weight0 * displacement[i] + phases->Weight1 * displacement1[i];
+    if (derivatives)
+      {
+      for (int j = 0; j < 3; j++)
+        {
+        derivatives[i][j] = weight0 * derivatives[i][j] + phases->Weight1 * derivatives1[i][j];
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTimeVaryingGridTransform::vtkOrientedTimeVaryingGridTransform()
+{
+  this->Time = 0.0;
+  this->Periodic = true;
+  this->TimeInterpolationMode = VTK_LINEAR_INTERPOLATION;
+  this->TimeOnlyModified = false;
+
+  this->Phases = new vtkOrientedTimeVaryingGridTransformPhases;
+  this->Phases->Active = false;
+  this->Phases->ScalarType = VTK_VOID;
+  this->Phases->InterpolationMode = VTK_LINEAR_INTERPOLATION;
+  this->Phases->ImageInterpolationFunction = nullptr;
+  this->Phases->Phase0 = nullptr;
+  this->Phases->Phase1 = nullptr;
+  this->Phases->Weight1 = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTimeVaryingGridTransform::~vtkOrientedTimeVaryingGridTransform()
+{
+  delete this->Phases;
+  this->Phases = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "NumberOfPhases: " << this->GetNumberOfPhases() << "\n";
+  os << indent << "Time: " << this->Time << "\n";
+  os << indent << "Periodic: " << (this->Periodic ? "true" : "false") << "\n";
+  os << indent << "TimeInterpolationMode: " << this->TimeInterpolationMode << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::AddPhaseGrid(vtkImageData* grid)
+{
+  if (!grid)
+    {
+    vtkErrorMacro("AddPhaseGrid: invalid phase grid");
+    return;
+    }
+  this->Phases->Grids.push_back(grid);
+  if (this->Phases->Grids.size() == 1)
+    {
+    // The first phase defines the geometry
+    this->SetDisplacementGridData(grid);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::RemoveAllPhaseGrids()
+{
+  if (this->Phases->Grids.empty())
+    {
+    return;
+    }
+  this->Phases->Grids.clear();
+  this->SetDisplacementGridData(nullptr);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTimeVaryingGridTransform::GetNumberOfPhases()
+{
+  return static_cast<int>(this->Phases->Grids.size());
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkOrientedTimeVaryingGridTransform::GetPhaseGrid(int phase)
+{
+  if (phase < 0 || phase >= this->GetNumberOfPhases())
+    {
+    vtkErrorMacro("GetPhaseGrid: phase " << phase << " is out of range");
+    return nullptr;
+    }
+  return this->Phases->Grids[phase];
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::SetTime(double time)
+{
+  if (this->Time == time)
+    {
+    return;
+    }
+  // Check before Modified() whether the transform was up to date
+  bool onlyTimeModified = this->IsOnlyTimeModified();
+  this->Time = time;
+  this->Modified();
+  this->TimeModifiedTime.Modified();
+  this->TimeOnlyModified = onlyTimeModified;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedTimeVaryingGridTransform::IsOnlyTimeModified()
+{
+  // The inverse caches depend on the displacement at the current time.
+  // The inverse grid is only computed for inverted transforms.
+  if (!this->Phases->Active || (this->UseInverseGrid && this->InverseFlag) || this->HierarchicalInverse)
+    {
+    return false;
+    }
+  vtkMTimeType mtime = this->GetMTime();
+  if (mtime <= this->PhasesUpdateTime.GetMTime())
+    {
+    return true;
+    }
+  return (this->TimeOnlyModified && mtime <= this->TimeModifiedTime.GetMTime());
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkOrientedTimeVaryingGridTransform::GetMTime()
+{
+  vtkMTimeType mtime = this->Superclass::GetMTime();
+  for (std::vector<vtkSmartPointer<vtkImageData> >::iterator it = this->Phases->Grids.begin();
+    it != this->Phases->Grids.end(); ++it)
+    {
+    vtkMTimeType mtime2 = (*it)->GetMTime();
+    if (mtime2 > mtime)
+      {
+      mtime = mtime2;
+      }
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::InternalDeepCopy(vtkAbstractTransform *transform)
+{
+  vtkOrientedTimeVaryingGridTransform *timeVaryingTransform = (vtkOrientedTimeVaryingGridTransform *)transform;
+
+  this->Phases->Grids = timeVaryingTransform->Phases->Grids;
+  this->Modified();
+  this->SetTime(timeVaryingTransform->GetTime());
+  this->SetPeriodic(timeVaryingTransform->GetPeriodic());
+  this->SetTimeInterpolationMode(timeVaryingTransform->GetTimeInterpolationMode());
+
+  // The displacement grid (first phase) is copied by the superclass
+  this->Superclass::InternalDeepCopy(transform);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::InternalUpdate()
+{
+  if (this->IsOnlyTimeModified())
+    {
+    this->UpdatePhaseWeights();
+    return;
+    }
+
+  this->Superclass::InternalUpdate();
+
+  this->PhasesUpdateTime.Modified();
+  this->TimeOnlyModified = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::UpdateGridStorage()
+{
+  // Restore the interpolation function of the displacement grid, so that
+  // the superclass does not save the phase interpolation function instead
+  if (this->InterpolationFunction == &vtkOrientedTimeVaryingGridTransformInterpolate
+    && this->Phases->ImageInterpolationFunction)
+    {
+    this->InterpolationFunction = this->Phases->ImageInterpolationFunction;
+    }
+
+  this->Superclass::UpdateGridStorage();
+
+  this->Phases->Active = false;
+  this->Phases->GridPointers.clear();
+  if (this->Phases->Grids.empty() || !this->GridPointer)
+    {
+    return;
+    }
+  if (this->UseBSplineInterpolation || this->UseMappedDisplacementGrid
+    || (this->HalfFloatGrid && this->GridDirectionMatrix && this->GridScalarType == VTK_UNSIGNED_SHORT))
+    {
+    vtkWarningMacro("UpdateGridStorage: B-spline interpolation, half-float and mapped grids are not supported"
+      " with phase grids, only the displacement grid is used");
+    return;
+    }
+
+  for (std::vector<vtkSmartPointer<vtkImageData> >::iterator it = this->Phases->Grids.begin();
+    it != this->Phases->Grids.end(); ++it)
+    {
+    vtkImageData *grid = *it;
+    int *extent = grid->GetExtent();
+    double *origin = grid->GetOrigin();
+    double *spacing = grid->GetSpacing();
+    bool sameGeometry = true;
+    for (int i = 0; i < 3; i++)
+      {
+      if (extent[2*i] != this->GridExtent[2*i] || extent[2*i+1] != this->GridExtent[2*i+1]
+        || origin[i] != this->GridOrigin[i] || spacing[i] != this->GridSpacing[i])
+        {
+        sameGeometry = false;
+        }
+      }
+    if (!sameGeometry || grid->GetScalarType() != this->GridScalarType
+      || grid->GetNumberOfScalarComponents() != 3 || !grid->GetScalarPointer())
+      {
+      vtkErrorMacro("UpdateGridStorage: phase grid " << this->Phases->GridPointers.size()
+        << " does not match the geometry or scalar type of the first phase grid, only the displacement grid is used");
+      this->Phases->GridPointers.clear();
+      return;
+      }
+    this->Phases->GridPointers.push_back(grid->GetScalarPointer());
+    }
+
+  // The interpolation function reads the phases and the blending weight
+  // from the phases structure, the kernels of the superclass are not used
+  this->Phases->Active = true;
+  this->Phases->ScalarType = this->GridScalarType;
+  this->Phases->InterpolationMode = this->InterpolationMode;
+  this->Phases->ImageInterpolationFunction = this->InterpolationFunction;
+  this->InterpolationFunction = &vtkOrientedTimeVaryingGridTransformInterpolate;
+  this->GridPointer = this->Phases;
+  this->GridScalarType = VTK_VOID;
+  this->UpdatePhaseWeights();
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTimeVaryingGridTransform::UpdatePhaseWeights()
+{
+  int numberOfPhases = static_cast<int>(this->Phases->GridPointers.size());
+  if (numberOfPhases == 0)
+    {
+    return;
+    }
+
+  double time = this->Time;
+  if (this->Periodic)
+    {
+    time = fmod(time, static_cast<double>(numberOfPhases));
+    if (time < 0)
+      {
+      time += numberOfPhases;
+      }
+    }
+  else
+    {
+    time = std::min(std::max(time, 0.0), static_cast<double>(numberOfPhases - 1));
+    }
+
+  int phase0 = std::min(vtkMath::Floor(time), numberOfPhases - 1);
+  double weight1 = time - phase0;
+  int phase1 = (this->Periodic ? (phase0 + 1) % numberOfPhases : std::min(phase0 + 1, numberOfPhases - 1));
+  if (this->TimeInterpolationMode == VTK_NEAREST_INTERPOLATION)
+    {
+    if (weight1 >= 0.5)
+      {
+      phase0 = phase1;
+      }
+    weight1 = 0.0;
+    }
+  if (weight1 <= 0.0 || phase0 == phase1)
+    {
+    phase1 = phase0;
+    weight1 = 0.0;
+    }
+
+  this->Phases->Phase0 = this->Phases->GridPointers[phase0];
+  this->Phases->Phase1 = this->Phases->GridPointers[phase1];
+  this->Phases->Weight1 = weight1;
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform *vtkOrientedTimeVaryingGridTransform::MakeTransform()
+{
+  return vtkOrientedTimeVaryingGridTransform::New();
+}
@@ -0,0 +1,146 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkOrientedTimeVaryingGridTransform - oriented displacement field
+/// transformation that changes over time.
+///
+/// Holds a sequence of displacement grids (phases, for example the phases of
+/// a respiratory or cardiac cycle) that share the geometry of the first
+/// phase grid. The displacement at Time is interpolated between the two
+/// adjacent phases, inside the spatial interpolation.
+///
+/// Changing only the Time does not copy grids or recompute the transform,
+/// the phases and the blending weight are switched when the transform is
+/// updated. The inverse grid (of inverted transforms) and the hierarchical
+/// inverse are computed from the displacement at the current time,
+/// therefore they are recomputed whenever the time changes.
+///
+/// Linear interpolation blends the grid values of the interpolated cell
+/// in a single pass, other interpolation modes interpolate both phases and
+/// blend the results. B-spline interpolation, half-float grids and mapped
+/// displacement grids are not supported with phase grids.
+///
+
+#ifndef __vtkOrientedTimeVaryingGridTransform_h
+#define __vtkOrientedTimeVaryingGridTransform_h
+
+#include "vtkAddon.h"
+
+#include "vtkOrientedGridTransform.h"
+#include "vtkTimeStamp.h"
+
+struct vtkOrientedTimeVaryingGridTransformPhases;
+
+class VTK_ADDON_EXPORT vtkOrientedTimeVaryingGridTransform : public vtkOrientedGridTransform
+{
+public:
+  static vtkOrientedTimeVaryingGridTransform *New();
+  vtkTypeMacro(vtkOrientedTimeVaryingGridTransform,vtkOrientedGridTransform);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Add a phase grid (3-component image). All phase grids must have the
+  // extent, scalar type, origin and spacing of the first phase grid, which
+  // is also set as the displacement grid of the transform.
+  void AddPhaseGrid(vtkImageData* grid);
+
+  // Description:
+  // Remove all phase grids and the displacement grid.
+  void RemoveAllPhaseGrids();
+
+  // Description:
+  // Get the number of phase grids and a phase grid.
+  int GetNumberOfPhases();
+  vtkImageData* GetPhaseGrid(int phase);
+
+  // Description:
+  // Set/Get the time, in units of phases: time k selects phase k and
+  // non-integer times interpolate between adjacent phases. Only the
+  // blending weight is changed when the transform is updated after a
+  // time change (unless the transform is inverted and uses the inverse
+  // grid, or the hierarchical inverse is used). Do not change the time
+  // while the transform is evaluated.
+  // Default is 0.
+  void SetTime(double time);
+  vtkGetMacro(Time,double);
+
+  // Description:
+  // If enabled then the phases form a cycle: the time is wrapped to
+  // [0, number of phases) and times after the last phase interpolate
+  // between the last and the first phase. Otherwise the time is clamped
+  // to [0, number of phases - 1]. Default is on.
+  vtkSetMacro(Periodic,bool);
+  vtkGetMacro(Periodic,bool);
+  vtkBooleanMacro(Periodic,bool);
+
+  // Description:
+  // Set/Get the interpolation between phases (VTK_NEAREST_INTERPOLATION
+  // selects the closest phase, VTK_LINEAR_INTERPOLATION blends the
+  // adjacent phases). Default is linear.
+  vtkSetClampMacro(TimeInterpolationMode,int,VTK_NEAREST_INTERPOLATION,VTK_LINEAR_INTERPOLATION);
+  vtkGetMacro(TimeInterpolationMode,int);
+  void SetTimeInterpolationModeToNearestNeighbor() { this->SetTimeInterpolationMode(VTK_NEAREST_INTERPOLATION); };
+  void SetTimeInterpolationModeToLinear() { this->SetTimeInterpolationMode(VTK_LINEAR_INTERPOLATION); };
+
+  // Description:
+  // Get the modification time, including the phase grids.
+  vtkMTimeType GetMTime() override;
+
+  // Description:
+  // Make another transform of the same type.
+  vtkAbstractTransform *MakeTransform() override;
+
+protected:
+  vtkOrientedTimeVaryingGridTransform();
+  ~vtkOrientedTimeVaryingGridTransform() override;
+
+  // Description:
+  // Update the transform, or only the phases and the blending weight if
+  // only the time was changed since the last update.
+  void InternalUpdate() override;
+
+  // Description:
+  // Copy this transform from another of the same type.
+  void InternalDeepCopy(vtkAbstractTransform *transform) override;
+
+  // Description:
+  // Replace the displacement grid by the phase grids.
+  void UpdateGridStorage() override;
+
+  // Description:
+  // Select the phases and the blending weight at the current time.
+  void UpdatePhaseWeights();
+
+  // Description:
+  // Returns true if the transform was updated and only the time was
+  // changed since then.
+  bool IsOnlyTimeModified();
+
+  double Time;
+  bool Periodic;
+  int TimeInterpolationMode;
+
+  // Description:
+  // Phase grids, their scalar pointers and the blending state read by the
+  // interpolation function.
+  vtkOrientedTimeVaryingGridTransformPhases* Phases;
+
+  // Description:
+  // Time of the last full update and of the last time change; the time
+  // change did not invalidate the transform if TimeOnlyModified is set.
+  vtkTimeStamp PhasesUpdateTime;
+  vtkTimeStamp TimeModifiedTime;
+  bool TimeOnlyModified;
+
+private:
+  vtkOrientedTimeVaryingGridTransform(const vtkOrientedTimeVaryingGridTransform&) = delete;
+  void operator=(const vtkOrientedTimeVaryingGridTransform&) = delete;
+};
+
+#endif
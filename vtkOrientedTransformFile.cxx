@@ -0,0 +1,426 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTransformFile.h"
+
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkMatrix4x4.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+#include "vtkPointData.h"
+#include "vtkSmartPointer.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+vtkStandardNewMacro(vtkOrientedTransformFile);
+
+// Signature and version of the transform file format. Only files of this
+// version are read (files of version 1 lack the per-component scale and
+// shift, B-spline interpolation and half-float grid fields).
+static const char vtkOrientedTransformFileSignature[16] = "vtkOrientedXfm";
+static const vtkTypeInt32 vtkOrientedTransformFileVersion = 2;
+
+// Written as is, to detect files that were written with another byte order
+static const vtkTypeUInt32 vtkOrientedTransformFileByteOrder = 0x01020304;
+
+// Offset of the grid values in the file (size of the padded header).
+// The grid values start at a page boundary of the mapped file.
+static const vtkIdType vtkOrientedTransformFileGridOffset = 4096;
+
+// Transform types stored in the file
+enum
+{
+  vtkOrientedTransformFileGridTransform = 1,
+  vtkOrientedTransformFileBSplineTransform = 2
+};
+
+//----------------------------------------------------------------------------
+// Header at the beginning of the transform file.
+struct vtkOrientedTransformFileHeader
+{
+  char Signature[16];
+  vtkTypeUInt32 ByteOrder;
+  vtkTypeInt32 Version;
+  vtkTypeInt32 TransformType;
+  vtkTypeInt32 InverseFlag;
+  vtkTypeInt32 ScalarType;
+  vtkTypeInt32 NumberOfComponents;
+  vtkTypeInt32 Extent[6];
+  vtkTypeInt32 InterpolationMode;
+  vtkTypeInt32 BorderMode;
+  vtkTypeInt32 HasBulkTransform;
+  vtkTypeInt32 BSplineInterpolation;
+  double Origin[3];
+  double Spacing[3];
+  double Direction[9];
+  double BulkTransform[16];
+  double DisplacementScale;
+  double DisplacementShift;
+  vtkTypeInt64 GridOffset;
+  vtkTypeInt64 GridSize;
+  vtkTypeInt64 FileSize;
+  double DisplacementComponentScale[3];
+  double DisplacementComponentShift[3];
+  vtkTypeInt32 HalfFloatGrid;
+  vtkTypeInt32 Reserved;
+};
+
+//----------------------------------------------------------------------------
+// Check that the scalar type can be used for transform grids.
+static bool vtkOrientedTransformFileIsValidScalarType(int scalarType)
+{
+  return (scalarType == VTK_FLOAT || scalarType == VTK_DOUBLE
+    || scalarType == VTK_SHORT || scalarType == VTK_UNSIGNED_SHORT);
+}
+
+//----------------------------------------------------------------------------
+// Map a file copy-on-write: the mapped memory can be modified, but the
+// changes are not written to the file. Returns nullptr on error.
+static char* vtkOrientedTransformFileMap(const char* fileName, size_t& mappedSize)
+{
+  mappedSize = 0;
+#ifdef _WIN32
+  HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+    return nullptr;
+    }
+  LARGE_INTEGER fileSize;
+  HANDLE mappingHandle = nullptr;
+  void* mappedData = nullptr;
+  if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+    {
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    }
+  if (mappingHandle)
+    {
+    mappedData = MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+    // The view remains valid after the handles are closed
+    CloseHandle(mappingHandle);
+    }
+  CloseHandle(fileHandle);
+  if (!mappedData)
+    {
+    return nullptr;
+    }
+  mappedSize = static_cast<size_t>(fileSize.QuadPart);
+  return static_cast<char*>(mappedData);
+#else
+  int fileDescriptor = open(fileName, O_RDONLY);
+  if (fileDescriptor < 0)
+    {
+    return nullptr;
+    }
+  struct stat fileStatus;
+  void* mappedData = MAP_FAILED;
+  if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0)
+    {
+    mappedData = mmap(nullptr, fileStatus.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0);
+    }
+  // The mapping remains valid after the file is closed
+  close(fileDescriptor);
+  if (mappedData == MAP_FAILED)
+    {
+    return nullptr;
+    }
+  mappedSize = static_cast<size_t>(fileStatus.st_size);
+  return static_cast<char*>(mappedData);
+#endif
+}
+
+//----------------------------------------------------------------------------
+static void vtkOrientedTransformFileUnmap(char* mappedData, size_t mappedSize)
+{
+#ifdef _WIN32
+  (void)mappedSize;
+  UnmapViewOfFile(mappedData);
+#else
+  munmap(mappedData, mappedSize);
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Free function of the mapped grid scalars. The grid values are at a fixed
+// offset from the beginning of the mapping and the header stores the size
+// of the file (which is the size of the mapping).
+static void vtkOrientedTransformFileReleaseGrid(void* gridValues)
+{
+  if (!gridValues)
+    {
+    return;
+    }
+  char* mappedData = static_cast<char*>(gridValues) - vtkOrientedTransformFileGridOffset;
+  vtkOrientedTransformFileHeader header;
+  memcpy(&header, mappedData, sizeof(header));
+  vtkOrientedTransformFileUnmap(mappedData, static_cast<size_t>(header.FileSize));
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformFile::vtkOrientedTransformFile()
+= default;
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformFile::~vtkOrientedTransformFile()
+= default;
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformFile::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedTransformFile::WriteFile(const char* fileName, vtkAbstractTransform* transform)
+{
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(transform);
+  vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(transform);
+  if (!fileName || (!gridTransform && !bsplineTransform))
+    {
+    vtkGenericWarningMacro("vtkOrientedTransformFile::WriteFile: invalid file name or transform,"
+      " only vtkOrientedGridTransform and vtkOrientedBSplineTransform can be written");
+    return false;
+    }
+
+  vtkOrientedTransformFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.Signature, vtkOrientedTransformFileSignature, sizeof(header.Signature));
+  header.ByteOrder = vtkOrientedTransformFileByteOrder;
+  header.Version = vtkOrientedTransformFileVersion;
+
+  vtkImageData* grid = nullptr;
+  vtkMatrix4x4* gridDirection = nullptr;
+  vtkMatrix4x4* bulkTransform = nullptr;
+  if (gridTransform)
+    {
+    grid = gridTransform->GetDisplacementGrid();
+    gridDirection = gridTransform->GetGridDirectionMatrix();
+    header.TransformType = vtkOrientedTransformFileGridTransform;
+    header.InverseFlag = gridTransform->GetInverseFlag();
+    header.InterpolationMode = gridTransform->GetInterpolationMode();
+    header.DisplacementScale = gridTransform->GetDisplacementScale();
+    header.DisplacementShift = gridTransform->GetDisplacementShift();
+    header.BSplineInterpolation = gridTransform->GetBSplineInterpolation();
+    header.HalfFloatGrid = gridTransform->GetHalfFloatGrid();
+    gridTransform->GetDisplacementComponentScale(header.DisplacementComponentScale);
+    gridTransform->GetDisplacementComponentShift(header.DisplacementComponentShift);
+    }
+  else
+    {
+    grid = bsplineTransform->GetCoefficientData();
+    gridDirection = bsplineTransform->GetGridDirectionMatrix();
+    bulkTransform = bsplineTransform->GetBulkTransformMatrix();
+    header.TransformType = vtkOrientedTransformFileBSplineTransform;
+    header.InverseFlag = bsplineTransform->GetInverseFlag();
+    header.BorderMode = bsplineTransform->GetBorderMode();
+    header.DisplacementScale = bsplineTransform->GetDisplacementScale();
+    for (int i = 0; i < 3; i++)
+      {
+      header.DisplacementComponentScale[i] = 1.0;
+      }
+    }
+  if (!grid || !grid->GetScalarPointer() || grid->GetNumberOfScalarComponents() != 3
+    || !vtkOrientedTransformFileIsValidScalarType(grid->GetScalarType()))
+    {
+    vtkGenericWarningMacro("vtkOrientedTransformFile::WriteFile: the transform must have a 3-component"
+      " float, double, short or unsigned short grid image");
+    return false;
+    }
+
+  int* extent = grid->GetExtent();
+  header.ScalarType = grid->GetScalarType();
+  header.NumberOfComponents = 3;
+  for (int i = 0; i < 6; i++)
+    {
+    header.Extent[i] = extent[i];
+    }
+  for (int i = 0; i < 3; i++)
+    {
+    header.Origin[i] = grid->GetOrigin()[i];
+    header.Spacing[i] = grid->GetSpacing()[i];
+    for (int j = 0; j < 3; j++)
+      {
+      header.Direction[3*i+j] = (gridDirection ? gridDirection->GetElement(i, j) : (i == j ? 1.0 : 0.0));
+      }
+    }
+  header.HasBulkTransform = (bulkTransform != nullptr);
+  for (int i = 0; i < 4; i++)
+    {
+    for (int j = 0; j < 4; j++)
+      {
+      header.BulkTransform[4*i+j] = (bulkTransform ? bulkTransform->GetElement(i, j) : (i == j ? 1.0 : 0.0));
+      }
+    }
+  vtkIdType numberOfValues = static_cast<vtkIdType>(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1)
+    * (extent[5] - extent[4] + 1) * 3;
+  header.GridOffset = vtkOrientedTransformFileGridOffset;
+  header.GridSize = numberOfValues * grid->GetScalarSize();
+  header.FileSize = header.GridOffset + header.GridSize;
+
+  std::ofstream file(fileName, std::ios::out | std::ios::binary);
+  if (!file)
+    {
+    vtkGenericWarningMacro("vtkOrientedTransformFile::WriteFile: cannot open " << fileName);
+    return false;
+    }
+  std::vector<char> buffer(vtkOrientedTransformFileGridOffset, 0);
+  memcpy(&buffer[0], &header, sizeof(header));
+  file.write(&buffer[0], buffer.size());
+  file.write(static_cast<const char*>(grid->GetScalarPointer()), header.GridSize);
+  if (!file)
+    {
+    vtkGenericWarningMacro("vtkOrientedTransformFile::WriteFile: failed to write " << fileName);
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedTransformFile::ReadFile(const char* fileName, vtkAbstractTransform* transform)
+{
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(transform);
+  vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(transform);
+  if (!fileName || (!gridTransform && !bsplineTransform))
+    {
+    vtkGenericWarningMacro("vtkOrientedTransformFile::ReadFile: invalid file name or transform,"
+      " only vtkOrientedGridTransform and vtkOrientedBSplineTransform can be read");
+    return false;
+    }
+
+  size_t mappedSize = 0;
+  char* mappedData = vtkOrientedTransformFileMap(fileName, mappedSize);
+  if (!mappedData)
+    {
+    vtkGenericWarningMacro("vtkOrientedTransformFile::ReadFile: cannot map " << fileName);
+    return false;
+    }
+
+  // Read and validate the header
+  vtkOrientedTransformFileHeader header;
+  bool valid = (mappedSize >= static_cast<size_t>(vtkOrientedTransformFileGridOffset));
+  if (valid)
+    {
+    memcpy(&header, mappedData, sizeof(header));
+    valid = (memcmp(header.Signature, vtkOrientedTransformFileSignature, sizeof(header.Signature)) == 0
+      && header.ByteOrder == vtkOrientedTransformFileByteOrder
+      && header.Version == vtkOrientedTransformFileVersion
+      && vtkOrientedTransformFileIsValidScalarType(header.ScalarType)
+      && header.NumberOfComponents == 3
+      && header.Extent[0] <= header.Extent[1] && header.Extent[2] <= header.Extent[3]
+      && header.Extent[4] <= header.Extent[5]
+      && header.GridOffset == vtkOrientedTransformFileGridOffset
+      && header.FileSize == header.GridOffset + header.GridSize
+      && static_cast<vtkTypeInt64>(mappedSize) == header.FileSize);
+    }
+  if (valid)
+    {
+    vtkIdType numberOfValues = static_cast<vtkIdType>(header.Extent[1] - header.Extent[0] + 1)
+      * (header.Extent[3] - header.Extent[2] + 1) * (header.Extent[5] - header.Extent[4] + 1) * 3;
+    vtkSmartPointer<vtkDataArray> typeArray = vtkSmartPointer<vtkDataArray>::Take(
+      vtkDataArray::CreateDataArray(header.ScalarType));
+    valid = (header.GridSize == numberOfValues * typeArray->GetDataTypeSize());
+    }
+  if (!valid)
+    {
+    vtkOrientedTransformFileUnmap(mappedData, mappedSize);
+    vtkGenericWarningMacro("vtkOrientedTransformFile::ReadFile: " << fileName << " is not a valid transform file");
+    return false;
+    }
+  if ((header.TransformType == vtkOrientedTransformFileGridTransform && !gridTransform)
+    || (header.TransformType == vtkOrientedTransformFileBSplineTransform && !bsplineTransform))
+    {
+    vtkOrientedTransformFileUnmap(mappedData, mappedSize);
+    vtkGenericWarningMacro("vtkOrientedTransformFile::ReadFile: " << fileName
+      << " contains a different transform type than " << transform->GetClassName());
+    return false;
+    }
+
+  // The grid scalars use the mapped values and release the mapping
+  vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(header.ScalarType));
+  vtkIdType numberOfValues = header.GridSize / scalars->GetDataTypeSize();
+  scalars->SetNumberOfComponents(3);
+  scalars->SetVoidArray(mappedData + header.GridOffset, numberOfValues, 0,
+    vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+  scalars->SetArrayFreeFunction(&vtkOrientedTransformFileReleaseGrid);
+
+  vtkNew<vtkImageData> grid;
+  grid->SetExtent(header.Extent);
+  grid->SetOrigin(header.Origin);
+  grid->SetSpacing(header.Spacing);
+  grid->GetPointData()->SetScalars(scalars);
+
+  vtkNew<vtkMatrix4x4> gridDirection;
+  for (int i = 0; i < 3; i++)
+    {
+    for (int j = 0; j < 3; j++)
+      {
+      gridDirection->SetElement(i, j, header.Direction[3*i+j]);
+      }
+    }
+
+  vtkWarpTransform* warpTransform = nullptr;
+  if (gridTransform)
+    {
+    gridTransform->SetMappedDisplacementGrid(nullptr);
+    gridTransform->SetDisplacementGridData(grid);
+    gridTransform->SetGridDirectionMatrix(gridDirection);
+    gridTransform->SetInterpolationMode(header.InterpolationMode);
+    gridTransform->SetDisplacementScale(header.DisplacementScale);
+    gridTransform->SetDisplacementShift(header.DisplacementShift);
+    gridTransform->SetDisplacementComponentScale(header.DisplacementComponentScale);
+    gridTransform->SetDisplacementComponentShift(header.DisplacementComponentShift);
+    gridTransform->SetBSplineInterpolation(header.BSplineInterpolation != 0);
+    gridTransform->SetHalfFloatGrid(header.HalfFloatGrid != 0);
+    warpTransform = gridTransform;
+    }
+  else
+    {
+    bsplineTransform->SetCoefficientData(grid);
+    bsplineTransform->SetGridDirectionMatrix(gridDirection);
+    bsplineTransform->SetBorderMode(header.BorderMode);
+    bsplineTransform->SetDisplacementScale(header.DisplacementScale);
+    if (header.HasBulkTransform)
+      {
+      vtkNew<vtkMatrix4x4> bulkTransform;
+      for (int i = 0; i < 4; i++)
+        {
+        for (int j = 0; j < 4; j++)
+          {
+          bulkTransform->SetElement(i, j, header.BulkTransform[4*i+j]);
+          }
+        }
+      bsplineTransform->SetBulkTransformMatrix(bulkTransform);
+      }
+    else
+      {
+      bsplineTransform->SetBulkTransformMatrix(nullptr);
+      }
+    warpTransform = bsplineTransform;
+    }
+  if ((header.InverseFlag != 0) != (warpTransform->GetInverseFlag() != 0))
+    {
+    warpTransform->Inverse();
+    }
+  return true;
+}
@@ -0,0 +1,70 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkOrientedTransformFile - binary file format for oriented grid
+/// and b-spline transforms.
+///
+/// Stores a vtkOrientedGridTransform (displacement grid, scale, shift,
+/// per-component scale and shift, interpolation mode, B-spline
+/// interpolation and half-float grid) or a vtkOrientedBSplineTransform
+/// (coefficient grid, scale, border mode and BulkTransformMatrix) together
+/// with the grid geometry (origin, spacing, extent and GridDirectionMatrix)
+/// and the inverse flag.
+///
+/// The grid values follow a fixed size header and start at a page-aligned
+/// offset. When a file is read, it is memory-mapped and the mapped values
+/// are used directly as the grid scalars, without parsing or copying.
+/// The mapping is copy-on-write (modifying the grid does not change the
+/// file) and it is released when the grid scalars are deleted.
+///
+/// The file is stored in the native byte order, files that were written
+/// with a different byte order are rejected.
+///
+
+#ifndef __vtkOrientedTransformFile_h
+#define __vtkOrientedTransformFile_h
+
+#include "vtkAddon.h"
+
+#include "vtkObject.h"
+
+class vtkAbstractTransform;
+
+class VTK_ADDON_EXPORT vtkOrientedTransformFile : public vtkObject
+{
+public:
+  static vtkOrientedTransformFile *New();
+  vtkTypeMacro(vtkOrientedTransformFile,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Write a vtkOrientedGridTransform or vtkOrientedBSplineTransform to a
+  // file. The transform must have a 3-component displacement or
+  // coefficient grid image. Returns false on error.
+  static bool WriteFile(const char* fileName, vtkAbstractTransform* transform);
+
+  // Description:
+  // Memory-map a transform file and set it in a transform of the type that
+  // was written (vtkOrientedGridTransform or vtkOrientedBSplineTransform).
+  // The grid image of the transform is replaced by an image that uses the
+  // mapped values and all properties stored in the file are set. Returns
+  // false if the file cannot be mapped, it is not a valid transform file of
+  // the current format version or it contains a different transform type.
+  static bool ReadFile(const char* fileName, vtkAbstractTransform* transform);
+
+protected:
+  vtkOrientedTransformFile();
+  ~vtkOrientedTransformFile() override;
+
+private:
+  vtkOrientedTransformFile(const vtkOrientedTransformFile&) = delete;
+  void operator=(const vtkOrientedTransformFile&) = delete;
+};
+
+#endif
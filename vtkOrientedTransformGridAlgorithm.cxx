@@ -0,0 +1,105 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTransformGridAlgorithm.h"
+
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkOrientedTransformLattice.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+vtkCxxSetObjectMacro(vtkOrientedTransformGridAlgorithm,Input,vtkAbstractTransform);
+vtkCxxSetObjectMacro(vtkOrientedTransformGridAlgorithm,GridDirectionMatrix,vtkMatrix4x4);
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformGridAlgorithm::vtkOrientedTransformGridAlgorithm()
+{
+  this->Input = nullptr;
+
+  for (int i = 0; i < 3; i++)
+    {
+    this->GridExtent[2*i] = this->GridExtent[2*i+1] = 0;
+    this->GridOrigin[i] = 0.0;
+    this->GridSpacing[i] = 1.0;
+    }
+  this->GridDirectionMatrix = nullptr;
+
+  this->SetNumberOfInputPorts(0);
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformGridAlgorithm::~vtkOrientedTransformGridAlgorithm()
+{
+  this->SetInput(nullptr);
+  this->SetGridDirectionMatrix(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformGridAlgorithm::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Input: (" << this->Input << ")\n";
+  os << indent << "GridSpacing: (" << this->GridSpacing[0] << ", "
+     << this->GridSpacing[1] << ", " << this->GridSpacing[2] << ")\n";
+  os << indent << "GridOrigin: (" << this->GridOrigin[0] << ", "
+     << this->GridOrigin[1] << ", " << this->GridOrigin[2] << ")\n";
+  os << indent << "GridExtent: (" << this->GridExtent[0] << ", "
+     << this->GridExtent[1] << ", " << this->GridExtent[2] << ", "
+     << this->GridExtent[3] << ", " << this->GridExtent[4] << ", "
+     << this->GridExtent[5] << ")\n";
+  os << indent << "GridDirectionMatrix: " << this->GridDirectionMatrix << "\n";
+  if (this->GridDirectionMatrix)
+    {
+    this->GridDirectionMatrix->PrintSelf(os,indent.GetNextIndent());
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkOrientedTransformGridAlgorithm::GetMTime()
+{
+  vtkMTimeType mtime = this->Superclass::GetMTime();
+  if (this->Input)
+    {
+    vtkMTimeType mtime2 = this->Input->GetMTime();
+    if (mtime2 > mtime)
+      {
+      mtime = mtime2;
+      }
+    }
+  if (this->GridDirectionMatrix)
+    {
+    vtkMTimeType mtime2 = this->GridDirectionMatrix->GetMTime();
+    if (mtime2 > mtime)
+      {
+      mtime = mtime2;
+      }
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformGridAlgorithm::RequestInformation(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector),
+  vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), this->GridExtent, 6);
+  outInfo->Set(vtkDataObject::SPACING(), this->GridSpacing, 3);
+  outInfo->Set(vtkDataObject::ORIGIN(), this->GridOrigin, 3);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformGridAlgorithm::GetGridIndexToOutputMatrix(vtkMatrix4x4* gridIndexToOutput)
+{
+  vtkOrientedTransformLattice::GetLatticeToOutputMatrix(this->GridOrigin, this->GridSpacing,
+    this->GridDirectionMatrix, gridIndexToOutput);
+}
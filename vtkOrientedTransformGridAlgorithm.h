@@ -0,0 +1,112 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkOrientedTransformGridAlgorithm - superclass of the filters that
+/// sample a transform on an arbitrarily oriented grid.
+///
+/// Holds the input transform and the geometry of the output grid, and
+/// provides the evaluation of transforms that are not guaranteed to be
+/// thread-safe, point by point.
+///
+
+#ifndef __vtkOrientedTransformGridAlgorithm_h
+#define __vtkOrientedTransformGridAlgorithm_h
+
+#include "vtkAddon.h"
+
+#include "vtkAbstractTransform.h"
+#include "vtkImageAlgorithm.h"
+#include "vtkMatrix4x4.h"
+
+class VTK_ADDON_EXPORT vtkOrientedTransformGridAlgorithm : public vtkImageAlgorithm
+{
+public:
+  vtkTypeMacro(vtkOrientedTransformGridAlgorithm,vtkImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Set/Get the transform that will be sampled.
+  virtual void SetInput(vtkAbstractTransform*);
+  vtkGetObjectMacro(Input,vtkAbstractTransform);
+
+  // Description:
+  // Get/Set the extent of the output grid.
+  vtkSetVector6Macro(GridExtent,int);
+  vtkGetVector6Macro(GridExtent,int);
+
+  // Description:
+  // Get/Set the origin of the output grid.
+  vtkSetVector3Macro(GridOrigin,double);
+  vtkGetVector3Macro(GridOrigin,double);
+
+  // Description:
+  // Get/Set the spacing between samples in the output grid.
+  vtkSetVector3Macro(GridSpacing,double);
+  vtkGetVector3Macro(GridSpacing,double);
+
+  // Description:
+  // Set/Get the output grid axis directions.
+  // Must be an orthogonal, normalized matrix. The 4th column and 4th row
+  // are ignored. If not set then the grid axes are aligned with the
+  // coordinate system axes.
+  virtual void SetGridDirectionMatrix(vtkMatrix4x4*);
+  vtkGetObjectMacro(GridDirectionMatrix,vtkMatrix4x4);
+
+  // Description:
+  // Get the modification time, including the input transform and
+  // the grid direction matrix.
+  vtkMTimeType GetMTime() override;
+
+protected:
+  vtkOrientedTransformGridAlgorithm();
+  ~vtkOrientedTransformGridAlgorithm() override;
+
+  // Description:
+  // Set the whole extent, spacing and origin of the output grid.
+  int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+
+  // Description:
+  // Compute the transform from grid index to output coordinates.
+  void GetGridIndexToOutputMatrix(vtkMatrix4x4* gridIndexToOutput);
+
+  // Description:
+  // Call evaluatePoint(point) with the output coordinates of each grid
+  // point of the extent, in memory order. Transforms are not guaranteed
+  // to be thread-safe, therefore the points are evaluated serially.
+  template <class PointFunctor>
+  void EvaluateInputPointByPoint(const int extent[6], vtkMatrix4x4* gridIndexToOutput, PointFunctor evaluatePoint)
+    {
+    this->Input->Update();
+    for (int k = extent[4]; k <= extent[5]; k++)
+      {
+      for (int j = extent[2]; j <= extent[3]; j++)
+        {
+        for (int i = extent[0]; i <= extent[1]; i++)
+          {
+          double point[4] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k), 1.0 };
+          gridIndexToOutput->MultiplyPoint(point, point);
+          evaluatePoint(point);
+          }
+        }
+      }
+    }
+
+  vtkAbstractTransform *Input;
+
+  int GridExtent[6];
+  double GridOrigin[3];
+  double GridSpacing[3];
+  vtkMatrix4x4 *GridDirectionMatrix;
+
+private:
+  vtkOrientedTransformGridAlgorithm(const vtkOrientedTransformGridAlgorithm&) = delete;
+  void operator=(const vtkOrientedTransformGridAlgorithm&) = delete;
+};
+
+#endif
@@ -0,0 +1,191 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTransformInverseStatistics.h"
+
+#include "vtkObjectFactory.h"
+
+vtkStandardNewMacro(vtkOrientedTransformInverseStatistics);
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformInverseStatistics::vtkOrientedTransformInverseStatistics()
+{
+  this->Reset();
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformInverseStatistics::~vtkOrientedTransformInverseStatistics()
+= default;
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformInverseStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "NumberOfCalls: " << this->GetNumberOfCalls() << "\n";
+  os << indent << "NumberOfIterations: " << this->GetNumberOfIterations() << "\n";
+  os << indent << "MeanNumberOfIterations: " << this->GetMeanNumberOfIterations() << "\n";
+  os << indent << "NumberOfFailures: " << this->GetNumberOfFailures() << "\n";
+  os << indent << "MaximumResidual: " << this->GetMaximumResidual() << "\n";
+  os << indent << "IterationHistogram:";
+  for (int bin = 0; bin < NumberOfIterationHistogramBins; bin++)
+    {
+    os << " " << this->IterationHistogram[bin].load();
+    }
+  os << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformInverseStatistics::Reset()
+{
+  this->NumberOfCalls = 0;
+  this->NumberOfIterations = 0;
+  this->NumberOfFailures = 0;
+  this->MaximumResidual = 0.0;
+  for (int bin = 0; bin < NumberOfIterationHistogramBins; bin++)
+    {
+    this->IterationHistogram[bin] = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkOrientedTransformInverseStatistics::GetNumberOfCalls()
+{
+  return this->NumberOfCalls.load();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkOrientedTransformInverseStatistics::GetNumberOfIterations()
+{
+  return this->NumberOfIterations.load();
+}
+
+//----------------------------------------------------------------------------
+double vtkOrientedTransformInverseStatistics::GetMeanNumberOfIterations()
+{
+  vtkIdType numberOfCalls = this->NumberOfCalls.load();
+  if (numberOfCalls == 0)
+    {
+    return 0.0;
+    }
+  return static_cast<double>(this->NumberOfIterations.load()) / numberOfCalls;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkOrientedTransformInverseStatistics::GetNumberOfFailures()
+{
+  return this->NumberOfFailures.load();
+}
+
+//----------------------------------------------------------------------------
+double vtkOrientedTransformInverseStatistics::GetMaximumResidual()
+{
+  return this->MaximumResidual.load();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkOrientedTransformInverseStatistics::GetIterationHistogramCount(int numberOfIterations)
+{
+  if (numberOfIterations < 0)
+    {
+    return 0;
+    }
+  return this->IterationHistogram[GetHistogramBin(numberOfIterations)].load();
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformInverseStatistics::GetHistogramBin(int numberOfIterations)
+{
+  if (numberOfIterations < 0)
+    {
+    return 0;
+    }
+  if (numberOfIterations >= NumberOfIterationHistogramBins)
+    {
+    return NumberOfIterationHistogramBins - 1;
+    }
+  return numberOfIterations;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformInverseStatistics::UpdateMaximumResidual(double residual)
+{
+  double currentMaximum = this->MaximumResidual.load(std::memory_order_relaxed);
+  while (residual > currentMaximum
+    && !this->MaximumResidual.compare_exchange_weak(currentMaximum, residual, std::memory_order_relaxed))
+    {
+    // currentMaximum has been updated by compare_exchange_weak, try again
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedTransformInverseStatistics::AddCall(int numberOfIterations, bool converged, double residual,
+  vtkIdType eventInterval)
+{
+  this->NumberOfIterations.fetch_add(numberOfIterations, std::memory_order_relaxed);
+  this->IterationHistogram[GetHistogramBin(numberOfIterations)].fetch_add(1, std::memory_order_relaxed);
+  if (!converged)
+    {
+    this->NumberOfFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+  this->UpdateMaximumResidual(residual);
+  vtkIdType numberOfCalls = this->NumberOfCalls.fetch_add(1, std::memory_order_relaxed) + 1;
+  return (eventInterval > 0 && numberOfCalls % eventInterval == 0);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedTransformInverseStatistics::AddCalls(const Accumulator& accumulator, vtkIdType eventInterval)
+{
+  if (accumulator.NumberOfCalls == 0)
+    {
+    return false;
+    }
+  this->NumberOfIterations.fetch_add(accumulator.NumberOfIterations, std::memory_order_relaxed);
+  for (int bin = 0; bin < NumberOfIterationHistogramBins; bin++)
+    {
+    if (accumulator.IterationHistogram[bin] > 0)
+      {
+      this->IterationHistogram[bin].fetch_add(accumulator.IterationHistogram[bin], std::memory_order_relaxed);
+      }
+    }
+  this->NumberOfFailures.fetch_add(accumulator.NumberOfFailures, std::memory_order_relaxed);
+  this->UpdateMaximumResidual(accumulator.MaximumResidual);
+  vtkIdType previousNumberOfCalls = this->NumberOfCalls.fetch_add(accumulator.NumberOfCalls, std::memory_order_relaxed);
+  return (eventInterval > 0
+    && previousNumberOfCalls / eventInterval != (previousNumberOfCalls + accumulator.NumberOfCalls) / eventInterval);
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformInverseStatistics::Accumulator::Accumulator()
+  : NumberOfCalls(0)
+  , NumberOfIterations(0)
+  , NumberOfFailures(0)
+  , MaximumResidual(0.0)
+{
+  for (int bin = 0; bin < NumberOfIterationHistogramBins; bin++)
+    {
+    this->IterationHistogram[bin] = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformInverseStatistics::Accumulator::AddCall(int numberOfIterations, bool converged, double residual)
+{
+  this->NumberOfCalls++;
+  this->NumberOfIterations += numberOfIterations;
+  this->IterationHistogram[GetHistogramBin(numberOfIterations)]++;
+  if (!converged)
+    {
+    this->NumberOfFailures++;
+    }
+  if (residual > this->MaximumResidual)
+    {
+    this->MaximumResidual = residual;
+    }
+}
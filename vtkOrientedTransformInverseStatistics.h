@@ -0,0 +1,121 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkOrientedTransformInverseStatistics - convergence statistics of
+/// iterative inverse transform computations.
+///
+/// Keeps track of the number of inverse computations, the total number of
+/// iterations, a histogram of the number of iterations per computation,
+/// the number of convergence failures, and the maximum residual error.
+/// Counters are updated atomically, so the statistics can be collected
+/// from multiple threads.
+///
+
+#ifndef __vtkOrientedTransformInverseStatistics_h
+#define __vtkOrientedTransformInverseStatistics_h
+
+#include "vtkAddon.h"
+
+#include "vtkObject.h"
+
+// STD includes
+#include <atomic>
+
+class VTK_ADDON_EXPORT vtkOrientedTransformInverseStatistics : public vtkObject
+{
+public:
+  static vtkOrientedTransformInverseStatistics *New();
+  vtkTypeMacro(vtkOrientedTransformInverseStatistics,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Number of bins in the iteration histogram.
+  // The last bin counts all computations that required at least
+  // NumberOfIterationHistogramBins-1 iterations.
+  enum
+    {
+    NumberOfIterationHistogramBins = 32
+    };
+
+  // Description:
+  // Set all counters to zero.
+  void Reset();
+
+  // Description:
+  // Number of inverse computations.
+  vtkIdType GetNumberOfCalls();
+
+  // Description:
+  // Total number of iterations of all inverse computations.
+  vtkIdType GetNumberOfIterations();
+
+  // Description:
+  // Mean number of iterations per inverse computation.
+  double GetMeanNumberOfIterations();
+
+  // Description:
+  // Number of inverse computations that did not converge.
+  vtkIdType GetNumberOfFailures();
+
+  // Description:
+  // Maximum residual error of all inverse computations.
+  double GetMaximumResidual();
+
+  // Description:
+  // Number of inverse computations that required numberOfIterations
+  // iterations (see NumberOfIterationHistogramBins).
+  vtkIdType GetIterationHistogramCount(int numberOfIterations);
+
+  // Description:
+  // Record one inverse computation. Thread-safe.
+  // Returns true if the number of calls reached a multiple of eventInterval
+  // (if eventInterval is larger than 0).
+  bool AddCall(int numberOfIterations, bool converged, double residual, vtkIdType eventInterval = 0);
+
+#ifndef __VTK_WRAP__
+  // Description:
+  // Statistics accumulated locally (for example in a thread), without
+  // atomic operations, and then added with AddCalls.
+  struct Accumulator
+    {
+    Accumulator();
+    void AddCall(int numberOfIterations, bool converged, double residual);
+    vtkIdType NumberOfCalls;
+    vtkIdType NumberOfIterations;
+    vtkIdType NumberOfFailures;
+    double MaximumResidual;
+    vtkIdType IterationHistogram[NumberOfIterationHistogramBins];
+    };
+
+  // Description:
+  // Add locally accumulated statistics. Thread-safe.
+  // Returns true if the number of calls reached or passed a multiple of
+  // eventInterval (if eventInterval is larger than 0).
+  bool AddCalls(const Accumulator& accumulator, vtkIdType eventInterval = 0);
+#endif
+
+protected:
+  vtkOrientedTransformInverseStatistics();
+  ~vtkOrientedTransformInverseStatistics() override;
+
+  static int GetHistogramBin(int numberOfIterations);
+  void UpdateMaximumResidual(double residual);
+
+  std::atomic<vtkIdType> NumberOfCalls;
+  std::atomic<vtkIdType> NumberOfIterations;
+  std::atomic<vtkIdType> NumberOfFailures;
+  std::atomic<double> MaximumResidual;
+  std::atomic<vtkIdType> IterationHistogram[NumberOfIterationHistogramBins];
+
+private:
+  vtkOrientedTransformInverseStatistics(const vtkOrientedTransformInverseStatistics&) = delete;
+  void operator=(const vtkOrientedTransformInverseStatistics&) = delete;
+};
+
+#endif
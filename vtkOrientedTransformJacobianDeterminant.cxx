@@ -0,0 +1,200 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTransformJacobianDeterminant.h"
+
+#include "vtkAbstractTransform.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMath.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+#include "vtkPointData.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+#include <algorithm>
+
+vtkStandardNewMacro(vtkOrientedTransformJacobianDeterminant);
+
+//----------------------------------------------------------------------------
+// Per-thread statistics of the determinant values
+struct vtkOrientedTransformJacobianDeterminantStatistics
+{
+  double Minimum = VTK_DOUBLE_MAX;
+  double Maximum = VTK_DOUBLE_MIN;
+  vtkIdType NumberOfFoldedPoints = 0;
+};
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformJacobianDeterminant::vtkOrientedTransformJacobianDeterminant()
+{
+  this->ComputeStatistics = false;
+  this->MinimumDeterminant = 0.0;
+  this->MaximumDeterminant = 0.0;
+  this->NumberOfFoldedPoints = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformJacobianDeterminant::~vtkOrientedTransformJacobianDeterminant()
+= default;
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformJacobianDeterminant::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "ComputeStatistics: " << (this->ComputeStatistics ? "On" : "Off") << "\n";
+  os << indent << "MinimumDeterminant: " << this->MinimumDeterminant << "\n";
+  os << indent << "MaximumDeterminant: " << this->MaximumDeterminant << "\n";
+  os << indent << "NumberOfFoldedPoints: " << this->NumberOfFoldedPoints << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformJacobianDeterminant::RequestInformation(
+  vtkInformation* request,
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  if (!this->Superclass::RequestInformation(request, inputVector, outputVector))
+    {
+    return 0;
+    }
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_DOUBLE, 1);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformJacobianDeterminant::RequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector),
+  vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* output = vtkImageData::GetData(outInfo);
+  if (!output)
+    {
+    vtkErrorMacro("RequestData: invalid output");
+    return 0;
+    }
+
+  this->MinimumDeterminant = 0.0;
+  this->MaximumDeterminant = 0.0;
+  this->NumberOfFoldedPoints = 0;
+
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+  output->SetExtent(extent);
+  output->SetOrigin(this->GridOrigin);
+  output->SetSpacing(this->GridSpacing);
+  if (extent[1] < extent[0] || extent[3] < extent[2] || extent[5] < extent[4])
+    {
+    return 1;
+    }
+  int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+  // Grid index to output transform
+  vtkNew<vtkMatrix4x4> gridIndexToOutput;
+  this->GetGridIndexToOutputMatrix(gridIndexToOutput);
+
+  // Position of the first sample of the requested extent
+  double extentOrigin[4] = { static_cast<double>(extent[0]), static_cast<double>(extent[2]), static_cast<double>(extent[4]), 1.0 };
+  gridIndexToOutput->MultiplyPoint(extentOrigin, extentOrigin);
+
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(this->Input);
+  vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(this->Input);
+
+  vtkNew<vtkImageData> determinantImage;
+  if (!this->Input)
+    {
+    // Identity transform
+    determinantImage->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+    determinantImage->AllocateScalars(VTK_DOUBLE, 1);
+    determinantImage->GetPointData()->GetScalars()->Fill(1.0);
+    }
+  else if (gridTransform)
+    {
+    if (!gridTransform->EvaluateJacobianDeterminantOnGrid(extentOrigin, this->GridSpacing, this->GridDirectionMatrix,
+      dimensions, determinantImage))
+      {
+      vtkErrorMacro("RequestData: failed to evaluate grid transform");
+      return 0;
+      }
+    }
+  else if (bsplineTransform)
+    {
+    if (!bsplineTransform->EvaluateJacobianDeterminantOnGrid(extentOrigin, this->GridSpacing, this->GridDirectionMatrix,
+      dimensions, determinantImage))
+      {
+      vtkErrorMacro("RequestData: failed to evaluate b-spline transform");
+      return 0;
+      }
+    }
+  else
+    {
+    // Generic transform
+    determinantImage->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+    determinantImage->AllocateScalars(VTK_DOUBLE, 1);
+    double* determinantPtr = static_cast<double*>(determinantImage->GetScalarPointer());
+    this->EvaluateInputPointByPoint(extent, gridIndexToOutput, [&](const double point[3])
+      {
+      double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+      double derivative[3][3];
+      this->Input->InternalTransformDerivative(point, transformedPoint, derivative);
+      *(determinantPtr++) = vtkMath::Determinant3x3(derivative);
+      });
+    }
+
+  vtkDataArray* determinantScalars = determinantImage->GetPointData()->GetScalars();
+  output->GetPointData()->SetScalars(determinantScalars);
+
+  if (this->ComputeStatistics)
+    {
+    this->UpdateStatistics(static_cast<double*>(determinantImage->GetScalarPointer()),
+      determinantScalars->GetNumberOfValues());
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformJacobianDeterminant::UpdateStatistics(const double* determinant, vtkIdType numberOfValues)
+{
+  vtkSMPThreadLocal<vtkOrientedTransformJacobianDeterminantStatistics> statisticsLocal;
+  vtkSMPTools::For(0, numberOfValues, [&](vtkIdType begin, vtkIdType end)
+    {
+    vtkOrientedTransformJacobianDeterminantStatistics& statistics = statisticsLocal.Local();
+    for (vtkIdType i = begin; i < end; i++)
+      {
+      double value = determinant[i];
+      statistics.Minimum = std::min(statistics.Minimum, value);
+      statistics.Maximum = std::max(statistics.Maximum, value);
+      if (value <= 0.0)
+        {
+        statistics.NumberOfFoldedPoints++;
+        }
+      }
+    });
+
+  vtkOrientedTransformJacobianDeterminantStatistics total;
+  for (const vtkOrientedTransformJacobianDeterminantStatistics& statistics : statisticsLocal)
+    {
+    total.Minimum = std::min(total.Minimum, statistics.Minimum);
+    total.Maximum = std::max(total.Maximum, statistics.Maximum);
+    total.NumberOfFoldedPoints += statistics.NumberOfFoldedPoints;
+    }
+  this->MinimumDeterminant = total.Minimum;
+  this->MaximumDeterminant = total.Maximum;
+  this->NumberOfFoldedPoints = total.NumberOfFoldedPoints;
+}
@@ -0,0 +1,75 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkOrientedTransformJacobianDeterminant - compute the Jacobian
+/// determinant of a transform, on an arbitrarily oriented grid.
+///
+/// Samples the determinant of the Jacobian matrix of a transform onto an
+/// oriented output grid and produces a 1-component double image.
+/// Values below 1 indicate local contraction, values above 1 local
+/// expansion and values at or below 0 indicate folding.
+/// vtkOrientedGridTransform and vtkOrientedBSplineTransform are evaluated
+/// in parallel (see EvaluateJacobianDeterminantOnGrid). Any other transform
+/// is evaluated point by point.
+///
+/// Optionally the minimum and maximum determinant and the number of folded
+/// points are computed.
+///
+
+#ifndef __vtkOrientedTransformJacobianDeterminant_h
+#define __vtkOrientedTransformJacobianDeterminant_h
+
+#include "vtkAddon.h"
+
+#include "vtkOrientedTransformGridAlgorithm.h"
+
+class VTK_ADDON_EXPORT vtkOrientedTransformJacobianDeterminant : public vtkOrientedTransformGridAlgorithm
+{
+public:
+  static vtkOrientedTransformJacobianDeterminant *New();
+  vtkTypeMacro(vtkOrientedTransformJacobianDeterminant,vtkOrientedTransformGridAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // If enabled then the minimum and maximum determinant and the number of
+  // folded points (determinant <= 0) are computed when the output is updated.
+  // Default is off.
+  vtkSetMacro(ComputeStatistics,bool);
+  vtkGetMacro(ComputeStatistics,bool);
+  vtkBooleanMacro(ComputeStatistics,bool);
+
+  // Description:
+  // Get the statistics of the last update. Only valid if ComputeStatistics
+  // was enabled.
+  vtkGetMacro(MinimumDeterminant,double);
+  vtkGetMacro(MaximumDeterminant,double);
+  vtkGetMacro(NumberOfFoldedPoints,vtkIdType);
+
+protected:
+  vtkOrientedTransformJacobianDeterminant();
+  ~vtkOrientedTransformJacobianDeterminant() override;
+
+  int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+
+  // Description:
+  // Compute the statistics of the determinant values.
+  void UpdateStatistics(const double* determinant, vtkIdType numberOfValues);
+
+  bool ComputeStatistics;
+  double MinimumDeterminant;
+  double MaximumDeterminant;
+  vtkIdType NumberOfFoldedPoints;
+
+private:
+  vtkOrientedTransformJacobianDeterminant(const vtkOrientedTransformJacobianDeterminant&) = delete;
+  void operator=(const vtkOrientedTransformJacobianDeterminant&) = delete;
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTransformLattice.h"
+
+#include "vtkMatrix4x4.h"
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformLattice::GetLatticeToOutputMatrix(const double origin[3], const double spacing[3],
+  vtkMatrix4x4* direction, vtkMatrix4x4* latticeToOutput)
+{
+  latticeToOutput->Identity();
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      latticeToOutput->SetElement(row, col,
+        spacing[col] * (direction ? direction->GetElement(row, col) : (row == col ? 1.0 : 0.0)));
+      }
+    latticeToOutput->SetElement(row, 3, origin[row]);
+    }
+}
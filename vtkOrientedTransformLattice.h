@@ -0,0 +1,59 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#ifndef __vtkOrientedTransformLattice_h
+#define __vtkOrientedTransformLattice_h
+
+#include "vtkAddon.h"
+
+#include "vtkSMPTools.h"
+
+class vtkMatrix4x4;
+
+/// This module provides functions to evaluate oriented transforms on a
+/// regular lattice of points.
+///
+/// A lattice is defined by an origin, a spacing and optional axis
+/// directions, as the output grids of vtkOrientedTransformToGrid and the
+/// EvaluateOnGrid methods of the oriented transforms.
+
+namespace vtkOrientedTransformLattice
+{
+
+/// Compute the transform from lattice index to output coordinates.
+/// The direction must be an orthogonal, normalized matrix, its 4th column
+/// and 4th row are ignored. If the direction is nullptr then the lattice
+/// axes are aligned with the coordinate system axes.
+VTK_ADDON_EXPORT
+void GetLatticeToOutputMatrix(const double origin[3], const double spacing[3],
+                              vtkMatrix4x4* direction, vtkMatrix4x4* latticeToOutput);
+
+/// Call evaluateSlices(sliceBegin, sliceEnd) to evaluate a transform on
+/// numberOfSlices lattice slices.
+/// The inverse of the transform reports convergence failures, so it is
+/// evaluated serially unless thread-safe evaluation is enabled. Slices are
+/// otherwise evaluated in parallel, and the events that were deferred
+/// during the evaluation are invoked afterwards.
+/// The transform must provide GetInverseFlag(), GetThreadSafeEvaluation()
+/// and InvokePendingEvents().
+template <class TransformType, class SliceFunctor>
+void EvaluateSlices(TransformType* transform, vtkIdType numberOfSlices, SliceFunctor& evaluateSlices)
+{
+  if (transform->GetInverseFlag() && !transform->GetThreadSafeEvaluation())
+    {
+    evaluateSlices(0, numberOfSlices);
+    return;
+    }
+  vtkSMPTools::For(0, numberOfSlices, evaluateSlices);
+  transform->InvokePendingEvents();
+}
+
+} // namespace vtkOrientedTransformLattice
+
+#endif
@@ -0,0 +1,379 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTransformResample.h"
+
+#include "vtkAbstractTransform.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+#include "vtkOrientedTransformLattice.h"
+#include "vtkSMPTools.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+vtkStandardNewMacro(vtkOrientedTransformResample);
+
+vtkCxxSetObjectMacro(vtkOrientedTransformResample,Transform,vtkAbstractTransform);
+vtkCxxSetObjectMacro(vtkOrientedTransformResample,OutputDirectionMatrix,vtkMatrix4x4);
+
+// Input points that are closer to the input extent than this tolerance
+// (in voxels) are clamped to the extent instead of set to the background.
+static const double vtkOrientedTransformResampleTolerance = 1e-6;
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformResample::vtkOrientedTransformResample()
+{
+  this->Transform = nullptr;
+
+  for (int i = 0; i < 3; i++)
+    {
+    this->OutputExtent[2*i] = this->OutputExtent[2*i+1] = 0;
+    this->OutputOrigin[i] = 0.0;
+    this->OutputSpacing[i] = 1.0;
+    }
+  this->OutputDirectionMatrix = nullptr;
+
+  this->InterpolationMode = VTK_LINEAR_INTERPOLATION;
+  this->BackgroundValue = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformResample::~vtkOrientedTransformResample()
+{
+  this->SetTransform(nullptr);
+  this->SetOutputDirectionMatrix(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformResample::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Transform: (" << this->Transform << ")\n";
+  os << indent << "OutputSpacing: (" << this->OutputSpacing[0] << ", "
+     << this->OutputSpacing[1] << ", " << this->OutputSpacing[2] << ")\n";
+  os << indent << "OutputOrigin: (" << this->OutputOrigin[0] << ", "
+     << this->OutputOrigin[1] << ", " << this->OutputOrigin[2] << ")\n";
+  os << indent << "OutputExtent: (" << this->OutputExtent[0] << ", "
+     << this->OutputExtent[1] << ", " << this->OutputExtent[2] << ", "
+     << this->OutputExtent[3] << ", " << this->OutputExtent[4] << ", "
+     << this->OutputExtent[5] << ")\n";
+  os << indent << "OutputDirectionMatrix: " << this->OutputDirectionMatrix << "\n";
+  if (this->OutputDirectionMatrix)
+    {
+    this->OutputDirectionMatrix->PrintSelf(os,indent.GetNextIndent());
+    }
+  os << indent << "InterpolationMode: "
+     << (this->InterpolationMode == VTK_NEAREST_INTERPOLATION ? "NearestNeighbor" : "Linear") << "\n";
+  os << indent << "BackgroundValue: " << this->BackgroundValue << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkOrientedTransformResample::GetMTime()
+{
+  vtkMTimeType mtime = this->Superclass::GetMTime();
+  if (this->Transform)
+    {
+    vtkMTimeType mtime2 = this->Transform->GetMTime();
+    if (mtime2 > mtime)
+      {
+      mtime = mtime2;
+      }
+    }
+  if (this->OutputDirectionMatrix)
+    {
+    vtkMTimeType mtime2 = this->OutputDirectionMatrix->GetMTime();
+    if (mtime2 > mtime)
+      {
+      mtime = mtime2;
+      }
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformResample::RequestInformation(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector),
+  vtkInformationVector* outputVector)
+{
+  // The scalar type and number of components are copied from the input
+  // by vtkImageAlgorithm
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), this->OutputExtent, 6);
+  outInfo->Set(vtkDataObject::SPACING(), this->OutputSpacing, 3);
+  outInfo->Set(vtkDataObject::ORIGIN(), this->OutputOrigin, 3);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformResample::RequestUpdateExtent(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* vtkNotUsed(outputVector))
+{
+  // Any part of the input may be needed, depending on the transform
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  int wholeExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), wholeExtent, 6);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+inline T vtkOrientedTransformResampleCast(double value)
+{
+  if (!std::numeric_limits<T>::is_integer)
+    {
+    return static_cast<T>(value);
+    }
+  // Round and clamp to the range of integer types
+  value = std::max(value, static_cast<double>(std::numeric_limits<T>::lowest()));
+  value = std::min(value, static_cast<double>(std::numeric_limits<T>::max()));
+  return static_cast<T>(std::floor(value + 0.5));
+}
+
+//----------------------------------------------------------------------------
+// Interpolate the input image at continuous index positions (3 values per
+// point) and store the values in an output row.
+template <class T>
+void vtkOrientedTransformResampleRow(const double *inputIndexes, int numberOfPoints,
+  const T *inPtr, const int inExt[6], const vtkIdType inInc[3], int numberOfComponents,
+  int interpolationMode, double backgroundValue, T *outPtr)
+{
+  T background = vtkOrientedTransformResampleCast<T>(backgroundValue);
+  for (int n = 0; n < numberOfPoints; n++, inputIndexes += 3, outPtr += numberOfComponents)
+    {
+    bool inside = true;
+    double f[3];
+    vtkIdType offset0[3], offset1[3];
+    for (int i = 0; i < 3 && inside; i++)
+      {
+      double index = inputIndexes[i];
+      if (index < inExt[2*i] - vtkOrientedTransformResampleTolerance
+        || index > inExt[2*i+1] + vtkOrientedTransformResampleTolerance)
+        {
+        inside = false;
+        break;
+        }
+      int ext = inExt[2*i+1] - inExt[2*i];
+      int id0 = 0;
+      if (interpolationMode == VTK_NEAREST_INTERPOLATION)
+        {
+        id0 = vtkMath::Floor(index + 0.5) - inExt[2*i];
+        f[i] = 0;
+        }
+      else
+        {
+        int floorIndex = vtkMath::Floor(index);
+        id0 = floorIndex - inExt[2*i];
+        f[i] = index - floorIndex;
+        }
+      int id1 = id0 + 1;
+      if (id0 < 0)
+        {
+        id0 = id1 = 0;
+        f[i] = 0;
+        }
+      else if (id1 > ext)
+        {
+        id0 = id1 = ext;
+        f[i] = 0;
+        }
+      offset0[i] = id0*inInc[i];
+      offset1[i] = id1*inInc[i];
+      }
+
+    if (!inside)
+      {
+      std::fill(outPtr, outPtr + numberOfComponents, background);
+      continue;
+      }
+
+    if (interpolationMode == VTK_NEAREST_INTERPOLATION)
+      {
+      const T *v = inPtr + offset0[0] + offset0[1] + offset0[2];
+      std::copy(v, v + numberOfComponents, outPtr);
+      continue;
+      }
+
+    double rx = 1 - f[0];
+    double ry = 1 - f[1];
+    double rz = 1 - f[2];
+
+    double ryrz = ry*rz;
+    double ryfz = ry*f[2];
+    double fyrz = f[1]*rz;
+    double fyfz = f[1]*f[2];
+
+    const T *v000 = inPtr + offset0[0] + offset0[1] + offset0[2];
+    const T *v001 = inPtr + offset0[0] + offset0[1] + offset1[2];
+    const T *v010 = inPtr + offset0[0] + offset1[1] + offset0[2];
+    const T *v011 = inPtr + offset0[0] + offset1[1] + offset1[2];
+    const T *v100 = inPtr + offset1[0] + offset0[1] + offset0[2];
+    const T *v101 = inPtr + offset1[0] + offset0[1] + offset1[2];
+    const T *v110 = inPtr + offset1[0] + offset1[1] + offset0[2];
+    const T *v111 = inPtr + offset1[0] + offset1[1] + offset1[2];
+
+    for (int c = 0; c < numberOfComponents; c++)
+      {
+      double value = (rx*(ryrz*v000[c] + ryfz*v001[c] + fyrz*v010[c] + fyfz*v011[c]) +
+                      f[0]*(ryrz*v100[c] + ryfz*v101[c] + fyrz*v110[c] + fyfz*v111[c]));
+      outPtr[c] = vtkOrientedTransformResampleCast<T>(value);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformResample::RequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* output = vtkImageData::GetData(outInfo);
+  if (!input || !output)
+    {
+    vtkErrorMacro("RequestData: invalid input or output");
+    return 0;
+    }
+
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+  output->SetExtent(extent);
+  output->SetOrigin(this->OutputOrigin);
+  output->SetSpacing(this->OutputSpacing);
+  if (extent[1] < extent[0] || extent[3] < extent[2] || extent[5] < extent[4])
+    {
+    return 1;
+    }
+  int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+  int scalarType = input->GetScalarType();
+  int numberOfComponents = input->GetNumberOfScalarComponents();
+  output->AllocateScalars(scalarType, numberOfComponents);
+
+  int* inExt = input->GetExtent();
+  if (inExt[1] < inExt[0] || inExt[3] < inExt[2] || inExt[5] < inExt[4])
+    {
+    vtkErrorMacro("RequestData: input image is empty");
+    return 0;
+    }
+  vtkIdType inInc[3] = { 0, 0, 0 };
+  input->GetIncrements(inInc);
+  void* inPtr = input->GetScalarPointerForExtent(inExt);
+  void* outPtr = output->GetScalarPointer();
+  double* inOrigin = input->GetOrigin();
+  double* inSpacing = input->GetSpacing();
+
+  // Output index to output transform
+  vtkNew<vtkMatrix4x4> outputIndexToOutput;
+  vtkOrientedTransformLattice::GetLatticeToOutputMatrix(this->OutputOrigin, this->OutputSpacing,
+    this->OutputDirectionMatrix, outputIndexToOutput);
+  const double (*outputIndexToOutputMatrix)[4] = outputIndexToOutput->Element;
+  double rowStep[3] = { outputIndexToOutputMatrix[0][0], outputIndexToOutputMatrix[1][0], outputIndexToOutputMatrix[2][0] };
+
+  if (this->Transform)
+    {
+    this->Transform->Update();
+    }
+
+  // Non-inverted grid transforms are evaluated along output rows
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(this->Transform);
+  vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(this->Transform);
+  bool lineEvaluation = (gridTransform != nullptr && gridTransform->SupportsLineEvaluation());
+
+  // Resample output rows rowBegin to rowEnd (rows are numbered slice by slice)
+  vtkIdType rowSize = static_cast<vtkIdType>(dimensions[0]) * numberOfComponents;
+  vtkIdType numberOfRows = static_cast<vtkIdType>(dimensions[1]) * dimensions[2];
+  auto resampleRows = [&](vtkIdType rowBegin, vtkIdType rowEnd)
+    {
+    std::vector<double> rowPoints(3*dimensions[0]);
+    std::vector<double> displacements(3*dimensions[0], 0.0);
+    for (vtkIdType rowIndex = rowBegin; rowIndex < rowEnd; rowIndex++)
+      {
+      vtkIdType j = rowIndex % dimensions[1];
+      vtkIdType k = rowIndex / dimensions[1];
+      double rowStart[4] = { static_cast<double>(extent[0]), static_cast<double>(extent[2] + j),
+        static_cast<double>(extent[4] + k), 1.0 };
+      outputIndexToOutput->MultiplyPoint(rowStart, rowStart);
+
+      if (lineEvaluation)
+        {
+        gridTransform->EvaluateDisplacementsAlongLine(rowStart, rowStep, dimensions[0], displacements.data());
+        }
+
+      // Continuous input index of each transformed point along the row
+      double point[3] = { rowStart[0], rowStart[1], rowStart[2] };
+      for (int i = 0; i < dimensions[0]; i++)
+        {
+        double* inputIndex = &rowPoints[3*i];
+        if (lineEvaluation || !this->Transform)
+          {
+          for (int c = 0; c < 3; c++)
+            {
+            inputIndex[c] = point[c] + displacements[3*i+c];
+            }
+          }
+        else
+          {
+          this->Transform->InternalTransformPoint(point, inputIndex);
+          }
+        for (int c = 0; c < 3; c++)
+          {
+          inputIndex[c] = (inputIndex[c] - inOrigin[c]) / inSpacing[c];
+          point[c] += rowStep[c];
+          }
+        }
+
+      vtkIdType rowOffset = rowIndex * rowSize;
+      switch (scalarType)
+        {
+        vtkTemplateMacro(vtkOrientedTransformResampleRow(rowPoints.data(), dimensions[0],
+          static_cast<const VTK_TT*>(inPtr), inExt, inInc, numberOfComponents,
+          this->InterpolationMode, this->BackgroundValue, static_cast<VTK_TT*>(outPtr) + rowOffset));
+        }
+      }
+    };
+
+  if (lineEvaluation || !this->Transform)
+    {
+    vtkSMPTools::For(0, numberOfRows, resampleRows);
+    }
+  else if (gridTransform)
+    {
+    // The inverse is evaluated in parallel in thread-safe evaluation mode
+    vtkOrientedTransformLattice::EvaluateSlices(gridTransform, numberOfRows, resampleRows);
+    }
+  else if (bsplineTransform)
+    {
+    vtkOrientedTransformLattice::EvaluateSlices(bsplineTransform, numberOfRows, resampleRows);
+    }
+  else
+    {
+    // Generic transform: evaluated serially, as transforms are not
+    // guaranteed to be thread-safe
+    resampleRows(0, numberOfRows);
+    }
+  return 1;
+}
@@ -0,0 +1,123 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkOrientedTransformResample - resample an image through a
+/// transform, on an arbitrarily oriented output grid.
+///
+/// Each output voxel is set to the value of the input image at the
+/// transformed output voxel position, similarly to vtkImageReslice with a
+/// reslice transform. The input image is interpolated with nearest
+/// neighbor or trilinear interpolation, points outside the input extent are
+/// set to BackgroundValue. The output has the scalar type and number of
+/// components of the input.
+///
+/// Output rows are processed in parallel. A non-inverted
+/// vtkOrientedGridTransform is evaluated along the rows (see
+/// vtkOrientedGridTransform::EvaluateDisplacementsAlongLine): grid index
+/// coordinates are advanced incrementally. Other transforms are evaluated
+/// point by point. The inverse of vtkOrientedGridTransform and
+/// vtkOrientedBSplineTransform is only evaluated in parallel if
+/// ThreadSafeEvaluation is enabled on the transform, and other transform
+/// classes are evaluated serially, as they are not guaranteed to be
+/// thread-safe.
+///
+/// vtkImageData does not store axis directions, therefore the input image
+/// is assumed to be axis-aligned and the output grid direction is only
+/// used for computing the output voxel positions.
+///
+
+#ifndef __vtkOrientedTransformResample_h
+#define __vtkOrientedTransformResample_h
+
+#include "vtkAddon.h"
+
+#include "vtkImageAlgorithm.h"
+
+class vtkAbstractTransform;
+class vtkMatrix4x4;
+
+class VTK_ADDON_EXPORT vtkOrientedTransformResample : public vtkImageAlgorithm
+{
+public:
+  static vtkOrientedTransformResample *New();
+  vtkTypeMacro(vtkOrientedTransformResample,vtkImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Set/Get the transform that maps output points to input points.
+  // If not set then the identity transform is used.
+  virtual void SetTransform(vtkAbstractTransform*);
+  vtkGetObjectMacro(Transform,vtkAbstractTransform);
+
+  // Description:
+  // Get/Set the extent of the output grid.
+  vtkSetVector6Macro(OutputExtent,int);
+  vtkGetVector6Macro(OutputExtent,int);
+
+  // Description:
+  // Get/Set the origin of the output grid.
+  vtkSetVector3Macro(OutputOrigin,double);
+  vtkGetVector3Macro(OutputOrigin,double);
+
+  // Description:
+  // Get/Set the spacing between samples in the output grid.
+  vtkSetVector3Macro(OutputSpacing,double);
+  vtkGetVector3Macro(OutputSpacing,double);
+
+  // Description:
+  // Set/Get the output grid axis directions.
+  // Must be an orthogonal, normalized matrix. The 4th column and 4th row
+  // are ignored. If not set then the grid axes are aligned with the
+  // coordinate system axes.
+  virtual void SetOutputDirectionMatrix(vtkMatrix4x4*);
+  vtkGetObjectMacro(OutputDirectionMatrix,vtkMatrix4x4);
+
+  // Description:
+  // Set/Get the interpolation mode of the input image
+  // (VTK_NEAREST_INTERPOLATION or VTK_LINEAR_INTERPOLATION).
+  // Default is linear.
+  vtkSetClampMacro(InterpolationMode,int,VTK_NEAREST_INTERPOLATION,VTK_LINEAR_INTERPOLATION);
+  vtkGetMacro(InterpolationMode,int);
+  void SetInterpolationModeToNearestNeighbor() { this->SetInterpolationMode(VTK_NEAREST_INTERPOLATION); };
+  void SetInterpolationModeToLinear() { this->SetInterpolationMode(VTK_LINEAR_INTERPOLATION); };
+
+  // Description:
+  // Set/Get the value of output voxels that are mapped outside the input
+  // image. Default is 0.
+  vtkSetMacro(BackgroundValue,double);
+  vtkGetMacro(BackgroundValue,double);
+
+  // Description:
+  // Get the modification time, including the transform and the output
+  // direction matrix.
+  vtkMTimeType GetMTime() override;
+
+protected:
+  vtkOrientedTransformResample();
+  ~vtkOrientedTransformResample() override;
+
+  int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+  int RequestUpdateExtent(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+
+  vtkAbstractTransform *Transform;
+
+  int OutputExtent[6];
+  double OutputOrigin[3];
+  double OutputSpacing[3];
+  vtkMatrix4x4 *OutputDirectionMatrix;
+  int InterpolationMode;
+  double BackgroundValue;
+
+private:
+  vtkOrientedTransformResample(const vtkOrientedTransformResample&) = delete;
+  void operator=(const vtkOrientedTransformResample&) = delete;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkOrientedTransformToGrid.h"
+
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+#include "vtkPointData.h"
+#include "vtkSMPTools.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+vtkStandardNewMacro(vtkOrientedTransformToGrid);
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformToGrid::vtkOrientedTransformToGrid()
+{
+  this->GridScalarType = VTK_DOUBLE;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedTransformToGrid::~vtkOrientedTransformToGrid()
+= default;
+
+//----------------------------------------------------------------------------
+void vtkOrientedTransformToGrid::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "GridScalarType: " << vtkImageScalarTypeNameMacro(this->GridScalarType) << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformToGrid::RequestInformation(
+  vtkInformation* request,
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  if (this->GridScalarType != VTK_FLOAT && this->GridScalarType != VTK_DOUBLE)
+    {
+    vtkErrorMacro("RequestInformation: GridScalarType must be VTK_FLOAT or VTK_DOUBLE");
+    return 0;
+    }
+
+  if (!this->Superclass::RequestInformation(request, inputVector, outputVector))
+    {
+    return 0;
+    }
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, this->GridScalarType, 3);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformToGrid::RequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector),
+  vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* output = vtkImageData::GetData(outInfo);
+  if (!output)
+    {
+    vtkErrorMacro("RequestData: invalid output");
+    return 0;
+    }
+
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+  output->SetExtent(extent);
+  output->SetOrigin(this->GridOrigin);
+  output->SetSpacing(this->GridSpacing);
+  if (extent[1] < extent[0] || extent[3] < extent[2] || extent[5] < extent[4])
+    {
+    return 1;
+    }
+  int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+  // Grid index to output transform
+  vtkNew<vtkMatrix4x4> gridIndexToOutput;
+  this->GetGridIndexToOutputMatrix(gridIndexToOutput);
+
+  // Position of the first sample of the requested extent
+  double extentOrigin[4] = { static_cast<double>(extent[0]), static_cast<double>(extent[2]), static_cast<double>(extent[4]), 1.0 };
+  gridIndexToOutput->MultiplyPoint(extentOrigin, extentOrigin);
+
+  if (!this->Input)
+    {
+    output->AllocateScalars(this->GridScalarType, 3);
+    output->GetPointData()->GetScalars()->Fill(0.0);
+    return 1;
+    }
+
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(this->Input);
+  vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(this->Input);
+
+  vtkNew<vtkImageData> field;
+  if (gridTransform)
+    {
+    if (!gridTransform->EvaluateOnGrid(extentOrigin, this->GridSpacing, this->GridDirectionMatrix, dimensions, field))
+      {
+      vtkErrorMacro("RequestData: failed to evaluate grid transform");
+      return 0;
+      }
+    }
+  else if (bsplineTransform)
+    {
+    if (!bsplineTransform->EvaluateOnGrid(extentOrigin, this->GridSpacing, this->GridDirectionMatrix, dimensions, field))
+      {
+      vtkErrorMacro("RequestData: failed to evaluate b-spline transform");
+      return 0;
+      }
+    }
+  else
+    {
+    // Generic transform
+    field->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+    field->AllocateScalars(VTK_DOUBLE, 3);
+    double* fieldPtr = static_cast<double*>(field->GetScalarPointer());
+    this->EvaluateInputPointByPoint(extent, gridIndexToOutput, [&](const double point[3])
+      {
+      double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+      this->Input->InternalTransformPoint(point, transformedPoint);
+      fieldPtr[0] = transformedPoint[0] - point[0];
+      fieldPtr[1] = transformedPoint[1] - point[1];
+      fieldPtr[2] = transformedPoint[2] - point[2];
+      fieldPtr += 3;
+      });
+    }
+
+  vtkDataArray* fieldScalars = field->GetPointData()->GetScalars();
+  if (this->GridScalarType == VTK_DOUBLE)
+    {
+    // The field is already in the requested type, no need to copy it
+    output->GetPointData()->SetScalars(fieldScalars);
+    return 1;
+    }
+
+  output->AllocateScalars(this->GridScalarType, 3);
+  const double* fieldPtr = static_cast<double*>(field->GetScalarPointer());
+  float* outPtr = static_cast<float*>(output->GetScalarPointer());
+  vtkSMPTools::For(0, fieldScalars->GetNumberOfValues(), [&](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType i = begin; i < end; i++)
+      {
+      outPtr[i] = static_cast<float>(fieldPtr[i]);
+      }
+    });
+  return 1;
+}
@@ -0,0 +1,61 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkOrientedTransformToGrid - create a displacement field from a
+/// transform, on an arbitrarily oriented grid.
+///
+/// Samples a transform onto an oriented output grid and produces a
+/// 3-component image that contains the displacement (output point minus
+/// input point) at each voxel.
+/// vtkOrientedGridTransform and vtkOrientedBSplineTransform are sampled in
+/// parallel, using their cached grid index transforms (see EvaluateOnGrid).
+/// Any other transform is sampled point by point.
+///
+/// vtkImageData does not store axis directions, therefore the output must
+/// be used with the same GridDirectionMatrix, for example in a
+/// vtkOrientedGridTransform.
+///
+
+#ifndef __vtkOrientedTransformToGrid_h
+#define __vtkOrientedTransformToGrid_h
+
+#include "vtkAddon.h"
+
+#include "vtkOrientedTransformGridAlgorithm.h"
+
+class VTK_ADDON_EXPORT vtkOrientedTransformToGrid : public vtkOrientedTransformGridAlgorithm
+{
+public:
+  static vtkOrientedTransformToGrid *New();
+  vtkTypeMacro(vtkOrientedTransformToGrid,vtkOrientedTransformGridAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Get/Set the scalar type of the output grid (VTK_FLOAT or VTK_DOUBLE).
+  // Default is VTK_DOUBLE.
+  vtkSetMacro(GridScalarType,int);
+  vtkGetMacro(GridScalarType,int);
+  void SetGridScalarTypeToFloat() { this->SetGridScalarType(VTK_FLOAT); };
+  void SetGridScalarTypeToDouble() { this->SetGridScalarType(VTK_DOUBLE); };
+
+protected:
+  vtkOrientedTransformToGrid();
+  ~vtkOrientedTransformToGrid() override;
+
+  int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+
+  int GridScalarType;
+
+private:
+  vtkOrientedTransformToGrid(const vtkOrientedTransformToGrid&) = delete;
+  void operator=(const vtkOrientedTransformToGrid&) = delete;
+};
+
+#endif
@@ -21,16 +21,100 @@ Care Ontario.
 // vtkAddon includes
 #include "vtkRawRGBVolumeCodec.h"
 
+// VTK includes
+#include <vtkFieldData.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
 vtkCodecNewMacro(vtkRawRGBVolumeCodec);
 
+namespace
+{
+  const char* const RESOLUTION_LEVELS_PARAMETER = "ResolutionLevels";
+  const int MAXIMUM_NUMBER_OF_RESOLUTION_LEVELS = 8;
+
+  // Progressive frames start with a header: the signature, the number of resolution levels and 3 reserved bytes.
+  // The header is part of the frame data, so that the levels can be decoded after the frame has been transmitted.
+  const char PROGRESSIVE_FRAME_SIGNATURE[4] = { 'R', 'V', 'P', 'L' };
+  const vtkIdType PROGRESSIVE_FRAME_HEADER_SIZE = 8;
+
+  // Name of the field data array that stores the resolution level stride that was applied to the spacing of a decoded image
+  const char* const RESOLUTION_LEVEL_STRIDE_ARRAY_NAME = "ResolutionLevelStride";
+
+  /// Number of voxels on the sampling grid of the specified stride
+  vtkIdType GetNumberOfSampledVoxels(const int dimensions[3], int stride)
+  {
+    return static_cast<vtkIdType>((dimensions[0] - 1) / stride + 1) * ((dimensions[1] - 1) / stride + 1)
+      * ((dimensions[2] - 1) / stride + 1);
+  }
+
+  /// Byte offset of each resolution level in the frame data of a progressive frame
+  /// The coarsest level contains all voxels of its sampling grid, each finer level contains
+  /// the voxels of its sampling grid that are not contained in the next coarser grid.
+  std::vector<vtkIdType> GetProgressiveLevelOffsets(const int dimensions[3], int numberOfLevels, int bytesPerVoxel)
+  {
+    std::vector<vtkIdType> levelOffsets;
+    vtkIdType offset = PROGRESSIVE_FRAME_HEADER_SIZE;
+    for (int level = 0; level < numberOfLevels; ++level)
+      {
+      levelOffsets.push_back(offset);
+      int stride = 1 << (numberOfLevels - 1 - level);
+      vtkIdType numberOfLevelVoxels = GetNumberOfSampledVoxels(dimensions, stride);
+      if (level > 0)
+        {
+        numberOfLevelVoxels -= GetNumberOfSampledVoxels(dimensions, 2 * stride);
+        }
+      offset += numberOfLevelVoxels * bytesPerVoxel;
+      }
+    return levelOffsets;
+  }
+}
+
 //---------------------------------------------------------------------------
 vtkRawRGBVolumeCodec::vtkRawRGBVolumeCodec()
-= default;
+  : NumberOfResolutionLevels(1)
+{
+  this->AvailiableParameterNames.push_back(RESOLUTION_LEVELS_PARAMETER);
+}
 
 //---------------------------------------------------------------------------
 vtkRawRGBVolumeCodec::~vtkRawRGBVolumeCodec()
 = default;
 
+//---------------------------------------------------------------------------
+bool vtkRawRGBVolumeCodec::UpdateParameterInternal(std::string parameterName, std::string parameterValue)
+{
+  if (parameterName == RESOLUTION_LEVELS_PARAMETER)
+    {
+    std::stringstream ss(parameterValue);
+    int numberOfLevels = 0;
+    if (!(ss >> numberOfLevels) || numberOfLevels < 1 || numberOfLevels > MAXIMUM_NUMBER_OF_RESOLUTION_LEVELS)
+      {
+      vtkErrorMacro("Invalid number of resolution levels: " << parameterValue);
+      return false;
+      }
+    this->NumberOfResolutionLevels = numberOfLevels;
+    return true;
+    }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+std::string vtkRawRGBVolumeCodec::GetParameterDescription(std::string parameterName)
+{
+  if (parameterName == RESOLUTION_LEVELS_PARAMETER)
+    {
+    return "Number of resolution levels stored in each frame (1-8). Values greater than 1 enable progressive encoding.";
+    }
+  return "";
+}
+
 //---------------------------------------------------------------------------
 bool vtkRawRGBVolumeCodec::DecodeFrameInternal(vtkStreamingVolumeFrame* inputFrame, vtkImageData* outputImageData, bool vtkNotUsed(saveDecodedImage))
 {
@@ -43,14 +127,12 @@ bool vtkRawRGBVolumeCodec::DecodeFrameInternal(vtkStreamingVolumeFrame* inputFra
   if (inputFrame->GetVTKScalarType() != VTK_UNSIGNED_CHAR || inputFrame->GetNumberOfComponents() != 3)
     {
     vtkErrorMacro("Codec only supports encoding and decoding of 8-bit color images");
+    return false;
     }
 
   int frameDimensions[3] = { 0,0,0 };
   inputFrame->GetDimensions(frameDimensions);
 
-  int imageDimensions[3] = { 0,0,0 };
-  outputImageData->GetDimensions(imageDimensions);
-
   unsigned int numberOfVoxels = frameDimensions[0] * frameDimensions[1] * frameDimensions[2];
   if (numberOfVoxels == 0)
     {
@@ -58,43 +140,171 @@ bool vtkRawRGBVolumeCodec::DecodeFrameInternal(vtkStreamingVolumeFrame* inputFra
     return false;
     }
 
-  for (int i = 0; i < 3; ++i)
+  vtkUnsignedCharArray* frameData = inputFrame->GetFrameData();
+  if (!frameData)
+    {
+    vtkErrorMacro("Cannot decode frame, frame data is missing");
+    return false;
+    }
+  unsigned char* framePointer = frameData->GetPointer(0);
+  vtkIdType frameSize = frameData->GetNumberOfValues();
+  int bytesPerVoxel = inputFrame->GetNumberOfComponents();
+  vtkIdType numberOfBytes = static_cast<vtkIdType>(numberOfVoxels) * bytesPerVoxel;
+
+  // Raw frames contain exactly the voxels of the image, progressive frames start with a header
+  int numberOfLevels = 1;
+  if (frameSize != numberOfBytes && frameSize >= PROGRESSIVE_FRAME_HEADER_SIZE
+    && memcmp(framePointer, PROGRESSIVE_FRAME_SIGNATURE, sizeof(PROGRESSIVE_FRAME_SIGNATURE)) == 0)
     {
-    if (frameDimensions[i] != imageDimensions[i])
+    numberOfLevels = framePointer[sizeof(PROGRESSIVE_FRAME_SIGNATURE)];
+    if (numberOfLevels < 2 || numberOfLevels > MAXIMUM_NUMBER_OF_RESOLUTION_LEVELS)
       {
-      vtkErrorMacro("Cannot decode frame, voxel size does not match image");
+      vtkErrorMacro("Cannot decode frame, invalid number of resolution levels: " << numberOfLevels);
       return false;
       }
     }
+  else if (frameSize < numberOfBytes)
+    {
+    vtkErrorMacro("Cannot decode frame, frame data is incomplete");
+    return false;
+    }
 
-  vtkUnsignedCharArray* frameData = inputFrame->GetFrameData();
-  void* framePointer = frameData->GetPointer(0);
-  void* imagePointer = outputImageData->GetScalarPointer();
+  // The level table is computed from the frame header, the frame is not modified
+  std::vector<vtkIdType> levelOffsets;
+  if (numberOfLevels > 1)
+    {
+    levelOffsets = GetProgressiveLevelOffsets(frameDimensions, numberOfLevels, bytesPerVoxel);
+    }
+
+  int maximumLevel = this->MaximumDecodedResolutionLevel;
+  if (maximumLevel < 0 || maximumLevel >= numberOfLevels)
+    {
+    maximumLevel = numberOfLevels - 1;
+    }
+
+  // Reduced resolution images are resized to fit the decoded levels
+  int outputStride = 1 << (numberOfLevels - 1 - maximumLevel);
+  int outputDimensions[3] = { 0,0,0 };
+  for (int i = 0; i < 3; ++i)
+    {
+    outputDimensions[i] = (frameDimensions[i] - 1) / outputStride + 1;
+    }
+
+  int imageDimensions[3] = { 0,0,0 };
+  outputImageData->GetDimensions(imageDimensions);
+  if (imageDimensions[0] != outputDimensions[0] || imageDimensions[1] != outputDimensions[1]
+    || imageDimensions[2] != outputDimensions[2] || !outputImageData->GetPointData()->GetScalars()
+    || outputImageData->GetScalarType() != VTK_UNSIGNED_CHAR
+    || outputImageData->GetNumberOfScalarComponents() != bytesPerVoxel)
+    {
+    outputImageData->SetDimensions(outputDimensions);
+    outputImageData->AllocateScalars(VTK_UNSIGNED_CHAR, bytesPerVoxel);
+    }
+
+  // The spacing of reduced resolution images is multiplied by the stride. The applied stride is stored
+  // in the field data of the image, so that the spacing is restored when a finer level is decoded.
+  int previousStride = 1;
+  vtkIntArray* strideArray = vtkIntArray::SafeDownCast(
+    outputImageData->GetFieldData()->GetArray(RESOLUTION_LEVEL_STRIDE_ARRAY_NAME));
+  if (strideArray && strideArray->GetNumberOfValues() > 0 && strideArray->GetValue(0) > 0)
+    {
+    previousStride = strideArray->GetValue(0);
+    }
+  if (previousStride != outputStride)
+    {
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    outputImageData->GetSpacing(spacing);
+    for (int i = 0; i < 3; ++i)
+      {
+      spacing[i] *= static_cast<double>(outputStride) / previousStride;
+      }
+    outputImageData->SetSpacing(spacing);
+    if (!strideArray)
+      {
+      vtkNew<vtkIntArray> newStrideArray;
+      newStrideArray->SetName(RESOLUTION_LEVEL_STRIDE_ARRAY_NAME);
+      outputImageData->GetFieldData()->AddArray(newStrideArray);
+      strideArray = newStrideArray;
+      }
+    strideArray->SetNumberOfValues(1);
+    strideArray->SetValue(0, outputStride);
+    }
 
-  unsigned int numberOfBytes = frameDimensions[0] * frameDimensions[1] * frameDimensions[2] * inputFrame->GetNumberOfComponents();
-  memcpy(imagePointer, framePointer, numberOfBytes);
+  unsigned char* imagePointer = static_cast<unsigned char*>(outputImageData->GetScalarPointer());
+  if (numberOfLevels == 1)
+    {
+    memcpy(imagePointer, framePointer, numberOfBytes);
+    return true;
+    }
+
+  vtkIdType requiredNumberOfBytes = PROGRESSIVE_FRAME_HEADER_SIZE + numberOfBytes;
+  if (maximumLevel + 1 < numberOfLevels)
+    {
+    requiredNumberOfBytes = levelOffsets[maximumLevel + 1];
+    }
+  if (frameSize < requiredNumberOfBytes)
+    {
+    vtkErrorMacro("Cannot decode frame, frame does not contain the requested resolution levels");
+    return false;
+    }
+
+  // Each level contains the voxels on its sampling grid that are not already contained in a coarser level
+  for (int level = 0; level <= maximumLevel; ++level)
+    {
+    unsigned char* levelPointer = framePointer + levelOffsets[level];
+    int stride = 1 << (numberOfLevels - 1 - level);
+    int coarserStride = 2 * stride;
+    for (int k = 0; k < frameDimensions[2]; k += stride)
+      {
+      for (int j = 0; j < frameDimensions[1]; j += stride)
+        {
+        bool coarserRow = level > 0 && k % coarserStride == 0 && j % coarserStride == 0;
+        int iStart = coarserRow ? stride : 0;
+        int iStep = coarserRow ? coarserStride : stride;
+        unsigned char* outputRowPointer = imagePointer +
+          ((vtkIdType)(k / outputStride) * outputDimensions[1] + j / outputStride) * outputDimensions[0] * bytesPerVoxel;
+        for (int i = iStart; i < frameDimensions[0]; i += iStep)
+          {
+          memcpy(outputRowPointer + (i / outputStride) * bytesPerVoxel, levelPointer, bytesPerVoxel);
+          levelPointer += bytesPerVoxel;
+          }
+        }
+      }
+    }
 
   return true;
 }
 
 //---------------------------------------------------------------------------
-bool vtkRawRGBVolumeCodec::EncodeImageDataInternal(vtkImageData* inputImageData, vtkStreamingVolumeFrame* outputFrame, bool vtkNotUsed(forceKeyFrame))
+bool vtkRawRGBVolumeCodec::EncodeImageDataInternal(vtkImageData* inputImageData, vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame)
 {
   if (!inputImageData || !outputFrame)
     {
     vtkErrorMacro("Incorrect arguments!");
     return false;
     }
+  return this->EncodeImageExtentInternal(inputImageData, inputImageData->GetExtent(), outputFrame, forceKeyFrame);
+}
+
+//---------------------------------------------------------------------------
+bool vtkRawRGBVolumeCodec::EncodeImageExtentInternal(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputFrame, bool vtkNotUsed(forceKeyFrame))
+{
+  if (!inputImageData || !extent || !outputFrame)
+    {
+    vtkErrorMacro("Incorrect arguments!");
+    return false;
+    }
 
   if (inputImageData->GetScalarType() != VTK_UNSIGNED_CHAR || inputImageData->GetNumberOfScalarComponents() != 3)
     {
     vtkErrorMacro("Codec only supports encoding and decoding of 8-bit color images");
     }
 
-  void* imagePointer = inputImageData->GetScalarPointer();
-
   int dimensions[3] = { 0,0,0 };
-  inputImageData->GetDimensions(dimensions);
+  for (int i = 0; i < 3; ++i)
+    {
+    dimensions[i] = std::max(extent[2 * i + 1] - extent[2 * i] + 1, 0);
+    }
   unsigned int numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
   if (numberOfVoxels == 0)
     {
@@ -102,13 +312,67 @@ bool vtkRawRGBVolumeCodec::EncodeImageDataInternal(vtkImageData* inputImageData,
     return false;
     }
 
-  unsigned int numberOfBytes = numberOfVoxels * inputImageData->GetNumberOfScalarComponents();
+  // The region is read in place: rows are contiguous, but rows and slices may be separated by the rest of the image
+  unsigned char* imagePointer = static_cast<unsigned char*>(inputImageData->GetScalarPointerForExtent(extent));
+  vtkIdType increments[3] = { 0,0,0 };
+  inputImageData->GetIncrements(increments);
+  int bytesPerVoxel = inputImageData->GetNumberOfScalarComponents();
+  vtkIdType rowIncrement = increments[1] * inputImageData->GetScalarSize();
+  vtkIdType sliceIncrement = increments[2] * inputImageData->GetScalarSize();
+  unsigned int numberOfBytes = numberOfVoxels * bytesPerVoxel;
+  vtkIdType frameSize = numberOfBytes;
+  if (this->NumberOfResolutionLevels > 1)
+    {
+    frameSize += PROGRESSIVE_FRAME_HEADER_SIZE;
+    }
 
   vtkSmartPointer<vtkUnsignedCharArray> frameData = vtkSmartPointer<vtkUnsignedCharArray>::New();
-  frameData->Allocate(numberOfBytes);
+  frameData->SetNumberOfValues(frameSize);
+
+  unsigned char* framePointer = frameData->GetPointer(0);
+  std::vector<vtkIdType> levelOffsets;
+  if (this->NumberOfResolutionLevels == 1)
+    {
+    size_t rowSize = dimensions[0] * bytesPerVoxel;
+    for (int k = 0; k < dimensions[2]; ++k)
+      {
+      for (int j = 0; j < dimensions[1]; ++j)
+        {
+        memcpy(framePointer, imagePointer + k * sliceIncrement + j * rowIncrement, rowSize);
+        framePointer += rowSize;
+        }
+      }
+    }
+  else
+    {
+    memset(framePointer, 0, PROGRESSIVE_FRAME_HEADER_SIZE);
+    memcpy(framePointer, PROGRESSIVE_FRAME_SIGNATURE, sizeof(PROGRESSIVE_FRAME_SIGNATURE));
+    framePointer[sizeof(PROGRESSIVE_FRAME_SIGNATURE)] = static_cast<unsigned char>(this->NumberOfResolutionLevels);
 
-  void* framePointer = frameData->GetPointer(0);
-  memcpy(framePointer, imagePointer, numberOfBytes);
+    // Store the coarsest level first, followed by the voxels that are added by each finer level
+    vtkIdType offset = PROGRESSIVE_FRAME_HEADER_SIZE;
+    for (int level = 0; level < this->NumberOfResolutionLevels; ++level)
+      {
+      levelOffsets.push_back(offset);
+      int stride = 1 << (this->NumberOfResolutionLevels - 1 - level);
+      int coarserStride = 2 * stride;
+      for (int k = 0; k < dimensions[2]; k += stride)
+        {
+        for (int j = 0; j < dimensions[1]; j += stride)
+          {
+          bool coarserRow = level > 0 && k % coarserStride == 0 && j % coarserStride == 0;
+          int iStart = coarserRow ? stride : 0;
+          int iStep = coarserRow ? coarserStride : stride;
+          unsigned char* inputRowPointer = imagePointer + k * sliceIncrement + j * rowIncrement;
+          for (int i = iStart; i < dimensions[0]; i += iStep)
+            {
+            memcpy(framePointer + offset, inputRowPointer + i * bytesPerVoxel, bytesPerVoxel);
+            offset += bytesPerVoxel;
+            }
+          }
+        }
+      }
+    }
 
   outputFrame->SetFrameData(frameData);
   outputFrame->SetVTKScalarType(VTK_UNSIGNED_CHAR);
@@ -117,6 +381,7 @@ bool vtkRawRGBVolumeCodec::EncodeImageDataInternal(vtkImageData* inputImageData,
   outputFrame->SetFrameType(vtkStreamingVolumeFrame::IFrame);
   outputFrame->SetCodecFourCC(this->GetFourCC());
   outputFrame->SetPreviousFrame(nullptr);
+  outputFrame->SetResolutionLevelOffsets(levelOffsets);
 
   return true;
 }
@@ -125,4 +390,5 @@ bool vtkRawRGBVolumeCodec::EncodeImageDataInternal(vtkImageData* inputImageData,
 void vtkRawRGBVolumeCodec::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfResolutionLevels:\t" << this->NumberOfResolutionLevels << std::endl;
 }
@@ -25,6 +25,12 @@ Care Ontario.
 #include "vtkStreamingVolumeCodec.h"
 
 /// \brief Codec for storing imagedata in an 24-bit RGB format (8-bit color depth, no compression)
+///
+/// If the "ResolutionLevels" parameter is greater than 1, frames are encoded progressively:
+/// the voxels are reordered so that a coarse subsampled image is stored first, followed by the refinement levels.
+/// The frame data of progressive frames starts with a header that stores the number of levels, so that
+/// transmitted frames can be decoded without any other information than the frame dimensions.
+/// \sa vtkStreamingVolumeCodec::SetMaximumDecodedResolutionLevel()
 class VTK_ADDON_EXPORT vtkRawRGBVolumeCodec : public vtkStreamingVolumeCodec
 {
 public:
@@ -47,13 +53,18 @@ protected:
   /// Encode the image to a compressed frame
   bool EncodeImageDataInternal(vtkImageData* outputImageData, vtkStreamingVolumeFrame* inputFrame, bool forceKeyFrame) override;
 
+  /// Encode a region of the image to a compressed frame, reading the rows directly from the image
+  bool EncodeImageExtentInternal(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame) override;
+
   /// Update the codec parameters
-  /// There are no parameters to update within this codec
-  bool UpdateParameterInternal(std::string vtkNotUsed(parameterValue), std::string vtkNotUsed(parameterName)) override { return false; };
+  bool UpdateParameterInternal(std::string parameterName, std::string parameterValue) override;
 
   /// Return the codec parameter description
-  /// There are no parameters to update within this codec
-  std::string GetParameterDescription(std::string vtkNotUsed(parameterName)) override { return ""; };
+  std::string GetParameterDescription(std::string parameterName) override;
+
+protected:
+  /// Number of resolution levels used when encoding frames
+  int NumberOfResolutionLevels;
 
 private:
   vtkRawRGBVolumeCodec(const vtkRawRGBVolumeCodec&) = delete;
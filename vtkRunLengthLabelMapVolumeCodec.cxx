@@ -0,0 +1,389 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkRunLengthLabelMapVolumeCodec.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkType.h>
+
+// STD includes
+#include <algorithm>
+#include <sstream>
+
+vtkCodecNewMacro(vtkRunLengthLabelMapVolumeCodec);
+
+namespace
+{
+  const char* const KEY_FRAME_DISTANCE_PARAMETER = "KeyFrameDistance";
+
+  // Runs are stored as a 16-bit length followed by the label value
+  typedef vtkTypeUInt16 RunLengthType;
+  const vtkIdType MAXIMUM_RUN_LENGTH = 65535;
+
+  //---------------------------------------------------------------------------
+  // Encode the voxels of a region (or, if Difference is true, the XOR of the voxels with the previous voxels) as runs
+  // Rows of the region are read in place from the image. The previous voxels are contiguous.
+  template<typename T, bool Difference>
+  void vtkRunLengthEncode(const T* input, const vtkIdType increments[3], const int dimensions[3],
+                          const T* previous, std::vector<unsigned char>& output)
+  {
+    const size_t runSize = sizeof(RunLengthType) + sizeof(T);
+    output.resize(0);
+
+    T runValue = 0;
+    vtkIdType runLength = 0;
+    for (int k = 0; k < dimensions[2]; ++k)
+      {
+      for (int j = 0; j < dimensions[1]; ++j)
+        {
+        const T* row = input + k * increments[2] + j * increments[1];
+        for (int i = 0; i < dimensions[0]; ++i)
+          {
+          T value = Difference ? static_cast<T>(row[i] ^ *(previous++)) : row[i];
+          if (runLength > 0 && (value != runValue || runLength == MAXIMUM_RUN_LENGTH))
+            {
+            RunLengthType storedRunLength = static_cast<RunLengthType>(runLength);
+            size_t offset = output.size();
+            output.resize(offset + runSize);
+            memcpy(&output[offset], &storedRunLength, sizeof(RunLengthType));
+            memcpy(&output[offset + sizeof(RunLengthType)], &runValue, sizeof(T));
+            runLength = 0;
+            }
+          runValue = value;
+          ++runLength;
+          }
+        }
+      }
+
+    if (runLength > 0)
+      {
+      RunLengthType storedRunLength = static_cast<RunLengthType>(runLength);
+      size_t offset = output.size();
+      output.resize(offset + runSize);
+      memcpy(&output[offset], &storedRunLength, sizeof(RunLengthType));
+      memcpy(&output[offset + sizeof(RunLengthType)], &runValue, sizeof(T));
+      }
+  }
+
+  //---------------------------------------------------------------------------
+  // Expand the runs into the output buffer (or, if Difference is true, XOR them with the output buffer)
+  // Returns false if the runs do not exactly cover the output buffer
+  template<typename T, bool Difference>
+  bool vtkRunLengthDecode(const unsigned char* input, vtkIdType inputSize, T* output, vtkIdType numberOfValues)
+  {
+    const vtkIdType runSize = sizeof(RunLengthType) + sizeof(T);
+    const unsigned char* inputEnd = input + inputSize - (inputSize % runSize);
+    T* outputEnd = output + numberOfValues;
+    for (; input < inputEnd; input += runSize)
+      {
+      RunLengthType runLength;
+      T value;
+      memcpy(&runLength, input, sizeof(RunLengthType));
+      memcpy(&value, input + sizeof(RunLengthType), sizeof(T));
+      if (runLength > outputEnd - output)
+        {
+        return false;
+        }
+      if (Difference)
+        {
+        // unchanged voxels are encoded as zero
+        if (value != 0)
+          {
+          for (T* voxel = output; voxel < output + runLength; ++voxel)
+            {
+            *voxel = static_cast<T>(*voxel ^ value);
+            }
+          }
+        }
+      else
+        {
+        std::fill(output, output + runLength, value);
+        }
+      output += runLength;
+      }
+    return output == outputEnd;
+  }
+
+  //---------------------------------------------------------------------------
+  template<typename T>
+  void vtkRunLengthEncodeImage(const void* input, const vtkIdType increments[3], const int dimensions[3],
+                               const void* previous, std::vector<unsigned char>& output)
+  {
+    if (previous)
+      {
+      vtkRunLengthEncode<T, true>(static_cast<const T*>(input), increments, dimensions, static_cast<const T*>(previous), output);
+      }
+    else
+      {
+      vtkRunLengthEncode<T, false>(static_cast<const T*>(input), increments, dimensions, nullptr, output);
+      }
+  }
+
+  //---------------------------------------------------------------------------
+  template<typename T>
+  bool vtkRunLengthDecodeImage(const unsigned char* input, vtkIdType inputSize, void* output, vtkIdType numberOfValues, bool difference)
+  {
+    if (difference)
+      {
+      return vtkRunLengthDecode<T, true>(input, inputSize, static_cast<T*>(output), numberOfValues);
+      }
+    return vtkRunLengthDecode<T, false>(input, inputSize, static_cast<T*>(output), numberOfValues);
+  }
+}
+
+//---------------------------------------------------------------------------
+vtkRunLengthLabelMapVolumeCodec::vtkRunLengthLabelMapVolumeCodec()
+  : KeyFrameDistance(1)
+  , FramesSinceKeyFrame(0)
+  , LastEncodedFrame(nullptr)
+{
+  this->AvailiableParameterNames.push_back(KEY_FRAME_DISTANCE_PARAMETER);
+}
+
+//---------------------------------------------------------------------------
+vtkRunLengthLabelMapVolumeCodec::~vtkRunLengthLabelMapVolumeCodec()
+= default;
+
+//---------------------------------------------------------------------------
+bool vtkRunLengthLabelMapVolumeCodec::UpdateParameterInternal(std::string parameterName, std::string parameterValue)
+{
+  if (parameterName == KEY_FRAME_DISTANCE_PARAMETER)
+    {
+    std::stringstream ss(parameterValue);
+    int keyFrameDistance = 0;
+    if (!(ss >> keyFrameDistance) || keyFrameDistance < 1)
+      {
+      vtkErrorMacro("Invalid key frame distance: " << parameterValue);
+      return false;
+      }
+    if (keyFrameDistance != this->KeyFrameDistance)
+      {
+      // The next frame starts a new group of frames
+      this->KeyFrameDistance = keyFrameDistance;
+      this->ResetEncodedReference();
+      }
+    return true;
+    }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+std::string vtkRunLengthLabelMapVolumeCodec::GetParameterDescription(std::string parameterName)
+{
+  if (parameterName == KEY_FRAME_DISTANCE_PARAMETER)
+    {
+    return "Maximum number of frames between keyframes. Frames between keyframes are encoded as the difference to the previous frame. "
+           "1 (default) encodes every frame as a keyframe.";
+    }
+  return "";
+}
+
+//---------------------------------------------------------------------------
+bool vtkRunLengthLabelMapVolumeCodec::DecodeFrameInternal(vtkStreamingVolumeFrame* inputFrame, vtkImageData* outputImageData, bool vtkNotUsed(saveDecodedImage))
+{
+  if (!inputFrame || !outputImageData)
+    {
+    vtkErrorMacro("Incorrect arguments!");
+    return false;
+    }
+
+  int scalarType = inputFrame->GetVTKScalarType();
+  if ((scalarType != VTK_UNSIGNED_CHAR && scalarType != VTK_SHORT) || inputFrame->GetNumberOfComponents() != 1)
+    {
+    vtkErrorMacro("Codec only supports decoding of single component unsigned char and short images");
+    return false;
+    }
+
+  int frameDimensions[3] = { 0,0,0 };
+  inputFrame->GetDimensions(frameDimensions);
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(frameDimensions[0]) * frameDimensions[1] * frameDimensions[2];
+  if (numberOfVoxels == 0)
+    {
+    vtkErrorMacro("Cannot decode frame, number of voxels is zero");
+    return false;
+    }
+
+  vtkUnsignedCharArray* frameData = inputFrame->GetFrameData();
+  if (!frameData || frameData->GetNumberOfValues() == 0)
+    {
+    vtkErrorMacro("Cannot decode frame, frame data is missing");
+    return false;
+    }
+  const unsigned char* framePointer = frameData->GetPointer(0);
+  vtkIdType frameSize = frameData->GetNumberOfValues();
+
+  int imageDimensions[3] = { 0,0,0 };
+  outputImageData->GetDimensions(imageDimensions);
+  bool outputAllocated = outputImageData->GetPointData()->GetScalars() &&
+    imageDimensions[0] == frameDimensions[0] && imageDimensions[1] == frameDimensions[1] && imageDimensions[2] == frameDimensions[2] &&
+    outputImageData->GetScalarType() == scalarType && outputImageData->GetNumberOfScalarComponents() == 1;
+
+  // Predicted frames are decoded by updating the output image, which contains the previous frame
+  bool difference = !inputFrame->IsKeyFrame();
+  if (difference && !outputAllocated)
+    {
+    vtkErrorMacro("Cannot decode frame, previous frame has not been decoded");
+    return false;
+    }
+  if (!outputAllocated)
+    {
+    outputImageData->SetDimensions(frameDimensions);
+    outputImageData->AllocateScalars(scalarType, 1);
+    }
+
+  // Frames are decoded directly into the output image, frames that are only decoded to reconstruct
+  // a later predicted frame are overwritten by that frame
+  bool success = false;
+  if (scalarType == VTK_SHORT)
+    {
+    success = vtkRunLengthDecodeImage<short>(framePointer, frameSize, outputImageData->GetScalarPointer(), numberOfVoxels, difference);
+    }
+  else
+    {
+    success = vtkRunLengthDecodeImage<unsigned char>(framePointer, frameSize, outputImageData->GetScalarPointer(), numberOfVoxels, difference);
+    }
+  outputImageData->GetPointData()->GetScalars()->Modified();
+  if (!success)
+    {
+    vtkErrorMacro("Cannot decode frame, frame data is corrupted");
+    return false;
+    }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkRunLengthLabelMapVolumeCodec::EncodeImageDataInternal(vtkImageData* inputImageData, vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame)
+{
+  if (!inputImageData || !outputFrame)
+    {
+    vtkErrorMacro("Incorrect arguments!");
+    return false;
+    }
+  return this->EncodeImageExtentInternal(inputImageData, inputImageData->GetExtent(), outputFrame, forceKeyFrame);
+}
+
+//---------------------------------------------------------------------------
+bool vtkRunLengthLabelMapVolumeCodec::EncodeImageExtentInternal(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame)
+{
+  if (!inputImageData || !extent || !outputFrame)
+    {
+    vtkErrorMacro("Incorrect arguments!");
+    return false;
+    }
+
+  int scalarType = inputImageData->GetScalarType();
+  if ((scalarType != VTK_UNSIGNED_CHAR && scalarType != VTK_SHORT) || inputImageData->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro("Codec only supports encoding of single component unsigned char and short images");
+    return false;
+    }
+
+  int dimensions[3] = { 0,0,0 };
+  for (int i = 0; i < 3; ++i)
+    {
+    dimensions[i] = std::max(extent[2 * i + 1] - extent[2 * i] + 1, 0);
+    }
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (numberOfVoxels == 0)
+    {
+    vtkErrorMacro("Cannot encode frame, number of voxels is zero");
+    return false;
+    }
+
+  size_t numberOfBytes = numberOfVoxels * inputImageData->GetScalarSize();
+  const void* imagePointer = inputImageData->GetScalarPointerForExtent(extent);
+  vtkIdType increments[3] = { 0,0,0 };
+  inputImageData->GetIncrements(increments);
+
+  // Predicted frames can only be encoded if the previous frame has the same size and type.
+  // A frame cannot reference itself, if the caller reuses the output frame
+  // object then a keyframe is encoded.
+  bool keyFrame = forceKeyFrame
+    || this->FramesSinceKeyFrame + 1 >= this->KeyFrameDistance
+    || !this->LastEncodedFrame
+    || this->LastEncodedFrame == outputFrame
+    || this->LastEncodedFrame->GetVTKScalarType() != scalarType
+    || this->LastEncodedImage.size() != numberOfBytes;
+
+  const void* previousImagePointer = keyFrame ? nullptr : &this->LastEncodedImage[0];
+  if (scalarType == VTK_SHORT)
+    {
+    vtkRunLengthEncodeImage<short>(imagePointer, increments, dimensions, previousImagePointer, this->EncodeBuffer);
+    }
+  else
+    {
+    vtkRunLengthEncodeImage<unsigned char>(imagePointer, increments, dimensions, previousImagePointer, this->EncodeBuffer);
+    }
+
+  vtkSmartPointer<vtkUnsignedCharArray> frameData = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  frameData->SetNumberOfValues(this->EncodeBuffer.size());
+  memcpy(frameData->GetPointer(0), &this->EncodeBuffer[0], this->EncodeBuffer.size());
+
+  outputFrame->SetFrameData(frameData);
+  outputFrame->SetVTKScalarType(scalarType);
+  outputFrame->SetDimensions(dimensions);
+  outputFrame->SetNumberOfComponents(1);
+  outputFrame->SetFrameType(keyFrame ? vtkStreamingVolumeFrame::IFrame : vtkStreamingVolumeFrame::PFrame);
+  outputFrame->SetCodecFourCC(this->GetFourCC());
+  outputFrame->SetPreviousFrame(keyFrame ? nullptr : this->LastEncodedFrame.GetPointer());
+
+  if (this->KeyFrameDistance <= 1)
+    {
+    // All frames are keyframes, a reference image is not needed
+    this->ResetEncodedReference();
+    return true;
+    }
+
+  this->FramesSinceKeyFrame = keyFrame ? 0 : this->FramesSinceKeyFrame + 1;
+  this->LastEncodedFrame = outputFrame;
+
+  // Only needed for computing the difference of the next frame
+  this->LastEncodedImage.resize(numberOfBytes);
+  unsigned char* lastEncodedPointer = &this->LastEncodedImage[0];
+  size_t rowSize = dimensions[0] * inputImageData->GetScalarSize();
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      const unsigned char* rowPointer = static_cast<const unsigned char*>(imagePointer) +
+        (k * increments[2] + j * increments[1]) * inputImageData->GetScalarSize();
+      memcpy(lastEncodedPointer, rowPointer, rowSize);
+      lastEncodedPointer += rowSize;
+      }
+    }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkRunLengthLabelMapVolumeCodec::ResetEncodedReference()
+{
+  this->FramesSinceKeyFrame = 0;
+  this->LastEncodedFrame = nullptr;
+  this->LastEncodedImage.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkRunLengthLabelMapVolumeCodec::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "KeyFrameDistance:\t" << this->KeyFrameDistance << std::endl;
+  os << indent << "FramesSinceKeyFrame:\t" << this->FramesSinceKeyFrame << std::endl;
+}
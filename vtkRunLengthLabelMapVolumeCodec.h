@@ -0,0 +1,88 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkRunLengthLabelMapVolumeCodec_h
+#define __vtkRunLengthLabelMapVolumeCodec_h
+
+// vtkAddon includes
+#include "vtkStreamingVolumeCodec.h"
+
+// STD includes
+#include <vector>
+
+/// \brief Lossless codec for label maps and segmentations
+///
+/// Voxels are run-length encoded along the X axis as (16-bit run length, label value) pairs.
+/// Supports single component unsigned char and short images.
+///
+/// If the "KeyFrameDistance" parameter is greater than 1, frames between keyframes are encoded
+/// as the XOR of the image with the previously encoded image, so that unchanged voxels form long runs of zeros.
+class VTK_ADDON_EXPORT vtkRunLengthLabelMapVolumeCodec : public vtkStreamingVolumeCodec
+{
+public:
+  static vtkRunLengthLabelMapVolumeCodec *New();
+  vtkStreamingVolumeCodec* CreateCodecInstance() override;
+  vtkTypeMacro(vtkRunLengthLabelMapVolumeCodec, vtkStreamingVolumeCodec);
+
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // FourCC code representing run-length encoded label maps
+  std::string GetFourCC() override { return "RLLM"; };
+
+  /// Return the codec parameter description
+  std::string GetParameterDescription(std::string parameterName) override;
+
+protected:
+  vtkRunLengthLabelMapVolumeCodec();
+  ~vtkRunLengthLabelMapVolumeCodec() override;
+
+  /// Decode the compressed frame to an image
+  bool DecodeFrameInternal(vtkStreamingVolumeFrame* inputFrame, vtkImageData* outputImageData, bool saveDecodedImage = true) override;
+
+  /// Encode the image to a compressed frame
+  bool EncodeImageDataInternal(vtkImageData* inputImageData, vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame) override;
+
+  /// Encode a region of the image to a compressed frame, reading the rows directly from the image
+  bool EncodeImageExtentInternal(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame) override;
+
+  /// Update the codec parameters
+  bool UpdateParameterInternal(std::string parameterName, std::string parameterValue) override;
+
+  /// Forget the last encoded frame, the next frame is encoded as a keyframe
+  void ResetEncodedReference();
+
+protected:
+  /// Maximum number of frames between keyframes
+  int KeyFrameDistance;
+
+  /// Number of frames encoded since the last keyframe
+  int FramesSinceKeyFrame;
+
+  /// Last encoded frame, referenced by the next predicted frame
+  vtkSmartPointer<vtkStreamingVolumeFrame> LastEncodedFrame;
+
+  /// Contents of the last encoded image, used for computing the difference of predicted frames
+  std::vector<unsigned char> LastEncodedImage;
+
+  /// Buffer storing the encoded runs before they are copied to the frame
+  std::vector<unsigned char> EncodeBuffer;
+
+private:
+  vtkRunLengthLabelMapVolumeCodec(const vtkRunLengthLabelMapVolumeCodec&) = delete;
+  void operator=(const vtkRunLengthLabelMapVolumeCodec&) = delete;
+};
+
+#endif
@@ -22,12 +22,17 @@ Care Ontario.
 #include "vtkStreamingVolumeCodec.h"
 
 // STD includes
+#include <algorithm>
+#include <cstring>
 #include <deque>
 #include <sstream>
 #include <string>
 
 // VTK includes
+#include <vtkDataArray.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 
 // vtksys includes
 #include <vtksys/SystemTools.hxx>
@@ -35,6 +40,10 @@ Care Ontario.
 //---------------------------------------------------------------------------
 vtkStreamingVolumeCodec::vtkStreamingVolumeCodec()
   : LastDecodedFrame(nullptr)
+  , LastDecodedScalarsMTime(0)
+  , ReorderBufferSize(0)
+  , LastOutputPresentationTimestamp(0.0)
+  , MaximumDecodedResolutionLevel(-1)
 {
 }
 
@@ -56,11 +65,21 @@ bool vtkStreamingVolumeCodec::DecodeFrame(vtkStreamingVolumeFrame* streamingFram
   std::deque<vtkStreamingVolumeFrame*> frames;
   frames.push_back(currentFrame);
 
+  // The last decoded frame can only be updated if it is still contained in the output image
+  vtkStreamingVolumeFrame* lastDecodedFrame = this->LastDecodedFrame;
+  vtkDataArray* outputScalars = outputImageData->GetPointData()->GetScalars();
+  if (!outputScalars || outputScalars != this->LastDecodedScalars
+      || outputScalars->GetMTime() != this->LastDecodedScalarsMTime)
+    {
+    lastDecodedFrame = nullptr;
+    }
+
   // Decode previous frames if the following is true:
   // - Current frame is not a keyframe
-  // - The frame that was previously decoded is not the same as the frame preceding the current one
+  // - The frame that was previously decoded is not the same as the frame preceding the current one,
+  //   or it is not contained in the output image
   while (currentFrame && !currentFrame->IsKeyFrame() &&
-         currentFrame->GetPreviousFrame() != this->LastDecodedFrame)
+         currentFrame->GetPreviousFrame() != lastDecodedFrame)
     {
     currentFrame = currentFrame->GetPreviousFrame();
     frames.push_back(currentFrame);
@@ -77,6 +96,8 @@ bool vtkStreamingVolumeCodec::DecodeFrame(vtkStreamingVolumeFrame* streamingFram
       if (!this->DecodeFrameInternal(frame, outputImageData, saveDecodedImage))
         {
         vtkErrorMacro("Could not decode frame!");
+        this->LastDecodedFrame = nullptr;
+        this->LastDecodedScalars = nullptr;
         return false;
         }
       }
@@ -84,6 +105,118 @@ bool vtkStreamingVolumeCodec::DecodeFrame(vtkStreamingVolumeFrame* streamingFram
     }
 
   this->LastDecodedFrame = streamingFrame;
+  this->LastDecodedScalars = outputImageData->GetPointData()->GetScalars();
+  this->LastDecodedScalarsMTime = this->LastDecodedScalars ? this->LastDecodedScalars->GetMTime() : 0;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkStreamingVolumeCodec::DecodeFrameReordered(vtkStreamingVolumeFrame* streamingFrame, vtkImageData* outputImageData, bool& outputAvailable)
+{
+  outputAvailable = false;
+  if (!streamingFrame || !outputImageData)
+    {
+    vtkErrorMacro("Invalid arguments!");
+    return false;
+    }
+
+  // Frames are always decoded into the same reference image, which predicted frames update.
+  // If the last decoded frame was decoded into another image, decoding restarts from the keyframe.
+  if (!this->ReorderReferenceImage)
+    {
+    this->ReorderReferenceImage = vtkSmartPointer<vtkImageData>::New();
+    }
+  if (!this->ReorderReferenceFrame || this->ReorderReferenceFrame != this->LastDecodedFrame)
+    {
+    this->LastDecodedFrame = nullptr;
+    this->ReorderReferenceImage->SetDimensions(streamingFrame->GetDimensions());
+    this->ReorderReferenceImage->AllocateScalars(streamingFrame->GetVTKScalarType(), streamingFrame->GetNumberOfComponents());
+    }
+  this->ReorderReferenceFrame = nullptr;
+  if (!this->DecodeFrame(streamingFrame, this->ReorderReferenceImage))
+    {
+    return false;
+    }
+  this->ReorderReferenceFrame = streamingFrame;
+
+  // Copy the decoded voxels into the image of a frame that has already been output, if possible
+  vtkSmartPointer<vtkImageData> decodedImage;
+  if (!this->ReorderBufferImagePool.empty())
+    {
+    decodedImage = this->ReorderBufferImagePool.back();
+    this->ReorderBufferImagePool.pop_back();
+    }
+  else
+    {
+    decodedImage = vtkSmartPointer<vtkImageData>::New();
+    }
+  vtkDataArray* referenceScalars = this->ReorderReferenceImage->GetPointData()->GetScalars();
+  decodedImage->SetDimensions(this->ReorderReferenceImage->GetDimensions());
+  decodedImage->AllocateScalars(referenceScalars->GetDataType(), referenceScalars->GetNumberOfComponents());
+  memcpy(decodedImage->GetScalarPointer(), referenceScalars->GetVoidPointer(0),
+    referenceScalars->GetNumberOfValues() * referenceScalars->GetDataTypeSize());
+
+  // Frames with equal timestamps are output in decode order
+  ReorderBufferEntry entry;
+  entry.PresentationTimestamp = streamingFrame->GetPresentationTimestamp();
+  entry.Image = decodedImage;
+  std::vector<ReorderBufferEntry>::iterator insertIt = std::upper_bound(
+    this->ReorderBuffer.begin(), this->ReorderBuffer.end(), entry,
+    [](const ReorderBufferEntry& a, const ReorderBufferEntry& b) { return a.PresentationTimestamp < b.PresentationTimestamp; });
+  this->ReorderBuffer.insert(insertIt, entry);
+
+  if (static_cast<int>(this->ReorderBuffer.size()) > this->ReorderBufferSize)
+    {
+    outputAvailable = this->OutputNextReorderedFrame(outputImageData);
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkStreamingVolumeCodec::FlushReorderBuffer(vtkImageData* outputImageData)
+{
+  if (!outputImageData)
+    {
+    vtkErrorMacro("Invalid arguments!");
+    return false;
+    }
+  return this->OutputNextReorderedFrame(outputImageData);
+}
+
+//---------------------------------------------------------------------------
+void vtkStreamingVolumeCodec::ClearReorderBuffer()
+{
+  std::vector<ReorderBufferEntry>::iterator entryIt;
+  for (entryIt = this->ReorderBuffer.begin(); entryIt != this->ReorderBuffer.end(); ++entryIt)
+    {
+    this->ReorderBufferImagePool.push_back(entryIt->Image);
+    }
+  this->ReorderBuffer.clear();
+}
+
+//---------------------------------------------------------------------------
+bool vtkStreamingVolumeCodec::OutputNextReorderedFrame(vtkImageData* outputImageData)
+{
+  if (this->ReorderBuffer.empty())
+    {
+    return false;
+    }
+
+  ReorderBufferEntry entry = this->ReorderBuffer.front();
+  this->ReorderBuffer.erase(this->ReorderBuffer.begin());
+
+  // Swap the decoded voxels into the output instead of copying them.
+  // The previous voxels of the output are reused to decode a later frame.
+  // The geometry of the output image is preserved, only its dimensions are updated.
+  vtkImageData* decodedImage = entry.Image;
+  vtkSmartPointer<vtkDataArray> previousOutputScalars = outputImageData->GetPointData()->GetScalars();
+  outputImageData->SetDimensions(decodedImage->GetDimensions());
+  outputImageData->GetPointData()->SetScalars(decodedImage->GetPointData()->GetScalars());
+  decodedImage->GetPointData()->SetScalars(previousOutputScalars);
+  outputImageData->Modified();
+
+  this->LastOutputPresentationTimestamp = entry.PresentationTimestamp;
+  this->ReorderBufferImagePool.push_back(entry.Image);
   return true;
 }
 
@@ -96,7 +229,30 @@ bool vtkStreamingVolumeCodec::EncodeImageData(vtkImageData* inputImageData, vtkS
     return false;
     }
 
-  if (!this->EncodeImageDataInternal(inputImageData, outputStreamingFrame, forceKeyFrame))
+  return this->EncodeImageData(inputImageData, inputImageData->GetExtent(), outputStreamingFrame, forceKeyFrame);
+}
+
+//---------------------------------------------------------------------------
+bool vtkStreamingVolumeCodec::EncodeImageData(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputStreamingFrame, bool forceKeyFrame/*=false*/)
+{
+  if (!inputImageData || !extent || !outputStreamingFrame)
+    {
+    vtkErrorMacro("Invalid arguments!");
+    return false;
+    }
+
+  int* imageExtent = inputImageData->GetExtent();
+  for (int i = 0; i < 3; ++i)
+    {
+    if (extent[2 * i] > extent[2 * i + 1] ||
+        extent[2 * i] < imageExtent[2 * i] || extent[2 * i + 1] > imageExtent[2 * i + 1])
+      {
+      vtkErrorMacro("Invalid arguments: extent is empty or not contained in the image extent");
+      return false;
+      }
+    }
+
+  if (!this->EncodeImageExtentInternal(inputImageData, extent, outputStreamingFrame, forceKeyFrame))
     {
     vtkErrorMacro("Could not encode frame!");
     return false;
@@ -105,6 +261,34 @@ bool vtkStreamingVolumeCodec::EncodeImageData(vtkImageData* inputImageData, vtkS
   return true;
 }
 
+//---------------------------------------------------------------------------
+bool vtkStreamingVolumeCodec::EncodeImageExtentInternal(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame)
+{
+  int* imageExtent = inputImageData->GetExtent();
+  if (std::equal(extent, extent + 6, imageExtent))
+    {
+    return this->EncodeImageDataInternal(inputImageData, outputFrame, forceKeyFrame);
+    }
+
+  // The codec requires contiguous voxels, copy the rows of the region
+  vtkNew<vtkImageData> regionImageData;
+  regionImageData->SetExtent(extent);
+  regionImageData->AllocateScalars(inputImageData->GetScalarType(), inputImageData->GetNumberOfScalarComponents());
+
+  size_t rowSize = static_cast<size_t>(extent[1] - extent[0] + 1) * inputImageData->GetScalarSize() * inputImageData->GetNumberOfScalarComponents();
+  unsigned char* regionPointer = static_cast<unsigned char*>(regionImageData->GetScalarPointer());
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      memcpy(regionPointer, inputImageData->GetScalarPointer(extent[0], j, k), rowSize);
+      regionPointer += rowSize;
+      }
+    }
+
+  return this->EncodeImageDataInternal(regionImageData, outputFrame, forceKeyFrame);
+}
+
 //---------------------------------------------------------------------------
 bool vtkStreamingVolumeCodec::SetParameter(std::string parameterName, std::string parameterValue)
 {
@@ -200,6 +384,9 @@ void vtkStreamingVolumeCodec::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "Codec FourCC:\t" << this->GetFourCC() << std::endl;
+  os << indent << "ReorderBufferSize:\t" << this->ReorderBufferSize << std::endl;
+  os << indent << "LastOutputPresentationTimestamp:\t" << this->LastOutputPresentationTimestamp << std::endl;
+  os << indent << "MaximumDecodedResolutionLevel:\t" << this->MaximumDecodedResolutionLevel << std::endl;
   std::map<std::string, std::string>::iterator codecParameterIt;
   for (codecParameterIt = this->Parameters.begin(); codecParameterIt != this->Parameters.end(); ++codecParameterIt)
     {
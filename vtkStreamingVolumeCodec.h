@@ -30,6 +30,7 @@ Care Ontario.
 #include <vtkImageData.h>
 #include <vtkObject.h>
 #include <vtkUnsignedCharArray.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
 #include <map>
@@ -65,6 +66,56 @@ public:
   /// Returns true if the frame is decoded successfully
   virtual bool DecodeFrame(vtkStreamingVolumeFrame* frame, vtkImageData* outputImageData);
 
+  /// Frame that was decoded by the last call to DecodeFrame()
+  /// Frames that are predicted from this frame are decoded by updating the output image of that call.
+  vtkStreamingVolumeFrame* GetLastDecodedFrame() { return this->LastDecodedFrame; };
+
+  /// Forget the last decoded frame, so that the next predicted frame is decoded starting from its keyframe
+  /// Output images whose scalars were replaced or modified since the last call to DecodeFrame() are detected,
+  /// this must be called if the voxels of the output image were changed without modifying its scalars.
+  void ResetLastDecodedFrame() { this->LastDecodedFrame = nullptr; };
+
+  /// Decode a frame that was received in decode order, and output the pending frame with the lowest presentation timestamp
+  /// Decoded images are held in a reorder buffer so that codecs using B-Frames produce images in presentation order.
+  /// Once the buffer is filled, each call outputs exactly one image.
+  /// \param frame Input frame containing the compressed frame data, passed in decode order
+  /// \param outputImageData Output image which will store the uncompressed image that is next in presentation order
+  /// \param outputAvailable Set to true if an image was written to outputImageData, false while the reorder buffer is being filled
+  /// The scalars of outputImageData are replaced by the decoded scalars, references to the previous output scalars
+  /// should not be kept, as their contents are overwritten by the decoding of later frames.
+  /// Returns true if the frame is decoded successfully
+  /// \sa SetReorderBufferSize(), FlushReorderBuffer()
+  virtual bool DecodeFrameReordered(vtkStreamingVolumeFrame* frame, vtkImageData* outputImageData, bool& outputAvailable);
+
+  /// Output the pending frame with the lowest presentation timestamp from the reorder buffer
+  /// Should be called repeatedly at the end of a stream until it returns false.
+  /// \param outputImageData Output image which will store the uncompressed image
+  /// Returns true if an image was written to outputImageData
+  bool FlushReorderBuffer(vtkImageData* outputImageData);
+
+  /// Discard all frames pending in the reorder buffer
+  /// Should be called when seeking within a stream.
+  void ClearReorderBuffer();
+
+  /// Number of decoded frames that are held back to restore presentation order
+  /// Should be set to the maximum number of consecutive B-Frames in the stream.
+  /// The default value of 0 outputs each frame as soon as it is decoded.
+  vtkSetMacro(ReorderBufferSize, int);
+  vtkGetMacro(ReorderBufferSize, int);
+
+  /// Highest resolution level that is decoded from progressive frames
+  /// Decoding stops after the specified level, and the output image is resized to the dimensions of that level.
+  /// The spacing of the output image is multiplied by the stride of the level, and restored when a finer level
+  /// is decoded into the same image.
+  /// Lower levels can be used to quickly display a preview of the frame, before the remaining levels are decoded.
+  /// The default value of -1 decodes all levels.
+  /// \sa vtkStreamingVolumeFrame::GetResolutionLevelStride()
+  vtkSetMacro(MaximumDecodedResolutionLevel, int);
+  vtkGetMacro(MaximumDecodedResolutionLevel, int);
+
+  /// Presentation timestamp of the last image output by DecodeFrameReordered() or FlushReorderBuffer()
+  vtkGetMacro(LastOutputPresentationTimestamp, double);
+
   /// Encode the image data and store it in the frame
   /// \param inputImageData Input image containing the uncompressed image
   /// \param outputStreamingFrame Output frame that will be used to store the compressed frame
@@ -72,6 +123,15 @@ public:
   /// Returns true if the image is encoded successfully
   virtual bool EncodeImageData(vtkImageData* inputImageData, vtkStreamingVolumeFrame* outputStreamingFrame, bool forceKeyFrame=false);
 
+  /// Encode a sub-extent of the image data and store it in the frame
+  /// The voxels are read directly from the image using the image increments, without copying the region first.
+  /// \param inputImageData Input image containing the uncompressed image
+  /// \param extent Region of the input image that will be encoded. Must be contained within the image extent
+  /// \param outputStreamingFrame Output frame that will be used to store the compressed frame
+  /// \param forceKeyFrame If the codec supports it, attempt to encode the image as a keyframe
+  /// Returns true if the region is encoded successfully
+  virtual bool EncodeImageData(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputStreamingFrame, bool forceKeyFrame=false);
+
   /// Read this codec's information from a string representation
   /// Format is "ParameterName1:ParameterValue1;ParameterName2;ParameterValue2;ParameterNameN:ParameterValueN"
   /// \sa GetParametersAsString()
@@ -163,6 +223,8 @@ protected:
   /// \param inputFame Frame object containing the compressed data to be decoded
   /// \param outputImageData Image data object that will be used to store the output image
   /// \param saveDecodedImage If true, writes the decoded image to the frame. If false, the decoded results are discarded
+  /// Frames that have no PreviousFrame must be decoded without reading the output scalars,
+  /// which may be a write-only buffer (see vtkOpenGLTextureImage::DecodeFrame)
   /// Returns true if the frame is decoded successfully
   virtual bool DecodeFrameInternal(vtkStreamingVolumeFrame* inputFrame, vtkImageData* outputImageData, bool saveDecodedImage = true) = 0;
 
@@ -174,6 +236,20 @@ protected:
   /// Returns true if the image is encoded successfully
   virtual bool EncodeImageDataInternal(vtkImageData* inputImageData, vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame) = 0;
 
+  /// Encode a sub-extent of a vtkImageData and store its contents in a frame
+  /// Should be overridden in subclasses that can read the voxels of the region directly from the image.
+  /// The default implementation encodes a copy of the region using EncodeImageDataInternal()
+  /// \param inputImageData Image data object containing the uncompressed data to be encoded
+  /// \param extent Region of the image that will be encoded, contained within the image extent
+  /// \param outputFrame Frame object that will be used to store the compressed data
+  /// \param forceKeyFrame When true, attempt to encode the image as a keyframe if the codec supports it
+  /// Returns true if the region is encoded successfully
+  virtual bool EncodeImageExtentInternal(vtkImageData* inputImageData, int extent[6], vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame);
+
+  /// Move the pending frame with the lowest presentation timestamp from the reorder buffer to the output image
+  /// The scalars of the buffered image and of the output image are swapped, the voxels are not copied.
+  bool OutputNextReorderedFrame(vtkImageData* outputImageData);
+
 protected:
   vtkStreamingVolumeCodec();
   ~vtkStreamingVolumeCodec() override;
@@ -185,9 +261,30 @@ private:
 protected:
   std::vector<std::string>                  AvailiableParameterNames;
   vtkSmartPointer<vtkStreamingVolumeFrame>  LastDecodedFrame;
+  /// Output scalars of the last decoded frame, and their modification time after decoding
+  /// Predicted frames are only decoded from LastDecodedFrame if the output still contains it.
+  vtkWeakPointer<vtkDataArray>              LastDecodedScalars;
+  vtkMTimeType                              LastDecodedScalarsMTime;
   std::map<std::string, std::string>        Parameters;
   std::vector<ParameterPreset>              ParameterPresets;
   std::string                               DefaultParameterPresetValue;
+
+  struct ReorderBufferEntry
+  {
+    double                        PresentationTimestamp;
+    vtkSmartPointer<vtkImageData> Image;
+  };
+  /// Decoded frames that have not been output yet, sorted by presentation timestamp
+  std::vector<ReorderBufferEntry>               ReorderBuffer;
+  /// Images holding the previous voxels of the output images, kept to avoid reallocating the buffers for every frame
+  std::vector<vtkSmartPointer<vtkImageData> >   ReorderBufferImagePool;
+  /// Image that frames passed to DecodeFrameReordered() are decoded into
+  /// Predicted frames are decoded by updating this image, so it always contains ReorderReferenceFrame.
+  vtkSmartPointer<vtkImageData>                 ReorderReferenceImage;
+  vtkSmartPointer<vtkStreamingVolumeFrame>      ReorderReferenceFrame;
+  int                                           ReorderBufferSize;
+  double                                        LastOutputPresentationTimestamp;
+  int                                           MaximumDecodedResolutionLevel;
 };
 
 #endif
@@ -20,6 +20,7 @@ Care Ontario.
 
 // vtkAddon includes
 #include "vtkRawRGBVolumeCodec.h"
+#include "vtkRunLengthLabelMapVolumeCodec.h"
 #include "vtkStreamingVolumeCodecFactory.h"
 
 // VTK includes
@@ -114,6 +115,7 @@ void vtkStreamingVolumeCodecFactory::classInitialize()
   vtkStreamingVolumeCodecFactoryInstance = vtkStreamingVolumeCodecFactory::GetInstance();
 
   vtkStreamingVolumeCodecFactoryInstance->RegisterStreamingCodec(vtkSmartPointer<vtkRawRGBVolumeCodec>::New());
+  vtkStreamingVolumeCodecFactoryInstance->RegisterStreamingCodec(vtkSmartPointer<vtkRunLengthLabelMapVolumeCodec>::New());
 }
 
 //----------------------------------------------------------------------------
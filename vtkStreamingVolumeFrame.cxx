@@ -33,6 +33,7 @@ vtkStreamingVolumeFrame::vtkStreamingVolumeFrame()
   , FrameType(vtkStreamingVolumeFrame::PFrame)
   , NumberOfComponents(3)
   , PreviousFrame(nullptr)
+  , PresentationTimestamp(0.0)
   , VTKScalarType(VTK_UNSIGNED_CHAR)
 {
   this->Dimensions[0] = 0;
@@ -58,6 +59,27 @@ void vtkStreamingVolumeFrame::SetPreviousFrame(vtkStreamingVolumeFrame* previous
   this->Modified();
 };
 
+//---------------------------------------------------------------------------
+int vtkStreamingVolumeFrame::GetNumberOfResolutionLevels()
+{
+  if (this->ResolutionLevelOffsets.empty())
+    {
+    return 1;
+    }
+  return static_cast<int>(this->ResolutionLevelOffsets.size());
+}
+
+//---------------------------------------------------------------------------
+int vtkStreamingVolumeFrame::GetResolutionLevelStride(int level)
+{
+  int numberOfLevels = this->GetNumberOfResolutionLevels();
+  if (level < 0 || level >= numberOfLevels)
+    {
+    return 1;
+    }
+  return 1 << (numberOfLevels - 1 - level);
+}
+
 //---------------------------------------------------------------------------
 void vtkStreamingVolumeFrame::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -69,4 +91,6 @@ void vtkStreamingVolumeFrame::PrintSelf(ostream& os, vtkIndent indent)
   os << "VTKScalarType: " << this->VTKScalarType << "\n";
   os << "CurrentFrame: " << this->FrameData << "\n";
   os << "PreviousFrame: " << this->PreviousFrame << "\n";
+  os << "PresentationTimestamp: " << this->PresentationTimestamp << "\n";
+  os << "NumberOfResolutionLevels: " << this->GetNumberOfResolutionLevels() << "\n";
 }
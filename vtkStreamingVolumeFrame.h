@@ -27,6 +27,10 @@ Care Ontario.
 
 // vtkAddon includes
 #include "vtkAddon.h"
+#include "vtkAddonSetGet.h"
+
+// STD includes
+#include <vector>
 
 /// \brief VTK object containing a single compressed frame
 class VTK_ADDON_EXPORT vtkStreamingVolumeFrame : public vtkObject
@@ -78,6 +82,29 @@ public:
   vtkSetMacro(CodecFourCC, std::string);
   vtkGetMacro(CodecFourCC, std::string);
 
+  /// Time at which the decoded frame should be displayed
+  /// B-Frames are transmitted and decoded ahead of their presentation time, so frames in decode order
+  /// may not be in presentation order.
+  /// \sa vtkStreamingVolumeCodec::DecodeFrameReordered()
+  vtkSetMacro(PresentationTimestamp, double);
+  vtkGetMacro(PresentationTimestamp, double);
+
+  /// Byte offset of each resolution level within the frame data, for progressive frames
+  /// Level 0 contains a coarse subsampled version of the image, and each following level contains the voxels
+  /// required to refine the image by a factor of two along each axis.
+  /// Frames that are not progressive contain a single level.
+  /// The offsets are set by the encoder and are not transmitted with the frame: codecs store the level structure
+  /// in the frame data and read it from there when the frame is decoded, so received frames report a single level.
+  vtkSetStdVectorMacro(ResolutionLevelOffsets, std::vector<vtkIdType>);
+  vtkGetStdVectorMacro(ResolutionLevelOffsets, std::vector<vtkIdType>);
+
+  /// Returns the number of resolution levels stored in the frame
+  int GetNumberOfResolutionLevels();
+
+  /// Returns the voxel stride of the image decoded up to the specified resolution level, relative to the full resolution image
+  /// The spacing of the image decoded up to this level is the original spacing multiplied by the stride.
+  int GetResolutionLevelStride(int level);
+
   /// Returns true if the frame is a "Keyframe", aka "I-Frame"
   bool IsKeyFrame() { return this->FrameType == IFrame; };
 
@@ -88,6 +115,8 @@ protected:
   int                                         FrameType;
   int                                         NumberOfComponents;
   vtkSmartPointer<vtkStreamingVolumeFrame>    PreviousFrame;
+  double                                      PresentationTimestamp;
+  std::vector<vtkIdType>                      ResolutionLevelOffsets;
   int                                         VTKScalarType;
 
 protected: